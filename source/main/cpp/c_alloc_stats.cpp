@@ -0,0 +1,263 @@
+#include "ccore/c_target.h"
+#include "ccore/c_alloc_stats.h"
+#include "ccore/c_atomic.h"
+#include "ccore/c_math.h"
+#include "ccore/c_memory.h"
+#include "ccore/c_stream.h"
+
+namespace ncore
+{
+    namespace nalloc_stats
+    {
+        void reset(alloc_stats_t* stats) { nmem::memset(stats, 0, sizeof(alloc_stats_t)); }
+
+        u32 size_class(u64 value)
+        {
+            if (value == 0)
+                return 0;
+            const u32 c = (u32)math::ilog2(value) + 1;
+            return c < c_alloc_stats_classes ? c : c_alloc_stats_classes - 1;
+        }
+
+        static inline u64 volatile* s_counter(u64& counter) { return (u64 volatile*)&counter; }
+
+        void on_alloc(alloc_stats_t* stats, u32 size)
+        {
+            const u32 c = size_class(size);
+            natomic::fetch_add_relaxed(s_counter(stats->m_count[c]), (u64)1);
+            natomic::fetch_add_relaxed(s_counter(stats->m_bytes[c]), (u64)size);
+            natomic::fetch_add_relaxed(s_counter(stats->m_allocs), (u64)1);
+            natomic::fetch_add_relaxed(s_counter(stats->m_live_count), (u64)1);
+
+            // the counters only need atomicity, the peak is a max that is raised with a CAS
+            const u64 live = natomic::fetch_add_relaxed(s_counter(stats->m_live_bytes), (u64)size) + size;
+            u64       peak = natomic::load_relaxed(s_counter(stats->m_peak_bytes));
+            while (live > peak && !natomic::cas(s_counter(stats->m_peak_bytes), peak, live))
+                peak = natomic::load_relaxed(s_counter(stats->m_peak_bytes));
+        }
+
+        void on_free(alloc_stats_t* stats, u32 size, u64 lifetime)
+        {
+            natomic::fetch_add_relaxed(s_counter(stats->m_lifetime[size_class(lifetime)]), (u64)1);
+            natomic::fetch_add_relaxed(s_counter(stats->m_frees), (u64)1);
+            natomic::fetch_sub_relaxed(s_counter(stats->m_live_count), (u64)1);
+            natomic::fetch_sub_relaxed(s_counter(stats->m_live_bytes), (u64)size);
+        }
+
+        // Global scope table, open addressing on (file, line), a slot is claimed by moving its state
+        // from empty to writing and it becomes visible to lookups when its state is ready.
+        enum
+        {
+            SCOPE_EMPTY   = 0,
+            SCOPE_WRITING = 1,
+            SCOPE_READY   = 2,
+        };
+
+        struct scope_entry_t
+        {
+            u32 volatile m_state;
+            s32          m_line;
+            const char*  m_file;
+        };
+
+        static scope_entry_t s_scopes[c_max_scopes];
+
+        u16 register_scope(const char* file, s32 line)
+        {
+            const u32 hash = (u32)(((u64)(ptr_t)file * 0x9E3779B97F4A7C15ull) >> 32) ^ ((u32)line * 0x85EBCA6Bu);
+            for (u32 i = 0; i < c_max_scopes; ++i)
+            {
+                const u32 index = (hash + i) & (c_max_scopes - 1);
+                if (index == 0)
+                    continue;  // index 0 is 'no scope'
+
+                scope_entry_t* entry = &s_scopes[index];
+                u32            state = natomic::load(&entry->m_state);
+                if (state == SCOPE_EMPTY && natomic::cas(&entry->m_state, SCOPE_EMPTY, SCOPE_WRITING))
+                {
+                    entry->m_file = file;
+                    entry->m_line = line;
+                    natomic::store(&entry->m_state, (u32)SCOPE_READY);
+                    return (u16)index;
+                }
+
+                while ((state = natomic::load(&entry->m_state)) == SCOPE_WRITING)
+                    natomic::pause();
+                if (entry->m_file == file && entry->m_line == line)
+                    return (u16)index;
+            }
+            return 0;
+        }
+
+        const char* scope_file(u16 scope) { return (scope != 0 && scope < c_max_scopes && natomic::load(&s_scopes[scope].m_state) == SCOPE_READY) ? s_scopes[scope].m_file : nullptr; }
+        s32         scope_line(u16 scope) { return (scope != 0 && scope < c_max_scopes && natomic::load(&s_scopes[scope].m_state) == SCOPE_READY) ? s_scopes[scope].m_line : 0; }
+
+        // Per-thread scope stack, scopes that are nested deeper than the stack are attributed to the
+        // deepest scope that fits.
+        static const u32 c_max_scope_depth = 64;
+
+        struct scope_stack_t
+        {
+            u16 m_scopes[c_max_scope_depth];
+            u32 m_depth;
+        };
+
+        static CC_THREAD_LOCAL scope_stack_t s_scope_stack;
+
+        void push_scope(const char* file, s32 line)
+        {
+            if (s_scope_stack.m_depth < c_max_scope_depth)
+                s_scope_stack.m_scopes[s_scope_stack.m_depth] = register_scope(file, line);
+            s_scope_stack.m_depth += 1;
+        }
+
+        void pop_scope()
+        {
+            ASSERT(s_scope_stack.m_depth > 0);
+            s_scope_stack.m_depth -= 1;
+        }
+
+        u16 current_scope()
+        {
+            if (s_scope_stack.m_depth == 0)
+                return 0;
+            const u32 top = s_scope_stack.m_depth < c_max_scope_depth ? s_scope_stack.m_depth : c_max_scope_depth;
+            return s_scope_stack.m_scopes[top - 1];
+        }
+
+        class scope_tracker_t : public alloc_tracker_t
+        {
+        public:
+            virtual void push(const char* file, int_t line) { push_scope(file, (s32)line); }
+            virtual void pop() { pop_scope(); }
+        };
+
+        static scope_tracker_t s_tracker;
+
+        alloc_tracker_t* tracker() { return &s_tracker; }
+    }  // namespace nalloc_stats
+
+    namespace nalloc_trace
+    {
+        static CC_THREAD_LOCAL alloc_ring_t* s_thread_ring = nullptr;
+
+        void init(alloc_ring_t* ring, alloc_event_t* events, u32 capacity)
+        {
+            ASSERT(math::ispo2(capacity));
+            ring->m_events = events;
+            ring->m_mask   = capacity - 1;
+            ring->m_head   = 0;
+        }
+
+        void          set_thread_ring(alloc_ring_t* ring) { s_thread_ring = ring; }
+        alloc_ring_t* thread_ring() { return s_thread_ring; }
+
+        void record(alloc_ring_t* ring, u8 type, void* address, u32 size, u16 scope, u64 sequence)
+        {
+            const u32      head  = ring->m_head;
+            alloc_event_t* event = &ring->m_events[head & ring->m_mask];
+            event->m_address     = (u64)(ptr_t)address;
+            event->m_sequence    = sequence;
+            event->m_size        = size;
+            event->m_scope       = scope;
+            event->m_type        = type;
+            event->m_padding     = 0;
+            natomic::store(&ring->m_head, head + 1);
+        }
+
+        s64 dump(alloc_ring_t const* ring, writer_t* writer)
+        {
+            const u32 head     = natomic::load(&ring->m_head);
+            const u32 capacity = ring->m_mask + 1;
+            const u32 count    = head < capacity ? head : capacity;
+
+            u32 header[4];
+            header[0] = ('A' << 24) | ('T' << 16) | ('R' << 8) | 'C';
+            header[1] = 1;
+            header[2] = sizeof(alloc_event_t);
+            header[3] = count;
+            s64 written = writer->write((u8 const*)header, sizeof(header));
+
+            // the oldest events are at the head position when the ring has wrapped around
+            const u32 first   = (head - count) & ring->m_mask;
+            const u32 part1   = math::min(count, capacity - first);
+            const u32 part2   = count - part1;
+            written          += writer->write((u8 const*)&ring->m_events[first], (s64)part1 * sizeof(alloc_event_t));
+            if (part2 > 0)
+                written += writer->write((u8 const*)&ring->m_events[0], (s64)part2 * sizeof(alloc_event_t));
+            return written;
+        }
+    }  // namespace nalloc_trace
+
+    // Every allocation is preceded by this header, 'm_offset' is the distance from the start of the
+    // block that was allocated from the wrapped allocator to the user pointer.
+    struct alloc_header_t
+    {
+        u32 m_size;
+        u16 m_scope;
+        u16 m_offset;
+        u64 m_sequence;
+    };
+
+    alloc_stats_alloc_t::alloc_stats_alloc_t(alloc_t* allocator, alloc_stats_t* scope_stats, u32 max_scopes)
+        : m_allocator(allocator)
+        , m_scope_stats(scope_stats)
+        , m_max_scopes(scope_stats != nullptr ? max_scopes : 0)
+        , m_sequence(0)
+    {
+        reset();
+    }
+
+    void alloc_stats_alloc_t::reset()
+    {
+        nalloc_stats::reset(&m_stats);
+        for (u32 i = 0; i < m_max_scopes; ++i)
+            nalloc_stats::reset(&m_scope_stats[i]);
+    }
+
+    void* alloc_stats_alloc_t::v_allocate(u32 size, u32 alignment)
+    {
+        const u32 align = math::max(alignment, (u32)sizeof(alloc_header_t));
+        ASSERT(align <= 0x8000);
+        byte* block = (byte*)m_allocator->allocate(size + align, align);
+        if (block == nullptr)
+            return nullptr;
+
+        byte*           ptr    = block + align;
+        alloc_header_t* header = (alloc_header_t*)ptr - 1;
+        header->m_size         = size;
+        header->m_scope        = nalloc_stats::current_scope();
+        header->m_offset       = (u16)align;
+        header->m_sequence     = natomic::fetch_add_relaxed(&m_sequence, (u64)1);
+
+        nalloc_stats::on_alloc(&m_stats, size);
+        if (header->m_scope < m_max_scopes)
+            nalloc_stats::on_alloc(&m_scope_stats[header->m_scope], size);
+
+        alloc_ring_t* ring = nalloc_trace::thread_ring();
+        if (ring != nullptr)
+            nalloc_trace::record(ring, alloc_event_t::ALLOC, ptr, size, header->m_scope, header->m_sequence);
+        return ptr;
+    }
+
+    void alloc_stats_alloc_t::v_deallocate(void* ptr)
+    {
+        if (ptr == nullptr)
+            return;
+
+        alloc_header_t* header   = (alloc_header_t*)ptr - 1;
+        const u64       sequence = natomic::load(&m_sequence);
+        const u64       lifetime = sequence - header->m_sequence - 1;  // number of allocations made in between
+
+        nalloc_stats::on_free(&m_stats, header->m_size, lifetime);
+        if (header->m_scope < m_max_scopes)
+            nalloc_stats::on_free(&m_scope_stats[header->m_scope], header->m_size, lifetime);
+
+        alloc_ring_t* ring = nalloc_trace::thread_ring();
+        if (ring != nullptr)
+            nalloc_trace::record(ring, alloc_event_t::FREE, ptr, header->m_size, header->m_scope, sequence);
+
+        m_allocator->deallocate((byte*)ptr - header->m_offset);
+    }
+
+}  // namespace ncore
@@ -6,6 +6,23 @@
 
 namespace ncore
 {
+    class empty_alloc_tracker_t : public alloc_tracker_t
+    {
+    public:
+        virtual void push(const char* file, int_t line)
+        {
+            CC_UNUSED(file);
+            CC_UNUSED(line);
+        }
+        virtual void pop() {}
+    };
+
+    static empty_alloc_tracker_t            s_empty_alloc_tracker;
+    static CC_THREAD_LOCAL alloc_tracker_t* s_alloc_tracker = &s_empty_alloc_tracker;
+
+    alloc_tracker_t* g_alloc_tracker() { return s_alloc_tracker; }
+    void             g_set_alloc_tracker(alloc_tracker_t* tracker) { s_alloc_tracker = tracker != nullptr ? tracker : &s_empty_alloc_tracker; }
+
     void* g_reallocate(alloc_t* alloc, void* ptr, u32 size, u32 new_size)
     {
         void*     newptr  = alloc->allocate(new_size, sizeof(void*));
@@ -2,6 +2,7 @@
 #include "ccore/c_bitvec.h"
 #include "ccore/c_math.h"
 #include "ccore/c_memory.h"
+#include "ccore/c_segment.h"
 
 #if defined(TARGET_MAC) || defined(TARGET_LINUX) || defined(TARGET_PC)
 
@@ -9,23 +10,92 @@ namespace ncore
 {
     namespace narena
     {
-        enum ownership_t
+        enum flags_t
         {
-            ARENA_IS_OWNER  = 0,
-            ARENA_NOT_OWNER = 1
+            ARENA_NOT_OWNER = 1,   // the arena does not own (release) the reserved virtual memory
+            ARENA_ACTIVE    = 2,   // the arena is in use
+            ARENA_PREFAULT  = 4,   // pages are prefaulted when they are committed
+            ARENA_CHAINED   = 8,   // the arena is a chain of reservations, 'm_base' points to an arena_link_t
+            ARENA_FILE      = 16,  // the arena is backed by a file, 'm_base' points to an arena_file_t
+            ARENA_COW       = 32,  // copy-on-write arena or a fork of one, 'm_base' points to an arena_file_t
         };
 
-        static bool s_new_arena(arena_t* arena, uint_t _reserve_size, uint_t _commit_size)
+        // A file backed arena starts with this header, the mapping of the file starts at 'm_base'
+        struct arena_file_t
         {
-            const u32    page_size       = v_alloc_get_page_size();
-            const u8     page_size_shift = v_alloc_get_page_size_shift();
-            const uint_t reserved_size   = math::alignUp(_reserve_size, (uint_t)page_size);
-            const uint_t commit_size     = math::alignUp(_commit_size, (uint_t)page_size);
+            u64         m_magic;  // c_file_magic
+            u64         m_pos;    // allocation position (relative to the start of the file) when last synced
+            u64         m_base;   // address the file was mapped at when last synced
+            vmem_file_t m_file;   // file handle while the arena is open
+        };
+
+        static const u64    c_file_magic       = 0x31414e4552414343ull;  // "CCARENA1"
+        static const uint_t c_file_header_size = 64;
+
+        static inline arena_file_t* s_file(arena_t* arena) { return (arena_file_t*)arena->m_base; }
+        static inline bool          s_has_file_header(arena_t* arena) { return (arena->m_flags & (ARENA_FILE | ARENA_COW)) != 0; }
+
+        // Every reservation (link) of a chained arena starts with this header, it holds the state of the
+        // previous link so that we can return to it when the current link is released.
+        struct arena_link_t
+        {
+            arena_link_t*          m_prev;                  // previous link (nullptr for the first link)
+            nsegment::allocator_t* m_segments;              // segment allocator the links come from (nullptr = v_alloc_reserve)
+            nsegment::node_t       m_node;                  // segment node of this link
+            u32                    m_reserved_pages;        // number of reserved pages of this link
+            uint_t                 m_link_size;             // (minimum) reserve size of a link
+            uint_t                 m_prev_pos;              // position in the previous link
+            u32                    m_prev_reserved_pages;   // reserved pages of the previous link
+            u32                    m_prev_committed_pages;  // committed pages of the previous link
+        };
+
+        static const uint_t c_link_header_size = (sizeof(arena_link_t) + 15) & ~(uint_t)15;
+
+        static inline arena_link_t* s_link(arena_t* arena) { return (arena_link_t*)arena->m_base; }
+
+        // The pages of a copy-on-write arena that is not snapshotted yet live in its memory file, decommit only drops the
+        // mapping of them, so the pages in [from_page, to_page) are also punched out of the file.
+        static void s_release_file_pages(arena_t* arena, u32 from_page, u32 to_page)
+        {
+            if ((arena->m_flags & (ARENA_FILE | ARENA_COW)) == (ARENA_FILE | ARENA_COW) && to_page > from_page)
+                v_file_punch(s_file(arena)->m_file, (u64)from_page << arena->m_page_size_shift, (u64)(to_page - from_page) << arena->m_page_size_shift);
+        }
+
+        // size of the header at the start of the arena (file or link header), this part is never released
+        static inline uint_t s_header_size(arena_t* arena)
+        {
+            if (s_has_file_header(arena))
+                return c_file_header_size;
+            return (arena->m_flags & ARENA_CHAINED) != 0 ? c_link_header_size : 0;
+        }
 
-            byte* base_address = (byte*)v_alloc_reserve(reserved_size);
+        static bool s_new_arena(arena_t* arena, uint_t _reserve_size, uint_t _commit_size, vmem_pages_t pages = VMEM_PAGES_DEFAULT, s32 numa_node = cNUMA_ANY_NODE)
+        {
+            byte*  base_address    = nullptr;
+            u8     page_size_shift = v_alloc_get_page_size_shift();
+            uint_t reserved_size   = 0;
+            if (pages == VMEM_PAGES_DEFAULT)
+            {
+                reserved_size = math::alignUp(_reserve_size, (uint_t)1 << page_size_shift);
+                base_address  = (byte*)v_alloc_reserve(reserved_size);
+            }
+            else
+            {
+                const u32 large_page_size = v_alloc_get_large_page_size();
+                reserved_size             = math::alignUp(_reserve_size, (uint_t)large_page_size);
+                base_address              = (byte*)v_alloc_reserve(reserved_size, pages);
+                if (pages != VMEM_PAGES_DEFAULT)
+                    page_size_shift = (u8)math::ilog2(large_page_size);
+            }
             if (base_address == nullptr)
                 return false;
 
+            // node affinity is best effort, nothing is faulted in yet so all pages will follow the policy
+            if (numa_node != cNUMA_ANY_NODE)
+                v_numa_bind(base_address, reserved_size, numa_node);
+
+            const uint_t commit_size = math::alignUp(_commit_size, (uint_t)1 << page_size_shift);
+
             if (commit_size > 0)
             {
                 const bool result = v_alloc_commit(base_address, commit_size);
@@ -41,7 +111,9 @@ namespace ncore
             arena->m_reserved_pages  = (u32)(reserved_size >> page_size_shift);
             arena->m_committed_pages = (u32)(commit_size >> page_size_shift);
             arena->m_page_size_shift = page_size_shift;
-            arena->m_ownership       = ARENA_IS_OWNER;
+            arena->m_flags           = arena->m_flags & ARENA_ACTIVE;
+            arena->m_commit_ahead    = 0;
+            arena->m_pages           = (u8)pages;
 
             return true;
         }
@@ -70,10 +142,10 @@ namespace ncore
             arena->m_reserved_pages  = 0;
             arena->m_committed_pages = 0;
             arena->m_page_size_shift = 0;
-            arena->m_ownership       = ARENA_IS_OWNER;
-            arena->m_active          = 0;
-            arena->m_padding1        = 0;
-            arena->m_padding2        = 0;
+            arena->m_flags           = 0;
+            arena->m_commit_ahead    = 0;
+            arena->m_pages           = VMEM_PAGES_DEFAULT;
+            nspinlock::init(arena->m_commit_lock);
         }
 
         static arena_t* s_pop_arena()
@@ -85,7 +157,7 @@ namespace ncore
                 s_arena_free_list_head = (arena_t*)arena->m_base;
 
                 s_reset_arena(arena);
-                arena->m_active = 1;
+                arena->m_flags = ARENA_ACTIVE;
                 return arena;
             }
 
@@ -93,14 +165,14 @@ namespace ncore
             if (arena == nullptr)
                 return nullptr;
             s_reset_arena(arena);
-            arena->m_active = 1;
+            arena->m_flags = ARENA_ACTIVE;
             return arena;
         }
 
         static void s_push_arena(arena_t* arena)
         {
             ASSERT(arena != nullptr);
-            ASSERT(arena->m_active == 1);
+            ASSERT((arena->m_flags & ARENA_ACTIVE) != 0);
             s_reset_arena(arena);
             arena->m_base          = (byte*)s_arena_free_list_head;
             s_arena_free_list_head = arena;
@@ -117,6 +189,17 @@ namespace ncore
             return arena;
         }
 
+        arena_t* new_arena(uint_t reserve_size, uint_t commit_size, vmem_pages_t pages, s32 numa_node)
+        {
+            arena_t* arena = s_pop_arena();
+            if (!s_new_arena(arena, reserve_size, commit_size, pages, numa_node))
+            {
+                s_push_arena(arena);
+                return nullptr;
+            }
+            return arena;
+        }
+
         arena_t* init_arena(void* base, uint_t reserve_size, uint_t commit_size)
         {
             arena_t* arena = s_pop_arena();
@@ -135,15 +218,33 @@ namespace ncore
             arena->m_reserved_pages  = (u32)(reserve_size >> page_size_shift);
             arena->m_committed_pages = (u32)(commit_size >> page_size_shift);
             arena->m_page_size_shift = page_size_shift;
-            arena->m_ownership       = ARENA_NOT_OWNER;
+            arena->m_flags           = ARENA_ACTIVE | ARENA_NOT_OWNER;
             return arena;
         }
 
+        // commit pages [from_page, to_page), a file backed arena grows the file and maps the new part
+        static bool s_commit_range(arena_t* arena, u32 from_page, u32 to_page)
+        {
+            const s8     page_size_shift = arena->m_page_size_shift;
+            byte*        address         = base_ptr(arena) + ((uint_t)from_page << page_size_shift);
+            const uint_t size            = (uint_t)(to_page - from_page) << page_size_shift;
+            if ((arena->m_flags & ARENA_FILE) != 0)
+            {
+                const vmem_file_t file      = s_file(arena)->m_file;
+                const u64         file_size = (u64)to_page << page_size_shift;
+                if (v_file_size(file) < file_size && !v_file_resize(file, file_size))
+                    return false;
+                return v_file_map(file, (u64)from_page << page_size_shift, address, size);
+            }
+            return v_alloc_commit(address, size);
+        }
+
         bool commit(arena_t* arena, uint_t committed_size_in_bytes)
         {
+            spinlock_scope_t lock(arena->m_commit_lock);
+
             const u32 want_committed_pages    = math::max((u32)(math::alignUp(committed_size_in_bytes, (uint_t)1 << arena->m_page_size_shift) >> arena->m_page_size_shift), (u32)1);
             const u32 total_reserved_pages    = arena->m_reserved_pages;
-            const s8  page_size_shift         = arena->m_page_size_shift;
             const u32 current_committed_pages = arena->m_committed_pages;
 
             if (want_committed_pages > current_committed_pages)
@@ -151,17 +252,18 @@ namespace ncore
                 const uint_t extra_needed_pages = (uint_t)(want_committed_pages - current_committed_pages);
                 if ((current_committed_pages + extra_needed_pages) > total_reserved_pages)
                     return false;
-                if (!v_alloc_commit(base_ptr(arena) + ((uint_t)current_committed_pages << page_size_shift), extra_needed_pages << page_size_shift))
+                if (!s_commit_range(arena, current_committed_pages, want_committed_pages))
                     return false;
             }
 
-            arena->m_committed_pages = want_committed_pages;
+            natomic::store((u32 volatile*)&arena->m_committed_pages, want_committed_pages);
             return true;
         }
 
         bool recommit(arena_t* arena, uint_t committed_size_in_bytes)
         {
-            const u32 want_committed_pages    = (u32)(math::alignUp(committed_size_in_bytes, (uint_t)1 << arena->m_page_size_shift) >> arena->m_page_size_shift);
+            const u32 min_committed_pages     = (u32)(math::alignUp(s_header_size(arena), (uint_t)1 << arena->m_page_size_shift) >> arena->m_page_size_shift);  // the page(s) with the file or link header stay
+            const u32 want_committed_pages    = math::max((u32)(math::alignUp(committed_size_in_bytes, (uint_t)1 << arena->m_page_size_shift) >> arena->m_page_size_shift), min_committed_pages);
             const u32 total_reserved_pages    = arena->m_reserved_pages;
             const s8  page_size_shift         = arena->m_page_size_shift;
             const u32 current_committed_pages = arena->m_committed_pages;
@@ -171,7 +273,7 @@ namespace ncore
                 const uint_t extra_needed_pages = (uint_t)(want_committed_pages - current_committed_pages);
                 if ((current_committed_pages + extra_needed_pages) > total_reserved_pages)
                     return false;
-                if (!v_alloc_commit(base_ptr(arena) + ((uint_t)current_committed_pages << page_size_shift), extra_needed_pages << page_size_shift))
+                if (!s_commit_range(arena, current_committed_pages, want_committed_pages))
                     return false;
             }
             else if (want_committed_pages < current_committed_pages)
@@ -181,15 +283,393 @@ namespace ncore
                 byte*       decommit_start         = base_ptr(arena) + (want_committed_pages << page_size_shift);
                 if (!v_alloc_decommit(decommit_start, decommit_size_in_bytes))
                     return false;
+                s_release_file_pages(arena, want_committed_pages, current_committed_pages);
 
-                if (arena->m_pos > (want_committed_pages << page_size_shift))
-                    arena->m_pos = want_committed_pages << page_size_shift;
+                const uint_t max_pos = math::max((uint_t)want_committed_pages << page_size_shift, s_header_size(arena));
+                if (arena->m_pos > max_pos)
+                    arena->m_pos = max_pos;
             }
 
             arena->m_committed_pages = want_committed_pages;
             return true;
         }
 
+        static inline u32 s_commit_ahead_pages(arena_t* arena) { return arena->m_commit_ahead == 0 ? 0 : ((u32)1 << (arena->m_commit_ahead - 1)); }
+
+        // Commit pages [from_page, to_page) and publish the new committed page count, the caller holds the commit lock.
+        static bool s_commit_pages_locked(arena_t* arena, u32 from_page, u32 to_page)
+        {
+            if (!s_commit_range(arena, from_page, to_page))
+                return false;
+            natomic::store((u32 volatile*)&arena->m_committed_pages, to_page);
+            return true;
+        }
+
+        // Make sure that the range [0, end_pos) is committed, including the commit-ahead window. The commit of
+        // a page range happens only once, threads that find their range already committed do not take the lock.
+        static bool s_commit_to(arena_t* arena, uint_t end_pos)
+        {
+            const u32 need_committed_pages = (u32)(math::alignUp(end_pos, (uint_t)1 << arena->m_page_size_shift) >> arena->m_page_size_shift);
+            if (need_committed_pages <= natomic::load((u32 volatile*)&arena->m_committed_pages))
+                return true;
+            if (need_committed_pages > arena->m_reserved_pages)
+                return false;
+
+            u32 from_page, to_page;
+            {
+                spinlock_scope_t lock(arena->m_commit_lock);
+                from_page = arena->m_committed_pages;
+                if (need_committed_pages <= from_page)
+                    return true;  // another thread committed this range while we were waiting
+                to_page = math::min(need_committed_pages + s_commit_ahead_pages(arena), arena->m_reserved_pages);
+                if (!s_commit_pages_locked(arena, from_page, to_page))
+                    return false;
+            }
+
+            // prefault outside of the lock, the pages are already visible to other threads
+            if ((arena->m_flags & ARENA_PREFAULT) != 0)
+                v_alloc_prefault(base_ptr(arena) + ((uint_t)from_page << arena->m_page_size_shift), (uint_t)(to_page - from_page) << arena->m_page_size_shift);
+            return true;
+        }
+
+        // reserve a link and commit its first page(s) so that the header can be written
+        static arena_link_t* s_new_link(nsegment::allocator_t* segments, uint_t size, u8 page_size_shift)
+        {
+            byte*            base  = nullptr;
+            nsegment::node_t node  = nsegment::cINVALID_NODE;
+            u32              pages = 0;
+            if (segments != nullptr)
+            {
+                node = nsegment::alloc_node(segments, size);
+                if (node == nsegment::cINVALID_NODE)
+                    return nullptr;
+                base = (byte*)nsegment::get_address(segments, node, pages);
+            }
+            else
+            {
+                pages = (u32)(math::alignUp(size, (uint_t)1 << page_size_shift) >> page_size_shift);
+                base  = (byte*)v_alloc_reserve((uint_t)pages << page_size_shift);
+                if (base == nullptr)
+                    return nullptr;
+            }
+
+            const uint_t header_size = math::alignUp(c_link_header_size, (uint_t)1 << page_size_shift);
+            if (!v_alloc_commit(base, header_size))
+            {
+                if (segments != nullptr)
+                    nsegment::dealloc_node(segments, node);
+                else
+                    v_alloc_release(base, (uint_t)pages << page_size_shift);
+                return nullptr;
+            }
+
+            arena_link_t* link     = (arena_link_t*)base;
+            link->m_prev           = nullptr;
+            link->m_segments       = segments;
+            link->m_node           = node;
+            link->m_reserved_pages = pages;
+            link->m_link_size      = size;
+            return link;
+        }
+
+        // decommit and release a link, the segment allocator does not track the pages that the arena committed
+        static void s_release_link(arena_link_t* link, u32 committed_pages, u8 page_size_shift)
+        {
+            nsegment::allocator_t* segments = link->m_segments;
+            nsegment::node_t       node     = link->m_node;
+            const uint_t           reserved = (uint_t)link->m_reserved_pages << page_size_shift;
+            v_alloc_decommit(link, (uint_t)committed_pages << page_size_shift);
+            if (segments != nullptr)
+                nsegment::dealloc_node(segments, node);
+            else
+                v_alloc_release(link, reserved);
+        }
+
+        // chain a new link that can hold at least 'size' bytes, the arena continues in the new link
+        static bool s_chain_link(arena_t* arena, uint_t size)
+        {
+            arena_link_t* prev      = s_link(arena);
+            const uint_t  page_size = (uint_t)1 << arena->m_page_size_shift;
+            const uint_t  link_size = math::max(prev->m_link_size, math::alignUp(c_link_header_size + size, page_size));
+            arena_link_t* link      = s_new_link(prev->m_segments, link_size, arena->m_page_size_shift);
+            if (link == nullptr)
+                return false;
+
+            link->m_link_size            = prev->m_link_size;
+            link->m_prev                 = prev;
+            link->m_prev_pos             = arena->m_pos;
+            link->m_prev_reserved_pages  = arena->m_reserved_pages;
+            link->m_prev_committed_pages = arena->m_committed_pages;
+
+            arena->m_base            = (byte*)link;
+            arena->m_pos             = c_link_header_size;
+            arena->m_reserved_pages  = link->m_reserved_pages;
+            arena->m_committed_pages = (u32)(math::alignUp(c_link_header_size, page_size) >> arena->m_page_size_shift);
+            return true;
+        }
+
+        // release the current link and continue in the previous link where we left it
+        static void s_pop_link(arena_t* arena)
+        {
+            arena_link_t* link = s_link(arena);
+            ASSERT(link->m_prev != nullptr);
+
+            const u32 committed_pages = arena->m_committed_pages;
+            arena->m_base             = (byte*)link->m_prev;
+            arena->m_pos              = link->m_prev_pos;
+            arena->m_reserved_pages   = link->m_prev_reserved_pages;
+            arena->m_committed_pages  = link->m_prev_committed_pages;
+            s_release_link(link, committed_pages, arena->m_page_size_shift);
+        }
+
+        static inline bool s_chain_needed(arena_t* arena, uint_t end_pos) { return (arena->m_flags & ARENA_CHAINED) != 0 && end_pos > reserved_size(arena); }
+
+        arena_t* new_chained_arena(uint_t link_reserve_size, uint_t commit_size) { return new_chained_arena(nullptr, link_reserve_size, commit_size); }
+
+        arena_t* new_chained_arena(nsegment::allocator_t* segments, uint_t link_reserve_size, uint_t commit_size)
+        {
+            arena_t* arena = s_pop_arena();
+            if (arena == nullptr)
+                return nullptr;
+
+            const u8      page_size_shift = segments != nullptr ? segments->m_pagesize_shift : v_alloc_get_page_size_shift();
+            const uint_t  page_size       = (uint_t)1 << page_size_shift;
+            arena_link_t* link            = s_new_link(segments, math::alignUp(math::max(link_reserve_size, c_link_header_size + commit_size), page_size), page_size_shift);
+            if (link == nullptr)
+            {
+                s_push_arena(arena);
+                return nullptr;
+            }
+
+            arena->m_base            = (byte*)link;
+            arena->m_pos             = c_link_header_size;
+            arena->m_reserved_pages  = link->m_reserved_pages;
+            arena->m_committed_pages = (u32)(math::alignUp(c_link_header_size, page_size) >> page_size_shift);
+            arena->m_page_size_shift = page_size_shift;
+            arena->m_flags           = ARENA_ACTIVE | ARENA_CHAINED;
+            if (!s_commit_to(arena, c_link_header_size + commit_size))
+            {
+                destroy(arena);
+                return nullptr;
+            }
+            return arena;
+        }
+
+        u32 num_links(arena_t* arena)
+        {
+            if ((arena->m_flags & ARENA_CHAINED) == 0)
+                return 1;
+            u32 count = 0;
+            for (arena_link_t* link = s_link(arena); link != nullptr; link = link->m_prev)
+                ++count;
+            return count;
+        }
+
+        // a file that is not empty has to be an arena file with a valid position, anything else is not touched
+        static bool s_read_file_header(vmem_file_t file, u64 file_size, arena_file_t& header)
+        {
+            g_memclr(&header, sizeof(arena_file_t));
+            if (file_size == 0)
+                return true;
+            if (file_size < c_file_header_size || !v_file_read(file, 0, &header, sizeof(arena_file_t)))
+                return false;
+            return header.m_magic == c_file_magic && header.m_pos >= c_file_header_size && header.m_pos <= file_size;
+        }
+
+        arena_t* open_file_arena(const char* path, uint_t reserve_size, uint_t commit_size, int_t* relocation)
+        {
+            if (relocation != nullptr)
+                *relocation = 0;
+
+            const vmem_file_t file = v_file_open(path);
+            if (file == cINVALID_VMEM_FILE)
+                return nullptr;
+
+            arena_file_t header;
+            const u64    file_size = v_file_size(file);
+            if (!s_read_file_header(file, file_size, header))
+            {
+                v_file_close(file);
+                return nullptr;
+            }
+
+            const u8     page_size_shift = v_alloc_get_page_size_shift();
+            const uint_t page_size       = (uint_t)1 << page_size_shift;
+            const uint_t map_size        = math::alignUp(math::max((uint_t)file_size, c_file_header_size + commit_size), page_size);
+            const uint_t reserved_size   = math::alignUp(math::max(reserve_size, map_size), page_size);
+
+            // map the file at the address it had before so that absolute pointers in it stay valid
+            arena_t* arena = s_pop_arena();
+            byte*    base  = arena != nullptr ? (byte*)v_alloc_reserve_at((void*)(ptr_t)header.m_base, reserved_size) : nullptr;
+            if (base == nullptr || (file_size < map_size && !v_file_resize(file, map_size)) || !v_file_map(file, 0, base, map_size))
+            {
+                if (base != nullptr)
+                    v_alloc_release(base, reserved_size);
+                if (arena != nullptr)
+                    s_push_arena(arena);
+                v_file_close(file);
+                return nullptr;
+            }
+
+            arena_file_t* file_header = (arena_file_t*)base;
+            if (file_size == 0)
+            {
+                file_header->m_magic = c_file_magic;
+                file_header->m_pos   = c_file_header_size;
+            }
+            else if (relocation != nullptr)
+            {
+                *relocation = (int_t)((ptr_t)base - (ptr_t)file_header->m_base);
+            }
+            file_header->m_base = (u64)(ptr_t)base;
+            file_header->m_file = file;
+
+            arena->m_base            = base;
+            arena->m_pos             = (uint_t)file_header->m_pos;
+            arena->m_reserved_pages  = (u32)(reserved_size >> page_size_shift);
+            arena->m_committed_pages = (u32)(map_size >> page_size_shift);
+            arena->m_page_size_shift = page_size_shift;
+            arena->m_flags           = ARENA_ACTIVE | ARENA_FILE;
+            return arena;
+        }
+
+        bool sync(arena_t* arena)
+        {
+            if ((arena->m_flags & ARENA_FILE) == 0)
+                return false;
+            s_file(arena)->m_pos = natomic::load_relaxed((uint_t volatile*)&arena->m_pos);
+            return v_file_sync(base_ptr(arena), committed_size(arena));
+        }
+
+        void* file_root(arena_t* arena)
+        {
+            ASSERT(s_has_file_header(arena));
+            return base_ptr(arena) + c_file_header_size;
+        }
+
+        arena_t* new_cow_arena(uint_t reserve_size, uint_t commit_size)
+        {
+            const vmem_file_t file = v_file_open_anonymous();
+            if (file == cINVALID_VMEM_FILE)
+                return nullptr;
+
+            const u8     page_size_shift = v_alloc_get_page_size_shift();
+            const uint_t page_size       = (uint_t)1 << page_size_shift;
+            const uint_t map_size        = math::alignUp(c_file_header_size + commit_size, page_size);
+            const uint_t reserved_size   = math::alignUp(math::max(reserve_size, map_size), page_size);
+
+            arena_t* arena = s_pop_arena();
+            byte*    base  = arena != nullptr ? (byte*)v_alloc_reserve(reserved_size) : nullptr;
+            if (base == nullptr || !v_file_resize(file, map_size) || !v_file_map(file, 0, base, map_size))
+            {
+                if (base != nullptr)
+                    v_alloc_release(base, reserved_size);
+                if (arena != nullptr)
+                    s_push_arena(arena);
+                v_file_close(file);
+                return nullptr;
+            }
+
+            arena_file_t* header = (arena_file_t*)base;
+            header->m_magic      = c_file_magic;
+            header->m_pos        = c_file_header_size;
+            header->m_base       = (u64)(ptr_t)base;
+            header->m_file       = file;
+
+            arena->m_base            = base;
+            arena->m_pos             = c_file_header_size;
+            arena->m_reserved_pages  = (u32)(reserved_size >> page_size_shift);
+            arena->m_committed_pages = (u32)(map_size >> page_size_shift);
+            arena->m_page_size_shift = page_size_shift;
+            arena->m_flags           = ARENA_ACTIVE | ARENA_FILE | ARENA_COW;
+            return arena;
+        }
+
+        bool snapshot(arena_t* arena, arena_snapshot_t& snapshot)
+        {
+            snapshot.m_file = cINVALID_VMEM_FILE;
+            if ((arena->m_flags & (ARENA_NOT_OWNER | ARENA_CHAINED)) != 0 || arena->m_pages != VMEM_PAGES_DEFAULT)
+                return false;
+
+            const bool   shared    = (arena->m_flags & ARENA_FILE) != 0;
+            const uint_t committed = committed_size(arena);
+            vmem_file_t  file      = cINVALID_VMEM_FILE;
+            if (shared)
+            {
+                if ((arena->m_flags & ARENA_COW) == 0)
+                    return false;  // the pages of a file backed arena belong to the file
+
+                // the pages are in the memory file already, it is frozen by turning the arena into a private mapping of it
+                file                  = s_file(arena)->m_file;
+                s_file(arena)->m_file = cINVALID_VMEM_FILE;
+            }
+            else
+            {
+                // the pages are private, the used ones are copied into a new memory file
+                const uint_t used = math::alignUp(arena->m_pos, page_size(arena));
+                file              = v_file_open_anonymous();
+                if (file == cINVALID_VMEM_FILE || !v_file_resize(file, committed) || !v_file_write(file, 0, base_ptr(arena), used))
+                {
+                    v_file_close(file);
+                    return false;
+                }
+            }
+
+            // the content does not change, the private pages of the arena are replaced by the pages of the file
+            if (committed > 0 && !v_file_map_private(file, 0, base_ptr(arena), committed))
+            {
+                if (shared)
+                    s_file(arena)->m_file = file;
+                else
+                    v_file_close(file);
+                return false;
+            }
+
+            snapshot.m_file            = file;
+            snapshot.m_pos             = arena->m_pos;
+            snapshot.m_reserved_pages  = arena->m_reserved_pages;
+            snapshot.m_committed_pages = arena->m_committed_pages;
+            snapshot.m_page_size_shift = arena->m_page_size_shift;
+            snapshot.m_flags           = arena->m_flags & ARENA_COW;
+            arena->m_flags &= ~ARENA_FILE;
+            return true;
+        }
+
+        arena_t* fork(arena_snapshot_t const& snapshot)
+        {
+            if (snapshot.m_file == cINVALID_VMEM_FILE)
+                return nullptr;
+
+            const uint_t reserved_size  = (uint_t)snapshot.m_reserved_pages << snapshot.m_page_size_shift;
+            const uint_t committed_size = (uint_t)snapshot.m_committed_pages << snapshot.m_page_size_shift;
+
+            arena_t* arena = s_pop_arena();
+            byte*    base  = arena != nullptr ? (byte*)v_alloc_reserve(reserved_size) : nullptr;
+            if (base == nullptr || (committed_size > 0 && !v_file_map_private(snapshot.m_file, 0, base, committed_size)))
+            {
+                if (base != nullptr)
+                    v_alloc_release(base, reserved_size);
+                if (arena != nullptr)
+                    s_push_arena(arena);
+                return nullptr;
+            }
+
+            arena->m_base            = base;
+            arena->m_pos             = snapshot.m_pos;
+            arena->m_reserved_pages  = snapshot.m_reserved_pages;
+            arena->m_committed_pages = snapshot.m_committed_pages;
+            arena->m_page_size_shift = snapshot.m_page_size_shift;
+            arena->m_flags           = ARENA_ACTIVE | snapshot.m_flags;
+            return arena;
+        }
+
+        // the mappings of the forks keep the memory file alive
+        void release(arena_snapshot_t& snapshot)
+        {
+            v_file_close(snapshot.m_file);
+            snapshot.m_file = cINVALID_VMEM_FILE;
+        }
+
         // commits (allocate) size number of bytes and possibly grows the committed region.
         // returns a pointer to the allocated memory or nullptr if allocation failed.
         void* alloc(arena_t* arena, uint_t size_in_bytes)
@@ -197,20 +677,17 @@ namespace ncore
             if (size_in_bytes == 0)
                 return nullptr;  // we will consider this an error
 
+            // A chained arena continues in a new link when the current link cannot hold the allocation
+            if (s_chain_needed(arena, arena->m_pos + size_in_bytes) && !s_chain_link(arena, size_in_bytes))
+                return nullptr;
+
             // When allocating, will our pointer stay within our committed region, if not we
             // need to see if we can commit the needed extra pages.
-            const u32 need_committed_pages = (u32)(math::alignUp(arena->m_pos + size_in_bytes, (uint_t)1 << arena->m_page_size_shift) >> arena->m_page_size_shift);
-            if (need_committed_pages > arena->m_committed_pages)
-            {
-                if (need_committed_pages > arena->m_reserved_pages)
-                    return nullptr;
-                const bool result = v_alloc_commit(base_ptr(arena) + ((uint_t)arena->m_committed_pages << arena->m_page_size_shift), (need_committed_pages - arena->m_committed_pages) << arena->m_page_size_shift);
-                if (!result)
-                    return nullptr;
-                arena->m_committed_pages = need_committed_pages;
-            }
+            if (!s_commit_to(arena, arena->m_pos + size_in_bytes))
+                return nullptr;
+            // 'warm' may read the position from another thread
             void* ptr = current_address(arena);
-            arena->m_pos += size_in_bytes;
+            natomic::store_relaxed((uint_t volatile*)&arena->m_pos, arena->m_pos + size_in_bytes);
             return ptr;
         }
 
@@ -224,7 +701,15 @@ namespace ncore
 
             // align the position to the requested alignment
             // const int_t aligning = (math::alignUp(arena->m_pos, (int_t)align) - arena->m_pos);
-            const u32 aligning = (((u32)arena->m_pos + (align - 1)) & ~(align - 1)) - (u32)arena->m_pos;
+            u32 aligning = (((u32)arena->m_pos + (align - 1)) & ~(align - 1)) - (u32)arena->m_pos;
+
+            // chain a new link up front, the alignment padding depends on the position in the link
+            if (s_chain_needed(arena, arena->m_pos + size + aligning))
+            {
+                if (!s_chain_link(arena, size + align))
+                    return nullptr;
+                aligning = (((u32)arena->m_pos + (align - 1)) & ~(align - 1)) - (u32)arena->m_pos;
+            }
 
             // we let our core commit function handle the rest
             void* ptr = alloc(arena, size + aligning);
@@ -272,6 +757,13 @@ namespace ncore
         // restore the arena to a saved address
         void restore_address(arena_t* arena, void* ptr)
         {
+            // a chained arena releases the links that were chained after the saved address
+            if ((arena->m_flags & ARENA_CHAINED) != 0)
+            {
+                while (((byte*)ptr < (base_ptr(arena) + c_link_header_size) || (byte*)ptr > (base_ptr(arena) + reserved_size(arena))) && s_link(arena)->m_prev != nullptr)
+                    s_pop_link(arena);
+            }
+
             ASSERT(ptr >= base_ptr(arena));
             const uint_t position = (uint_t)((byte*)ptr - base_ptr(arena));
             ASSERT(position <= (arena->m_committed_pages << arena->m_page_size_shift));
@@ -280,7 +772,7 @@ namespace ncore
             if (arena->m_pos > position && (arena->m_pos - position) > 0)
                 nmem::memset(base_ptr(arena) + position, 0xFEFEFEFE, arena->m_pos - position);
     #endif
-            arena->m_pos = position;
+            natomic::store_relaxed((uint_t volatile*)&arena->m_pos, position);
         }
 
         void shrink(arena_t* arena)
@@ -297,23 +789,173 @@ namespace ncore
                 {
                     if (v_alloc_decommit(decommit_start, decommit_size_in_bytes))
                     {
+                        s_release_file_pages(arena, used_committed_pages, arena->m_committed_pages);
                         arena->m_committed_pages = used_committed_pages;
                     }
                 }
             }
         }
 
-        void reset(arena_t* arena) { arena->m_pos = 0; }
+        void reset(arena_t* arena)
+        {
+            if ((arena->m_flags & ARENA_CHAINED) != 0)
+            {
+                while (s_link(arena)->m_prev != nullptr)
+                    s_pop_link(arena);
+                arena->m_pos = c_link_header_size;
+                return;
+            }
+            natomic::store_relaxed((uint_t volatile*)&arena->m_pos, s_has_file_header(arena) ? c_file_header_size : (uint_t)0);
+        }
+
+        void shrink(arena_t* arena, vmem_decommit_policy_t* policy)
+        {
+            const uint_t used_bytes           = math::alignUp(arena->m_pos, ((uint_t)1 << arena->m_page_size_shift));
+            const u32    used_committed_pages = (u32)(used_bytes >> arena->m_page_size_shift);
+            if (used_committed_pages < arena->m_committed_pages)
+            {
+                // the whole range beyond the used pages is unused, so nothing is retained yet
+                const uint_t unused_size = (uint_t)(arena->m_committed_pages - used_committed_pages) << arena->m_page_size_shift;
+                const uint_t kept_size   = v_decommit(policy, base_ptr(arena) + used_bytes, unused_size, 0, arena->m_page_size_shift);
+                const u32    kept_pages  = used_committed_pages + (u32)(kept_size >> arena->m_page_size_shift);
+                s_release_file_pages(arena, kept_pages, arena->m_committed_pages);
+                arena->m_committed_pages = kept_pages;
+            }
+        }
+
+        void reset(arena_t* arena, vmem_decommit_policy_t* policy)
+        {
+            reset(arena);
+            shrink(arena, policy);
+        }
+
+        void set_commit_ahead(arena_t* arena, uint_t size_in_bytes)
+        {
+            const u32 pages       = (u32)(math::alignUp(size_in_bytes, (uint_t)1 << arena->m_page_size_shift) >> arena->m_page_size_shift);
+            arena->m_commit_ahead = pages == 0 ? 0 : (u8)(math::ilog2(math::ceilpo2(pages)) + 1);
+        }
+
+        void set_prefault(arena_t* arena, bool prefault)
+        {
+            if (!prefault)
+            {
+                arena->m_flags &= ~ARENA_PREFAULT;
+                return;
+            }
+
+            arena->m_flags |= ARENA_PREFAULT;
+
+            // prefault the pages that are committed but not used yet
+            const uint_t used_size      = math::alignDown(arena->m_pos, (uint_t)1 << arena->m_page_size_shift);
+            const uint_t committed_size = (uint_t)natomic::load((u32 volatile*)&arena->m_committed_pages) << arena->m_page_size_shift;
+            if (committed_size > used_size)
+                v_alloc_prefault(base_ptr(arena) + used_size, committed_size - used_size);
+        }
+
+        u32 warm(arena_t* arena, u32 num_pages)
+        {
+            const u32 pos_page = (u32)(natomic::load_relaxed((uint_t volatile*)&arena->m_pos) >> arena->m_page_size_shift);
+            const u32 to_page  = math::min(pos_page + num_pages, arena->m_reserved_pages);
+            if (to_page <= natomic::load((u32 volatile*)&arena->m_committed_pages))
+                return 0;
+
+            u32 from_page;
+            {
+                spinlock_scope_t lock(arena->m_commit_lock);
+                from_page = arena->m_committed_pages;
+                if (to_page <= from_page)
+                    return 0;
+                if (!s_commit_pages_locked(arena, from_page, to_page))
+                    return 0;
+            }
+
+            v_alloc_prefault(base_ptr(arena) + ((uint_t)from_page << arena->m_page_size_shift), (uint_t)(to_page - from_page) << arena->m_page_size_shift);
+            return to_page - from_page;
+        }
+
+        void* alloc_concurrent(arena_t* arena, uint_t size)
+        {
+            if (size == 0)
+                return nullptr;
+
+            const uint_t pos = natomic::fetch_add((uint_t volatile*)&arena->m_pos, size);
+            if (!s_commit_to(arena, pos + size))
+                return nullptr;
+            return base_ptr(arena) + pos;
+        }
+
+        void* alloc_concurrent(arena_t* arena, uint_t size, u32 align)
+        {
+            if (size == 0)
+                return nullptr;
+
+            ASSERTS(math::ispo2(align), "Error: alignment value should be a power of 2");
+            const uint_t mask = (uint_t)align - 1;
+
+            // Claim exactly the aligned range, when another thread moved the position first the
+            // aligned position is recomputed from the new position, so no padding is wasted.
+            uint_t pos     = natomic::load_relaxed((uint_t volatile*)&arena->m_pos);
+            uint_t aligned = (pos + mask) & ~mask;
+            while (!natomic::cas((uint_t volatile*)&arena->m_pos, pos, aligned + size))
+            {
+                pos     = natomic::load_relaxed((uint_t volatile*)&arena->m_pos);
+                aligned = (pos + mask) & ~mask;
+            }
+
+            if (!s_commit_to(arena, aligned + size))
+                return nullptr;
+            return base_ptr(arena) + aligned;
+        }
+
+        void* alloc_and_zero_concurrent(arena_t* arena, uint_t size)
+        {
+            void* ptr = alloc_concurrent(arena, size);
+            if (ptr != nullptr)
+                nmem::memset(ptr, 0, size);
+            return ptr;
+        }
+
+        void* alloc_and_zero_concurrent(arena_t* arena, uint_t size, u32 alignment)
+        {
+            void* ptr = alloc_concurrent(arena, size, alignment);
+            if (ptr != nullptr)
+                nmem::memset(ptr, 0, size);
+            return ptr;
+        }
 
         bool destroy(arena_t*& arena)
         {
             if (arena == nullptr)
                 return false;
 
+            if ((arena->m_flags & ARENA_CHAINED) != 0)
+            {
+                while (s_link(arena)->m_prev != nullptr)
+                    s_pop_link(arena);
+                s_release_link(s_link(arena), arena->m_committed_pages, arena->m_page_size_shift);
+                s_push_arena(arena);
+                arena = nullptr;
+                return true;
+            }
+
+            if ((arena->m_flags & ARENA_FILE) != 0)
+            {
+                // the mapping is released after the position and the pages are written to the file
+                const vmem_file_t file = s_file(arena)->m_file;
+                s_file(arena)->m_file  = cINVALID_VMEM_FILE;
+                if ((arena->m_flags & ARENA_COW) == 0)
+                    sync(arena);
+                v_alloc_release(base_ptr(arena), reserved_size(arena));
+                v_file_close(file);
+                s_push_arena(arena);
+                arena = nullptr;
+                return true;
+            }
+
             byte* base_address = base_ptr(arena);
             if (arena->m_committed_pages > 0)
                 v_alloc_decommit(base_address, (uint_t)arena->m_committed_pages << arena->m_page_size_shift);
-            if (arena->m_ownership == ARENA_IS_OWNER)
+            if ((arena->m_flags & ARENA_NOT_OWNER) == 0)
                 v_alloc_release(base_address, (uint_t)arena->m_reserved_pages << arena->m_page_size_shift);
 
             s_push_arena(arena);
@@ -322,7 +964,143 @@ namespace ncore
             return true;
         }
 
+        bool new_numa_arenas(numa_arenas_t* set, uint_t reserve_size, uint_t commit_size)
+        {
+            set->m_num_nodes = v_numa_num_nodes();
+            for (u32 node = 0; node < cNUMA_MAX_NODES; ++node)
+                set->m_arenas[node] = nullptr;
+
+            for (u32 node = 0; node < set->m_num_nodes; ++node)
+            {
+                set->m_arenas[node] = new_arena(reserve_size, commit_size, VMEM_PAGES_DEFAULT, (s32)node);
+                if (set->m_arenas[node] == nullptr)
+                {
+                    destroy(set);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void destroy(numa_arenas_t* set)
+        {
+            for (u32 node = 0; node < set->m_num_nodes; ++node)
+            {
+                if (set->m_arenas[node] != nullptr)
+                    destroy(set->m_arenas[node]);
+            }
+            set->m_num_nodes = 0;
+        }
+
+        arena_t* local_arena(numa_arenas_t* set)
+        {
+            const u32 node = (u32)v_numa_current_node();
+            return set->m_arenas[node < set->m_num_nodes ? node : 0];
+        }
+
     }  // namespace narena
+
+    namespace nscratch
+    {
+        static uint_t s_reserve_size = 256 * cMB;
+        static uint_t s_commit_size  = 64 * cKB;
+
+        // The scratch arenas are embedded in the thread local state and thus do not come from the
+        // (single-threaded) internal arena pool, they are released when the thread exits.
+        struct scratch_tls_t
+        {
+            arena_t m_arenas[2];
+            uint_t  m_high_water;
+
+            ~scratch_tls_t() { release(); }
+        };
+
+        static CC_THREAD_LOCAL scratch_tls_t s_tls;
+
+        static void s_release_arena(arena_t* arena)
+        {
+            if (arena->m_base == nullptr)
+                return;
+            byte* base_address = narena::base_ptr(arena);
+            if (arena->m_committed_pages > 0)
+                v_alloc_decommit(base_address, (uint_t)arena->m_committed_pages << arena->m_page_size_shift);
+            v_alloc_release(base_address, (uint_t)arena->m_reserved_pages << arena->m_page_size_shift);
+            narena::s_reset_arena(arena);
+        }
+
+        static inline void s_update_high_water(arena_t* arena)
+        {
+            if (arena->m_pos > s_tls.m_high_water)
+                s_tls.m_high_water = arena->m_pos;
+        }
+
+        void configure(uint_t reserve_size, uint_t commit_size)
+        {
+            ASSERT(commit_size <= reserve_size);
+            s_reserve_size = reserve_size;
+            s_commit_size  = commit_size;
+        }
+
+        arena_t* get(arena_t* const* conflicts, u32 count)
+        {
+            for (s32 i = 0; i < 2; ++i)
+            {
+                arena_t* arena       = &s_tls.m_arenas[i];
+                bool     conflicting = false;
+                for (u32 c = 0; c < count && !conflicting; ++c)
+                    conflicting = (conflicts[c] == arena);
+                if (conflicting)
+                    continue;
+
+                if (arena->m_base == nullptr)
+                {
+                    if (!narena::s_new_arena(arena, s_reserve_size, s_commit_size))
+                        return nullptr;
+                    arena->m_flags |= narena::ARENA_ACTIVE;
+                }
+                return arena;
+            }
+            return nullptr;
+        }
+
+        arena_t* get(arena_t* conflict) { return get(&conflict, conflict != nullptr ? 1 : 0); }
+
+        uint_t high_water()
+        {
+            s_update_high_water(&s_tls.m_arenas[0]);
+            s_update_high_water(&s_tls.m_arenas[1]);
+            return s_tls.m_high_water;
+        }
+
+        void reset_high_water() { s_tls.m_high_water = 0; }
+
+        void release()
+        {
+            s_release_arena(&s_tls.m_arenas[0]);
+            s_release_arena(&s_tls.m_arenas[1]);
+        }
+    }  // namespace nscratch
+
+    scratch_t::scratch_t(arena_t* conflict)
+    {
+        m_point.m_arena   = nscratch::get(conflict);
+        m_point.m_address = m_point.m_arena != nullptr ? narena::current_address(m_point.m_arena) : nullptr;
+    }
+
+    scratch_t::scratch_t(arena_t* const* conflicts, u32 count)
+    {
+        m_point.m_arena   = nscratch::get(conflicts, count);
+        m_point.m_address = m_point.m_arena != nullptr ? narena::current_address(m_point.m_arena) : nullptr;
+    }
+
+    scratch_t::~scratch_t()
+    {
+        if (m_point.m_arena == nullptr)
+            return;
+        nscratch::s_update_high_water(m_point.m_arena);
+        restore_point(m_point);
+    }
+
 }  // namespace ncore
 
 #else
@@ -414,14 +1192,206 @@ namespace ncore
             CC_UNUSED(ptr);
         }
 
+        void set_commit_ahead(arena_t* ar, uint_t size_in_bytes)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(size_in_bytes);
+        }
+
+        void set_prefault(arena_t* ar, bool prefault)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(prefault);
+        }
+
+        u32 warm(arena_t* ar, u32 num_pages)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(num_pages);
+            return 0;
+        }
+
+        void* alloc_concurrent(arena_t* ar, uint_t size)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(size);
+            return nullptr;
+        }
+
+        void* alloc_concurrent(arena_t* ar, uint_t size, u32 alignment)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(size);
+            CC_UNUSED(alignment);
+            return nullptr;
+        }
+
+        void* alloc_and_zero_concurrent(arena_t* ar, uint_t size)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(size);
+            return nullptr;
+        }
+
+        void* alloc_and_zero_concurrent(arena_t* ar, uint_t size, u32 alignment)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(size);
+            CC_UNUSED(alignment);
+            return nullptr;
+        }
+
         void shrink(arena_t* ar) { CC_UNUSED(ar); }
         void reset(arena_t* ar) { CC_UNUSED(ar); }
+        void shrink(arena_t* ar, vmem_decommit_policy_t* policy)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(policy);
+        }
+        void reset(arena_t* ar, vmem_decommit_policy_t* policy)
+        {
+            CC_UNUSED(ar);
+            CC_UNUSED(policy);
+        }
+        arena_t* new_arena(uint_t reserve_size, uint_t commit_size, vmem_pages_t pages, s32 numa_node)
+        {
+            CC_UNUSED(reserve_size);
+            CC_UNUSED(commit_size);
+            CC_UNUSED(pages);
+            CC_UNUSED(numa_node);
+            return nullptr;
+        }
+
+        arena_t* new_chained_arena(uint_t link_reserve_size, uint_t commit_size)
+        {
+            CC_UNUSED(link_reserve_size);
+            CC_UNUSED(commit_size);
+            return nullptr;
+        }
+
+        arena_t* new_chained_arena(nsegment::allocator_t* segments, uint_t link_reserve_size, uint_t commit_size)
+        {
+            CC_UNUSED(segments);
+            CC_UNUSED(link_reserve_size);
+            CC_UNUSED(commit_size);
+            return nullptr;
+        }
+
+        u32 num_links(arena_t* ar)
+        {
+            CC_UNUSED(ar);
+            return 0;
+        }
+
         bool destroy(arena_t* ar)
         {
             CC_UNUSED(ar);
             return false;
         }
+
+        arena_t* open_file_arena(const char* path, uint_t reserve_size, uint_t commit_size, int_t* relocation)
+        {
+            CC_UNUSED(path);
+            CC_UNUSED(reserve_size);
+            CC_UNUSED(commit_size);
+            if (relocation != nullptr)
+                *relocation = 0;
+            return nullptr;
+        }
+
+        bool sync(arena_t* ar)
+        {
+            CC_UNUSED(ar);
+            return false;
+        }
+
+        void* file_root(arena_t* ar)
+        {
+            CC_UNUSED(ar);
+            return nullptr;
+        }
+
+        arena_t* new_cow_arena(uint_t reserve_size, uint_t commit_size)
+        {
+            CC_UNUSED(reserve_size);
+            CC_UNUSED(commit_size);
+            return nullptr;
+        }
+
+        bool snapshot(arena_t* ar, arena_snapshot_t& snapshot)
+        {
+            CC_UNUSED(ar);
+            snapshot.m_file = cINVALID_VMEM_FILE;
+            return false;
+        }
+
+        arena_t* fork(arena_snapshot_t const& snapshot)
+        {
+            CC_UNUSED(snapshot);
+            return nullptr;
+        }
+
+        void release(arena_snapshot_t& snapshot) { snapshot.m_file = cINVALID_VMEM_FILE; }
+
+        bool new_numa_arenas(numa_arenas_t* set, uint_t reserve_size, uint_t commit_size)
+        {
+            CC_UNUSED(reserve_size);
+            CC_UNUSED(commit_size);
+            set->m_num_nodes = 0;
+            return false;
+        }
+
+        void destroy(numa_arenas_t* set) { set->m_num_nodes = 0; }
+
+        arena_t* local_arena(numa_arenas_t* set)
+        {
+            CC_UNUSED(set);
+            return nullptr;
+        }
     }  // namespace narena
+
+    namespace nscratch
+    {
+        void configure(uint_t reserve_size, uint_t commit_size)
+        {
+            CC_UNUSED(reserve_size);
+            CC_UNUSED(commit_size);
+        }
+
+        arena_t* get(arena_t* const* conflicts, u32 count)
+        {
+            CC_UNUSED(conflicts);
+            CC_UNUSED(count);
+            return nullptr;
+        }
+
+        arena_t* get(arena_t* conflict)
+        {
+            CC_UNUSED(conflict);
+            return nullptr;
+        }
+
+        uint_t high_water() { return 0; }
+        void   reset_high_water() {}
+        void   release() {}
+    }  // namespace nscratch
+
+    scratch_t::scratch_t(arena_t* conflict)
+    {
+        CC_UNUSED(conflict);
+        m_point.m_arena   = nullptr;
+        m_point.m_address = nullptr;
+    }
+
+    scratch_t::scratch_t(arena_t* const* conflicts, u32 count)
+    {
+        CC_UNUSED(conflicts);
+        CC_UNUSED(count);
+        m_point.m_arena   = nullptr;
+        m_point.m_address = nullptr;
+    }
+
+    scratch_t::~scratch_t() {}
 }  // namespace ncore
 
 #endif
@@ -1,4 +1,5 @@
 #include "ccore/c_arena.h"
+#include "ccore/c_atomic.h"
 #include "ccore/c_math.h"
 #include "ccore/c_memory.h"
 #include "ccore/c_bitvec.h"
@@ -18,9 +19,11 @@ namespace ncore
         u32 m_bin2_offset;
         u32 m_bin3_offset;
         u32 m_items_offset;
+        u32 m_gens_offset;  // generation per item (u16[])
         u32 m_reserved_pages;
         u32 m_bin_committed_pages;
         u32 m_items_committed_pages;
+        u32 m_gens_committed_pages;
     };
 
     struct bin32_layout_t
@@ -47,6 +50,8 @@ namespace ncore
     static inline u64 const*  s_bin32_bm3(ibin32_t const* ibin) { return (u64 const*)((byte const*)ibin + ibin->m_bin3_offset); }
     static inline byte*       s_bin32_items(ibin32_t* ibin) { return (byte*)ibin + ibin->m_items_offset; }
     static inline byte const* s_bin32_items(ibin32_t const* ibin) { return (byte const*)ibin + ibin->m_items_offset; }
+    static inline u16*        s_bin32_gens(ibin32_t* ibin) { return (u16*)((byte*)ibin + ibin->m_gens_offset); }
+    static inline u16 const*  s_bin32_gens(ibin32_t const* ibin) { return (u16 const*)((byte const*)ibin + ibin->m_gens_offset); }
     static inline u32         s_bin32_reserved_size(ibin32_t const* ibin) { return ibin->m_reserved_pages << ibin->m_page_size_shift; }
     static inline u32         s_bin32_committed_bin_end(ibin32_t const* ibin) { return ibin->m_bin_committed_pages << ibin->m_page_size_shift; }
     static inline u32         s_bin32_items_committed_size(ibin32_t const* ibin) { return ibin->m_items_committed_pages << ibin->m_page_size_shift; }
@@ -156,12 +161,23 @@ namespace ncore
         const u32 page_size_bytes = (u32)1 << page_size_shift;
         const u32 required_size   = required_items * (u32)ibin->m_item_sizeof;
         const u32 committed_pages = (u32)(math::alignUp(required_size, page_size_bytes) >> page_size_shift);
-        if (committed_pages <= ibin->m_items_committed_pages)
-            return true;
-        const u32 extra_pages = committed_pages - ibin->m_items_committed_pages;
-        if (!v_alloc_commit(s_bin32_base(bin) + ibin->m_items_offset + s_bin32_items_committed_size(ibin), extra_pages << page_size_shift))
-            return false;
-        ibin->m_items_committed_pages = committed_pages;
+        if (committed_pages > ibin->m_items_committed_pages)
+        {
+            const u32 extra_pages = committed_pages - ibin->m_items_committed_pages;
+            if (!v_alloc_commit(s_bin32_base(bin) + ibin->m_items_offset + s_bin32_items_committed_size(ibin), extra_pages << page_size_shift))
+                return false;
+            ibin->m_items_committed_pages = committed_pages;
+        }
+
+        // the generations of the items
+        const u32 gens_pages = (u32)(math::alignUp(required_items * (u32)sizeof(u16), page_size_bytes) >> page_size_shift);
+        if (gens_pages > ibin->m_gens_committed_pages)
+        {
+            const u32 extra_pages = gens_pages - ibin->m_gens_committed_pages;
+            if (!v_alloc_commit(s_bin32_base(bin) + ibin->m_gens_offset + (ibin->m_gens_committed_pages << page_size_shift), extra_pages << page_size_shift))
+                return false;
+            ibin->m_gens_committed_pages = gens_pages;
+        }
         return true;
     }
 
@@ -198,11 +214,13 @@ namespace ncore
         const u32 bin3_offset       = bin2_offset + (layout.m_bin2 * (u32)sizeof(u64));
         const u32 bin3_size         = layout.m_bin3 * (u32)sizeof(u64);
         const u32 items_offset      = math::alignUp(bin3_offset + bin3_size, page_size_bytes);
-        const u32 reserve_size      = math::alignUp(items_offset + ((u32)item_size * max_items), page_size_bytes);
+        const u32 gens_offset       = math::alignUp(items_offset + ((u32)item_size * max_items), page_size_bytes);
+        const u32 reserve_size      = math::alignUp(gens_offset + ((u32)sizeof(u16) * max_items), page_size_bytes);
         const u32 meta_commit_size  = math::alignUp(bin3_offset, page_size_bytes);
         const u32 bin3_initial_size = initial_num_items >> 3;
         const u32 bin_commit_size   = math::alignUp(bin3_offset + bin3_initial_size, page_size_bytes);
         const u32 items_commit_size = math::alignUp((u32)item_size * initial_num_items, page_size_bytes);
+        const u32 gens_commit_size  = math::alignUp((u32)sizeof(u16) * initial_num_items, page_size_bytes);
 
         bin->m_memory = v_alloc_reserve(reserve_size);
         ASSERT(bin->m_memory != nullptr);
@@ -225,7 +243,7 @@ namespace ncore
             return;
         }
 
-        if (!v_alloc_commit((byte*)bin->m_memory + items_offset, items_commit_size))
+        if (!v_alloc_commit((byte*)bin->m_memory + items_offset, items_commit_size) || !v_alloc_commit((byte*)bin->m_memory + gens_offset, gens_commit_size))
         {
             v_alloc_release(bin->m_memory, reserve_size);
             bin->m_memory = nullptr;
@@ -248,9 +266,11 @@ namespace ncore
         ibin->m_bin2_offset           = (u32)bin2_offset;
         ibin->m_bin3_offset           = (u32)bin3_offset;
         ibin->m_items_offset          = (u32)items_offset;
+        ibin->m_gens_offset           = (u32)gens_offset;
         ibin->m_reserved_pages        = (u32)(reserve_size >> page_size_shift);
         ibin->m_bin_committed_pages   = (u32)(bin_commit_size >> page_size_shift);
         ibin->m_items_committed_pages = (u32)(items_commit_size >> page_size_shift);
+        ibin->m_gens_committed_pages  = (u32)(gens_commit_size >> page_size_shift);
 
         nbitvec24::setup_used_lazy(s_bin32_bm0(ibin), s_bin32_bm1(ibin), s_bin32_bm2(ibin), s_bin32_bm3(ibin), max_items);
     }
@@ -329,11 +349,86 @@ namespace ncore
         u64* bm3 = s_bin32_bm3(ibin);
 
         nbitvec24::set_free(bm0, bm1, bm2, bm3, item_free_index, item_index);
+        s_bin32_gens(ibin)[item_index] += 1;
 
         // Decrease number of used items
         ibin->m_items_count -= 1;
     }
 
+    // Batch allocation, free items are claimed a bitvec word at a time and the items above the highwater
+    // mark are committed with one call.
+    u32 bin_alloc_n(bin32_t* bin, void** out_ptrs, u32 count)
+    {
+        ibin32_t* ibin        = s_bin32(bin);
+        byte*     items       = s_bin32_items(ibin);
+        const u32 item_sizeof = ibin->m_item_sizeof;
+        const u32 highwater   = ibin->m_items_highwater;
+        u32       n           = 0;
+
+        u64* bm0 = s_bin32_bm0(ibin);
+        u64* bm1 = s_bin32_bm1(ibin);
+        u64* bm2 = s_bin32_bm2(ibin);
+        u64* bm3 = s_bin32_bm3(ibin);
+
+        u32 num_free = highwater - ibin->m_items_count;
+        while (n < count && num_free > 0)
+        {
+            u32       indices[64];
+            const u32 wanted = math::min(math::min(count - n, num_free), 64u);
+            const u32 found  = nbitvec24::find_free_and_remove_n(bm0, bm1, bm2, bm3, highwater, indices, wanted);
+            for (u32 i = 0; i < found; ++i)
+                out_ptrs[n++] = items + (indices[i] * item_sizeof);
+            num_free -= found;
+            if (found < wanted)
+                break;
+        }
+
+        const u32 num_new = math::min(count - n, ibin->m_items_capacity - highwater);
+        if (num_new > 0 && s_bin32_commit_bin3(bin, ibin, highwater + num_new) && s_bin32_commit_items(bin, ibin, highwater + num_new))
+        {
+            for (u32 i = highwater; i < highwater + num_new; ++i)
+            {
+                nbitvec24::tick_used_lazy(bm0, bm1, bm2, bm3, ibin->m_items_capacity, i);
+                out_ptrs[n++] = items + (i * item_sizeof);
+            }
+            ibin->m_items_highwater += num_new;
+        }
+
+        ibin->m_items_count += n;
+        return n;
+    }
+
+    void bin_free_n(bin32_t* bin, void* const* ptrs, u32 count)
+    {
+        ibin32_t*   ibin      = s_bin32(bin);
+        const byte* items     = s_bin32_items(ibin);
+        u16*        gens      = s_bin32_gens(ibin);
+        const u32   highwater = ibin->m_items_highwater;
+
+        u64* bm0 = s_bin32_bm0(ibin);
+        u64* bm1 = s_bin32_bm1(ibin);
+        u64* bm2 = s_bin32_bm2(ibin);
+        u64* bm3 = s_bin32_bm3(ibin);
+
+        u32 i = 0;
+        while (i < count)
+        {
+            u32 indices[64];
+            u32 num_indices = 0;
+            for (; i < count && num_indices < 64; ++i)
+            {
+                const s32 item_index = (s32)(((const byte*)ptrs[i] - items) / ibin->m_item_sizeof);
+                if (item_index >= 0 && (u32)item_index < highwater)  // skip invalid pointers
+                {
+                    gens[item_index] += 1;
+                    indices[num_indices++] = (u32)item_index;
+                }
+            }
+            nbitvec24::set_free_n(bm0, bm1, bm2, bm3, highwater, indices, num_indices);
+            ibin->m_items_count -= num_indices;
+        }
+    }
+
     // convert a pointer to an index within the bin
     u32 bin_ptr2idx(bin32_t const* bin, void* ptr)
     {
@@ -360,6 +455,128 @@ namespace ncore
         return item;
     }
 
+    u32 bin_ptr2gidx(bin32_t const* bin, void* ptr)
+    {
+        const u32 index = bin_ptr2idx(bin, ptr);
+        if (index >= 0x00FFFFFF)
+            return c_null_gidx32;  // invalid pointer, or the last index that with a generation of 0xFF would be c_null_gidx32
+        return ((u32)s_bin32_gens(s_bin32(bin))[index] << 24) | index;
+    }
+
+    u64 bin_ptr2gidx64(bin32_t const* bin, void* ptr)
+    {
+        const u32 index = bin_ptr2idx(bin, ptr);
+        if (index == D_U32_MAX)
+            return c_null_gidx64;  // invalid pointer
+        return ((u64)s_bin32_gens(s_bin32(bin))[index] << 32) | index;
+    }
+
+    void* bin_gidx2ptr(bin32_t* bin, u32 gidx)
+    {
+        ibin32_t* ibin  = s_bin32(bin);
+        const u32 index = gidx & 0x00FFFFFF;
+        if (index >= ibin->m_items_highwater || index == 0x00FFFFFF || (u8)s_bin32_gens(ibin)[index] != (u8)(gidx >> 24))
+            return nullptr;  // stale or invalid
+        return s_bin32_items(ibin) + (index * (u32)ibin->m_item_sizeof);
+    }
+
+    void* bin_gidx2ptr(bin32_t* bin, u64 gidx)
+    {
+        ibin32_t* ibin  = s_bin32(bin);
+        const u32 index = (u32)gidx;
+        if (index >= ibin->m_items_highwater || s_bin32_gens(ibin)[index] != (u16)(gidx >> 32))
+            return nullptr;  // stale or invalid
+        return s_bin32_items(ibin) + (index * (u32)ibin->m_item_sizeof);
+    }
+
+    u32 bin_gidx2ptr_n(bin32_t* bin, u32 const* gidx, void** out_ptrs, u32 count)
+    {
+        ibin32_t*  ibin        = s_bin32(bin);
+        u16 const* gens        = s_bin32_gens(ibin);
+        byte*      items       = s_bin32_items(ibin);
+        const u32  item_sizeof = ibin->m_item_sizeof;
+        const u32  highwater   = ibin->m_items_highwater;
+
+        u32 valid = 0;
+        for (u32 i = 0; i < count; ++i)
+        {
+            const u32  index = gidx[i] & 0x00FFFFFF;
+            const bool ok    = index < highwater && index != 0x00FFFFFF && (u8)gens[index] == (u8)(gidx[i] >> 24);
+            out_ptrs[i]      = ok ? items + (index * item_sizeof) : nullptr;
+            valid += ok ? 1 : 0;
+        }
+        return valid;
+    }
+
+    // the run of used items at or after 'from', out_count is 0 when there is none
+    // Note: the bitvec only summarizes where the free items are, so free words are skipped one word (64 items) at a time
+    static void s_bin32_find_run(ibin32_t const* ibin, u32 from, u32& out_index, u32& out_count)
+    {
+        u64 const* bm3       = s_bin32_bm3(ibin);
+        const u32  highwater = ibin->m_items_highwater;
+
+        out_count = 0;
+
+        // a '1' bit is a free item
+        u32 first = from;
+        while (first < highwater)
+        {
+            const u64 used = ~bm3[first >> 6] & (~(u64)0 << (first & 63));
+            if (used != 0)
+            {
+                first = (first & ~63u) + (u32)math::findFirstBit(used);
+                break;
+            }
+            first = (first & ~63u) + 64;
+        }
+        if (first >= highwater)
+            return;
+
+        u32 end = first;
+        while (end < highwater)
+        {
+            const u64 free = bm3[end >> 6] & (~(u64)0 << (end & 63));
+            if (free != 0)
+            {
+                end = (end & ~63u) + (u32)math::findFirstBit(free);
+                break;
+            }
+            end = (end & ~63u) + 64;
+        }
+
+        out_index = first;
+        out_count = math::min(end, highwater) - first;
+    }
+
+    void bin_iter_begin(bin32_t const* bin, bin_used_iter_t& it)
+    {
+        ibin32_t const* ibin = s_bin32(bin);
+        it.m_items           = nullptr;
+        it.m_index           = 0;
+        it.m_count           = 0;
+        s_bin32_find_run(ibin, 0, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(s_bin32_items(ibin) + (it.m_next_index * (u32)ibin->m_item_sizeof));
+    }
+
+    bool bin_iter_next(bin32_t const* bin, bin_used_iter_t& it)
+    {
+        if (it.m_next_count == 0)
+            return false;
+
+        ibin32_t const* ibin  = s_bin32(bin);
+        byte*           items = (byte*)s_bin32_items(ibin);
+        it.m_index            = it.m_next_index;
+        it.m_count            = it.m_next_count;
+        it.m_items            = items + (it.m_index * (u32)ibin->m_item_sizeof);
+
+        // find the next run and start loading its first item while the caller processes this run
+        s_bin32_find_run(ibin, it.m_index + it.m_count, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(items + (it.m_next_index * (u32)ibin->m_item_sizeof));
+        return true;
+    }
+
     // highest index of free item in the bin
     s32 bin_highest_free(bin32_t const* bin)
     {
@@ -376,6 +593,176 @@ namespace ncore
         return hi;
     }
 
+    // ----------------------------------------------------------------------------------------------------------------------
+    // mbin32 implementation, thread-safe frontend of bin32 with magazines
+    // ----------------------------------------------------------------------------------------------------------------------
+    static const u32 c_magazine_capacity = 30;  // the size of a magazine is 4 cache-lines
+    static const u32 c_magazine_batch    = 16;  // number of items that are moved between a magazine and the bin at once
+
+    struct magazine_t
+    {
+        spinlock_t m_lock;
+        u32        m_count;
+        void*      m_items[c_magazine_capacity];
+        u64        m_padding;
+    };
+
+    struct imbin32_t
+    {
+        bin32_t    m_bin;
+        spinlock_t m_lock;  // protects m_bin
+        u32        m_magazine_mask;
+        u32        m_reserved_size;
+        u32        m_magazines_offset;
+    };
+
+    static inline imbin32_t*        s_mbin32(mbin32_t* bin) { return (imbin32_t*)bin->m_memory; }
+    static inline imbin32_t const*  s_mbin32(mbin32_t const* bin) { return (imbin32_t const*)bin->m_memory; }
+    static inline magazine_t*       s_mbin32_magazines(imbin32_t* ibin) { return (magazine_t*)((byte*)ibin + ibin->m_magazines_offset); }
+    static inline magazine_t const* s_mbin32_magazines(imbin32_t const* ibin) { return (magazine_t const*)((byte const*)ibin + ibin->m_magazines_offset); }
+
+    // Every thread gets a slot number the first time it uses a mbin32_t, the slot selects the magazine.
+    // Slot numbers are never recycled, when threads come and go they wrap around the magazines.
+    static u32 volatile        s_mbin32_num_thread_slots = 0;
+    static CC_THREAD_LOCAL u32 s_mbin32_thread_slot      = 0;
+
+    static inline magazine_t* s_mbin32_magazine(imbin32_t* ibin)
+    {
+        if (s_mbin32_thread_slot == 0)
+            s_mbin32_thread_slot = natomic::fetch_add(&s_mbin32_num_thread_slots, 1u) + 1;
+        return &s_mbin32_magazines(ibin)[(s_mbin32_thread_slot - 1) & ibin->m_magazine_mask];
+    }
+
+    // move up to c_magazine_batch items from the bin to the magazine, the caller holds the lock of the magazine
+    static void s_mbin32_refill(imbin32_t* ibin, magazine_t* mag)
+    {
+        void* items[c_magazine_batch];
+        u32   count;
+        {
+            spinlock_scope_t lock(ibin->m_lock);
+            count = bin_alloc_n(&ibin->m_bin, items, c_magazine_batch);
+        }
+        // the magazine is a stack, push them in reverse so that the lowest index is handed out first
+        while (count > 0)
+            mag->m_items[mag->m_count++] = items[--count];
+    }
+
+    // move the c_magazine_batch oldest items from the magazine to the bin, the caller holds the lock of the magazine
+    static void s_mbin32_drain(imbin32_t* ibin, magazine_t* mag, u32 count)
+    {
+        {
+            spinlock_scope_t lock(ibin->m_lock);
+            bin_free_n(&ibin->m_bin, mag->m_items, count);
+        }
+        for (u32 i = count; i < mag->m_count; ++i)
+            mag->m_items[i - count] = mag->m_items[i];
+        mag->m_count -= count;
+    }
+
+    void bin_setup(mbin32_t* bin, u16 item_size, u32 max_items, u32 num_magazines)
+    {
+        num_magazines = math::ceilpo2(math::max(num_magazines, 1u));
+
+        const u32 page_size        = v_alloc_get_page_size();
+        const u32 magazines_offset = math::alignUp((u32)sizeof(imbin32_t), 64u);
+        const u32 reserve_size     = math::alignUp(magazines_offset + num_magazines * (u32)sizeof(magazine_t), page_size);
+
+        bin->m_memory = v_alloc_reserve(reserve_size);
+        ASSERT(bin->m_memory != nullptr);
+        if (bin->m_memory == nullptr)
+            return;
+        if (!v_alloc_commit(bin->m_memory, reserve_size))
+        {
+            v_alloc_release(bin->m_memory, reserve_size);
+            bin->m_memory = nullptr;
+            ASSERT(false);
+            return;
+        }
+
+        imbin32_t* ibin = s_mbin32(bin);
+        nmem::memset(ibin, 0, reserve_size);
+        bin_setup(&ibin->m_bin, item_size, max_items);
+        nspinlock::init(ibin->m_lock);
+        ibin->m_magazine_mask    = num_magazines - 1;
+        ibin->m_reserved_size    = reserve_size;
+        ibin->m_magazines_offset = magazines_offset;
+    }
+
+    void bin_destroy(mbin32_t* bin)
+    {
+        if (bin->m_memory != nullptr)
+        {
+            imbin32_t* ibin = s_mbin32(bin);
+            bin_destroy(&ibin->m_bin);
+            v_alloc_release(bin->m_memory, ibin->m_reserved_size);
+            bin->m_memory = nullptr;
+        }
+    }
+
+    void* bin_alloc(mbin32_t* bin)
+    {
+        imbin32_t*  ibin = s_mbin32(bin);
+        magazine_t* mag  = s_mbin32_magazine(ibin);
+        if (!nspinlock::try_lock(mag->m_lock))
+        {
+            // another thread is using this magazine
+            spinlock_scope_t lock(ibin->m_lock);
+            return bin_alloc(&ibin->m_bin);
+        }
+
+        if (mag->m_count == 0)
+            s_mbin32_refill(ibin, mag);
+        void* item = mag->m_count > 0 ? mag->m_items[--mag->m_count] : nullptr;
+        nspinlock::unlock(mag->m_lock);
+        return item;
+    }
+
+    void bin_free(mbin32_t* bin, void* ptr)
+    {
+        if (ptr == nullptr)
+            return;
+
+        imbin32_t*  ibin = s_mbin32(bin);
+        magazine_t* mag  = s_mbin32_magazine(ibin);
+        if (!nspinlock::try_lock(mag->m_lock))
+        {
+            // another thread is using this magazine
+            spinlock_scope_t lock(ibin->m_lock);
+            bin_free(&ibin->m_bin, ptr);
+            return;
+        }
+
+        if (mag->m_count == c_magazine_capacity)
+            s_mbin32_drain(ibin, mag, c_magazine_batch);
+        mag->m_items[mag->m_count++] = ptr;
+        nspinlock::unlock(mag->m_lock);
+    }
+
+    void bin_flush(mbin32_t* bin)
+    {
+        imbin32_t*  ibin      = s_mbin32(bin);
+        magazine_t* magazines = s_mbin32_magazines(ibin);
+        for (u32 i = 0; i <= ibin->m_magazine_mask; ++i)
+        {
+            magazine_t*      mag = &magazines[i];
+            spinlock_scope_t lock(mag->m_lock);
+            if (mag->m_count > 0)
+                s_mbin32_drain(ibin, mag, mag->m_count);
+        }
+    }
+
+    u32 bin_cached(mbin32_t const* bin)
+    {
+        imbin32_t const*  ibin      = s_mbin32(bin);
+        magazine_t const* magazines = s_mbin32_magazines(ibin);
+        u32               cached    = 0;
+        for (u32 i = 0; i <= ibin->m_magazine_mask; ++i)
+            cached += natomic::load_relaxed(&magazines[i].m_count);
+        return cached;
+    }
+
+    u32 bin_size(mbin32_t const* bin) { return bin_size(&s_mbin32(bin)->m_bin) - bin_cached(bin); }
+
     // ----------------------------------------------------------------------------------------------------------------------
     // bin16 implementation
     // ----------------------------------------------------------------------------------------------------------------------
@@ -580,6 +967,72 @@ namespace ncore
         ibin->m_items_count -= 1;
     }
 
+    u32 bin_alloc_n(bin16_t* bin, void** out_ptrs, u32 count)
+    {
+        ibin16_t* ibin        = s_bin16(bin);
+        byte*     items       = s_bin16_items(ibin);
+        const u32 item_sizeof = ibin->m_item_sizeof;
+        const u32 highwater   = ibin->m_items_highwater;
+        u32       n           = 0;
+
+        u64* bm0 = s_bin16_bm0(ibin);
+        u64* bm1 = s_bin16_bm1(ibin);
+        u64* bm2 = s_bin16_bm2(ibin);
+
+        u32 num_free = highwater - ibin->m_items_count;
+        while (n < count && num_free > 0)
+        {
+            u32       indices[64];
+            const u32 wanted = math::min(math::min(count - n, num_free), 64u);
+            const u32 found  = nbitvec18::find_free_and_remove_n(bm0, bm1, bm2, highwater, indices, wanted);
+            for (u32 i = 0; i < found; ++i)
+                out_ptrs[n++] = items + (indices[i] * item_sizeof);
+            num_free -= found;
+            if (found < wanted)
+                break;
+        }
+
+        const u32 num_new = math::min(count - n, ibin->m_items_capacity - highwater);
+        if (num_new > 0 && s_bin16_commit(bin, ibin, ibin->m_items_offset + ((highwater + num_new) * item_sizeof)))
+        {
+            for (u32 i = highwater; i < highwater + num_new; ++i)
+            {
+                nbitvec18::tick_used_lazy(bm0, bm1, bm2, ibin->m_items_capacity, i);
+                out_ptrs[n++] = items + (i * item_sizeof);
+            }
+            ibin->m_items_highwater += num_new;
+        }
+
+        ibin->m_items_count += n;
+        return n;
+    }
+
+    void bin_free_n(bin16_t* bin, void* const* ptrs, u32 count)
+    {
+        ibin16_t* ibin      = s_bin16(bin);
+        byte*     items     = s_bin16_items(ibin);
+        const u32 highwater = ibin->m_items_highwater;
+
+        u64* bm0 = s_bin16_bm0(ibin);
+        u64* bm1 = s_bin16_bm1(ibin);
+        u64* bm2 = s_bin16_bm2(ibin);
+
+        u32 i = 0;
+        while (i < count)
+        {
+            u32 indices[64];
+            u32 num_indices = 0;
+            for (; i < count && num_indices < 64; ++i)
+            {
+                const s32 item_index = (s32)(((const byte*)ptrs[i] - items) / ibin->m_item_sizeof);
+                if (item_index >= 0 && (u32)item_index < highwater)  // skip invalid pointers
+                    indices[num_indices++] = (u32)item_index;
+            }
+            nbitvec18::set_free_n(bm0, bm1, bm2, highwater, indices, num_indices);
+            ibin->m_items_count -= num_indices;
+        }
+    }
+
     u32 bin_item_sizeof(bin16_t const* bin)
     {
         ibin16_t const* ibin = s_bin16(bin);
@@ -1,9 +1,62 @@
+#include "ccore/c_arena.h"
+#include "ccore/c_atomic.h"
 #include "ccore/c_math.h"
 
 #include "ccore/c_bitvec.h"
 
+#if CC_AVX2
+#    include <immintrin.h>
+#elif CC_SSE2
+#    include <emmintrin.h>
+#elif CC_NEON
+#    include <arm_neon.h>
+#endif
+
 namespace ncore
 {
+    namespace nbitvec
+    {
+        // The words are compared byte-wise against the value repeated over a vector, a vector with a mismatch
+        // is finished one word at a time.
+        template <typename T>
+        static inline u32 s_scan_equal(T const* words, u32 from, u32 to, T value)
+        {
+            u32 i = from;
+#if CC_AVX2
+            __m256i const pattern = (sizeof(T) == 8) ? _mm256_set1_epi64x((long long)value) : _mm256_set1_epi32((int)value);
+            for (u32 const per = 32 / sizeof(T); (i + per) <= to; i += per)
+            {
+                __m256i const v = _mm256_loadu_si256((__m256i const*)(words + i));
+                if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, pattern)) != -1)
+                    break;
+            }
+#elif CC_SSE2
+            __m128i const pattern = (sizeof(T) == 8) ? _mm_set1_epi64x((long long)value) : _mm_set1_epi32((int)value);
+            for (u32 const per = 16 / sizeof(T); (i + per) <= to; i += per)
+            {
+                __m128i const v = _mm_loadu_si128((__m128i const*)(words + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, pattern)) != 0xFFFF)
+                    break;
+            }
+#elif CC_NEON
+            u64 const        value64 = (sizeof(T) == 8) ? (u64)value : (((u64)value << 32) | (u64)value);
+            uint8x16_t const pattern = vreinterpretq_u8_u64(vdupq_n_u64(value64));
+            for (u32 const per = 16 / sizeof(T); (i + per) <= to; i += per)
+            {
+                uint64x2_t const eq = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8((u8 const*)(words + i)), pattern));
+                if ((vgetq_lane_u64(eq, 0) & vgetq_lane_u64(eq, 1)) != ~(u64)0)
+                    break;
+            }
+#endif
+            while (i < to && words[i] == value)
+                i += 1;
+            return i;
+        }
+
+        u32 scan_equal(u32 const* words, u32 from, u32 to, u32 value) { return s_scan_equal<u32>(words, from, to, value); }
+        u32 scan_equal(u64 const* words, u32 from, u32 to, u64 value) { return s_scan_equal<u64>(words, from, to, value); }
+    }  // namespace nbitvec
+
     // --------------------------------------------------------------------------------
     // --------------------------------------------------------------------------------
     // bit-vector, these functions are tracking '1' bits.
@@ -214,6 +267,307 @@ namespace ncore
     //       888"                888      888           Y888P    888        888     Y88b  d88P
     //       888888888           88888888 8888888888     Y8P     8888888888 88888888 "Y8888P"
 
+    // take up to 'count' of the lowest '1' bits of 'word', writes the bit indices to 'out_bits' and returns the bits that remain
+    template <typename bintype_t>
+    static inline bintype_t s_take_lowest_bits(bintype_t word, u32 base_bit, u32* out_bits, u32& n, u32 count)
+    {
+        while (word != 0 && n < count)
+        {
+            out_bits[n++] = base_bit + (u32)math::findFirstBit(word);
+            word &= word - 1;
+        }
+        return word;
+    }
+
+    // Lock-free claim/release on a bit-vector of 'num_levels' levels, 'levels[0]' is bin0 and 'levels[num_levels - 1]'
+    // holds the bits. A bit is claimed with a CAS on its word, a summary bit is cleared only by a thread that emptied
+    // the word below it and that thread checks the word again after clearing the bit, so that a summary bit is never
+    // clear while the word below it has a free bit. A summary bit can be stale (set while the word below it is empty),
+    // a search that runs into a stale bit clears it.
+    template <typename bintype_t, u32 binshift, u32 num_levels>
+    class bitvec_concurrent_t
+    {
+    public:
+        static constexpr u32       binbits     = (u32)1 << binshift;
+        static constexpr u32       binmask     = binbits - 1;
+        static constexpr bintype_t binconstant = (bintype_t) ~(bintype_t)0;
+
+        static inline bintype_t valid_level0_mask(u32 maxbits)
+        {
+            u32 count = maxbits;  // number of words at level 1
+            for (u32 l = 1; l < num_levels; ++l)
+                count = (count + binmask) >> binshift;
+            return (count >= binbits) ? binconstant : ~(bintype_t)(binconstant << count);
+        }
+
+        // the word at 'level' became empty, clear the summary bits above it
+        static void clear_summary(bintype_t* const* levels, u32 level, u32 word)
+        {
+            while (level > 0)
+            {
+                u32 const       parent = word >> binshift;
+                bintype_t const bit    = (bintype_t)1 << (word & binmask);
+                bintype_t const old    = natomic::fetch_and(&levels[level - 1][parent], D_INVERT(bit));
+                if (natomic::load(&levels[level][word]) != 0)
+                {
+                    // a bit was freed in the meantime
+                    natomic::fetch_or(&levels[level - 1][parent], bit);
+                    return;
+                }
+                if ((old & D_INVERT(bit)) != 0)
+                    return;
+                word = parent;
+                level -= 1;
+            }
+        }
+
+        // the thread that makes a word non-empty sets the summary bit above it
+        static void set_free(bintype_t* const* levels, u32 maxbits, u32 bit)
+        {
+            if (bit >= maxbits)
+                return;
+            u32 word = bit;
+            for (s32 level = (s32)num_levels - 1; level >= 0; --level)
+            {
+                bintype_t const mask = (bintype_t)1 << (word & binmask);
+                word                 = word >> binshift;
+                bintype_t const old  = natomic::fetch_or(&levels[level][word], mask);
+                if (old != 0)
+                    return;
+            }
+        }
+
+        static void set_used(bintype_t* const* levels, u32 maxbits, u32 bit)
+        {
+            if (bit >= maxbits)
+                return;
+            u32 const       word = bit >> binshift;
+            bintype_t const mask = (bintype_t)1 << (bit & binmask);
+            bintype_t const old  = natomic::fetch_and(&levels[num_levels - 1][word], D_INVERT(mask));
+            if (old == mask)
+                clear_summary(levels, num_levels - 1, word);
+        }
+
+        static s32 find_free_and_remove(bintype_t* const* levels, u32 maxbits)
+        {
+            bintype_t const mask0 = valid_level0_mask(maxbits);
+            for (;;)
+            {
+                bintype_t words[num_levels] = {};  // bits of the words on the path that are not visited yet
+                u32       index[num_levels] = {};  // index of the words on the path
+                words[0] = natomic::load(levels[0]) & mask0;
+                index[0] = 0;
+                if (words[0] == 0)
+                    return -1;
+
+                s32 level = 0;
+                while (level >= 0)
+                {
+                    if (words[level] == 0)
+                    {
+                        level -= 1;  // continue with the next bit of the parent
+                        continue;
+                    }
+
+                    u32 const b = (u32)math::findFirstBit(words[level]);
+                    if (level == (s32)num_levels - 1)
+                    {
+                        bintype_t* const word = &levels[level][index[level]];
+                        bintype_t const  mask = (bintype_t)1 << b;
+                        if (natomic::cas(word, words[level], words[level] & D_INVERT(mask)))
+                        {
+                            if (words[level] == mask)
+                                clear_summary(levels, (u32)level, index[level]);
+                            return (s32)((index[level] << binshift) + b);
+                        }
+                        words[level] = natomic::load(word);  // another thread changed the word
+                        continue;
+                    }
+
+                    words[level] &= D_INVERT((bintype_t)1 << b);
+                    index[level + 1] = (index[level] << binshift) + b;
+                    words[level + 1] = natomic::load(&levels[level + 1][index[level + 1]]);
+                    if (words[level + 1] == 0)
+                        clear_summary(levels, (u32)level + 1, index[level + 1]);  // stale summary bit
+                    level += 1;
+                }
+            }
+        }
+    };
+
+    // Ranges of contiguous free bits on a bit-vector of 'num_levels' levels, 'levels[0]' is bin0 and 'levels[num_levels - 1]'
+    // holds the bits. The search only visits words that have a free bit (the summary levels are used to skip over full
+    // words), carries a run of free bits from one word into the next, and finds a run inside a word with a few shift-and
+    // steps instead of testing bit by bit.
+    template <typename bintype_t, u32 binshift, u32 num_levels>
+    class bitvec_range_t
+    {
+    public:
+        static constexpr u32       binbits     = (u32)1 << binshift;
+        static constexpr u32       binmask     = binbits - 1;
+        static constexpr bintype_t binconstant = (bintype_t) ~(bintype_t)0;
+
+        static inline bintype_t mask_for_count(u32 count) { return (count >= binbits) ? binconstant : ~(bintype_t)(binconstant << count); }
+        static inline bintype_t mask_from(u32 bit) { return (bit == 0) ? binconstant : (bintype_t)(binconstant << bit); }
+
+        // number of valid bits per level, counts[num_levels - 1] = maxbits
+        static void compute_counts(u32 maxbits, u32* counts)
+        {
+            counts[num_levels - 1] = maxbits;
+            for (s32 l = (s32)num_levels - 2; l >= 0; --l)
+                counts[l] = (counts[l + 1] + binmask) >> binshift;
+        }
+
+        // the first set bit at or after 'pos' at 'level', -1 if there is none
+        static s32 next_set(bintype_t const* const* levels, u32 const* counts, u32 level, u32 pos)
+        {
+            while (pos < counts[level])
+            {
+                u32 const       wi   = pos >> binshift;
+                bintype_t const word = levels[level][wi] & mask_from(pos & binmask);
+                if (word != 0)
+                {
+                    u32 const bit = (wi << binshift) + (u32)math::findFirstBit(word);
+                    return bit < counts[level] ? (s32)bit : -1;
+                }
+                if (level == 0)
+                    return -1;
+                s32 const next = next_set(levels, counts, level - 1, wi + 1);
+                if (next < 0)
+                    return -1;
+                pos = (u32)next << binshift;
+            }
+            return -1;
+        }
+
+        // the lowest position in a word where 'n' (n <= binbits) set bits start, -1 if there is none
+        static inline s32 find_run(bintype_t word, u32 n)
+        {
+            for (u32 len = 1; len < n && word != 0;)
+            {
+                u32 const step = (len < (n - len)) ? len : (n - len);
+                word &= (bintype_t)(word >> step);
+                len += step;
+            }
+            return word != 0 ? (s32)math::findFirstBit(word) : -1;
+        }
+
+        static s32 find_free_range(bintype_t const* const* levels, u32 maxbits, u32 n)
+        {
+            if (n == 0 || n > maxbits)
+                return -1;
+
+            u32 counts[num_levels];
+            compute_counts(maxbits, counts);
+            u32 const leaf       = num_levels - 1;
+            u32 const full_words = maxbits >> binshift;  // words that have all their bits below maxbits
+
+            u32 run_start = 0;  // the run of free bits that ends at the top of the previous word
+            u32 run_len   = 0;
+            u32 expected  = 0;  // a word that is skipped is full and breaks the run
+            for (s32 wi = next_set(levels, counts, leaf - 1, 0); wi >= 0; wi = next_set(levels, counts, leaf - 1, expected))
+            {
+                if ((u32)wi != expected)
+                    run_len = 0;
+                expected = (u32)wi + 1;
+
+                bintype_t const word = levels[leaf][wi] & mask_for_count(maxbits - ((u32)wi << binshift));
+                if (word == binconstant)
+                {
+                    if (run_len == 0)
+                        run_start = (u32)wi << binshift;
+                    run_len += binbits;
+                    if (run_len >= n)
+                        return (s32)run_start;
+
+                    // the full words that follow extend the run, they are compared many at a time
+                    u32 const need = (n - run_len + binmask) >> binshift;
+                    u32 const to   = ((u32)wi + 1 + need) < full_words ? ((u32)wi + 1 + need) : full_words;
+                    u32 const end  = nbitvec::scan_equal(levels[leaf], (u32)wi + 1, to, binconstant);
+                    run_len += (end - ((u32)wi + 1)) << binshift;
+                    if (run_len >= n)
+                        return (s32)run_start;
+                    expected = end;
+                    continue;
+                }
+
+                // the run continues into the low bits of this word
+                u32 const low = (u32)math::findFirstBit(D_INVERT(word));
+                if (run_len > 0 && (run_len + low) >= n)
+                    return (s32)run_start;
+                if (n <= binbits)
+                {
+                    s32 const bit = find_run(word, n);
+                    if (bit >= 0)
+                        return (s32)(((u32)wi << binshift) + (u32)bit);
+                }
+
+                // the high bits of this word start a new run (the bits beyond maxbits count as used)
+                run_len   = binmask - (u32)math::findLastBit(D_INVERT(word));
+                run_start = (((u32)wi + 1) << binshift) - run_len;
+            }
+            return -1;
+        }
+
+        // the bits [start, start + n) become used, a word that becomes empty clears its summary bit
+        static void set_used_range(bintype_t* const* levels, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const       wi    = bit >> binshift;
+                u32 const       count = ((end - bit) < (binbits - (bit & binmask))) ? (end - bit) : (binbits - (bit & binmask));
+                bintype_t const mask  = (bintype_t)(mask_for_count(count) << (bit & binmask));
+                bit += count;
+
+                u32 word = wi;
+                for (s32 level = (s32)num_levels - 1; level >= 0; --level)
+                {
+                    bintype_t const clear = (level == (s32)num_levels - 1) ? mask : (bintype_t)((bintype_t)1 << (word & binmask));
+                    u32 const       index = (level == (s32)num_levels - 1) ? word : (word >> binshift);
+                    bintype_t const old   = levels[level][index];
+                    levels[level][index]  = old & D_INVERT(clear);
+                    if (old == 0 || levels[level][index] != 0)
+                        break;
+                    word = index;
+                }
+            }
+        }
+
+        // the bits [start, start + n) become free, a word that was empty sets its summary bit
+        static void set_free_range(bintype_t* const* levels, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const       wi    = bit >> binshift;
+                u32 const       count = ((end - bit) < (binbits - (bit & binmask))) ? (end - bit) : (binbits - (bit & binmask));
+                bintype_t const mask  = (bintype_t)(mask_for_count(count) << (bit & binmask));
+                bit += count;
+
+                u32 word = wi;
+                for (s32 level = (s32)num_levels - 1; level >= 0; --level)
+                {
+                    bintype_t const set   = (level == (s32)num_levels - 1) ? mask : (bintype_t)((bintype_t)1 << (word & binmask));
+                    u32 const       index = (level == (s32)num_levels - 1) ? word : (word >> binshift);
+                    bintype_t const old   = levels[level][index];
+                    levels[level][index]  = old | set;
+                    if (old != 0)
+                        break;
+                    word = index;
+                }
+            }
+        }
+
+        static s32 alloc_range(bintype_t* const* levels, u32 maxbits, u32 n)
+        {
+            s32 const start = find_free_range(levels, maxbits, n);
+            if (start >= 0)
+                set_used_range(levels, maxbits, (u32)start, n);
+            return start;
+        }
+    };
+
     template <typename bintype_t, u32 binshift>
     class bitvec_bin0_bin1_t
     {
@@ -323,6 +677,50 @@ namespace ncore
             return bit;
         }
 
+        static inline bintype_t valid_word_mask(u32 word, u32 maxbits) { return mask_for_count(maxbits - (word << binshift)); }
+
+        static u32 find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32* out_bits, u32 count)
+        {
+            u32 n = 0;
+            while (n < count)
+            {
+                bintype_t const summary = *_bin0 & valid_level0_mask(maxbits);
+                if (summary == 0)
+                    break;
+
+                u32 const       w1   = (u32)math::findFirstBit(summary);
+                bintype_t const word = _bin1[w1] & valid_word_mask(w1, maxbits);
+                if (word == 0)
+                    break;
+
+                bintype_t const rest = s_take_lowest_bits(word, w1 << binshift, out_bits, n, count);
+                _bin1[w1] &= ~(word ^ rest);
+                if (_bin1[w1] == 0)
+                    *_bin0 = D_BIT_CLEAR(*_bin0, w1);
+            }
+            return n;
+        }
+
+        static void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 const* bits, u32 count)
+        {
+            u32 i = 0;
+            while (i < count)
+            {
+                u32 const w1   = bits[i] >> binshift;
+                bintype_t mask = 0;
+                for (; i < count && (bits[i] >> binshift) == w1; ++i)
+                {
+                    ASSERT(bits[i] < maxbits);
+                    mask = D_BIT_SET(mask, bits[i] & binmask);
+                }
+
+                bintype_t const old1 = _bin1[w1];
+                _bin1[w1]            = old1 | mask;
+                if (old1 == 0)
+                    *_bin0 = D_BIT_SET(*_bin0, w1);
+            }
+        }
+
         static s32 find_free_last(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, u32 maxbits)
         {
             bintype_t summary = *_bin0 & valid_level0_mask(maxbits);
@@ -413,6 +811,40 @@ namespace ncore
         s32  find_free_last_and_remove(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits) { return bitvec_bin0_bin1_t<bintype_t, 5>::find_free_last_and_remove(_bin0, _bin1, maxbits); }
         s32  find_free_after(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, u32 maxbits, u32 pivot) { return bitvec_bin0_bin1_t<bintype_t, 5>::find_free_after(_bin0, _bin1, maxbits, pivot); }
         s32  find_free_before(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, u32 maxbits, u32 pivot) { return bitvec_bin0_bin1_t<bintype_t, 5>::find_free_before(_bin0, _bin1, maxbits, pivot); }
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32* out_bits, u32 count) { return bitvec_bin0_bin1_t<bintype_t, 5>::find_free_and_remove_n(_bin0, _bin1, maxbits, out_bits, count); }
+        void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 const* bits, u32 count) { bitvec_bin0_bin1_t<bintype_t, 5>::set_free_n(_bin0, _bin1, maxbits, bits, count); }
+
+        s32 find_free_range(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, u32 maxbits, u32 n)
+        {
+            bintype_t const* levels[] = {_bin0, _bin1};
+            return bitvec_range_t<bintype_t, 5, 2>::find_free_range(levels, maxbits, n);
+        }
+        s32 alloc_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            return bitvec_range_t<bintype_t, 5, 2>::alloc_range(levels, maxbits, n);
+        }
+        void free_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 start, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            bitvec_range_t<bintype_t, 5, 2>::set_free_range(levels, maxbits, start, n);
+        }
+
+        s32 find_free_and_remove_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            return bitvec_concurrent_t<bintype_t, 5, 2>::find_free_and_remove(levels, maxbits);
+        }
+        void set_free_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            bitvec_concurrent_t<bintype_t, 5, 2>::set_free(levels, maxbits, bit);
+        }
+        void set_used_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            bitvec_concurrent_t<bintype_t, 5, 2>::set_used(levels, maxbits, bit);
+        }
     }  // namespace nbitvec10
 
     namespace nbitvec12
@@ -430,6 +862,40 @@ namespace ncore
         s32  find_free_last_and_remove(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits) { return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_last_and_remove(_bin0, _bin1, maxbits); }
         s32  find_free_after(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, u32 maxbits, u32 pivot) { return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_after(_bin0, _bin1, maxbits, pivot); }
         s32  find_free_before(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, u32 maxbits, u32 pivot) { return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_before(_bin0, _bin1, maxbits, pivot); }
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32* out_bits, u32 count) { return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_and_remove_n(_bin0, _bin1, maxbits, out_bits, count); }
+        void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 const* bits, u32 count) { bitvec_bin0_bin1_t<bintype_t, 6>::set_free_n(_bin0, _bin1, maxbits, bits, count); }
+
+        s32 find_free_range(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, u32 maxbits, u32 n)
+        {
+            bintype_t const* levels[] = {_bin0, _bin1};
+            return bitvec_range_t<bintype_t, 6, 2>::find_free_range(levels, maxbits, n);
+        }
+        s32 alloc_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            return bitvec_range_t<bintype_t, 6, 2>::alloc_range(levels, maxbits, n);
+        }
+        void free_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 start, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            bitvec_range_t<bintype_t, 6, 2>::set_free_range(levels, maxbits, start, n);
+        }
+
+        s32 find_free_and_remove_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            return bitvec_concurrent_t<bintype_t, 6, 2>::find_free_and_remove(levels, maxbits);
+        }
+        void set_free_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            bitvec_concurrent_t<bintype_t, 6, 2>::set_free(levels, maxbits, bit);
+        }
+        void set_used_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1};
+            bitvec_concurrent_t<bintype_t, 6, 2>::set_used(levels, maxbits, bit);
+        }
     }  // namespace nbitvec12
 
     // --------------------------------------------------------------------------------
@@ -497,17 +963,18 @@ namespace ncore
 
         static void set_all_free(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits)
         {
-            u32 size = (maxbits + (binbits - 1)) >> binshift;
-            for (u32 i = 0; i < size; ++i)
+            u32 const size2 = (maxbits + (binbits - 1)) >> binshift;
+            for (u32 i = 0; i < size2; ++i)
                 _bin2[i] = (binconstant);
-            if ((maxbits & binmask) && size > 0)
-                _bin2[size - 1] &= ((bintype_t)1 << (maxbits & binmask)) - 1;
+            if ((maxbits & binmask) && size2 > 0)
+                _bin2[size2 - 1] &= ((bintype_t)1 << (maxbits & binmask)) - 1;
 
-            size = (size + (binbits - 1)) >> binshift;
-            for (u32 i = 0; i < size; ++i)
+            // a bit at this level represents a word at level 2, so mask by the (partial) word count of level 2
+            u32 const size1 = (size2 + (binbits - 1)) >> binshift;
+            for (u32 i = 0; i < size1; ++i)
                 _bin1[i] = (binconstant);
-            if (((maxbits >> binshift) & binmask) && size > 0)
-                _bin1[size - 1] &= ((bintype_t)1 << ((maxbits >> binshift) & binmask)) - 1;
+            if ((size2 & binmask) && size1 > 0)
+                _bin1[size1 - 1] &= ((bintype_t)1 << (size2 & binmask)) - 1;
 
             *_bin0 = valid_level0_mask(maxbits);
         }
@@ -602,6 +1069,65 @@ namespace ncore
             return bit;
         }
 
+        static inline bintype_t valid_word_mask(u32 word, u32 maxbits) { return mask_for_count(maxbits - (word << binshift)); }
+
+        static u32 find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32* out_bits, u32 count)
+        {
+            u32 n = 0;
+            while (n < count)
+            {
+                bintype_t const summary0 = *_bin0 & valid_level0_mask(maxbits);
+                if (summary0 == 0)
+                    break;
+
+                u32 const       b0       = (u32)math::findFirstBit(summary0);
+                bintype_t const summary1 = _bin1[b0];
+                ASSERT(summary1 != 0);
+
+                u32 const       w2   = (u32)math::findFirstBit(summary1) + (b0 << binshift);
+                bintype_t const word = _bin2[w2] & valid_word_mask(w2, maxbits);
+                if (word == 0)
+                    break;
+
+                // claim the bits of this word at once, the summary levels only change when the word becomes empty
+                bintype_t const rest = s_take_lowest_bits(word, w2 << binshift, out_bits, n, count);
+                _bin2[w2] &= ~(word ^ rest);
+                if (_bin2[w2] != 0)
+                    continue;
+
+                _bin1[b0] = D_BIT_CLEAR(_bin1[b0], w2 & binmask);
+                if (_bin1[b0] == 0)
+                    *_bin0 = D_BIT_CLEAR(*_bin0, b0);
+            }
+            return n;
+        }
+
+        static void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 const* bits, u32 count)
+        {
+            u32 i = 0;
+            while (i < count)
+            {
+                u32 const i2   = bits[i] >> binshift;
+                bintype_t mask = 0;
+                for (; i < count && (bits[i] >> binshift) == i2; ++i)
+                {
+                    ASSERT(bits[i] < maxbits);
+                    mask = D_BIT_SET(mask, bits[i] & binmask);
+                }
+
+                bintype_t const old2 = _bin2[i2];
+                _bin2[i2]            = old2 | mask;
+                if (old2 != 0)
+                    continue;
+
+                u32 const       i1   = i2 >> binshift;
+                bintype_t const old1 = _bin1[i1];
+                _bin1[i1]            = D_BIT_SET(old1, i2 & binmask);
+                if (old1 == 0)
+                    *_bin0 = D_BIT_SET(*_bin0, i1);
+            }
+        }
+
         static s32 find_free_last(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, u32 maxbits)
         {
             bintype_t summary0 = *_bin0 & valid_level0_mask(maxbits);
@@ -739,6 +1265,40 @@ namespace ncore
         { return bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::find_free_after(_bin0, _bin1, _bin2, maxbits, pivot); }
         s32 find_free_before(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, u32 maxbits, u32 pivot)
         { return bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::find_free_before(_bin0, _bin1, _bin2, maxbits, pivot); }
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32* out_bits, u32 count) { return bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::find_free_and_remove_n(_bin0, _bin1, _bin2, maxbits, out_bits, count); }
+        void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 const* bits, u32 count) { bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::set_free_n(_bin0, _bin1, _bin2, maxbits, bits, count); }
+
+        s32 find_free_range(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, u32 maxbits, u32 n)
+        {
+            bintype_t const* levels[] = {_bin0, _bin1, _bin2};
+            return bitvec_range_t<bintype_t, 5, 3>::find_free_range(levels, maxbits, n);
+        }
+        s32 alloc_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            return bitvec_range_t<bintype_t, 5, 3>::alloc_range(levels, maxbits, n);
+        }
+        void free_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 start, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            bitvec_range_t<bintype_t, 5, 3>::set_free_range(levels, maxbits, start, n);
+        }
+
+        s32 find_free_and_remove_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            return bitvec_concurrent_t<bintype_t, 5, 3>::find_free_and_remove(levels, maxbits);
+        }
+        void set_free_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            bitvec_concurrent_t<bintype_t, 5, 3>::set_free(levels, maxbits, bit);
+        }
+        void set_used_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            bitvec_concurrent_t<bintype_t, 5, 3>::set_used(levels, maxbits, bit);
+        }
     }  // namespace nbitvec15
 
     namespace nbitvec18
@@ -762,6 +1322,40 @@ namespace ncore
         { return bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::find_free_after(_bin0, _bin1, _bin2, maxbits, pivot); }
         s32 find_free_before(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, u32 maxbits, u32 pivot)
         { return bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::find_free_before(_bin0, _bin1, _bin2, maxbits, pivot); }
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32* out_bits, u32 count) { return bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::find_free_and_remove_n(_bin0, _bin1, _bin2, maxbits, out_bits, count); }
+        void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 const* bits, u32 count) { bitvec_bin0_bin1_bin2_t<bintype_t, binshift>::set_free_n(_bin0, _bin1, _bin2, maxbits, bits, count); }
+
+        s32 find_free_range(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, u32 maxbits, u32 n)
+        {
+            bintype_t const* levels[] = {_bin0, _bin1, _bin2};
+            return bitvec_range_t<bintype_t, 6, 3>::find_free_range(levels, maxbits, n);
+        }
+        s32 alloc_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            return bitvec_range_t<bintype_t, 6, 3>::alloc_range(levels, maxbits, n);
+        }
+        void free_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 start, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            bitvec_range_t<bintype_t, 6, 3>::set_free_range(levels, maxbits, start, n);
+        }
+
+        s32 find_free_and_remove_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            return bitvec_concurrent_t<bintype_t, 6, 3>::find_free_and_remove(levels, maxbits);
+        }
+        void set_free_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            bitvec_concurrent_t<bintype_t, 6, 3>::set_free(levels, maxbits, bit);
+        }
+        void set_used_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2};
+            bitvec_concurrent_t<bintype_t, 6, 3>::set_used(levels, maxbits, bit);
+        }
     }  // namespace nbitvec18
 
     // --------------------------------------------------------------------------------
@@ -842,30 +1436,30 @@ namespace ncore
         static void set_all_free(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits)
         {
             // free means bits are set to 1
-            u32 size = (maxbits + (binbits - 1)) >> binshift;
-            for (u32 i = 0; i < size; ++i)
+            u32 const size3 = (maxbits + (binbits - 1)) >> binshift;
+            for (u32 i = 0; i < size3; ++i)
                 _bin3[i] = binconstant;
 
             // mask off the excess bits in the last word of this level, if any
-            if ((maxbits & binmask) && size > 0)
-                _bin3[size - 1] &= mask_for_count(maxbits & binmask);
+            if ((maxbits & binmask) && size3 > 0)
+                _bin3[size3 - 1] &= mask_for_count(maxbits & binmask);
 
-            size = (size + (binbits - 1)) >> binshift;
-            for (u32 i = 0; i < size; ++i)
+            u32 const size2 = (size3 + (binbits - 1)) >> binshift;
+            for (u32 i = 0; i < size2; ++i)
                 _bin2[i] = binconstant;
 
-            // mask off the excess bits in the last word of this level, if any
-            if ((maxbits & (binmask << binshift)) && size > 0)
-                _bin2[size - 1] &= mask_for_count((maxbits >> binshift) & binmask);
+            // a bit at a summary level represents a word at the level below, so mask by the (partial) word count of that level
+            if ((size3 & binmask) && size2 > 0)
+                _bin2[size2 - 1] &= mask_for_count(size3 & binmask);
 
-            size = (size + (binbits - 1)) >> binshift;
-            for (u32 i = 0; i < size; ++i)
+            u32 const size1 = (size2 + (binbits - 1)) >> binshift;
+            for (u32 i = 0; i < size1; ++i)
                 _bin1[i] = binconstant;
 
-            if ((maxbits & (binmask << (binshift * 2))) && size > 0)
-                _bin1[size - 1] &= mask_for_count((maxbits >> (binshift * 2)) & binmask);
+            if ((size2 & binmask) && size1 > 0)
+                _bin1[size1 - 1] &= mask_for_count(size2 & binmask);
 
-            *_bin0 = binconstant;
+            *_bin0 = mask_for_count(size1);
         }
 
         static void set_all_used(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits)
@@ -976,6 +1570,79 @@ namespace ncore
             return bit;
         }
 
+        static inline bintype_t valid_word_mask(u32 word, u32 maxbits) { return mask_for_count(maxbits - (word << binshift)); }
+
+        static u32 find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32* out_bits, u32 count)
+        {
+            u32 n = 0;
+            while (n < count)
+            {
+                bintype_t const summary0 = *_bin0 & valid_level0_mask(maxbits);
+                if (summary0 == 0)
+                    break;
+
+                u32 const       b0       = (u32)math::findFirstBit(summary0);
+                bintype_t const summary1 = _bin1[b0];
+                ASSERT(summary1 != 0);
+
+                u32 const       w2       = (u32)math::findFirstBit(summary1) + (b0 << binshift);
+                bintype_t const summary2 = _bin2[w2];
+                ASSERT(summary2 != 0);
+
+                u32 const       w3   = (u32)math::findFirstBit(summary2) + (w2 << binshift);
+                bintype_t const word = _bin3[w3] & valid_word_mask(w3, maxbits);
+                if (word == 0)
+                    break;
+
+                // claim the bits of this word at once, the summary levels only change when the word becomes empty
+                bintype_t const rest = s_take_lowest_bits(word, w3 << binshift, out_bits, n, count);
+                _bin3[w3] &= ~(word ^ rest);
+                if (_bin3[w3] != 0)
+                    continue;
+
+                _bin2[w2] = D_BIT_CLEAR(_bin2[w2], w3 & binmask);
+                if (_bin2[w2] != 0)
+                    continue;
+
+                _bin1[b0] = D_BIT_CLEAR(_bin1[b0], w2 & binmask);
+                if (_bin1[b0] == 0)
+                    *_bin0 = D_BIT_CLEAR(*_bin0, b0);
+            }
+            return n;
+        }
+
+        static void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 const* bits, u32 count)
+        {
+            u32 i = 0;
+            while (i < count)
+            {
+                u32 const i3   = bits[i] >> binshift;
+                bintype_t mask = 0;
+                for (; i < count && (bits[i] >> binshift) == i3; ++i)
+                {
+                    ASSERT(bits[i] < maxbits);
+                    mask = D_BIT_SET(mask, bits[i] & binmask);
+                }
+
+                bintype_t const old3 = _bin3[i3];
+                _bin3[i3]            = old3 | mask;
+                if (old3 != 0)
+                    continue;
+
+                u32 const       i2   = i3 >> binshift;
+                bintype_t const old2 = _bin2[i2];
+                _bin2[i2]            = D_BIT_SET(old2, i3 & binmask);
+                if (old2 != 0)
+                    continue;
+
+                u32 const       i1   = i2 >> binshift;
+                bintype_t const old1 = _bin1[i1];
+                _bin1[i1]            = D_BIT_SET(old1, i2 & binmask);
+                if (old1 == 0)
+                    *_bin0 = D_BIT_SET(*_bin0, i1);
+            }
+        }
+
         static s32 find_free_last(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT bin2, bintype_t const * CC_RESTRICT bin3, u32 maxbits)
         {
             bintype_t const summary0 = *_bin0 & valid_level0_mask(maxbits);
@@ -1029,7 +1696,7 @@ namespace ncore
             {
                 u32 const       b2    = (u32)math::findFirstBit(level2);
                 u32 const       w3    = b2 + (start_level2 << binshift);
-                bintype_t const word3 = bin3[w3] & mask_from(start_level3_bit + 1);
+                bintype_t const word3 = bin3[w3];
                 ASSERT(word3 != 0);
                 return (s32)((w3 << binshift) + (u32)math::findFirstBit(word3));
             }
@@ -1160,6 +1827,40 @@ namespace ncore
         { return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 5>::find_free_after(_bin0, _bin1, _bin2, _bin3, maxbits, pivot); }
         s32 find_free_before(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, bintype_t const * CC_RESTRICT _bin3, u32 maxbits, u32 pivot)
         { return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 5>::find_free_before(_bin0, _bin1, _bin2, _bin3, maxbits, pivot); }
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32* out_bits, u32 count) { return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 5>::find_free_and_remove_n(_bin0, _bin1, _bin2, _bin3, maxbits, out_bits, count); }
+        void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 const* bits, u32 count) { bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 5>::set_free_n(_bin0, _bin1, _bin2, _bin3, maxbits, bits, count); }
+
+        s32 find_free_range(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, bintype_t const * CC_RESTRICT _bin3, u32 maxbits, u32 n)
+        {
+            bintype_t const* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            return bitvec_range_t<bintype_t, 5, 4>::find_free_range(levels, maxbits, n);
+        }
+        s32 alloc_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            return bitvec_range_t<bintype_t, 5, 4>::alloc_range(levels, maxbits, n);
+        }
+        void free_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 start, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            bitvec_range_t<bintype_t, 5, 4>::set_free_range(levels, maxbits, start, n);
+        }
+
+        s32 find_free_and_remove_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            return bitvec_concurrent_t<bintype_t, 5, 4>::find_free_and_remove(levels, maxbits);
+        }
+        void set_free_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            bitvec_concurrent_t<bintype_t, 5, 4>::set_free(levels, maxbits, bit);
+        }
+        void set_used_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            bitvec_concurrent_t<bintype_t, 5, 4>::set_used(levels, maxbits, bit);
+        }
     }  // namespace nbitvec20
 
     namespace nbitvec24
@@ -1187,6 +1888,40 @@ namespace ncore
         { return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free_after(_bin0, _bin1, _bin2, _bin3, maxbits, pivot); }
         s32 find_free_before(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, bintype_t const * CC_RESTRICT _bin3, u32 maxbits, u32 pivot)
         { return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free_before(_bin0, _bin1, _bin2, _bin3, maxbits, pivot); }
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32* out_bits, u32 count) { return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free_and_remove_n(_bin0, _bin1, _bin2, _bin3, maxbits, out_bits, count); }
+        void set_free_n(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 const* bits, u32 count) { bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::set_free_n(_bin0, _bin1, _bin2, _bin3, maxbits, bits, count); }
+
+        s32 find_free_range(bintype_t const * CC_RESTRICT _bin0, bintype_t const * CC_RESTRICT _bin1, bintype_t const * CC_RESTRICT _bin2, bintype_t const * CC_RESTRICT _bin3, u32 maxbits, u32 n)
+        {
+            bintype_t const* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            return bitvec_range_t<bintype_t, 6, 4>::find_free_range(levels, maxbits, n);
+        }
+        s32 alloc_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            return bitvec_range_t<bintype_t, 6, 4>::alloc_range(levels, maxbits, n);
+        }
+        void free_range(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 start, u32 n)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            bitvec_range_t<bintype_t, 6, 4>::set_free_range(levels, maxbits, start, n);
+        }
+
+        s32 find_free_and_remove_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            return bitvec_concurrent_t<bintype_t, 6, 4>::find_free_and_remove(levels, maxbits);
+        }
+        void set_free_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            bitvec_concurrent_t<bintype_t, 6, 4>::set_free(levels, maxbits, bit);
+        }
+        void set_used_concurrent(bintype_t* CC_RESTRICT _bin0, bintype_t* CC_RESTRICT _bin1, bintype_t* CC_RESTRICT _bin2, bintype_t* CC_RESTRICT _bin3, u32 maxbits, u32 bit)
+        {
+            bintype_t* levels[] = {_bin0, _bin1, _bin2, _bin3};
+            bitvec_concurrent_t<bintype_t, 6, 4>::set_used(levels, maxbits, bit);
+        }
     }  // namespace nbitvec24
 
     namespace nbitvec
@@ -1221,10 +1956,13 @@ namespace ncore
             layout.m_maxbits = number_of_bits;
 
             // force 2 layers
-            u32 len       = number_of_bits;
-            len           = (len + 63) >> 6;
-            layout.m_bin1 = len > 0 ? len : 1;
-            layout.m_bin0 = 1;
+            u32 len         = number_of_bits;
+            len             = (len + 63) >> 6;
+            layout.m_bin3   = 0;
+            layout.m_bin2   = 0;
+            layout.m_bin1   = len > 0 ? len : 1;
+            layout.m_bin0   = 1;
+            layout.m_levels = 1;
         }
 
         void compute_l3(u32 number_of_bits, layout64_t& layout)
@@ -1234,12 +1972,14 @@ namespace ncore
             layout.m_maxbits = number_of_bits;
 
             // force 3 layers
-            u32 len       = number_of_bits;
-            len           = (len + 63) >> 6;
-            layout.m_bin2 = len > 0 ? len : 1;
-            len           = (len + 63) >> 6;
-            layout.m_bin1 = len > 0 ? len : 1;
-            layout.m_bin0 = 1;
+            u32 len         = number_of_bits;
+            len             = (len + 63) >> 6;
+            layout.m_bin3   = 0;
+            layout.m_bin2   = len > 0 ? len : 1;
+            len             = (len + 63) >> 6;
+            layout.m_bin1   = len > 0 ? len : 1;
+            layout.m_bin0   = 1;
+            layout.m_levels = 2;
         }
 
         void compute_l4(u32 number_of_bits, layout64_t& layout)
@@ -1249,14 +1989,15 @@ namespace ncore
             layout.m_maxbits = number_of_bits;
 
             // force 4 layers
-            u32 len       = number_of_bits;
-            len           = (len + 63) >> 6;
-            layout.m_bin3 = len > 0 ? len : 1;
-            len           = (len + 63) >> 6;
-            layout.m_bin2 = len > 0 ? len : 1;
-            len           = (len + 63) >> 6;
-            layout.m_bin1 = len > 0 ? len : 1;
-            layout.m_bin0 = 1;
+            u32 len         = number_of_bits;
+            len             = (len + 63) >> 6;
+            layout.m_bin3   = len > 0 ? len : 1;
+            len             = (len + 63) >> 6;
+            layout.m_bin2   = len > 0 ? len : 1;
+            len             = (len + 63) >> 6;
+            layout.m_bin1   = len > 0 ? len : 1;
+            layout.m_bin0   = 1;
+            layout.m_levels = 3;
         }
 
         u32 sizeof_data(layout64_t const & l) { return l.m_bin0 + l.m_bin1 + l.m_bin2 + l.m_bin3; }
@@ -1291,10 +2032,13 @@ namespace ncore
             layout.m_maxbits = number_of_bits;
 
             // force 2 layers
-            u32 len       = number_of_bits;
-            len           = (len + 31) >> 5;
-            layout.m_bin1 = len > 0 ? len : 1;
-            layout.m_bin0 = 1;
+            u32 len         = number_of_bits;
+            len             = (len + 31) >> 5;
+            layout.m_bin3   = 0;
+            layout.m_bin2   = 0;
+            layout.m_bin1   = len > 0 ? len : 1;
+            layout.m_bin0   = 1;
+            layout.m_levels = 1;
         }
 
         void compute_l3(u32 number_of_bits, layout32_t& layout)
@@ -1304,12 +2048,14 @@ namespace ncore
             layout.m_maxbits = number_of_bits;
 
             // force 3 layers
-            u32 len       = number_of_bits;
-            len           = (len + 31) >> 5;
-            layout.m_bin2 = len > 0 ? len : 1;
-            len           = (len + 31) >> 5;
-            layout.m_bin1 = len > 0 ? len : 1;
-            layout.m_bin0 = 1;
+            u32 len         = number_of_bits;
+            len             = (len + 31) >> 5;
+            layout.m_bin3   = 0;
+            layout.m_bin2   = len > 0 ? len : 1;
+            len             = (len + 31) >> 5;
+            layout.m_bin1   = len > 0 ? len : 1;
+            layout.m_bin0   = 1;
+            layout.m_levels = 2;
         }
 
         void compute_l4(u32 number_of_bits, layout32_t& layout)
@@ -1319,18 +2065,500 @@ namespace ncore
             layout.m_maxbits = number_of_bits;
 
             // force 4 layers
-            u32 len       = number_of_bits;
-            len           = (len + 31) >> 5;
-            layout.m_bin3 = len > 0 ? len : 1;
-            len           = (len + 31) >> 5;
-            layout.m_bin2 = len > 0 ? len : 1;
-            len           = (len + 31) >> 5;
-            layout.m_bin1 = len > 0 ? len : 1;
-            layout.m_bin0 = 1;
+            u32 len         = number_of_bits;
+            len             = (len + 31) >> 5;
+            layout.m_bin3   = len > 0 ? len : 1;
+            len             = (len + 31) >> 5;
+            layout.m_bin2   = len > 0 ? len : 1;
+            len             = (len + 31) >> 5;
+            layout.m_bin1   = len > 0 ? len : 1;
+            layout.m_bin0   = 1;
+            layout.m_levels = 3;
         }
 
         u32 sizeof_data(layout32_t const & l) { return l.m_bin0 + l.m_bin1 + l.m_bin2 + l.m_bin3; }
 
+        // --------------------------------------------------------------------------------------------
+        // whole-set operations
+
+        enum
+        {
+            BULK_AND    = 0,
+            BULK_OR     = 1,
+            BULK_ANDNOT = 2,
+            BULK_XOR    = 3,
+        };
+
+        template <s32 op>
+        static inline u64 s_bulk_op(u64 d, u64 s)
+        {
+            switch (op)
+            {
+                case BULK_AND: return d & s;
+                case BULK_OR: return d | s;
+                case BULK_ANDNOT: return d & ~s;
+                default: return d ^ s;
+            }
+        }
+
+        // Combines 'n' (<= 64) leaf words and returns the summary word, a bit for every word that is non-zero
+        template <s32 op>
+        static u64 s_bulk_words(u64* dst, u64 const* src, u32 n)
+        {
+            u64 summary = 0;
+            u32 i       = 0;
+#if CC_AVX2
+            __m256i const zero = _mm256_setzero_si256();
+            for (; (i + 4) <= n; i += 4)
+            {
+                __m256i const d = _mm256_loadu_si256((__m256i const*)(dst + i));
+                __m256i const s = _mm256_loadu_si256((__m256i const*)(src + i));
+                __m256i       r;
+                switch (op)
+                {
+                    case BULK_AND: r = _mm256_and_si256(d, s); break;
+                    case BULK_OR: r = _mm256_or_si256(d, s); break;
+                    case BULK_ANDNOT: r = _mm256_andnot_si256(s, d); break;
+                    default: r = _mm256_xor_si256(d, s); break;
+                }
+                _mm256_storeu_si256((__m256i*)(dst + i), r);
+                u32 const zeros = (u32)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(r, zero)));
+                summary |= (u64)(~zeros & 0xF) << i;
+            }
+#elif CC_SSE2
+            __m128i const zero = _mm_setzero_si128();
+            for (; (i + 2) <= n; i += 2)
+            {
+                __m128i const d = _mm_loadu_si128((__m128i const*)(dst + i));
+                __m128i const s = _mm_loadu_si128((__m128i const*)(src + i));
+                __m128i       r;
+                switch (op)
+                {
+                    case BULK_AND: r = _mm_and_si128(d, s); break;
+                    case BULK_OR: r = _mm_or_si128(d, s); break;
+                    case BULK_ANDNOT: r = _mm_andnot_si128(s, d); break;
+                    default: r = _mm_xor_si128(d, s); break;
+                }
+                _mm_storeu_si128((__m128i*)(dst + i), r);
+                // SSE2 has no 64-bit compare, a word is zero when both of its 32-bit halves are
+                __m128i const eq    = _mm_cmpeq_epi32(r, zero);
+                u32 const     zeros = (u32)_mm_movemask_pd(_mm_castsi128_pd(_mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)))));
+                summary |= (u64)(~zeros & 0x3) << i;
+            }
+#elif CC_NEON
+            for (; (i + 2) <= n; i += 2)
+            {
+                uint64x2_t const d = vld1q_u64(dst + i);
+                uint64x2_t const s = vld1q_u64(src + i);
+                uint64x2_t       r;
+                switch (op)
+                {
+                    case BULK_AND: r = vandq_u64(d, s); break;
+                    case BULK_OR: r = vorrq_u64(d, s); break;
+                    case BULK_ANDNOT: r = vbicq_u64(d, s); break;
+                    default: r = veorq_u64(d, s); break;
+                }
+                vst1q_u64(dst + i, r);
+                summary |= (u64)(vgetq_lane_u64(r, 0) != 0) << i;
+                summary |= (u64)(vgetq_lane_u64(r, 1) != 0) << (i + 1);
+            }
+#endif
+            for (; i < n; ++i)
+            {
+                u64 const r = s_bulk_op<op>(dst[i], src[i]);
+                dst[i]      = r;
+                summary |= (u64)(r != 0) << i;
+            }
+            return summary;
+        }
+
+        static inline void s_bulk_levels(u64* data, layout64_t const& l, u64** levels)
+        {
+            u32 const sizes[] = {l.m_bin0, l.m_bin1, l.m_bin2, l.m_bin3};
+            for (u32 i = 0; i <= l.m_levels; ++i)
+            {
+                levels[i] = data;
+                data += sizes[i];
+            }
+        }
+
+        // A word at 'level' went from 'old_word' to 'new_word', the bit of that word in the level above only changes
+        // when the word became zero or non-zero.
+        static inline void s_bulk_propagate(u64* const* levels, u32 level, u32 index, u64 old_word, u64 new_word)
+        {
+            while (level > 0 && ((old_word == 0) != (new_word == 0)))
+            {
+                u64* const parent = &levels[level - 1][index >> 6];
+                u64 const  bit    = (u64)1 << (index & 63);
+                old_word          = *parent;
+                new_word          = (new_word != 0) ? (old_word | bit) : (old_word & ~bit);
+                *parent           = new_word;
+                index >>= 6;
+                level -= 1;
+            }
+        }
+
+        // 'leaf' (>= 1) is the index of the level that holds the bits, 'nwords' is the number of words at that level
+        template <s32 op>
+        static void s_bulk(u64* const* dl, u64 const* const* sl, u32 leaf, u32 nwords)
+        {
+            // every summary word above the leaf covers (up to) 64 leaf words
+            u64* const       dsum  = dl[leaf - 1];
+            u64 const* const ssum  = sl[leaf - 1];
+            u32 const        nsums = (nwords + 63) >> 6;
+            for (u32 i = 0; i < nsums; ++i)
+            {
+                u64 const d = dsum[i];
+                u64 const s = ssum[i];
+
+                // skip the words the operation does not change
+                if ((op == BULK_AND || op == BULK_ANDNOT) && d == 0)
+                    continue;
+                if ((op != BULK_AND) && s == 0)
+                    continue;
+
+                u32 const first = i << 6;
+                u64       summary;
+                if (op == BULK_AND && s == 0)
+                {
+                    // nothing to intersect with, only clear the non-zero words
+                    for (u64 bits = d; bits != 0; bits &= bits - 1)
+                        dl[leaf][first + math::findFirstBit(bits)] = 0;
+                    summary = 0;
+                }
+                else
+                {
+                    summary = s_bulk_words<op>(dl[leaf] + first, sl[leaf] + first, math::min(nwords - first, (u32)64));
+                }
+
+                if (summary != d)
+                {
+                    dsum[i] = summary;
+                    s_bulk_propagate(dl, leaf - 1, i, d, summary);
+                }
+            }
+        }
+
+        template <s32 op>
+        static void s_bulk(u64* dst, u64 const* src, layout64_t const& l)
+        {
+            ASSERT(l.m_levels <= 3);
+            if (l.m_levels == 0)
+            {
+                dst[0] = s_bulk_op<op>(dst[0], src[0]);
+                return;
+            }
+
+            u64* dl[4];
+            u64* sl[4];
+            s_bulk_levels(dst, l, dl);
+            s_bulk_levels((u64*)src, l, sl);
+            s_bulk<op>(dl, sl, l.m_levels, (l.m_maxbits + 63) >> 6);
+        }
+
+        void bulk_and(u64* dst, u64 const* src, layout64_t const& l) { s_bulk<BULK_AND>(dst, src, l); }
+        void bulk_or(u64* dst, u64 const* src, layout64_t const& l) { s_bulk<BULK_OR>(dst, src, l); }
+        void bulk_andnot(u64* dst, u64 const* src, layout64_t const& l) { s_bulk<BULK_ANDNOT>(dst, src, l); }
+        void bulk_xor(u64* dst, u64 const* src, layout64_t const& l) { s_bulk<BULK_XOR>(dst, src, l); }
+
+        static inline u32 s_popcount_words(u64 const* words, u32 n)
+        {
+            u32 count = 0;
+            u32 i     = 0;
+#if CC_AVX2
+            // count the bits of every nibble with a table lookup, sum the bytes per 64-bit lane
+            __m256i const table  = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            __m256i const low    = _mm256_set1_epi8(0x0F);
+            __m256i       totals = _mm256_setzero_si256();
+            for (; (i + 4) <= n; i += 4)
+            {
+                __m256i const v      = _mm256_loadu_si256((__m256i const*)(words + i));
+                __m256i const lo     = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+                __m256i const hi     = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+                totals           = _mm256_add_epi64(totals, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+            }
+            count = (u32)(_mm256_extract_epi64(totals, 0) + _mm256_extract_epi64(totals, 1) + _mm256_extract_epi64(totals, 2) + _mm256_extract_epi64(totals, 3));
+#endif
+            for (; i < n; ++i)
+                count += (u32)math::countBits(words[i]);
+            return count;
+        }
+
+        // only the groups of 64 words that have a non-zero word are counted
+        static u32 s_popcount(u64 const* const* levels, u32 leaf, u32 nwords)
+        {
+            u64 const* const sum   = levels[leaf - 1];
+            u32 const        nsums = (nwords + 63) >> 6;
+            u32              count = 0;
+            for (u32 i = 0; i < nsums; ++i)
+            {
+                if (sum[i] != 0)
+                {
+                    u32 const first = i << 6;
+                    count += s_popcount_words(levels[leaf] + first, math::min(nwords - first, (u32)64));
+                }
+            }
+            return count;
+        }
+
+        u32 popcount(u64 const* data, layout64_t const& l)
+        {
+            ASSERT(l.m_levels <= 3);
+            if (l.m_levels == 0)
+                return (u32)math::countBits(data[0]);
+
+            u64* levels[4];
+            s_bulk_levels((u64*)data, l, levels);
+            return s_popcount(levels, l.m_levels, (l.m_maxbits + 63) >> 6);
+        }
+
+        bool any(u64 const* data, layout64_t const& l)
+        {
+            CC_UNUSED(l);
+            return data[0] != 0;  // the root word has a bit for every non-zero word of the level below
+        }
+
+    }  // namespace nbitvec
+
+    // --------------------------------------------------------------------------------
+    // runtime sized bit-vector, dispatches to the 2, 3 and 4 level implementations
+    // --------------------------------------------------------------------------------
+
+    namespace nbitvec
+    {
+        typedef u64 bintype_t;
+
+        // byte offsets of the levels in the block, every level starts on a cache line, the last level is at the end
+        static u32 s_block_offsets(u32 capacity, u32 levels, u32* offsets)
+        {
+            u32 words[4];
+            words[levels] = (capacity + 63) >> 6;
+            for (s32 i = (s32)levels - 1; i >= 0; --i)
+                words[i] = (words[i + 1] + 63) >> 6;
+
+            u32 offset = 0;
+            for (u32 i = 0; i <= levels; ++i)
+            {
+                offsets[i] = offset;
+                offset     = math::alignUp(offset + (words[i] * (u32)sizeof(u64)), (u32)CC_CACHE_LINE_SIZE);
+            }
+            return offset;
+        }
+
+        // memory that has to be committed for 'maxbits', the levels above the last one are always fully committed
+        static inline uint_t s_commit_size(bitvec_t const* bv, u32 maxbits) { return (uint_t)((byte const*)bv->m_bins[bv->m_levels] - narena::base_ptr(bv->m_arena)) + (((maxbits + 63) >> 6) * sizeof(u64)); }
+
+        bool setup(bitvec_t* bv, u32 maxbits, u32 capacity)
+        {
+            ASSERT(maxbits <= capacity && capacity > 0 && capacity <= 16 * 1024 * 1024);
+
+            // a single word bit-vector also gets a level above it, so there are always 2, 3 or 4 levels
+            layout64_t layout;
+            compute(capacity, layout);
+            bv->m_levels   = layout.m_levels > 0 ? layout.m_levels : 1;
+            bv->m_maxbits  = maxbits;
+            bv->m_capacity = capacity;
+
+            u32       offsets[4];
+            u32 const block_size = s_block_offsets(capacity, bv->m_levels, offsets);
+            bv->m_arena          = narena::new_arena(block_size, offsets[bv->m_levels]);
+            if (bv->m_arena == nullptr)
+            {
+                destroy(bv);
+                return false;
+            }
+
+            // committed pages are zero, all bits are used
+            for (u32 i = 0; i < 4; ++i)
+                bv->m_bins[i] = (i <= bv->m_levels) ? (u64*)(narena::base_ptr(bv->m_arena) + offsets[i]) : nullptr;
+            if (!narena::commit(bv->m_arena, s_commit_size(bv, maxbits)))
+            {
+                destroy(bv);
+                return false;
+            }
+            return true;
+        }
+
+        void destroy(bitvec_t* bv)
+        {
+            if (bv->m_arena != nullptr)
+                narena::destroy(bv->m_arena);
+            bv->m_arena = nullptr;
+            for (u32 i = 0; i < 4; ++i)
+                bv->m_bins[i] = nullptr;
+            bv->m_maxbits  = 0;
+            bv->m_capacity = 0;
+        }
+
+        bool grow(bitvec_t* bv, u32 maxbits)
+        {
+            if (maxbits > bv->m_capacity)
+                return false;
+            if (maxbits <= bv->m_maxbits)
+                return true;
+
+            // the words beyond the old number of bits are zero, so the new bits are used and the summary levels are correct
+            if (!narena::commit(bv->m_arena, s_commit_size(bv, maxbits)))
+                return false;
+            bv->m_maxbits = maxbits;
+            return true;
+        }
+
+        void set_all_free(bitvec_t* bv)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::set_all_free(b[0], b[1], bv->m_maxbits);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::set_all_free(b[0], b[1], b[2], bv->m_maxbits);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::set_all_free(b[0], b[1], b[2], b[3], bv->m_maxbits);
+            }
+        }
+
+        void set_all_used(bitvec_t* bv)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::set_all_used(b[0], b[1], bv->m_maxbits);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::set_all_used(b[0], b[1], b[2], bv->m_maxbits);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::set_all_used(b[0], b[1], b[2], b[3], bv->m_maxbits);
+            }
+        }
+
+        void set_free(bitvec_t* bv, u32 bit)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::set_free(b[0], b[1], bv->m_maxbits, bit);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::set_free(b[0], b[1], b[2], bv->m_maxbits, bit);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::set_free(b[0], b[1], b[2], b[3], bv->m_maxbits, bit);
+            }
+        }
+
+        void set_used(bitvec_t* bv, u32 bit)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::set_used(b[0], b[1], bv->m_maxbits, bit);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::set_used(b[0], b[1], b[2], bv->m_maxbits, bit);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::set_used(b[0], b[1], b[2], b[3], bv->m_maxbits, bit);
+            }
+        }
+
+        bool get(bitvec_t const* bv, u32 bit)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::get(b[0], b[1], bv->m_maxbits, bit);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::get(b[0], b[1], b[2], bv->m_maxbits, bit);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::get(b[0], b[1], b[2], b[3], bv->m_maxbits, bit);
+            }
+        }
+
+        s32 find_free(bitvec_t const* bv)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::find_free(b[0], b[1], bv->m_maxbits);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::find_free(b[0], b[1], b[2], bv->m_maxbits);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free(b[0], b[1], b[2], b[3], bv->m_maxbits);
+            }
+        }
+
+        s32 find_free_and_remove(bitvec_t* bv)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_and_remove(b[0], b[1], bv->m_maxbits);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::find_free_and_remove(b[0], b[1], b[2], bv->m_maxbits);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free_and_remove(b[0], b[1], b[2], b[3], bv->m_maxbits);
+            }
+        }
+
+        s32 find_free_last(bitvec_t const* bv)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_last(b[0], b[1], bv->m_maxbits);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::find_free_last(b[0], b[1], b[2], bv->m_maxbits);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free_last(b[0], b[1], b[2], b[3], bv->m_maxbits);
+            }
+        }
+
+        s32 find_free_after(bitvec_t const* bv, u32 pivot)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_after(b[0], b[1], bv->m_maxbits, pivot);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::find_free_after(b[0], b[1], b[2], bv->m_maxbits, pivot);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free_after(b[0], b[1], b[2], b[3], bv->m_maxbits, pivot);
+            }
+        }
+
+        s32 find_free_before(bitvec_t const* bv, u32 pivot)
+        {
+            u64* const* b = bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_bin0_bin1_t<bintype_t, 6>::find_free_before(b[0], b[1], bv->m_maxbits, pivot);
+                case 2: return bitvec_bin0_bin1_bin2_t<bintype_t, 6>::find_free_before(b[0], b[1], b[2], bv->m_maxbits, pivot);
+                default: return bitvec_bin0_bin1_bin2_bin3_t<bintype_t, 6>::find_free_before(b[0], b[1], b[2], b[3], bv->m_maxbits, pivot);
+            }
+        }
+
+        s32 find_free_range(bitvec_t const* bv, u32 n)
+        {
+            bintype_t const* const* levels = (bintype_t const* const*)bv->m_bins;
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_range_t<bintype_t, 6, 2>::find_free_range(levels, bv->m_maxbits, n);
+                case 2: return bitvec_range_t<bintype_t, 6, 3>::find_free_range(levels, bv->m_maxbits, n);
+                default: return bitvec_range_t<bintype_t, 6, 4>::find_free_range(levels, bv->m_maxbits, n);
+            }
+        }
+
+        s32 alloc_range(bitvec_t* bv, u32 n)
+        {
+            switch (bv->m_levels)
+            {
+                case 1: return bitvec_range_t<bintype_t, 6, 2>::alloc_range(bv->m_bins, bv->m_maxbits, n);
+                case 2: return bitvec_range_t<bintype_t, 6, 3>::alloc_range(bv->m_bins, bv->m_maxbits, n);
+                default: return bitvec_range_t<bintype_t, 6, 4>::alloc_range(bv->m_bins, bv->m_maxbits, n);
+            }
+        }
+
+        void free_range(bitvec_t* bv, u32 start, u32 n)
+        {
+            switch (bv->m_levels)
+            {
+                case 1: bitvec_range_t<bintype_t, 6, 2>::set_free_range(bv->m_bins, bv->m_maxbits, start, n); break;
+                case 2: bitvec_range_t<bintype_t, 6, 3>::set_free_range(bv->m_bins, bv->m_maxbits, start, n); break;
+                default: bitvec_range_t<bintype_t, 6, 4>::set_free_range(bv->m_bins, bv->m_maxbits, start, n); break;
+            }
+        }
+
+        template <s32 op>
+        static void s_bulk(bitvec_t* dst, bitvec_t const* src)
+        {
+            ASSERT(dst->m_levels == src->m_levels && dst->m_maxbits == src->m_maxbits);
+            s_bulk<op>(dst->m_bins, src->m_bins, dst->m_levels, (dst->m_maxbits + 63) >> 6);
+        }
+
+        void bulk_and(bitvec_t* dst, bitvec_t const* src) { s_bulk<BULK_AND>(dst, src); }
+        void bulk_or(bitvec_t* dst, bitvec_t const* src) { s_bulk<BULK_OR>(dst, src); }
+        void bulk_andnot(bitvec_t* dst, bitvec_t const* src) { s_bulk<BULK_ANDNOT>(dst, src); }
+        void bulk_xor(bitvec_t* dst, bitvec_t const* src) { s_bulk<BULK_XOR>(dst, src); }
+        u32  popcount(bitvec_t const* bv) { return s_popcount(bv->m_bins, bv->m_levels, (bv->m_maxbits + 63) >> 6); }
+        bool any(bitvec_t const* bv) { return bv->m_bins[0][0] != 0; }
+
     }  // namespace nbitvec
 
 };  // namespace ncore
@@ -7,25 +7,27 @@ namespace ncore
 {
     static const u16 cINVALID_BLOCK_INDEX = (u16)~0u;
 
-    union bblock_t
+    struct bblock_t
     {
-        u32 m_pages_committed;  // number of pages committed by this block
+        u32 m_pages_committed;  // number of pages committed by this block (also while it is on the free list)
         u32 m_free_next;        // index of the next free block in the list
     };
 
     struct bbin_t
     {
-        void* m_address_base;           // base address of the virtual address range managed by this bin
-        u32   m_address_size_in_pages;  // total size of the virtual address range managed by this bin
-        u8    m_bin_size_in_pages;      // total size of the bin structure (+ array of blocks) in pages
-        u8    m_block_size_shift;       // block size in shift (e.g. 14 for 16 KiB block size)
-        u16   m_free_head;              // index of the head of the free list
-        u16   m_block_count;            // number of blocks currently allocated
-        u16   m_block_max_count;        // maximum number of blocks that can be allocated
-        u16   m_block_free_index;       // highest free index
-        u8    m_page_size_shift;        // page size in shift (e.g. 12 for 4 KiB page size)
-        b8    m_ownership;              // do we own the reserved address space?
-        // bblock_t* m_blocks;          // array of blocks (follows bbin_t in memory)
+        void*                   m_address_base;           // base address of the virtual address range managed by this bin
+        vmem_decommit_policy_t* m_decommit_policy;        // how to give the pages of freed blocks back, nullptr = eager
+        u32                     m_retained_pages;         // number of pages of blocks on the free list that are still committed
+        u32                     m_address_size_in_pages;  // total size of the virtual address range managed by this bin
+        u8                      m_bin_size_in_pages;      // total size of the bin structure (+ array of blocks) in pages
+        u8                      m_block_size_shift;       // block size in shift (e.g. 14 for 16 KiB block size)
+        u16                     m_free_head;              // index of the head of the free list
+        u16                     m_block_count;            // number of blocks currently allocated
+        u16                     m_block_max_count;        // maximum number of blocks that can be allocated
+        u16                     m_block_free_index;       // highest free index
+        u8                      m_page_size_shift;        // page size in shift (e.g. 12 for 4 KiB page size)
+        b8                      m_ownership;              // do we own the reserved address space?
+        // bblock_t*            m_blocks;                 // array of blocks (follows bbin_t in memory)
     };
 
     static inline bblock_t* s_blocks(bbin_t* bin) { return (bblock_t*)((byte*)bin + sizeof(bbin_t)); }
@@ -94,16 +96,18 @@ namespace ncore
         {
             const u32 pages_to_commit = required_pages - block->m_pages_committed;
 
-            ASSERT(v_alloc_commit(block_address + (block->m_pages_committed << bin->m_page_size_shift), pages_to_commit << bin->m_page_size_shift));
+            const bool committed = v_alloc_commit(block_address + ((uint_t)block->m_pages_committed << bin->m_page_size_shift), (uint_t)pages_to_commit << bin->m_page_size_shift);
+            ASSERT(committed);
+            CC_UNUSED(committed);
             block->m_pages_committed += pages_to_commit;
             return block_address;
         }
         else if (block->m_pages_committed > required_pages)
         {
-            const u32 pages_to_decommit = block->m_pages_committed - required_pages;
-
-            v_alloc_decommit(block_address + (required_pages << bin->m_page_size_shift), pages_to_decommit << bin->m_page_size_shift);
-            block->m_pages_committed -= pages_to_decommit;
+            const u32    pages_to_decommit = block->m_pages_committed - required_pages;
+            const uint_t kept_size         = v_decommit(bin->m_decommit_policy, block_address + ((uint_t)required_pages << bin->m_page_size_shift), (uint_t)pages_to_decommit << bin->m_page_size_shift,
+                                                        (uint_t)bin->m_retained_pages << bin->m_page_size_shift, bin->m_page_size_shift);
+            block->m_pages_committed -= pages_to_decommit - (u32)(kept_size >> bin->m_page_size_shift);
             return block_address;
         }
 
@@ -115,9 +119,11 @@ namespace ncore
         const u32 block_size = (u32)1 << bin->m_block_size_shift;
         if (block->m_pages_committed > 0)
         {
-            byte* block_address = (byte*)bin->m_address_base + ((uint_t)block_index * block_size);
-            v_alloc_decommit(block_address, block->m_pages_committed << bin->m_page_size_shift);
-            block->m_pages_committed = 0;
+            byte*        block_address = (byte*)bin->m_address_base + ((uint_t)block_index * block_size);
+            const uint_t kept_size     = v_decommit(bin->m_decommit_policy, block_address, (uint_t)block->m_pages_committed << bin->m_page_size_shift, (uint_t)bin->m_retained_pages << bin->m_page_size_shift,
+                                                    bin->m_page_size_shift);
+            block->m_pages_committed   = (u32)(kept_size >> bin->m_page_size_shift);
+            bin->m_retained_pages += block->m_pages_committed;
         }
     }
 
@@ -134,27 +140,65 @@ namespace ncore
     {
         ASSERT(item_size <= ((u32)1 << bin->m_block_size_shift));
 
-        u16 active_block_index;
+        bblock_t* blocks = s_blocks(bin);
+        u16       active_block_index;
         if (bin->m_free_head != cINVALID_BLOCK_INDEX)
         {
+            // the block may still have (retained) committed pages
             active_block_index = s_pop_from_list(bin, bin->m_free_head);
+            bin->m_retained_pages -= blocks[active_block_index].m_pages_committed;
         }
         else
         {
             if (bin->m_block_free_index >= bin->m_block_max_count)
                 return nullptr;
 
-            active_block_index = bin->m_block_free_index++;
+            active_block_index                          = bin->m_block_free_index++;
+            blocks[active_block_index].m_pages_committed = 0;
         }
 
-        bblock_t* blocks                       = s_blocks(bin);
-        bblock_t* active_block                 = &blocks[active_block_index];
-        active_block->m_pages_committed = 0;
+        bblock_t* active_block = &blocks[active_block_index];
 
         bin->m_block_count += 1;
         return s_commit_block(bin, active_block, active_block_index, item_size);
     }
 
+    // Batch allocation, blocks from the free list are handed out one by one since each of them has its own
+    // committed state, the blocks that were never used are contiguous and their pages are committed with
+    // one call when the items fill whole blocks.
+    u32 bin_alloc_n(bbin_t* bin, u32 item_size, void** out_ptrs, u32 count)
+    {
+        ASSERT(item_size <= ((u32)1 << bin->m_block_size_shift));
+
+        u32 n = 0;
+        while (n < count && bin->m_free_head != cINVALID_BLOCK_INDEX)
+            out_ptrs[n++] = bin_alloc(bin, item_size);
+
+        const u32 num_new = math::min(count - n, (u32)(bin->m_block_max_count - bin->m_block_free_index));
+        if (num_new == 0)
+            return n;
+
+        bblock_t* blocks         = s_blocks(bin);
+        const u32 block_pages    = (u32)1 << (bin->m_block_size_shift - bin->m_page_size_shift);
+        const u32 required_pages = (item_size + ((u32)1 << bin->m_page_size_shift) - 1) >> bin->m_page_size_shift;
+        const u16 first_index    = bin->m_block_free_index;
+        byte*     first_address  = (byte*)bin->m_address_base + ((uint_t)first_index << bin->m_block_size_shift);
+
+        const bool contiguous = required_pages == block_pages;
+        if (contiguous && !v_alloc_commit(first_address, (uint_t)num_new << bin->m_block_size_shift))
+            return n;
+
+        for (u32 i = 0; i < num_new; ++i)
+        {
+            const u16 block_index                 = (u16)(first_index + i);
+            blocks[block_index].m_pages_committed = contiguous ? block_pages : 0;
+            out_ptrs[n++]                         = contiguous ? first_address + ((uint_t)i << bin->m_block_size_shift) : s_commit_block(bin, &blocks[block_index], block_index, item_size);
+        }
+        bin->m_block_free_index += (u16)num_new;
+        bin->m_block_count += (u16)num_new;
+        return n;
+    }
+
     // 8888888888 8888888b.  8888888888 8888888888
     // 888        888   Y88b 888        888
     // 888        888    888 888        888
@@ -183,6 +227,13 @@ namespace ncore
         s_add_to_list(bin, bin->m_free_head, block_index);
     }
 
+    void bin_free_n(bbin_t* bin, void* const* ptrs, u32 count)
+    {
+        // every block gives its own pages back, there is nothing to share between them
+        for (u32 i = 0; i < count; ++i)
+            bin_free(bin, ptrs[i]);
+    }
+
     //  .d8888b.  8888888888 88888888888 888     888 8888888b.
     // d88P  Y88b 888            888     888     888 888   Y88b
     // Y88b.      888            888     888     888 888    888
@@ -238,6 +289,8 @@ namespace ncore
         return bin->m_block_count;
     }
 
+    void bin_set_decommit_policy(bbin_t* bin, vmem_decommit_policy_t* policy) { bin->m_decommit_policy = policy; }
+
     // 8888888b.  8888888888 .d8888b. 88888888888 8888888b.   .d88888b. Y88b   d88P
     // 888  "Y88b 888       d88P  Y88b    888     888   Y88b d88P" "Y88b Y88b d88P
     // 888    888 888       Y88b.         888     888    888 888     888  Y88o88P
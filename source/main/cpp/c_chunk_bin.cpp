@@ -22,7 +22,7 @@ namespace ncore
     // - max items <= (1 << 10) = 1024
     struct cchunk_t
     {
-        u16 m_free_index;  // highwater mark free index
+        u16 m_free_index;  // highwater mark free index (when on the free list: number of pages still committed)
         u16 m_item_count;  // number of items currently allocated in this chunk
         u16 m_prev;        // previous chunk in list
         u16 m_next;        // next chunk in list
@@ -32,20 +32,22 @@ namespace ncore
 
     struct cbin_t
     {
-        void* m_address_base;
-        u32   m_address_size_in_pages;
-        u32   m_bin_size_in_pages;
-        u32   m_total_items_count;
-        u16   m_chunk_max_count;
-        u16   m_chunk_free_index;
-        u16   m_chunk_max_items;
-        u16   m_sizeof_item;
-        u16   m_chunk_sizeof;
-        u16   m_chunk_free_list_head;
-        u16   m_chunk_active_list_head;
-        u8    m_chunk_size_shift;
-        u8    m_page_size_shift;
-        b8    m_ownership;
+        void*                   m_address_base;
+        vmem_decommit_policy_t* m_decommit_policy;         // how to give the pages of empty chunks back, nullptr = eager
+        u32                     m_address_size_in_pages;
+        u32                     m_bin_size_in_pages;
+        u32                     m_total_items_count;
+        u32                     m_retained_pages;          // number of pages of chunks on the free list that are still committed
+        u16                     m_chunk_max_count;
+        u16                     m_chunk_free_index;
+        u16                     m_chunk_max_items;
+        u16                     m_sizeof_item;
+        u16                     m_chunk_sizeof;
+        u16                     m_chunk_free_list_head;
+        u16                     m_chunk_active_list_head;
+        u8                      m_chunk_size_shift;
+        u8                      m_page_size_shift;
+        b8                      m_ownership;
     };
 
     static inline byte* s_chunks(cbin_t* bin) { return (byte*)bin + sizeof(cbin_t); }
@@ -57,6 +59,8 @@ namespace ncore
         return (cchunk_t*)(s_chunks(bin) + (chunk_index * bin->m_chunk_sizeof));
     }
 
+    static inline cchunk_t const* s_get_chunk(cbin_t const* bin, u32 chunk_index) { return s_get_chunk((cbin_t*)bin, chunk_index); }
+
     static inline void s_push_to_list(cbin_t* bin, u16* list_head, u16 chunk_index)
     {
         cchunk_t* chunk = s_get_chunk(bin, chunk_index);
@@ -175,18 +179,24 @@ namespace ncore
         // Note: Currently there is no function in nbitvec10 that can lower our free index
     }
 
-    static void s_commit_chunk_memory(cbin_t* bin, u32 chunk_index)
+    // commit the chunk memory, the first 'committed_pages' of the chunk are still committed
+    static void s_commit_chunk_memory(cbin_t* bin, u32 chunk_index, u32 committed_pages)
     {
-        const u32 chunk_size    = (u32)1 << bin->m_chunk_size_shift;
-        byte*     chunk_address = (byte*)bin->m_address_base + ((uint_t)chunk_index * chunk_size);
-        v_alloc_commit(chunk_address, chunk_size);
+        const u32    chunk_size     = (u32)1 << bin->m_chunk_size_shift;
+        byte*        chunk_address  = (byte*)bin->m_address_base + ((uint_t)chunk_index * chunk_size);
+        const uint_t committed_size = (uint_t)committed_pages << bin->m_page_size_shift;
+        if (committed_size < chunk_size)
+            v_alloc_commit(chunk_address + committed_size, chunk_size - committed_size);
     }
 
-    static void s_decommit_chunk_memory(cbin_t* bin, u32 chunk_index)
+    // give the chunk memory back according to the decommit policy, returns the number of pages still committed
+    static u32 s_decommit_chunk_memory(cbin_t* bin, u32 chunk_index)
     {
-        const u32 chunk_size    = (u32)1 << bin->m_chunk_size_shift;
-        byte*     chunk_address = (byte*)bin->m_address_base + ((uint_t)chunk_index * chunk_size);
-        v_alloc_decommit(chunk_address, chunk_size);
+        const u32    chunk_size     = (u32)1 << bin->m_chunk_size_shift;
+        byte*        chunk_address  = (byte*)bin->m_address_base + ((uint_t)chunk_index * chunk_size);
+        const uint_t retained_size  = (uint_t)bin->m_retained_pages << bin->m_page_size_shift;
+        const uint_t committed_size = v_decommit(bin->m_decommit_policy, chunk_address, chunk_size, retained_size, bin->m_page_size_shift);
+        return (u32)(committed_size >> bin->m_page_size_shift);
     }
 
     //        d8888 888      888      .d88888b.   .d8888b.
@@ -198,24 +208,25 @@ namespace ncore
     //  d8888888888 888      888     Y88b. .d88P Y88b  d88P
     // d88P     888 88888888 88888888 "Y88888P"   "Y8888P"
 
-    void* bin_alloc(cbin_t* bin)
+    // returns the index of the chunk to allocate from, a free or new chunk becomes the active chunk when there
+    // is none, returns -1 when the bin is full
+    static s32 s_active_chunk(cbin_t* bin)
     {
-        cchunk_t* active_chunk       = nullptr;
-        s32       active_chunk_index = -1;
-
         if (bin->m_chunk_active_list_head != cINVALID_CHUNK_INDEX)
         {
             // Get the active chunk from the head of the active chunk list
-            active_chunk_index = bin->m_chunk_active_list_head;
-            active_chunk       = s_get_chunk(bin, active_chunk_index);
+            return bin->m_chunk_active_list_head;
         }
-        else if (bin->m_chunk_free_list_head != cINVALID_CHUNK_INDEX)
+
+        u16 active_chunk_index;
+        if (bin->m_chunk_free_list_head != cINVALID_CHUNK_INDEX)
         {
-            active_chunk_index = s_pop_from_list(bin, &bin->m_chunk_free_list_head);
-            active_chunk       = s_get_chunk(bin, active_chunk_index);
+            active_chunk_index        = s_pop_from_list(bin, &bin->m_chunk_free_list_head);
+            cchunk_t* active_chunk    = s_get_chunk(bin, active_chunk_index);
+            const u32 committed_pages = active_chunk->m_free_index;
+            bin->m_retained_pages -= committed_pages;
             s_chunk_init(bin, active_chunk);
-            s_commit_chunk_memory(bin, active_chunk_index);
-            s_push_to_list(bin, &bin->m_chunk_active_list_head, active_chunk_index);
+            s_commit_chunk_memory(bin, active_chunk_index, committed_pages);
         }
         else
         {
@@ -223,17 +234,26 @@ namespace ncore
             if (bin->m_chunk_free_index >= bin->m_chunk_max_count)
             {
                 // No more space for new chunks
-                return nullptr;
+                return -1;
             }
 
             active_chunk_index = bin->m_chunk_free_index++;
-            active_chunk       = s_get_chunk(bin, active_chunk_index);
-            s_chunk_init(bin, active_chunk);
-            s_commit_chunk_memory(bin, active_chunk_index);
-            s_push_to_list(bin, &bin->m_chunk_active_list_head, active_chunk_index);
+            s_chunk_init(bin, s_get_chunk(bin, active_chunk_index));
+            s_commit_chunk_memory(bin, active_chunk_index, 0);
         }
 
-        ASSERT(active_chunk != nullptr && active_chunk_index >= 0 && active_chunk_index < bin->m_chunk_free_index);
+        s_push_to_list(bin, &bin->m_chunk_active_list_head, active_chunk_index);
+        return active_chunk_index;
+    }
+
+    void* bin_alloc(cbin_t* bin)
+    {
+        const s32 active_chunk_index = s_active_chunk(bin);
+        if (active_chunk_index < 0)
+            return nullptr;
+
+        cchunk_t* active_chunk = s_get_chunk(bin, (u32)active_chunk_index);
+        ASSERT(active_chunk_index < bin->m_chunk_free_index);
         void* item = s_chunk_alloc_item(bin, active_chunk, (u32)active_chunk_index);
         ASSERT(item != nullptr);
 
@@ -247,6 +267,38 @@ namespace ncore
         return item;
     }
 
+    // Batch allocation, the free items of the active chunk are claimed a bitvec word at a time
+    u32 bin_alloc_n(cbin_t* bin, void** out_ptrs, u32 count)
+    {
+        const u32 chunk_size = (u32)1 << bin->m_chunk_size_shift;
+
+        u32 n = 0;
+        while (n < count)
+        {
+            const s32 active_chunk_index = s_active_chunk(bin);
+            if (active_chunk_index < 0)
+                break;
+
+            cchunk_t* active_chunk  = s_get_chunk(bin, (u32)active_chunk_index);
+            byte*     chunk_address = (byte*)bin->m_address_base + ((uint_t)active_chunk_index * chunk_size);
+            u32*      layer0        = &active_chunk->m_layer0;
+            u32*      layer1        = layer0 + 1;
+
+            u32       indices[64];
+            const u32 wanted = math::min(math::min(count - n, (u32)(bin->m_chunk_max_items - active_chunk->m_item_count)), 64u);
+            const u32 found  = nbitvec10::find_free_and_remove_n(layer0, layer1, bin->m_chunk_max_items, indices, wanted);
+            ASSERT(found == wanted);
+            for (u32 i = 0; i < found; ++i)
+                out_ptrs[n++] = chunk_address + ((uint_t)indices[i] * bin->m_sizeof_item);
+
+            active_chunk->m_item_count += (u16)found;
+            bin->m_total_items_count += found;
+            if (active_chunk->m_item_count >= bin->m_chunk_max_items)
+                s_remove_from_list(bin, &bin->m_chunk_active_list_head, (u16)active_chunk_index);
+        }
+        return n;
+    }
+
     // 8888888888 8888888b.  8888888888 8888888888
     // 888        888   Y88b 888        888
     // 888        888    888 888        888
@@ -281,10 +333,56 @@ namespace ncore
         }
         else if (chunk->m_item_count == 0)
         {
-            // This chunk is now empty, move it to the free list and decommit its backing pages.
+            // This chunk is now empty, move it to the free list and give its backing pages back.
             s_remove_from_list(bin, &bin->m_chunk_active_list_head, (u16)chunk_index);
             s_push_to_list(bin, &bin->m_chunk_free_list_head, chunk_index);
-            s_decommit_chunk_memory(bin, chunk_index);
+            const u32 committed_pages = s_decommit_chunk_memory(bin, chunk_index);
+            chunk->m_free_index       = (u16)committed_pages;
+            bin->m_retained_pages += committed_pages;
+        }
+    }
+
+    // Batch free, consecutive items that belong to the same chunk are freed at once and the chunk only moves
+    // between the lists once.
+    void bin_free_n(cbin_t* bin, void* const* ptrs, u32 count)
+    {
+        const u8 chunk_size_shift = bin->m_chunk_size_shift;
+
+        u32 i = 0;
+        while (i < count)
+        {
+            const u32 chunk_index   = (u32)((uint_t)((byte*)ptrs[i] - (byte*)bin->m_address_base) >> chunk_size_shift);
+            cchunk_t* chunk         = s_get_chunk(bin, chunk_index);
+            byte*     chunk_address = (byte*)bin->m_address_base + ((uint_t)chunk_index << chunk_size_shift);
+
+            u32 indices[64];
+            u32 num_indices = 0;
+            for (; i < count && num_indices < 64; ++i)
+            {
+                if ((u32)((uint_t)((byte*)ptrs[i] - (byte*)bin->m_address_base) >> chunk_size_shift) != chunk_index)
+                    break;
+                indices[num_indices++] = (u32)(((byte*)ptrs[i] - chunk_address) / bin->m_sizeof_item);
+            }
+
+            const bool chunk_was_full = (chunk->m_item_count >= bin->m_chunk_max_items);
+
+            u32* layer0 = &chunk->m_layer0;
+            u32* layer1 = layer0 + 1;
+            nbitvec10::set_free_n(layer0, layer1, bin->m_chunk_max_items, indices, num_indices);
+            chunk->m_item_count -= (u16)num_indices;
+            bin->m_total_items_count -= num_indices;
+
+            if (chunk_was_full)
+                s_push_to_list(bin, &bin->m_chunk_active_list_head, chunk_index);
+
+            if (chunk->m_item_count == 0)
+            {
+                s_remove_from_list(bin, &bin->m_chunk_active_list_head, (u16)chunk_index);
+                s_push_to_list(bin, &bin->m_chunk_free_list_head, chunk_index);
+                const u32 committed_pages = s_decommit_chunk_memory(bin, chunk_index);
+                chunk->m_free_index       = (u16)committed_pages;
+                bin->m_retained_pages += committed_pages;
+            }
         }
     }
 
@@ -399,12 +497,94 @@ namespace ncore
         return bin;
     }
 
+    // the run of used items at or after 'from', out_count is 0 when there is none
+    static void s_find_run(cbin_t const* bin, u32 from, u32& out_index, u32& out_count)
+    {
+        const u32 max_items = bin->m_chunk_max_items;
+
+        out_count = 0;
+        for (u32 chunk_index = from / max_items; chunk_index < bin->m_chunk_free_index; ++chunk_index)
+        {
+            // empty chunks, also the ones on the free list, are skipped
+            cchunk_t const* chunk = s_get_chunk(bin, chunk_index);
+            if (chunk->m_item_count == 0)
+                continue;
+
+            // a '1' bit in layer1 is a free item
+            u32 const* layer1 = &chunk->m_layer0 + 1;
+            u32        first  = (chunk_index == from / max_items) ? (from % max_items) : 0;
+            while (first < max_items)
+            {
+                const u32 used = ~layer1[first >> 5] & (~(u32)0 << (first & 31));
+                if (used != 0)
+                {
+                    first = (first & ~31u) + (u32)math::findFirstBit(used);
+                    break;
+                }
+                first = (first & ~31u) + 32;
+            }
+            if (first >= max_items)
+                continue;
+
+            u32 end = first;
+            while (end < max_items)
+            {
+                const u32 free = layer1[end >> 5] & (~(u32)0 << (end & 31));
+                if (free != 0)
+                {
+                    end = (end & ~31u) + (u32)math::findFirstBit(free);
+                    break;
+                }
+                end = (end & ~31u) + 32;
+            }
+
+            out_index = (chunk_index * max_items) + first;
+            out_count = math::min(end, max_items) - first;
+            return;
+        }
+    }
+
+    static inline byte* s_item_address(cbin_t const* bin, u32 index)
+    {
+        const u32 chunk_index = index / bin->m_chunk_max_items;
+        const u32 item_index  = index - (chunk_index * bin->m_chunk_max_items);
+        return (byte*)bin->m_address_base + ((uint_t)chunk_index << bin->m_chunk_size_shift) + ((uint_t)item_index * bin->m_sizeof_item);
+    }
+
+    void bin_iter_begin(cbin_t const* bin, bin_used_iter_t& it)
+    {
+        it.m_items = nullptr;
+        it.m_index = 0;
+        it.m_count = 0;
+        s_find_run(bin, 0, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(s_item_address(bin, it.m_next_index));
+    }
+
+    bool bin_iter_next(cbin_t const* bin, bin_used_iter_t& it)
+    {
+        if (it.m_next_count == 0)
+            return false;
+
+        it.m_index = it.m_next_index;
+        it.m_count = it.m_next_count;
+        it.m_items = s_item_address(bin, it.m_index);
+
+        // find the next run and start loading its first item while the caller processes this run
+        s_find_run(bin, it.m_index + it.m_count, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(s_item_address(bin, it.m_next_index));
+        return true;
+    }
+
     u32 bin_size(cbin_t const* bin)
     {
         // The global item count
         return bin->m_total_items_count;
     }
 
+    void bin_set_decommit_policy(cbin_t* bin, vmem_decommit_policy_t* policy) { bin->m_decommit_policy = policy; }
+
     // 8888888b.  8888888888 .d8888b. 88888888888 8888888b.   .d88888b. Y88b   d88P
     // 888  "Y88b 888       d88P  Y88b    888     888   Y88b d88P" "Y88b Y88b d88P
     // 888    888 888       Y88b.         888     888    888 888     888  Y88o88P
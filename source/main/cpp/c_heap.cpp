@@ -0,0 +1,536 @@
+#include "ccore/c_target.h"
+#include "ccore/c_arena.h"
+#include "ccore/c_atomic.h"
+#include "ccore/c_bin.h"
+#include "ccore/c_block_bin.h"
+#include "ccore/c_chunk_bin.h"
+#include "ccore/c_math.h"
+#include "ccore/c_memory.h"
+#include "ccore/c_segment.h"
+
+#include "ccore/c_heap.h"
+
+namespace ncore
+{
+    namespace nheap
+    {
+        const u32 c_num_small_classes  = 21;       // 8 B .. 1 KiB, bin32_t
+        const u32 c_num_cached_classes = 41;       // 8 B .. 32 KiB, bin32_t and cbin_t, these go through the thread cache
+        const u32 c_num_classes        = 46;       // 8 B .. 1 MiB, the last 5 classes are bbin_t
+        const u32 c_small_reserve_size = 1 * cGB;  // upper bound for the address space of a bin32_t
+        const u32 c_medium_slice_shift = 30;       // every cbin_t/bbin_t class has a 1 GiB slice of the medium address range
+        const u64 c_large_segment_min  = 2 * cMB;  // smallest node of the large allocations
+        const u64 c_large_segment_max  = 1 * cGB;  // largest node of the large allocations
+        const u32 c_tcache_capacity    = 32;       // number of items in the thread cache per class
+        const u32 c_tcache_batch       = 16;       // number of items that are moved between the thread cache and a bin at once
+        const u32 c_max_heaps          = 16;       // maximum number of heaps that can exist at the same time
+
+        u32 class_size(u32 c)
+        {
+            if (c < 9)
+                return c == 0 ? 8 : c * 16;
+            if (c < c_num_cached_classes)
+            {
+                const u32 shift = 7 + ((c - 9) >> 2);
+                return ((u32)1 << shift) + ((((c - 9) & 3) + 1) << (shift - 2));
+            }
+            if (c < c_num_classes)
+                return (u32)(64 * cKB) << (c - c_num_cached_classes);
+            return 0;
+        }
+
+        u32 size_class(uint_t size)
+        {
+            if (size <= 8)
+                return 0;
+            if (size <= 128)
+                return (u32)((size + 15) >> 4);
+            if (size <= 32 * cKB)
+            {
+                const u32 shift = (u32)math::ilog2((u32)(size - 1));
+                return 9 + ((shift - 7) << 2) + (u32)(((size - 1) - ((uint_t)1 << shift)) >> (shift - 2));
+            }
+            if (size <= 1 * cMB)
+                return c_num_cached_classes + (u32)math::ilog2(math::ceilpo2((u32)size)) - 16;
+            return c_num_classes;
+        }
+
+        u32 num_size_classes() { return c_num_classes; }
+
+        struct tcache_bin_t
+        {
+            u32   m_count;
+            void* m_items[c_tcache_capacity];
+        };
+
+        struct tcache_t
+        {
+            tcache_t*    m_next;       // next thread cache of the heap
+            u32 volatile m_in_use;     // owned by a thread, caches of exited threads are reused
+            tcache_bin_t m_bins[c_num_cached_classes];
+        };
+
+        struct size_class_t
+        {
+            spinlock_t     m_lock;
+            void* volatile m_remote_free;  // items that could not be returned while the lock was taken, linked through their first word
+            bin32_t        m_bin32;        // small classes
+            cbin_t*        m_cbin;         // medium classes
+            bbin_t*        m_bbin;         // block classes
+        };
+    }  // namespace nheap
+
+    struct heap_t
+    {
+        nheap::size_class_t       m_classes[nheap::c_num_classes];
+        byte*                     m_small_bases[nheap::c_num_small_classes];    // base of every bin32_t, sorted
+        u8                        m_small_classes[nheap::c_num_small_classes];  // size class of m_small_bases[i]
+        byte*                     m_medium_base;
+        uint_t                    m_medium_size;
+        byte*                     m_large_base;
+        uint_t                    m_large_size;
+        nsegment::allocator_t     m_segments;
+        spinlock_t                m_segments_lock;
+        arena_t*                  m_arena;    // heap, bin metadata and thread caches
+        nheap::tcache_t* volatile m_tcaches;  // all thread caches of this heap
+        u32                       m_id;
+        u32                       m_generation;
+    };
+
+    namespace nheap
+    {
+        // Registered heaps, a thread cache belongs to a heap generation so that a thread never touches
+        // the cache of a heap that was destroyed (or of a new heap that reuses the slot).
+        static heap_t* volatile s_heaps[c_max_heaps];
+        static spinlock_t       s_heaps_lock;
+        static u32              s_next_generation = 1;
+
+        static void s_flush_cache(heap_t* heap, tcache_t* cache);
+
+        struct thread_caches_t
+        {
+            tcache_t* m_caches[c_max_heaps];
+            u32       m_generations[c_max_heaps];
+
+            ~thread_caches_t()
+            {
+                for (u32 i = 0; i < c_max_heaps; ++i)
+                {
+                    heap_t* heap = natomic::load_ptr(&s_heaps[i]);
+                    if (m_caches[i] == nullptr || heap == nullptr || heap->m_generation != m_generations[i])
+                        continue;
+                    s_flush_cache(heap, m_caches[i]);
+                    natomic::store(&m_caches[i]->m_in_use, 0);
+                }
+            }
+        };
+
+        static CC_THREAD_LOCAL thread_caches_t s_thread_caches;
+
+        static tcache_t* s_thread_cache(heap_t* heap)
+        {
+            const u32 id = heap->m_id;
+            if (s_thread_caches.m_generations[id] == heap->m_generation)
+                return s_thread_caches.m_caches[id];
+
+            // reuse the cache of a thread that exited, otherwise create a new one
+            tcache_t* cache = natomic::load_ptr(&heap->m_tcaches);
+            while (cache != nullptr && !(natomic::load(&cache->m_in_use) == 0 && natomic::cas(&cache->m_in_use, 0, 1)))
+                cache = cache->m_next;
+
+            if (cache == nullptr)
+            {
+                cache = (tcache_t*)narena::alloc_and_zero_concurrent(heap->m_arena, sizeof(tcache_t), 64);
+                if (cache == nullptr)
+                    return nullptr;
+                cache->m_in_use = 1;
+
+                tcache_t* head;
+                do
+                {
+                    head          = natomic::load_ptr(&heap->m_tcaches);
+                    cache->m_next = head;
+                } while (!natomic::cas_ptr(&heap->m_tcaches, head, cache));
+            }
+
+            s_thread_caches.m_caches[id]      = cache;
+            s_thread_caches.m_generations[id] = heap->m_generation;
+            return cache;
+        }
+
+        static inline void* s_class_alloc(size_class_t* cls, u32 c) { return c < c_num_small_classes ? bin_alloc(&cls->m_bin32) : bin_alloc(cls->m_cbin); }
+
+        static inline void s_class_free(size_class_t* cls, u32 c, void* item)
+        {
+            if (c < c_num_small_classes)
+                bin_free(&cls->m_bin32, item);
+            else
+                bin_free(cls->m_cbin, item);
+        }
+
+        static inline u32 s_class_alloc_n(size_class_t* cls, u32 c, void** items, u32 count) { return c < c_num_small_classes ? bin_alloc_n(&cls->m_bin32, items, count) : bin_alloc_n(cls->m_cbin, items, count); }
+
+        static inline void s_class_free_n(size_class_t* cls, u32 c, void* const* items, u32 count)
+        {
+            if (c < c_num_small_classes)
+                bin_free_n(&cls->m_bin32, items, count);
+            else
+                bin_free_n(cls->m_cbin, items, count);
+        }
+
+        // take the remote-free list, the caller holds the lock of the class
+        static void* s_take_remote(size_class_t* cls)
+        {
+            void* head;
+            do
+            {
+                head = natomic::load_ptr(&cls->m_remote_free);
+            } while (head != nullptr && !natomic::cas_ptr(&cls->m_remote_free, head, (void*)nullptr));
+            return head;
+        }
+
+        static void s_push_remote(size_class_t* cls, void* first, void* last)
+        {
+            void* head;
+            do
+            {
+                head          = natomic::load_ptr(&cls->m_remote_free);
+                *(void**)last = head;
+            } while (!natomic::cas_ptr(&cls->m_remote_free, head, first));
+        }
+
+        static void s_refill(heap_t* heap, u32 c, tcache_bin_t* bin)
+        {
+            size_class_t*    cls = &heap->m_classes[c];
+            spinlock_scope_t lock(cls->m_lock);
+
+            // items on the remote-free list are handed out first, the ones that do not fit go back to the bin
+            void* item = s_take_remote(cls);
+            while (item != nullptr)
+            {
+                void* next = *(void**)item;
+                if (bin->m_count < c_tcache_capacity)
+                    bin->m_items[bin->m_count++] = item;
+                else
+                    s_class_free(cls, c, item);
+                item = next;
+            }
+
+            if (bin->m_count < c_tcache_batch)
+                bin->m_count += s_class_alloc_n(cls, c, &bin->m_items[bin->m_count], c_tcache_batch - bin->m_count);
+        }
+
+        // return the 'count' oldest items of the thread cache bin to the class, when 'wait' is false
+        // and the lock is taken the items are pushed on the remote-free list of the class.
+        static void s_flush(heap_t* heap, u32 c, tcache_bin_t* bin, u32 count, bool wait)
+        {
+            size_class_t* cls = &heap->m_classes[c];
+            if (wait)
+                nspinlock::lock(cls->m_lock);
+
+            if (wait || nspinlock::try_lock(cls->m_lock))
+            {
+                void* item = s_take_remote(cls);
+                while (item != nullptr)
+                {
+                    void* next = *(void**)item;
+                    s_class_free(cls, c, item);
+                    item = next;
+                }
+                s_class_free_n(cls, c, bin->m_items, count);
+                nspinlock::unlock(cls->m_lock);
+            }
+            else
+            {
+                for (u32 i = 0; i + 1 < count; ++i)
+                    *(void**)bin->m_items[i] = bin->m_items[i + 1];
+                s_push_remote(cls, bin->m_items[0], bin->m_items[count - 1]);
+            }
+
+            for (u32 i = count; i < bin->m_count; ++i)
+                bin->m_items[i - count] = bin->m_items[i];
+            bin->m_count -= count;
+        }
+
+        static void s_flush_cache(heap_t* heap, tcache_t* cache)
+        {
+            for (u32 c = 0; c < c_num_cached_classes; ++c)
+            {
+                tcache_bin_t* bin = &cache->m_bins[c];
+                if (bin->m_count > 0)
+                    s_flush(heap, c, bin, bin->m_count, true);
+            }
+        }
+
+        static void* s_alloc_cached(heap_t* heap, u32 c)
+        {
+            tcache_t* cache = s_thread_cache(heap);
+            if (cache == nullptr)
+            {
+                spinlock_scope_t lock(heap->m_classes[c].m_lock);
+                return s_class_alloc(&heap->m_classes[c], c);
+            }
+
+            tcache_bin_t* bin = &cache->m_bins[c];
+            if (bin->m_count == 0)
+            {
+                s_refill(heap, c, bin);
+                if (bin->m_count == 0)
+                    return nullptr;
+            }
+            return bin->m_items[--bin->m_count];
+        }
+
+        static void s_free_cached(heap_t* heap, u32 c, void* ptr)
+        {
+            tcache_t* cache = s_thread_cache(heap);
+            if (cache == nullptr)
+            {
+                spinlock_scope_t lock(heap->m_classes[c].m_lock);
+                s_class_free(&heap->m_classes[c], c, ptr);
+                return;
+            }
+
+            tcache_bin_t* bin = &cache->m_bins[c];
+            if (bin->m_count == c_tcache_capacity)
+                s_flush(heap, c, bin, c_tcache_batch, false);
+            bin->m_items[bin->m_count++] = ptr;
+        }
+
+        static void* s_alloc_large(heap_t* heap, uint_t size)
+        {
+            const u8         page_size_shift = heap->m_segments.m_pagesize_shift;
+            const u32        pages           = (u32)(math::alignUp(size, (uint_t)1 << page_size_shift) >> page_size_shift);
+            spinlock_scope_t lock(heap->m_segments_lock);
+
+            const nsegment::node_t node = nsegment::alloc_node(&heap->m_segments, size);
+            if (node == nsegment::cINVALID_NODE)
+                return nullptr;
+            nsegment::commit(&heap->m_segments, node, pages);
+            if (nsegment::committed_pages(&heap->m_segments, node) < pages)
+            {
+                nsegment::dealloc_node(&heap->m_segments, node);
+                return nullptr;
+            }
+
+            u32 node_pages;
+            return nsegment::get_address(&heap->m_segments, node, node_pages);
+        }
+
+        // the bin32_t bases are sorted, the bin that owns 'ptr' is the one with the highest base below 'ptr'
+        static u32 s_small_class(heap_t* heap, byte* ptr)
+        {
+            u32 lo = 0;
+            u32 hi = c_num_small_classes;
+            while (hi - lo > 1)
+            {
+                const u32 mid = (lo + hi) >> 1;
+                if (heap->m_small_bases[mid] <= ptr)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            return heap->m_small_classes[lo];
+        }
+
+        void* alloc(heap_t* heap, uint_t size, u32 alignment)
+        {
+            ASSERT(math::ispo2(alignment) && alignment <= v_alloc_get_page_size());
+            if (size < alignment)
+                size = alignment;
+
+            // the items of a class are aligned to the largest power of two that divides the class size
+            u32 c = size_class(size);
+            while (c < c_num_classes && (class_size(c) & (alignment - 1)) != 0)
+                ++c;
+
+            if (c < c_num_cached_classes)
+                return s_alloc_cached(heap, c);
+
+            if (c < c_num_classes)
+            {
+                size_class_t*    cls = &heap->m_classes[c];
+                spinlock_scope_t lock(cls->m_lock);
+                return bin_alloc(cls->m_bbin, (u32)size);
+            }
+
+            return s_alloc_large(heap, size);
+        }
+
+        void free(heap_t* heap, void* ptr)
+        {
+            if (ptr == nullptr)
+                return;
+
+            byte* p = (byte*)ptr;
+            if (p >= heap->m_medium_base && p < (heap->m_medium_base + heap->m_medium_size))
+            {
+                const u32 c = c_num_small_classes + (u32)((uint_t)(p - heap->m_medium_base) >> c_medium_slice_shift);
+                if (c < c_num_cached_classes)
+                {
+                    s_free_cached(heap, c, ptr);
+                }
+                else
+                {
+                    size_class_t*    cls = &heap->m_classes[c];
+                    spinlock_scope_t lock(cls->m_lock);
+                    bin_free(cls->m_bbin, ptr);
+                }
+                return;
+            }
+
+            if (p >= heap->m_large_base && p < (heap->m_large_base + heap->m_large_size))
+            {
+                spinlock_scope_t lock(heap->m_segments_lock);
+                nsegment::dealloc_node(&heap->m_segments, nsegment::address_to_node(&heap->m_segments, ptr));
+                return;
+            }
+
+            s_free_cached(heap, s_small_class(heap, p), ptr);
+        }
+
+        void flush_thread_cache(heap_t* heap)
+        {
+            if (s_thread_caches.m_generations[heap->m_id] == heap->m_generation)
+                s_flush_cache(heap, s_thread_caches.m_caches[heap->m_id]);
+        }
+
+        static void s_release(heap_t* heap)
+        {
+            for (u32 c = 0; c < c_num_small_classes; ++c)
+                bin_destroy(&heap->m_classes[c].m_bin32);
+            for (u32 c = c_num_small_classes; c < c_num_cached_classes; ++c)
+            {
+                if (heap->m_classes[c].m_cbin != nullptr)
+                    bin_destroy(heap->m_classes[c].m_cbin);
+            }
+            for (u32 c = c_num_cached_classes; c < c_num_classes; ++c)
+            {
+                if (heap->m_classes[c].m_bbin != nullptr)
+                    bin_destroy(heap->m_classes[c].m_bbin);
+            }
+            if (heap->m_medium_base != nullptr)
+                v_alloc_release(heap->m_medium_base, heap->m_medium_size);
+            if (heap->m_segments.m_base_address != nullptr)
+                nsegment::teardown(&heap->m_segments);
+
+            nspinlock::lock(s_heaps_lock);
+            natomic::store_ptr(&s_heaps[heap->m_id], (heap_t*)nullptr);
+            nspinlock::unlock(s_heaps_lock);
+
+            arena_t* arena = heap->m_arena;
+            narena::destroy(arena);
+        }
+
+        heap_t* create(u64 large_address_space)
+        {
+            arena_t* arena = narena::new_arena(256 * cMB, 64 * cKB);
+            if (arena == nullptr)
+                return nullptr;
+
+            heap_t* heap  = g_allocate_and_clear<heap_t>(arena, 64);
+            heap->m_arena = arena;
+
+            // register the heap
+            nspinlock::lock(s_heaps_lock);
+            heap->m_id = c_max_heaps;
+            for (u32 i = 0; i < c_max_heaps && heap->m_id == c_max_heaps; ++i)
+            {
+                if (s_heaps[i] == nullptr)
+                    heap->m_id = i;
+            }
+            if (heap->m_id < c_max_heaps)
+            {
+                heap->m_generation = s_next_generation++;
+                natomic::store_ptr(&s_heaps[heap->m_id], heap);
+            }
+            nspinlock::unlock(s_heaps_lock);
+            if (heap->m_id == c_max_heaps)
+            {
+                narena::destroy(arena);
+                return nullptr;
+            }
+
+            for (u32 c = 0; c < c_num_classes; ++c)
+                nspinlock::init(heap->m_classes[c].m_lock);
+            nspinlock::init(heap->m_segments_lock);
+
+            // small, every class has its own bin32_t reservation
+            for (u32 c = 0; c < c_num_small_classes; ++c)
+            {
+                const u32 item_size = class_size(c);
+                const u32 max_items = math::min((u32)(c_small_reserve_size / item_size), (u32)(1 << 24) - 64);
+                bin_setup(&heap->m_classes[c].m_bin32, (u16)item_size, max_items);
+                if (heap->m_classes[c].m_bin32.m_memory == nullptr)
+                {
+                    s_release(heap);
+                    return nullptr;
+                }
+
+                // insertion sort on the base address
+                u32 i = c;
+                while (i > 0 && heap->m_small_bases[i - 1] > (byte*)heap->m_classes[c].m_bin32.m_memory)
+                {
+                    heap->m_small_bases[i]   = heap->m_small_bases[i - 1];
+                    heap->m_small_classes[i] = heap->m_small_classes[i - 1];
+                    --i;
+                }
+                heap->m_small_bases[i]   = (byte*)heap->m_classes[c].m_bin32.m_memory;
+                heap->m_small_classes[i] = (u8)c;
+            }
+
+            // medium and block, one reservation where every class has a slice
+            const uint_t slice_size = (uint_t)1 << c_medium_slice_shift;
+            const u8     page_shift = v_alloc_get_page_size_shift();
+            heap->m_medium_size     = (uint_t)(c_num_classes - c_num_small_classes) << c_medium_slice_shift;
+            heap->m_medium_base     = (byte*)v_alloc_reserve(heap->m_medium_size);
+            if (heap->m_medium_base == nullptr)
+            {
+                s_release(heap);
+                return nullptr;
+            }
+
+            for (u32 c = c_num_small_classes; c < c_num_classes; ++c)
+            {
+                byte* slice = heap->m_medium_base + ((uint_t)(c - c_num_small_classes) << c_medium_slice_shift);
+                if (c < c_num_cached_classes)
+                {
+                    const u32 pages           = bin_calculate_size(slice_size, (u16)class_size(c));
+                    void*     meta            = narena::alloc_and_zero(arena, (uint_t)pages << page_shift, (u32)1 << page_shift);
+                    heap->m_classes[c].m_cbin = meta != nullptr ? bin_setup(meta, pages, slice, slice_size, (u16)class_size(c)) : nullptr;
+                }
+                else
+                {
+                    const u32 pages           = bin_calculate_size(slice_size, (u32)class_size(c));
+                    void*     meta            = narena::alloc_and_zero(arena, (uint_t)pages << page_shift, (u32)1 << page_shift);
+                    heap->m_classes[c].m_bbin = meta != nullptr ? bin_setup(meta, pages, slice, slice_size, (u32)class_size(c)) : nullptr;
+                }
+                if (heap->m_classes[c].m_cbin == nullptr && heap->m_classes[c].m_bbin == nullptr)
+                {
+                    s_release(heap);
+                    return nullptr;
+                }
+            }
+
+            // large
+            nsegment::initialize(&heap->m_segments, large_address_space, c_large_segment_min, math::min(c_large_segment_max, large_address_space));
+            if (heap->m_segments.m_base_address == nullptr)
+            {
+                s_release(heap);
+                return nullptr;
+            }
+            heap->m_large_base = heap->m_segments.m_base_address;
+            heap->m_large_size = (uint_t)large_address_space;
+            return heap;
+        }
+
+        void destroy(heap_t*& heap)
+        {
+            if (heap == nullptr)
+                return;
+            s_release(heap);
+            heap = nullptr;
+        }
+    }  // namespace nheap
+
+}  // namespace ncore
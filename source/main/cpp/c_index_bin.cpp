@@ -1,4 +1,5 @@
 #include "ccore/c_arena.h"
+#include "ccore/c_bitvec.h"
 #include "ccore/c_statevec.h"
 #include "ccore/c_math.h"
 #include "ccore/c_memory.h"
@@ -6,6 +7,302 @@
 
 namespace ncore
 {
+    // The tag and the generation of an item are stored next to each other, so that validating a
+    // generational index is a single load. The generation is bumped when an item is freed or moved.
+    struct itag16_t
+    {
+        u16 m_tag;
+        u16 m_generation;
+    };
+
+    struct itag32_t
+    {
+        u32 m_tag;
+        u32 m_generation;
+    };
+
+    // Tag index, a small tag domain has a bitset per tag (nbitvec, a set bit is an item with that tag, the summary
+    // levels skip the regions without matches). A large tag domain has an open addressing hash table of tag to a
+    // doubly linked list of items, the links are stored per item.
+    struct tag_index_t
+    {
+        arena_t* m_arena;                        // arena that holds this structure
+        u32      m_maxbits;                      // maximum number of items of the bin
+        u32      m_num_tags;                     // number of tags with a bitset, 0 when the hash table is used
+        u32      m_counts[c_ibin_tag_bitsets];   // number of items per tag (bitsets)
+        arena_t* m_bitsets[c_ibin_tag_bitsets];  // bitset per tag (nullptr until the first item with that tag)
+        arena_t* m_links;                        // {next, prev} per item (hash table)
+        arena_t* m_table;                        // {tag, head, count}[] (hash table)
+        u32      m_table_mask;                   // capacity - 1
+        u32      m_table_used;                   // number of taken entries, including the ones that became empty
+    };
+
+    struct tag_link_t
+    {
+        u32 m_next;
+        u32 m_prev;
+    };
+
+    struct tag_entry_t
+    {
+        u32 m_tag;
+        u32 m_head;
+        u32 m_count;
+    };
+
+    static const u32 cTAG_NO_ITEM          = 0xFFFFFFFF;     // end of a list of items
+    static const u32 cTAG_EMPTY_ENTRY      = 0xFFFFFFFF;     // count of an entry that was never taken
+    static const u32 cTAG_BITSET16_WORDS   = 1 + 16 + 1024;  // nbitvec18 for 65535 items, fully committed
+    static const u32 cTAG_BITSET32_SUMMARY = 1 + 64 + 4096;  // nbitvec24 level 0, 1 and 2, level 3 is committed on demand
+    static const u32 cTAG_BITSET32_WORDS   = cTAG_BITSET32_SUMMARY + 4096 * 64;
+
+    static inline u32 s_tag_hash(u32 tag) { return (u32)(((u64)tag * 0x9E3779B97F4A7C15ull) >> 32); }
+
+    static void s_tag_table_create(tag_index_t* ti, u32 capacity)
+    {
+        ti->m_table      = narena::new_arena((uint_t)capacity * sizeof(tag_entry_t), (uint_t)capacity * sizeof(tag_entry_t));
+        ti->m_table_mask = capacity - 1;
+        ti->m_table_used = 0;
+
+        tag_entry_t* table = narena::base_ptr_as<tag_entry_t>(ti->m_table);
+        for (u32 i = 0; i < capacity; ++i)
+        {
+            table[i].m_tag   = 0;
+            table[i].m_head  = cTAG_NO_ITEM;
+            table[i].m_count = cTAG_EMPTY_ENTRY;
+        }
+    }
+
+    static tag_entry_t* s_tag_find(tag_index_t const* ti, u32 tag)
+    {
+        tag_entry_t* table = narena::base_ptr_as<tag_entry_t>(ti->m_table);
+        u32          slot  = s_tag_hash(tag) & ti->m_table_mask;
+        while (table[slot].m_count != cTAG_EMPTY_ENTRY)
+        {
+            if (table[slot].m_tag == tag)
+                return &table[slot];
+            slot = (slot + 1) & ti->m_table_mask;
+        }
+        return nullptr;
+    }
+
+    // the table is rebuilt with only the entries that still have items, at most half of the entries are taken
+    static void s_tag_table_grow(tag_index_t* ti)
+    {
+        arena_t*           old_arena = ti->m_table;
+        tag_entry_t const* old_table = narena::base_ptr_as<tag_entry_t>(old_arena);
+        const u32          old_size  = ti->m_table_mask + 1;
+
+        u32 live = 0;
+        for (u32 i = 0; i < old_size; ++i)
+            live += (old_table[i].m_count != cTAG_EMPTY_ENTRY && old_table[i].m_count > 0) ? 1 : 0;
+
+        u32 capacity = 64;
+        while (capacity < live * 4)
+            capacity <<= 1;
+        s_tag_table_create(ti, capacity);
+
+        tag_entry_t* table = narena::base_ptr_as<tag_entry_t>(ti->m_table);
+        for (u32 i = 0; i < old_size; ++i)
+        {
+            if (old_table[i].m_count == cTAG_EMPTY_ENTRY || old_table[i].m_count == 0)
+                continue;
+            u32 slot = s_tag_hash(old_table[i].m_tag) & ti->m_table_mask;
+            while (table[slot].m_count != cTAG_EMPTY_ENTRY)
+                slot = (slot + 1) & ti->m_table_mask;
+            table[slot] = old_table[i];
+            ti->m_table_used += 1;
+        }
+        narena::destroy(old_arena);
+    }
+
+    static tag_entry_t* s_tag_find_or_add(tag_index_t* ti, u32 tag)
+    {
+        tag_entry_t* entry = s_tag_find(ti, tag);
+        if (entry != nullptr)
+            return entry;
+
+        if ((ti->m_table_used + 1) * 2 > ti->m_table_mask + 1)
+            s_tag_table_grow(ti);
+
+        tag_entry_t* table = narena::base_ptr_as<tag_entry_t>(ti->m_table);
+        u32          slot  = s_tag_hash(tag) & ti->m_table_mask;
+        while (table[slot].m_count != cTAG_EMPTY_ENTRY)
+            slot = (slot + 1) & ti->m_table_mask;
+        table[slot].m_tag   = tag;
+        table[slot].m_head  = cTAG_NO_ITEM;
+        table[slot].m_count = 0;
+        ti->m_table_used += 1;
+        return &table[slot];
+    }
+
+    static tag_index_t* s_tag_index_create(u32 maxbits, u32 num_tags)
+    {
+        arena_t*     arena = narena::new_arena(sizeof(tag_index_t), sizeof(tag_index_t));
+        tag_index_t* ti    = (tag_index_t*)narena::alloc_and_zero(arena, sizeof(tag_index_t));
+        ti->m_arena        = arena;
+        ti->m_maxbits      = maxbits;
+        if (num_tags <= c_ibin_tag_bitsets)
+        {
+            ti->m_num_tags = num_tags;
+        }
+        else
+        {
+            u32 capacity = 64;
+            while (capacity < num_tags * 2 && capacity < (1u << 24))
+                capacity <<= 1;
+            s_tag_table_create(ti, capacity);
+            ti->m_links = narena::new_arena((uint_t)maxbits * sizeof(tag_link_t), 0);
+        }
+        return ti;
+    }
+
+    static void s_tag_index_destroy(tag_index_t* ti)
+    {
+        if (ti == nullptr)
+            return;
+        for (u32 t = 0; t < ti->m_num_tags; ++t)
+        {
+            if (ti->m_bitsets[t] != nullptr)
+                narena::destroy(ti->m_bitsets[t]);
+        }
+        if (ti->m_links != nullptr)
+            narena::destroy(ti->m_links);
+        if (ti->m_table != nullptr)
+            narena::destroy(ti->m_table);
+        arena_t* arena = ti->m_arena;  // the arena holds 'ti'
+        narena::destroy(arena);
+    }
+
+    // the bitset of a tag, created on the first item with the tag, the pages with the word of 'item_index' and the
+    // word after it (which find_free_after reads) are committed
+    static u64* s_tag_bitset_commit(tag_index_t* ti, u32 tag, u32 item_index)
+    {
+        if (ti->m_maxbits <= 65536)
+        {
+            if (ti->m_bitsets[tag] == nullptr)
+                ti->m_bitsets[tag] = narena::new_arena(cTAG_BITSET16_WORDS * sizeof(u64), cTAG_BITSET16_WORDS * sizeof(u64));
+        }
+        else
+        {
+            if (ti->m_bitsets[tag] == nullptr)
+                ti->m_bitsets[tag] = narena::new_arena(cTAG_BITSET32_WORDS * sizeof(u64), cTAG_BITSET32_SUMMARY * sizeof(u64));
+            narena::commit(ti->m_bitsets[tag], math::min(cTAG_BITSET32_SUMMARY + (item_index >> 6) + 2, cTAG_BITSET32_WORDS) * sizeof(u64));
+        }
+        return narena::base_ptr_as<u64>(ti->m_bitsets[tag]);
+    }
+
+    static void s_tag_insert(tag_index_t* ti, u32 tag, u32 item_index)
+    {
+        if (ti == nullptr)
+            return;
+
+        if (ti->m_num_tags > 0)
+        {
+            ASSERT(tag < ti->m_num_tags);  // tag outside of the domain of the tag index
+            if (tag >= ti->m_num_tags)
+                return;
+            u64* bin0 = s_tag_bitset_commit(ti, tag, item_index);
+            if (ti->m_maxbits <= 65536)
+                nbitvec18::set_free(bin0, bin0 + 1, bin0 + 1 + 16, ti->m_maxbits, item_index);
+            else
+                nbitvec24::set_free(bin0, bin0 + 1, bin0 + 1 + 64, bin0 + cTAG_BITSET32_SUMMARY, ti->m_maxbits, item_index);
+            ti->m_counts[tag] += 1;
+            return;
+        }
+
+        // push the item at the head of the list of the tag
+        narena::commit(ti->m_links, ((uint_t)item_index + 1) * sizeof(tag_link_t));
+        tag_link_t*  links = narena::base_ptr_as<tag_link_t>(ti->m_links);
+        tag_entry_t* entry = s_tag_find_or_add(ti, tag);
+        links[item_index].m_next = entry->m_head;
+        links[item_index].m_prev = cTAG_NO_ITEM;
+        if (entry->m_head != cTAG_NO_ITEM)
+            links[entry->m_head].m_prev = item_index;
+        entry->m_head = item_index;
+        entry->m_count += 1;
+    }
+
+    // the 'next' link of a removed item is left as is, so that enumeration can continue from it
+    static void s_tag_remove(tag_index_t* ti, u32 tag, u32 item_index)
+    {
+        if (ti == nullptr)
+            return;
+
+        if (ti->m_num_tags > 0)
+        {
+            if (tag >= ti->m_num_tags)
+                return;
+            u64* bin0 = narena::base_ptr_as<u64>(ti->m_bitsets[tag]);
+            if (ti->m_maxbits <= 65536)
+                nbitvec18::set_used(bin0, bin0 + 1, bin0 + 1 + 16, ti->m_maxbits, item_index);
+            else
+                nbitvec24::set_used(bin0, bin0 + 1, bin0 + 1 + 64, bin0 + cTAG_BITSET32_SUMMARY, ti->m_maxbits, item_index);
+            ti->m_counts[tag] -= 1;
+            return;
+        }
+
+        tag_link_t*  links = narena::base_ptr_as<tag_link_t>(ti->m_links);
+        tag_entry_t* entry = s_tag_find(ti, tag);
+        ASSERT(entry != nullptr && entry->m_count > 0);
+        tag_link_t const& link = links[item_index];
+        if (link.m_prev != cTAG_NO_ITEM)
+            links[link.m_prev].m_next = link.m_next;
+        else
+            entry->m_head = link.m_next;
+        if (link.m_next != cTAG_NO_ITEM)
+            links[link.m_next].m_prev = link.m_prev;
+        entry->m_count -= 1;
+    }
+
+    static u32 s_tag_count(tag_index_t const* ti, u32 tag)
+    {
+        if (ti == nullptr)
+            return 0;
+        if (ti->m_num_tags > 0)
+            return tag < ti->m_num_tags ? ti->m_counts[tag] : 0;
+        tag_entry_t const* entry = s_tag_find(ti, tag);
+        return entry != nullptr ? entry->m_count : 0;
+    }
+
+    static i32 s_tag_first(tag_index_t const* ti, u32 tag)
+    {
+        if (ti == nullptr)
+            return -1;
+
+        if (ti->m_num_tags > 0)
+        {
+            if (tag >= ti->m_num_tags || ti->m_counts[tag] == 0)
+                return -1;
+            u64 const* bin0 = narena::base_ptr_as<u64>(ti->m_bitsets[tag]);
+            if (ti->m_maxbits <= 65536)
+                return nbitvec18::find_free(bin0, bin0 + 1, bin0 + 1 + 16, ti->m_maxbits);
+            return nbitvec24::find_free(bin0, bin0 + 1, bin0 + 1 + 64, bin0 + cTAG_BITSET32_SUMMARY, ti->m_maxbits);
+        }
+
+        tag_entry_t const* entry = s_tag_find(ti, tag);
+        return (entry != nullptr && entry->m_head != cTAG_NO_ITEM) ? (i32)entry->m_head : -1;
+    }
+
+    static i32 s_tag_next(tag_index_t const* ti, u32 tag, u32 item_index)
+    {
+        if (ti == nullptr)
+            return -1;
+
+        if (ti->m_num_tags > 0)
+        {
+            if (tag >= ti->m_num_tags || ti->m_bitsets[tag] == nullptr)
+                return -1;
+            u64 const* bin0 = narena::base_ptr_as<u64>(ti->m_bitsets[tag]);
+            if (ti->m_maxbits <= 65536)
+                return nbitvec18::find_free_after(bin0, bin0 + 1, bin0 + 1 + 16, ti->m_maxbits, item_index);
+            return nbitvec24::find_free_after(bin0, bin0 + 1, bin0 + 1 + 64, bin0 + cTAG_BITSET32_SUMMARY, ti->m_maxbits, item_index);
+        }
+
+        const u32 next = narena::base_ptr_as<tag_link_t>(ti->m_links)[item_index].m_next;
+        return next != cTAG_NO_ITEM ? (i32)next : -1;
+    }
+
     // ASCII font Collosal
     // 8888888 888888b.  8888888 888b    888  d888   .d8888b.
     //   888   888  "88b   888   8888b   888 d8888  d88P  Y88b
@@ -23,7 +320,7 @@ namespace ncore
         const u32 max_elements = 65535;  // maximum number of elements is 65535 (u16 indices)
 
         bin->m_items = narena::new_arena((uint_t)element_size * max_elements, 0);
-        bin->m_tags  = narena::new_arena((uint_t)sizeof(u16) * max_elements, 0);
+        bin->m_tags  = narena::new_arena((uint_t)sizeof(itag16_t) * max_elements, 0);
 
         bin->m_items_count = 0;             // number of items_array currently in use
         bin->m_item_sizeof = element_size;  // sizeof(item)
@@ -37,6 +334,8 @@ namespace ncore
         u64* bin2  = free1 + 16;
 
         nstatevec18::setup_used_lazy(free0, free1, used0, used1, bin2, max_elements);
+
+        bin->m_tag_index = nullptr;
     }
 
     void bin_destroy(ibin16_t* bin)
@@ -47,6 +346,8 @@ namespace ncore
             narena::destroy(bin->m_items);
         if (bin->m_binmap != nullptr)
             narena::destroy(bin->m_binmap);
+        s_tag_index_destroy(bin->m_tag_index);
+        bin->m_tag_index = nullptr;
     }
 
     // resize the bin to be able to hold new_max_elements
@@ -55,7 +356,7 @@ namespace ncore
         ASSERT(num_elements > 0 && num_elements < 65536);  // maximum number of elements is 65535 (u16 indices)
 
         narena::commit(bin->m_items, num_elements * bin->m_item_sizeof);
-        narena::commit(bin->m_tags, num_elements * sizeof(u16));
+        narena::commit(bin->m_tags, num_elements * sizeof(itag16_t));
         narena::commit(bin->m_binmap, (1 + 1 + 16 + 16 + ((num_elements + 63) / 64)) * sizeof(u64));
     }
 
@@ -76,8 +377,9 @@ namespace ncore
         {
             const s32 item_index = nstatevec18::alloc(free0, free1, used0, used1, bin2, items_free_index);
             ASSERT(item_index >= 0 && (u32)item_index < items_free_index);
-            u16* tags_array        = narena::base_ptr_as<u16>(bin->m_tags);
-            tags_array[item_index] = tag;
+            itag16_t* tags_array          = narena::base_ptr_as<itag16_t>(bin->m_tags);
+            tags_array[item_index].m_tag = tag;
+            s_tag_insert(bin->m_tag_index, tag, (u32)item_index);
             bin->m_items_count += 1;
             return item_index;
         }
@@ -87,28 +389,74 @@ namespace ncore
 
             // We need to make sure there is enough committed space in the binmap arena
             narena::commit(bin->m_binmap, (1 + 1 + 16 + 16 + ((items_free_index + 1 + 63) / 64)) * sizeof(u64));
-            nstatevec18::tick_used_lazy(free0, free1, used0, used1, bin2, items_free_index, item_index);
+            nstatevec18::tick_used_lazy(free0, free1, used0, used1, bin2, items_free_index + 1, item_index);
 
             narena::alloc(bin->m_items, bin->m_item_sizeof);
 
-            narena::commit(bin->m_tags, (items_free_index + 1) * sizeof(u16));
+            narena::commit(bin->m_tags, (items_free_index + 1) * sizeof(itag16_t));
             narena::commit(bin->m_binmap, (1 + 1 + 16 + 16 + ((items_free_index + 63) / 64)) * sizeof(u64));
 
-            u16* tags_array        = narena::base_ptr_as<u16>(bin->m_tags);
-            tags_array[item_index] = tag;
+            itag16_t* tags_array          = narena::base_ptr_as<itag16_t>(bin->m_tags);
+            tags_array[item_index].m_tag = tag;
+            s_tag_insert(bin->m_tag_index, tag, (u32)item_index);
             bin->m_items_count += 1;
             return item_index;
         }
     }
 
+    // Batch allocation, free slots below the highwater mark are reused first (the statevec has no batch
+    // allocation, so these are taken one by one), the remaining items are appended with a single commit
+    // of the binmap, tags and items.
+    u32 bin_alloc_n(ibin16_t* bin, u16 tag, u32* out_indices, u32 count)
+    {
+        u64* used0 = narena::base_ptr_as<u64>(bin->m_binmap);
+        u64* free0 = used0 + 1;
+        u64* used1 = free0 + 1;
+        u64* free1 = used1 + 16;
+        u64* bin2  = free1 + 16;
+
+        itag16_t* tags_array       = narena::base_ptr_as<itag16_t>(bin->m_tags);
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        u32 n = 0;
+        while (n < count && bin->m_items_count < items_free_index)
+        {
+            const s32 item_index = nstatevec18::alloc(free0, free1, used0, used1, bin2, items_free_index);
+            ASSERT(item_index >= 0 && (u32)item_index < items_free_index);
+            tags_array[item_index].m_tag = tag;
+            s_tag_insert(bin->m_tag_index, tag, (u32)item_index);
+            bin->m_items_count += 1;
+            out_indices[n++] = (u32)item_index;
+        }
+
+        const u32 num_new = math::min(count - n, 65535 - items_free_index);
+        if (num_new == 0)
+            return n;
+
+        const u32 new_free_index = items_free_index + num_new;
+        narena::commit(bin->m_binmap, (1 + 1 + 16 + 16 + ((new_free_index + 63) / 64)) * sizeof(u64));
+        narena::commit(bin->m_tags, new_free_index * sizeof(itag16_t));
+        narena::alloc(bin->m_items, num_new * bin->m_item_sizeof);
+
+        for (u32 item_index = items_free_index; item_index < new_free_index; ++item_index)
+        {
+            nstatevec18::tick_used_lazy(free0, free1, used0, used1, bin2, item_index + 1, item_index);
+            tags_array[item_index].m_tag = tag;
+            s_tag_insert(bin->m_tag_index, tag, item_index);
+            out_indices[n++] = item_index;
+        }
+        bin->m_items_count += num_new;
+        return n;
+    }
+
     // get the tag associated with an item index
     i32 bin_get_tag(ibin16_t const * bin, u32 item_index)
     {
         const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
         if (item_index < items_free_index)
         {
-            const u16* tags = narena::base_ptr_as<u16>(bin->m_tags);
-            return tags[item_index];
+            const itag16_t* tags = narena::base_ptr_as<itag16_t>(bin->m_tags);
+            return tags[item_index].m_tag;
         }
         return -1;
     }
@@ -118,8 +466,22 @@ namespace ncore
         const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
         if (item_index < items_free_index)
         {
-            u16* tags        = narena::base_ptr_as<u16>(bin->m_tags);
-            tags[item_index] = tag;
+            itag16_t* tags = narena::base_ptr_as<itag16_t>(bin->m_tags);
+            if (bin->m_tag_index != nullptr && tags[item_index].m_tag != tag)
+            {
+                // only used items are in the tag index
+                u64 const* used0 = narena::base_ptr_as<u64>(bin->m_binmap);
+                u64 const* free0 = used0 + 1;
+                u64 const* used1 = free0 + 1;
+                u64 const* free1 = used1 + 16;
+                u64 const* bin2  = free1 + 16;
+                if (nstatevec18::get(free0, free1, used0, used1, bin2, items_free_index, item_index))
+                {
+                    s_tag_remove(bin->m_tag_index, tags[item_index].m_tag, item_index);
+                    s_tag_insert(bin->m_tag_index, tag, item_index);
+                }
+            }
+            tags[item_index].m_tag = tag;
         }
     }
 
@@ -138,13 +500,37 @@ namespace ncore
         u64* bin2  = free1 + 16;
 
         nstatevec18::set_free(free0, free1, used0, used1, bin2, items_free_index, item_index);
+        itag16_t* tags_array = narena::base_ptr_as<itag16_t>(bin->m_tags);
+        s_tag_remove(bin->m_tag_index, tags_array[item_index].m_tag, item_index);
+        tags_array[item_index].m_generation += 1;
         bin->m_items_count -= 1;
     }
 
+    void bin_free_n(ibin16_t* bin, u32 const* indices, u32 count)
+    {
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        u64* used0 = narena::base_ptr_as<u64>(bin->m_binmap);
+        u64* free0 = used0 + 1;
+        u64* used1 = free0 + 1;
+        u64* free1 = used1 + 16;
+        u64* bin2  = free1 + 16;
+
+        itag16_t* tags_array = narena::base_ptr_as<itag16_t>(bin->m_tags);
+        for (u32 i = 0; i < count; ++i)
+        {
+            ASSERT(indices[i] < items_free_index);  // invalid index
+            nstatevec18::set_free(free0, free1, used0, used1, bin2, items_free_index, indices[i]);
+            s_tag_remove(bin->m_tag_index, tags_array[indices[i]].m_tag, indices[i]);
+            tags_array[indices[i]].m_generation += 1;
+        }
+        bin->m_items_count -= count;
+    }
+
     i32 bin_compact(ibin16_t* bin, u32& out_item_index)
     {
-        u16*  tags_array  = narena::base_ptr_as<u16>(bin->m_tags);
-        byte* items_array = narena::base_ptr(bin->m_items);
+        itag16_t* tags_array  = narena::base_ptr_as<itag16_t>(bin->m_tags);
+        byte*     items_array = narena::base_ptr(bin->m_items);
 
         u64* used0 = narena::base_ptr_as<u64>(bin->m_binmap);
         u64* free0 = used0 + 1;
@@ -176,9 +562,12 @@ namespace ncore
             // the moved item now occupies the hole again, so restore that slot as used
             nstatevec18::set_used(free0, free1, used0, used1, bin2, items_free_index, first_free_index);
 
-            // return the owner index of the item that was moved to fill the hole
-            tags_array[first_free_index] = tags_array[last_used_index];
-            out_item_index               = (u32)first_free_index;
+            // the item keeps its tag, generational indices of the item become stale
+            tags_array[first_free_index].m_tag = tags_array[last_used_index].m_tag;
+            tags_array[last_used_index].m_generation += 1;
+            s_tag_remove(bin->m_tag_index, tags_array[first_free_index].m_tag, (u32)last_used_index);
+            s_tag_insert(bin->m_tag_index, tags_array[first_free_index].m_tag, (u32)first_free_index);
+            out_item_index = (u32)first_free_index;
             return last_used_index;
         }
 
@@ -206,6 +595,106 @@ namespace ncore
 
     u32 bin_size(ibin16_t const * bin) { return bin->m_items_count; }
 
+    u32 bin_idx2gidx(ibin16_t const * bin, u32 index)
+    {
+        if (((uint_t)index * bin->m_item_sizeof) >= (uint_t)narena::current_pos(bin->m_items))
+            return c_null_gidx32;
+        return ((u32)narena::base_ptr_as<itag16_t>(bin->m_tags)[index].m_generation << 16) | index;
+    }
+
+    i32 bin_gidx2idx(ibin16_t const * bin, u32 gidx)
+    {
+        const u32 index = gidx & 0xFFFF;
+        if (((uint_t)index * bin->m_item_sizeof) >= (uint_t)narena::current_pos(bin->m_items))
+            return -1;
+        return narena::base_ptr_as<itag16_t>(bin->m_tags)[index].m_generation == (u16)(gidx >> 16) ? (i32)index : -1;
+    }
+
+    u32 bin_gidx2idx_n(ibin16_t const * bin, u32 const* gidx, i32* out_indices, u32 count)
+    {
+        const itag16_t* tags_array       = narena::base_ptr_as<itag16_t>(bin->m_tags);
+        const u32       items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        u32 valid = 0;
+        for (u32 i = 0; i < count; ++i)
+        {
+            const u32  index = gidx[i] & 0xFFFF;
+            const bool ok    = index < items_free_index && tags_array[index].m_generation == (u16)(gidx[i] >> 16);
+            out_indices[i]   = ok ? (i32)index : -1;
+            valid += ok ? 1 : 0;
+        }
+        return valid;
+    }
+
+    // the run of used items at or after 'from', out_count is 0 when there is none
+    static void s_bin16_find_run(ibin16_t const * bin, u32 from, u32& out_index, u32& out_count)
+    {
+        u64 const* used0 = narena::base_ptr_as<u64>(bin->m_binmap);
+        u64 const* free0 = used0 + 1;
+        u64 const* used1 = free0 + 1;
+        u64 const* free1 = used1 + 16;
+        u64 const* bin2  = free1 + 16;
+
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        out_count = 0;
+        if (from >= items_free_index)
+            return;
+
+        const s32 first = nstatevec18::get(free0, free1, used0, used1, bin2, items_free_index, from) ? (s32)from : nstatevec18::find_used_after(free0, free1, used0, used1, bin2, items_free_index, from);
+        if (first < 0)
+            return;
+        const s32 end = nstatevec18::find_free_after(free0, free1, used0, used1, bin2, items_free_index, (u32)first);
+        out_index     = (u32)first;
+        out_count     = (end < 0 ? items_free_index : (u32)end) - (u32)first;
+    }
+
+    void bin_iter_begin(ibin16_t const * bin, bin_used_iter_t& it)
+    {
+        it.m_items = nullptr;
+        it.m_index = 0;
+        it.m_count = 0;
+        s_bin16_find_run(bin, 0, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(narena::base_ptr(bin->m_items) + ((uint_t)it.m_next_index * bin->m_item_sizeof));
+    }
+
+    bool bin_iter_next(ibin16_t const * bin, bin_used_iter_t& it)
+    {
+        if (it.m_next_count == 0)
+            return false;
+
+        byte* items_array = narena::base_ptr(bin->m_items);
+        it.m_index        = it.m_next_index;
+        it.m_count        = it.m_next_count;
+        it.m_items        = items_array + ((uint_t)it.m_index * bin->m_item_sizeof);
+
+        // find the next run and start loading its first item while the caller processes this run
+        s_bin16_find_run(bin, it.m_index + it.m_count, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(items_array + ((uint_t)it.m_next_index * bin->m_item_sizeof));
+        return true;
+    }
+
+    void bin_tag_index_setup(ibin16_t* bin, u32 num_tags)
+    {
+        ASSERT(bin->m_tag_index == nullptr);  // the tag index already exists
+        bin->m_tag_index = s_tag_index_create(65535, num_tags);
+
+        itag16_t const* tags_array = narena::base_ptr_as<itag16_t>(bin->m_tags);
+        bin_used_iter_t it;
+        bin_iter_begin(bin, it);
+        while (bin_iter_next(bin, it))
+        {
+            for (u32 i = it.m_index; i < it.m_index + it.m_count; ++i)
+                s_tag_insert(bin->m_tag_index, tags_array[i].m_tag, i);
+        }
+    }
+
+    u32 bin_tag_count(ibin16_t const * bin, u16 tag) { return s_tag_count(bin->m_tag_index, tag); }
+    i32 bin_tag_first(ibin16_t const * bin, u16 tag) { return s_tag_first(bin->m_tag_index, tag); }
+    i32 bin_tag_next(ibin16_t const * bin, u16 tag, u32 item_index) { return s_tag_next(bin->m_tag_index, tag, item_index); }
+
     // ASCII font Collosal
     // 8888888 888888b.  8888888 888b    888  .d8888b.   .d8888b.
     //   888   888  "88b   888   8888b   888 d88P  Y88b d88P  Y88b
@@ -218,6 +707,75 @@ namespace ncore
 
     const u32 cBIN32_MAX_ELEMENTS = 1 << 24;  // maximum number of elements in the ibin32 (limited by u32 indices)
 
+    // Handle table, a handle and a handle table entry are a generation (8 bits) and a slot or item index (24 bits).
+    // The entry of a free slot holds the next free slot, the generation is bumped when a slot is freed.
+    static const u32 cBIN32_INDEX_MASK = 0x00FFFFFF;
+    static const u32 cBIN32_NO_SLOT    = 0x00FFFFFF;  // end of the free slot list and 'no handle' in the owners array
+
+    static void s_bin32_setup_handles(ibin32_t* bin)
+    {
+        bin->m_handles      = narena::new_arena((uint_t)sizeof(u32) * cBIN32_MAX_ELEMENTS, 0);
+        bin->m_owners       = narena::new_arena((uint_t)sizeof(u32) * cBIN32_MAX_ELEMENTS, 0);
+        bin->m_handles_free = cBIN32_NO_SLOT;
+
+        // the items that were allocated before have no handle
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+        narena::commit(bin->m_owners, items_free_index * sizeof(u32));
+        u32* owners = narena::base_ptr_as<u32>(bin->m_owners);
+        for (u32 i = 0; i < items_free_index; ++i)
+            owners[i] = cBIN32_NO_SLOT;
+    }
+
+    static inline void s_bin32_no_owner(ibin32_t* bin, u32 item_index)
+    {
+        if (bin->m_owners != nullptr)
+            narena::base_ptr_as<u32>(bin->m_owners)[item_index] = cBIN32_NO_SLOT;
+    }
+
+    // put the handle slot of the item (if any) back on the free list
+    static void s_bin32_release_handle(ibin32_t* bin, u32 item_index)
+    {
+        if (bin->m_owners == nullptr)
+            return;
+
+        u32*      owners = narena::base_ptr_as<u32>(bin->m_owners);
+        const u32 slot   = owners[item_index];
+        if (slot == cBIN32_NO_SLOT)
+            return;
+
+        u32* handles        = narena::base_ptr_as<u32>(bin->m_handles);
+        handles[slot]       = ((handles[slot] & ~cBIN32_INDEX_MASK) + (cBIN32_INDEX_MASK + 1)) | bin->m_handles_free;
+        bin->m_handles_free = slot;
+        owners[item_index]  = cBIN32_NO_SLOT;
+    }
+
+    // move an item (data, tag and handle) to a free slot, the binmap is not touched
+    static void s_bin32_move(ibin32_t* bin, u32 from_index, u32 to_index)
+    {
+        byte* items_array = narena::base_ptr(bin->m_items);
+        g_memcpy(items_array + ((uint_t)to_index * bin->m_item_sizeof), items_array + ((uint_t)from_index * bin->m_item_sizeof), bin->m_item_sizeof);
+
+        // the item keeps its tag, generational indices of the item become stale
+        itag32_t* tags_array       = narena::base_ptr_as<itag32_t>(bin->m_tags);
+        tags_array[to_index].m_tag = tags_array[from_index].m_tag;
+        tags_array[from_index].m_generation += 1;
+        s_tag_remove(bin->m_tag_index, tags_array[to_index].m_tag, from_index);
+        s_tag_insert(bin->m_tag_index, tags_array[to_index].m_tag, to_index);
+
+        if (bin->m_owners != nullptr)
+        {
+            u32*      owners   = narena::base_ptr_as<u32>(bin->m_owners);
+            const u32 slot     = owners[from_index];
+            owners[to_index]   = slot;
+            owners[from_index] = cBIN32_NO_SLOT;
+            if (slot != cBIN32_NO_SLOT)
+            {
+                u32* handles  = narena::base_ptr_as<u32>(bin->m_handles);
+                handles[slot] = (handles[slot] & ~cBIN32_INDEX_MASK) | to_index;
+            }
+        }
+    }
+
     void bin_setup(ibin32_t* bin, u16 element_size)
     {
         ASSERT(element_size > 0 && element_size <= 1024);  // element size should be reasonable
@@ -225,7 +783,7 @@ namespace ncore
         const u32 max_elements = cBIN32_MAX_ELEMENTS;  // maximum number of elements is 16 MILLION
 
         bin->m_items = narena::new_arena((uint_t)element_size * max_elements, 0);
-        bin->m_tags  = narena::new_arena((uint_t)sizeof(u32) * max_elements, 0);
+        bin->m_tags  = narena::new_arena((uint_t)sizeof(itag32_t) * max_elements, 0);
 
         bin->m_items_count = 0;             // number of items_array currently in use
         bin->m_item_sizeof = element_size;  // sizeof(item)
@@ -234,6 +792,10 @@ namespace ncore
         bin->m_binmap2u = narena::new_arena(4096 * sizeof(u64), 8);
         bin->m_binmap3  = narena::new_arena(4096 * 64 * sizeof(u64), 8);
 
+        bin->m_handles      = nullptr;  // created on the first handle allocation
+        bin->m_owners       = nullptr;
+        bin->m_handles_free = cBIN32_NO_SLOT;
+
         u64* free0 = narena::base_ptr_as<u64>(bin->m_binmap);
         u64* used0 = free0 + 1;
         u64* free1 = used0 + 1;
@@ -243,6 +805,8 @@ namespace ncore
         u64* bin3  = narena::base_ptr_as<u64>(bin->m_binmap3);
 
         nstatevec24::setup_used_lazy(free0, free1, used0, used1, free2, used2, bin3, max_elements);
+
+        bin->m_tag_index = nullptr;
     }
 
     void bin_destroy(ibin32_t* bin)
@@ -257,6 +821,12 @@ namespace ncore
             narena::destroy(bin->m_binmap2u);
         if (bin->m_binmap3 != nullptr)
             narena::destroy(bin->m_binmap3);
+        if (bin->m_handles != nullptr)
+            narena::destroy(bin->m_handles);
+        if (bin->m_owners != nullptr)
+            narena::destroy(bin->m_owners);
+        s_tag_index_destroy(bin->m_tag_index);
+        bin->m_tag_index = nullptr;
     }
 
     // resize the bin to be able to hold new_max_elements
@@ -265,10 +835,12 @@ namespace ncore
         ASSERT(num_elements > 0 && num_elements < cBIN32_MAX_ELEMENTS);  // maximum number of elements is 16 million
 
         narena::commit(bin->m_items, num_elements * bin->m_item_sizeof);
-        narena::commit(bin->m_tags, num_elements * sizeof(u32));
+        narena::commit(bin->m_tags, num_elements * sizeof(itag32_t));
         narena::commit(bin->m_binmap, (1 + 1 + 64 + 64 + ((num_elements + 63) / 64)) * sizeof(u64));
         narena::commit(bin->m_binmap2u, ((num_elements + (1 << 12) - 1) >> 12) * sizeof(u64));
         narena::commit(bin->m_binmap3, ((num_elements + (1 << 6) - 1) >> 6) * sizeof(u64));
+        if (bin->m_owners != nullptr)
+            narena::commit(bin->m_owners, num_elements * sizeof(u32));
     }
 
     i32 bin_alloc(ibin32_t* bin, u32 tag)
@@ -290,8 +862,10 @@ namespace ncore
         {
             const s32 item_index = nstatevec24::alloc(free0, free1, free2, used0, used1, used2, bin3, items_free_index);
             ASSERT(item_index >= 0 && (u32)item_index < items_free_index);
-            u32* tags_array        = narena::base_ptr_as<u32>(bin->m_tags);
-            tags_array[item_index] = tag;
+            itag32_t* tags_array          = narena::base_ptr_as<itag32_t>(bin->m_tags);
+            tags_array[item_index].m_tag = tag;
+            s_bin32_no_owner(bin, (u32)item_index);
+            s_tag_insert(bin->m_tag_index, tag, (u32)item_index);
             bin->m_items_count += 1;
             return item_index;
         }
@@ -306,21 +880,69 @@ namespace ncore
 
             narena::alloc(bin->m_items, bin->m_item_sizeof);
 
-            u32* tags_array        = narena::base_ptr_as<u32>(bin->m_tags);
-            tags_array[item_index] = tag;
+            itag32_t* tags_array          = narena::base_ptr_as<itag32_t>(bin->m_tags);
+            tags_array[item_index].m_tag = tag;
+            s_bin32_no_owner(bin, (u32)item_index);
+            s_tag_insert(bin->m_tag_index, tag, (u32)item_index);
             bin->m_items_count += 1;
             return item_index;
         }
     }
 
+    // Batch allocation, see the ibin16 version
+    u32 bin_alloc_n(ibin32_t* bin, u32 tag, u32* out_indices, u32 count)
+    {
+        u64* free0 = narena::base_ptr_as<u64>(bin->m_binmap);
+        u64* used0 = free0 + 1;
+        u64* free1 = used0 + 1;
+        u64* used1 = free1 + 64;
+        u64* free2 = used1 + 64;
+        u64* used2 = narena::base_ptr_as<u64>(bin->m_binmap2u);
+        u64* bin3  = narena::base_ptr_as<u64>(bin->m_binmap3);
+
+        itag32_t* tags_array       = narena::base_ptr_as<itag32_t>(bin->m_tags);
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        u32 n = 0;
+        while (n < count && bin->m_items_count < items_free_index)
+        {
+            const s32 item_index = nstatevec24::alloc(free0, free1, free2, used0, used1, used2, bin3, items_free_index);
+            ASSERT(item_index >= 0 && (u32)item_index < items_free_index);
+            tags_array[item_index].m_tag = tag;
+            s_bin32_no_owner(bin, (u32)item_index);
+            s_tag_insert(bin->m_tag_index, tag, (u32)item_index);
+            bin->m_items_count += 1;
+            out_indices[n++] = (u32)item_index;
+        }
+
+        const u32 num_new = math::min(count - n, (cBIN32_MAX_ELEMENTS - 1) - items_free_index);
+        if (num_new == 0)
+            return n;
+
+        const u32 new_free_index = items_free_index + num_new;
+        bin_commit(bin, new_free_index);
+        narena::alloc(bin->m_items, num_new * bin->m_item_sizeof);
+
+        for (u32 item_index = items_free_index; item_index < new_free_index; ++item_index)
+        {
+            nstatevec24::tick_used_lazy(free0, free1, free2, used0, used1, used2, bin3, item_index + 1, item_index);
+            tags_array[item_index].m_tag = tag;
+            s_bin32_no_owner(bin, item_index);
+            s_tag_insert(bin->m_tag_index, tag, item_index);
+            out_indices[n++] = item_index;
+        }
+        bin->m_items_count += num_new;
+        return n;
+    }
+
     // get the tag associated with an item index
     i32 bin_get_tag(ibin32_t const * bin, u32 item_index)
     {
         const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
         if (item_index < items_free_index)
         {
-            const u32* tags = narena::base_ptr_as<u32>(bin->m_tags);
-            return tags[item_index];
+            const itag32_t* tags = narena::base_ptr_as<itag32_t>(bin->m_tags);
+            return tags[item_index].m_tag;
         }
         return -1;
     }
@@ -330,8 +952,24 @@ namespace ncore
         const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
         if (item_index < items_free_index)
         {
-            u32* tags        = narena::base_ptr_as<u32>(bin->m_tags);
-            tags[item_index] = tag;
+            itag32_t* tags = narena::base_ptr_as<itag32_t>(bin->m_tags);
+            if (bin->m_tag_index != nullptr && tags[item_index].m_tag != tag)
+            {
+                // only used items are in the tag index
+                u64 const* free0 = narena::base_ptr_as<u64>(bin->m_binmap);
+                u64 const* used0 = free0 + 1;
+                u64 const* free1 = used0 + 1;
+                u64 const* used1 = free1 + 64;
+                u64 const* free2 = used1 + 64;
+                u64 const* used2 = narena::base_ptr_as<u64>(bin->m_binmap2u);
+                u64 const* bin3  = narena::base_ptr_as<u64>(bin->m_binmap3);
+                if (nstatevec24::get(free0, free1, free2, used0, used1, used2, bin3, items_free_index, item_index))
+                {
+                    s_tag_remove(bin->m_tag_index, tags[item_index].m_tag, item_index);
+                    s_tag_insert(bin->m_tag_index, tag, item_index);
+                }
+            }
+            tags[item_index].m_tag = tag;
         }
     }
 
@@ -352,14 +990,39 @@ namespace ncore
         u64* bin3  = narena::base_ptr_as<u64>(bin->m_binmap3);
 
         nstatevec24::set_free(free0, free1, free2, used0, used1, used2, bin3, items_free_index, item_index);
+        s_bin32_release_handle(bin, item_index);
+        itag32_t* tags_array = narena::base_ptr_as<itag32_t>(bin->m_tags);
+        s_tag_remove(bin->m_tag_index, tags_array[item_index].m_tag, item_index);
+        tags_array[item_index].m_generation += 1;
         bin->m_items_count -= 1;
     }
 
-    i32 bin_compact(ibin32_t* bin, u32& out_item_index)
+    void bin_free_n(ibin32_t* bin, u32 const* indices, u32 count)
     {
-        u32*  tags_array  = narena::base_ptr_as<u32>(bin->m_tags);
-        byte* items_array = narena::base_ptr(bin->m_items);
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        u64* free0 = narena::base_ptr_as<u64>(bin->m_binmap);
+        u64* used0 = free0 + 1;
+        u64* free1 = used0 + 1;
+        u64* used1 = free1 + 64;
+        u64* free2 = used1 + 64;
+        u64* used2 = narena::base_ptr_as<u64>(bin->m_binmap2u);
+        u64* bin3  = narena::base_ptr_as<u64>(bin->m_binmap3);
 
+        itag32_t* tags_array = narena::base_ptr_as<itag32_t>(bin->m_tags);
+        for (u32 i = 0; i < count; ++i)
+        {
+            ASSERT(indices[i] < items_free_index);  // invalid index
+            nstatevec24::set_free(free0, free1, free2, used0, used1, used2, bin3, items_free_index, indices[i]);
+            s_bin32_release_handle(bin, indices[i]);
+            s_tag_remove(bin->m_tag_index, tags_array[indices[i]].m_tag, indices[i]);
+            tags_array[indices[i]].m_generation += 1;
+        }
+        bin->m_items_count -= count;
+    }
+
+    i32 bin_compact(ibin32_t* bin, u32& out_item_index)
+    {
         u64* free0 = narena::base_ptr_as<u64>(bin->m_binmap);
         u64* used0 = free0 + 1;
         u64* free1 = used0 + 1;
@@ -385,23 +1048,126 @@ namespace ncore
 
         if (first_free_index < last_used_index)
         {
-            // move the item data
-            byte* dst_item = items_array + ((uint_t)first_free_index * bin->m_item_sizeof);
-            byte* src_item = items_array + ((uint_t)last_used_index * bin->m_item_sizeof);
-            g_memcpy(dst_item, src_item, bin->m_item_sizeof);
+            // move the item data, tag and handle
+            s_bin32_move(bin, (u32)last_used_index, (u32)first_free_index);
 
             // the moved item now occupies the hole again, so restore that slot as used
             nstatevec24::set_used(free0, free1, free2, used0, used1, used2, bin3, items_free_index, first_free_index);
 
-            // return the owner index of the item that was moved to fill the hole
-            tags_array[first_free_index] = tags_array[last_used_index];
-            out_item_index               = (u32)first_free_index;
+            out_item_index = (u32)first_free_index;
             return last_used_index;
         }
 
         return -1;  // no swap performed
     }
 
+    u32 bin_defrag(ibin32_t* bin, u32 max_moves)
+    {
+        u64* free0 = narena::base_ptr_as<u64>(bin->m_binmap);
+        u64* used0 = free0 + 1;
+        u64* free1 = used0 + 1;
+        u64* used1 = free1 + 64;
+        u64* free2 = used1 + 64;
+        u64* used2 = narena::base_ptr_as<u64>(bin->m_binmap2u);
+        u64* bin3  = narena::base_ptr_as<u64>(bin->m_binmap3);
+
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+        if (items_free_index == 0)
+            return 0;
+
+        // move the highest used items into the lowest free slots
+        u32 moves     = 0;
+        s32 last_used = nstatevec24::find_used_last(free0, free1, free2, used0, used1, used2, bin3, items_free_index);
+        while (moves < max_moves && bin->m_items_count < items_free_index)
+        {
+            const s32 first_free = nstatevec24::find_free(free0, free1, free2, used0, used1, used2, bin3, items_free_index);
+            if (first_free < 0 || first_free > last_used)
+                break;
+
+            s_bin32_move(bin, (u32)last_used, (u32)first_free);
+            nstatevec24::set_used(free0, free1, free2, used0, used1, used2, bin3, items_free_index, (u32)first_free);
+            nstatevec24::set_free(free0, free1, free2, used0, used1, used2, bin3, items_free_index, (u32)last_used);
+            moves += 1;
+
+            last_used = nstatevec24::find_used_last(free0, free1, free2, used0, used1, used2, bin3, items_free_index);
+        }
+
+        // all the slots above the last used item are free, lower the highwater mark and give the pages back,
+        // the tags stay committed since they hold the generations of the slots
+        const u32 new_free_index = (u32)(last_used + 1);
+        if (new_free_index < items_free_index)
+        {
+            nstatevec24::trim_used_lazy(free0, free1, free2, used0, used1, used2, bin3, items_free_index, new_free_index);
+            narena::restore_address(bin->m_items, narena::base_ptr(bin->m_items) + ((uint_t)new_free_index * bin->m_item_sizeof));
+            narena::shrink(bin->m_items);
+            if (bin->m_owners != nullptr)
+                narena::recommit(bin->m_owners, new_free_index * sizeof(u32));
+        }
+        return moves;
+    }
+
+    u32 bin_alloc_handle(ibin32_t* bin, u32 tag)
+    {
+        if (bin->m_handles == nullptr)
+            s_bin32_setup_handles(bin);
+
+        // take a slot first, a full handle table should not leave an allocated item behind
+        u32* handles = narena::base_ptr_as<u32>(bin->m_handles);
+        u32  slot    = bin->m_handles_free;
+        if (slot != cBIN32_NO_SLOT)
+        {
+            bin->m_handles_free = handles[slot] & cBIN32_INDEX_MASK;
+        }
+        else
+        {
+            slot = (u32)(narena::current_pos(bin->m_handles) / sizeof(u32));
+            if (slot >= cBIN32_NO_SLOT || narena::alloc(bin->m_handles, sizeof(u32)) == nullptr)
+                return c_ibin32_null_handle;
+            handles[slot] = 0;
+        }
+
+        const u32 generation = handles[slot] & ~cBIN32_INDEX_MASK;
+        const i32 item_index = bin_alloc(bin, tag);
+        if (item_index < 0)
+        {
+            handles[slot]       = generation | bin->m_handles_free;
+            bin->m_handles_free = slot;
+            return c_ibin32_null_handle;
+        }
+
+        handles[slot]                                       = generation | (u32)item_index;
+        narena::base_ptr_as<u32>(bin->m_owners)[item_index] = slot;
+        return generation | slot;
+    }
+
+    void bin_free_handle(ibin32_t* bin, u32 handle)
+    {
+        const i32 item_index = bin_handle2idx(bin, handle);
+        ASSERT(item_index >= 0);  // stale or invalid handle
+        if (item_index >= 0)
+            bin_free(bin, (u32)item_index);
+    }
+
+    i32 bin_handle2idx(ibin32_t const * bin, u32 handle)
+    {
+        if (bin->m_handles == nullptr)
+            return -1;
+
+        const u32 slot = handle & cBIN32_INDEX_MASK;
+        if (slot >= (u32)(narena::current_pos(bin->m_handles) / sizeof(u32)))
+            return -1;
+
+        // a freed slot has a different generation than any handle that was handed out for it
+        const u32 entry = narena::base_ptr_as<u32>(bin->m_handles)[slot];
+        return ((entry ^ handle) & ~cBIN32_INDEX_MASK) == 0 ? (i32)(entry & cBIN32_INDEX_MASK) : -1;
+    }
+
+    void* bin_handle2ptr(ibin32_t const * bin, u32 handle)
+    {
+        const i32 item_index = bin_handle2idx(bin, handle);
+        return item_index >= 0 ? bin_idx2ptr(bin, (u32)item_index) : nullptr;
+    }
+
     void* bin_idx2ptr(ibin32_t const * bin, u32 index)
     {
         const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
@@ -424,4 +1190,141 @@ namespace ncore
 
     u32 bin_size(ibin32_t const * bin) { return bin->m_items_count; }
 
+    static inline bool s_bin32_in_range(ibin32_t const * bin, u32 index) { return ((uint_t)index * bin->m_item_sizeof) < (uint_t)narena::current_pos(bin->m_items); }
+
+    // The last index is not packed in 32 bits, with a generation of 0xFF it would be c_null_gidx32
+    u32 bin_idx2gidx(ibin32_t const * bin, u32 index)
+    {
+        if (index >= cBIN32_INDEX_MASK || !s_bin32_in_range(bin, index))
+            return c_null_gidx32;
+        return (narena::base_ptr_as<itag32_t>(bin->m_tags)[index].m_generation << 24) | index;
+    }
+
+    u64 bin_idx2gidx64(ibin32_t const * bin, u32 index)
+    {
+        if (!s_bin32_in_range(bin, index))
+            return c_null_gidx64;
+        return ((u64)narena::base_ptr_as<itag32_t>(bin->m_tags)[index].m_generation << 32) | index;
+    }
+
+    i32 bin_gidx2idx(ibin32_t const * bin, u32 gidx)
+    {
+        const u32 index = gidx & cBIN32_INDEX_MASK;
+        if (index == cBIN32_INDEX_MASK || !s_bin32_in_range(bin, index))
+            return -1;
+        return (u8)narena::base_ptr_as<itag32_t>(bin->m_tags)[index].m_generation == (u8)(gidx >> 24) ? (i32)index : -1;
+    }
+
+    i32 bin_gidx2idx(ibin32_t const * bin, u64 gidx)
+    {
+        const u32 index = (u32)gidx;
+        if (!s_bin32_in_range(bin, index))
+            return -1;
+        return narena::base_ptr_as<itag32_t>(bin->m_tags)[index].m_generation == (u32)(gidx >> 32) ? (i32)index : -1;
+    }
+
+    u32 bin_gidx2idx_n(ibin32_t const * bin, u32 const* gidx, i32* out_indices, u32 count)
+    {
+        const itag32_t* tags_array       = narena::base_ptr_as<itag32_t>(bin->m_tags);
+        const u32       items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        u32 valid = 0;
+        for (u32 i = 0; i < count; ++i)
+        {
+            const u32  index = gidx[i] & cBIN32_INDEX_MASK;
+            const bool ok    = index < items_free_index && index != cBIN32_INDEX_MASK && (u8)tags_array[index].m_generation == (u8)(gidx[i] >> 24);
+            out_indices[i]   = ok ? (i32)index : -1;
+            valid += ok ? 1 : 0;
+        }
+        return valid;
+    }
+
+    u32 bin_gidx2idx_n(ibin32_t const * bin, u64 const* gidx, i32* out_indices, u32 count)
+    {
+        const itag32_t* tags_array       = narena::base_ptr_as<itag32_t>(bin->m_tags);
+        const u32       items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        u32 valid = 0;
+        for (u32 i = 0; i < count; ++i)
+        {
+            const u32  index = (u32)gidx[i];
+            const bool ok    = index < items_free_index && tags_array[index].m_generation == (u32)(gidx[i] >> 32);
+            out_indices[i]   = ok ? (i32)index : -1;
+            valid += ok ? 1 : 0;
+        }
+        return valid;
+    }
+
+    // the run of used items at or after 'from', out_count is 0 when there is none
+    static void s_bin32_find_run(ibin32_t const * bin, u32 from, u32& out_index, u32& out_count)
+    {
+        u64 const* free0 = narena::base_ptr_as<u64>(bin->m_binmap);
+        u64 const* used0 = free0 + 1;
+        u64 const* free1 = used0 + 1;
+        u64 const* used1 = free1 + 64;
+        u64 const* free2 = used1 + 64;
+        u64 const* used2 = narena::base_ptr_as<u64>(bin->m_binmap2u);
+        u64 const* bin3  = narena::base_ptr_as<u64>(bin->m_binmap3);
+
+        const u32 items_free_index = (u32)(narena::current_pos(bin->m_items) / bin->m_item_sizeof);
+
+        out_count = 0;
+        if (from >= items_free_index)
+            return;
+
+        // the used summary levels make find_used_after skip over whole words (64 items) and level 2 words (64x64 items) that are free
+        const s32 first = nstatevec24::get(free0, free1, free2, used0, used1, used2, bin3, items_free_index, from) ? (s32)from : nstatevec24::find_used_after(free0, free1, free2, used0, used1, used2, bin3, items_free_index, from);
+        if (first < 0)
+            return;
+        const s32 end = nstatevec24::find_free_after(free0, free1, free2, used0, used1, used2, bin3, items_free_index, (u32)first);
+        out_index     = (u32)first;
+        out_count     = (end < 0 ? items_free_index : (u32)end) - (u32)first;
+    }
+
+    void bin_iter_begin(ibin32_t const * bin, bin_used_iter_t& it)
+    {
+        it.m_items = nullptr;
+        it.m_index = 0;
+        it.m_count = 0;
+        s_bin32_find_run(bin, 0, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(narena::base_ptr(bin->m_items) + ((uint_t)it.m_next_index * bin->m_item_sizeof));
+    }
+
+    bool bin_iter_next(ibin32_t const * bin, bin_used_iter_t& it)
+    {
+        if (it.m_next_count == 0)
+            return false;
+
+        byte* items_array = narena::base_ptr(bin->m_items);
+        it.m_index        = it.m_next_index;
+        it.m_count        = it.m_next_count;
+        it.m_items        = items_array + ((uint_t)it.m_index * bin->m_item_sizeof);
+
+        // find the next run and start loading its first item while the caller processes this run
+        s_bin32_find_run(bin, it.m_index + it.m_count, it.m_next_index, it.m_next_count);
+        if (it.m_next_count > 0)
+            CC_PREFETCH(items_array + ((uint_t)it.m_next_index * bin->m_item_sizeof));
+        return true;
+    }
+
+    void bin_tag_index_setup(ibin32_t* bin, u32 num_tags)
+    {
+        ASSERT(bin->m_tag_index == nullptr);  // the tag index already exists
+        bin->m_tag_index = s_tag_index_create(cBIN32_MAX_ELEMENTS, num_tags);
+
+        itag32_t const* tags_array = narena::base_ptr_as<itag32_t>(bin->m_tags);
+        bin_used_iter_t it;
+        bin_iter_begin(bin, it);
+        while (bin_iter_next(bin, it))
+        {
+            for (u32 i = it.m_index; i < it.m_index + it.m_count; ++i)
+                s_tag_insert(bin->m_tag_index, tags_array[i].m_tag, i);
+        }
+    }
+
+    u32 bin_tag_count(ibin32_t const * bin, u32 tag) { return s_tag_count(bin->m_tag_index, tag); }
+    i32 bin_tag_first(ibin32_t const * bin, u32 tag) { return s_tag_first(bin->m_tag_index, tag); }
+    i32 bin_tag_next(ibin32_t const * bin, u32 tag, u32 item_index) { return s_tag_next(bin->m_tag_index, tag, item_index); }
+
 }  // namespace ncore
@@ -1,13 +1,11 @@
 #include "ccore/c_memory.h"
 
-// TODO
-// - Investigate the use of madvise(MADV_FREE) to decommit memory on Mac, madvise(MADV_DONTNEED) on Linux, and VirtualAlloc(MEM_RESET)
-
 #if defined(TARGET_PC)
     #define WIN32_LEAN_AND_MEAN
     #include <windows.h>
 
     #include "ccore/c_arena.h"
+    #include "ccore/c_atomic.h"
     #include "ccore/c_math.h"
     #include "ccore/c_memory.h"
 
@@ -55,14 +53,166 @@ namespace ncore
         (void)size;
         return VirtualFree(addr, 0, MEM_RELEASE);
     }
+
+    bool v_alloc_lazy_free(void* addr, uint_t size)
+    {
+        // MEM_RESET: the pages are no longer of interest, they stay committed but are not written to the paging file
+        void* result = VirtualAlloc(addr, size, MEM_RESET, PAGE_READWRITE);
+        return result != nullptr;
+    }
+
+    static void s_touch_pages(void* addr, uint_t size);
+
+    bool v_alloc_prefault(void* addr, uint_t size)
+    {
+        // there is no populate for anonymous committed memory, so touch every page
+        s_touch_pages(addr, size);
+        return true;
+    }
+
+    u32 v_alloc_get_large_page_size()
+    {
+        const SIZE_T large_page_size = GetLargePageMinimum();
+        return large_page_size != 0 ? (u32)large_page_size : 2 * cMB;
+    }
+
+    // Note: Windows large pages (MEM_LARGE_PAGES) require the SeLockMemoryPrivilege, have to be committed
+    //       at reservation time and can never be decommitted, that does not fit the reserve/commit model, so
+    //       here we only provide the large page alignment and report that we have default pages.
+    void* v_alloc_reserve(uint_t size, vmem_pages_t& pages)
+    {
+        pages                   = VMEM_PAGES_DEFAULT;
+        const uint_t page_align = v_alloc_get_large_page_size();
+        for (s32 attempt = 0; attempt < 8; ++attempt)
+        {
+            // Windows cannot release part of a reservation, so we reserve more, release it and then
+            // try to reserve again at the aligned address (which may race with other threads).
+            void* ptr = VirtualAlloc(nullptr, size + page_align, MEM_RESERVE, PAGE_NOACCESS);
+            if (ptr == nullptr)
+                return nullptr;
+            VirtualFree(ptr, 0, MEM_RELEASE);
+            void* aligned = (void*)math::alignUp((ptr_t)ptr, (ptr_t)page_align);
+            ptr           = VirtualAlloc(aligned, size, MEM_RESERVE, PAGE_NOACCESS);
+            if (ptr != nullptr)
+                return ptr;
+        }
+        return nullptr;
+    }
+
+    u32 v_numa_num_nodes()
+    {
+        ULONG highest_node = 0;
+        if (!GetNumaHighestNodeNumber(&highest_node))
+            return 1;
+        return highest_node < cNUMA_MAX_NODES ? (u32)highest_node + 1 : cNUMA_MAX_NODES;
+    }
+
+    s32 v_numa_current_node()
+    {
+        PROCESSOR_NUMBER processor;
+        USHORT           node = 0;
+        GetCurrentProcessorNumberEx(&processor);
+        if (!GetNumaProcessorNodeEx(&processor, &node))
+            return 0;
+        return (s32)node;
+    }
+
+    void* v_alloc_reserve_at(void* address, uint_t size)
+    {
+        void* ptr = VirtualAlloc(address, size, MEM_RESERVE, PAGE_NOACCESS);
+        return ptr != nullptr ? ptr : v_alloc_reserve(size);
+    }
+
+    // Note: a view of a file cannot be mapped into an existing reservation (only with the placeholder API of
+    //       Windows 10 1803+), so file backed memory is not supported.
+    vmem_file_t v_file_open(const char* path)
+    {
+        CC_UNUSED(path);
+        return cINVALID_VMEM_FILE;
+    }
+    vmem_file_t v_file_open_anonymous() { return cINVALID_VMEM_FILE; }
+    void v_file_close(vmem_file_t file) { CC_UNUSED(file); }
+    u64  v_file_size(vmem_file_t file)
+    {
+        CC_UNUSED(file);
+        return 0;
+    }
+    bool v_file_resize(vmem_file_t file, u64 size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_read(vmem_file_t file, u64 offset, void* dst, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(dst);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_write(vmem_file_t file, u64 offset, void const* src, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(src);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_map(vmem_file_t file, u64 offset, void* addr, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_map_private(vmem_file_t file, u64 offset, void* addr, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_sync(void* addr, uint_t size)
+    {
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_punch(vmem_file_t file, u64 offset, u64 size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(size);
+        return false;
+    }
+
+    // Note: Windows takes the preferred node at reservation or commit time (VirtualAllocExNuma), an existing
+    //       reservation cannot be bound.
+    bool v_numa_bind(void* addr, uint_t size, s32 node)
+    {
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        CC_UNUSED(node);
+        return false;
+    }
 }  // namespace ncore
 
 #elif defined(TARGET_LINUX) || defined(TARGET_MAC)
 
+    #include <fcntl.h>
+    #include <stdlib.h>
     #include <unistd.h>
     #include <sys/mman.h>
+    #include <sys/stat.h>
+    #if defined(TARGET_LINUX)
+        #include <sys/syscall.h>
+    #endif
 
     #include "ccore/c_arena.h"
+    #include "ccore/c_atomic.h"
     #include "ccore/c_math.h"
     #include "ccore/c_memory.h"
 
@@ -103,11 +253,240 @@ namespace ncore
         // munmap returns 0 on success
         return munmap(addr, size) == 0;
     }
+
+    bool v_alloc_lazy_free(void* addr, uint_t size)
+    {
+    #if defined(MADV_FREE)
+        // the kernel reclaims the pages only under memory pressure, until then they are reused without a fault
+        if (madvise(addr, size, MADV_FREE) == 0)
+            return true;
+    #endif
+        // MADV_FREE not available (e.g. Linux < 4.5), pages stay committed but will fault (zero-fill) when touched
+        return madvise(addr, size, MADV_DONTNEED) == 0;
+    }
+
+    static void s_touch_pages(void* addr, uint_t size);
+
+    bool v_alloc_prefault(void* addr, uint_t size)
+    {
+    #if defined(MADV_POPULATE_WRITE)
+        // Linux 5.14+, populate the page tables writable (the MAP_POPULATE equivalent for an existing mapping)
+        if (madvise(addr, size, MADV_POPULATE_WRITE) == 0)
+            return true;
+    #endif
+        s_touch_pages(addr, size);
+        return true;
+    }
+
+    u32 v_alloc_get_large_page_size() { return 2 * cMB; }
+
+    static void* s_reserve_aligned(uint_t size, uint_t alignment)
+    {
+        // reserve more than needed and unmap the head and tail that are outside the aligned range
+        const uint_t reserve_size = size + alignment;
+        byte*        ptr          = (byte*)mmap(nullptr, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (ptr == (byte*)MAP_FAILED)
+            return nullptr;
+        byte*        aligned = (byte*)math::alignUp((ptr_t)ptr, (ptr_t)alignment);
+        const uint_t head    = (uint_t)(aligned - ptr);
+        const uint_t tail    = reserve_size - head - size;
+        if (head > 0)
+            munmap(ptr, head);
+        if (tail > 0)
+            munmap(aligned + size, tail);
+        return aligned;
+    }
+
+    void* v_alloc_reserve(uint_t size, vmem_pages_t& pages)
+    {
+        ASSERT((size & (v_alloc_get_large_page_size() - 1)) == 0);
+
+    #if defined(MAP_HUGETLB)
+        if (pages == VMEM_PAGES_HUGE)
+        {
+            // Huge pages come from the pre-allocated hugetlbfs pool, the mapping fails when the pool cannot
+            // provide enough pages, in which case we fall back to transparent huge pages.
+            void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED)
+                return ptr;
+        }
+    #endif
+
+        void* ptr = s_reserve_aligned(size, v_alloc_get_large_page_size());
+        if (ptr == nullptr)
+        {
+            pages = VMEM_PAGES_DEFAULT;
+            return nullptr;
+        }
+
+    #if defined(MADV_HUGEPAGE)
+        if (pages != VMEM_PAGES_DEFAULT && madvise(ptr, size, MADV_HUGEPAGE) == 0)
+        {
+            pages = VMEM_PAGES_TRANSPARENT_HUGE;
+            return ptr;
+        }
+    #endif
+
+        pages = VMEM_PAGES_DEFAULT;
+        return ptr;
+    }
+
+    void* v_alloc_reserve_at(void* address, uint_t size)
+    {
+        // without MAP_FIXED the address is a hint, the kernel uses it when the range is free
+        void* ptr = mmap(address, size, PROT_NONE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    }
+
+    vmem_file_t v_file_open(const char* path)
+    {
+        const int fd = open(path, O_RDWR | O_CREAT, 0644);
+        return fd < 0 ? cINVALID_VMEM_FILE : (vmem_file_t)fd;
+    }
+
+    vmem_file_t v_file_open_anonymous()
+    {
+    #if defined(TARGET_LINUX) && defined(SYS_memfd_create)
+        const int fd = (int)syscall(SYS_memfd_create, "ccore", 1u);  // MFD_CLOEXEC
+    #else
+        // a temporary file that is unlinked right away, it lives as long as it is open or mapped
+        char      path[] = "/tmp/ccore-XXXXXX";
+        const int fd     = mkstemp(path);
+        if (fd >= 0)
+            unlink(path);
+    #endif
+        return fd < 0 ? cINVALID_VMEM_FILE : (vmem_file_t)fd;
+    }
+
+    void v_file_close(vmem_file_t file)
+    {
+        if (file != cINVALID_VMEM_FILE)
+            close((int)file);
+    }
+
+    u64 v_file_size(vmem_file_t file)
+    {
+        struct stat st;
+        if (fstat((int)file, &st) != 0)
+            return 0;
+        return (u64)st.st_size;
+    }
+
+    bool v_file_resize(vmem_file_t file, u64 size) { return ftruncate((int)file, (off_t)size) == 0; }
+
+    bool v_file_read(vmem_file_t file, u64 offset, void* dst, uint_t size) { return pread((int)file, dst, (size_t)size, (off_t)offset) == (ssize_t)size; }
+
+    bool v_file_write(vmem_file_t file, u64 offset, void const* src, uint_t size)
+    {
+        // pwrite can be partial for large sizes
+        byte const* ptr = (byte const*)src;
+        while (size > 0)
+        {
+            const ssize_t written = pwrite((int)file, ptr, (size_t)size, (off_t)offset);
+            if (written <= 0)
+                return false;
+            ptr += written;
+            offset += (u64)written;
+            size -= (uint_t)written;
+        }
+        return true;
+    }
+
+    bool v_file_map(vmem_file_t file, u64 offset, void* addr, uint_t size)
+    {
+        // replaces the (reserved) pages in the range with a shared mapping of the file
+        void* ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, (int)file, (off_t)offset);
+        return ptr == addr;
+    }
+
+    bool v_file_map_private(vmem_file_t file, u64 offset, void* addr, uint_t size)
+    {
+        // a page is copied when it is first written, until then it reads the content of the file
+        void* ptr = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, (int)file, (off_t)offset);
+        return ptr == addr;
+    }
+
+    bool v_file_sync(void* addr, uint_t size) { return msync(addr, size, MS_SYNC) == 0; }
+
+    bool v_file_punch(vmem_file_t file, u64 offset, u64 size)
+    {
+    #if defined(TARGET_LINUX) && defined(FALLOC_FL_PUNCH_HOLE) && defined(FALLOC_FL_KEEP_SIZE)
+        // unmapping or decommitting a shared mapping keeps the pages in the file, this frees them
+        return fallocate((int)file, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)size) == 0;
+    #else
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(size);
+        return false;
+    #endif
+    }
+
+    #if defined(TARGET_LINUX) && defined(SYS_mbind) && defined(SYS_get_mempolicy) && defined(SYS_getcpu)
+    // The memory policy constants from <linux/mempolicy.h>, the syscalls are used directly so there is no libnuma dependency
+    static const unsigned long cMPOL_PREFERRED      = 1;
+    static const unsigned long cMPOL_F_MEMS_ALLOWED = 1 << 2;
+    static const u32           cNUMA_MASK_BITS      = 1024;  // the kernel rejects a node mask smaller than its number of node ids
+    static const u32           cNUMA_WORD_BITS      = sizeof(unsigned long) * 8;
+    static u32                 s_numa_num_nodes     = 0;
+
+    u32 v_numa_num_nodes()
+    {
+        if (s_numa_num_nodes == 0)
+        {
+            int           mode      = 0;
+            u32           num_nodes = 1;
+            unsigned long mask[cNUMA_MASK_BITS / cNUMA_WORD_BITS];
+            g_memclr(mask, sizeof(mask));
+            if (syscall(SYS_get_mempolicy, &mode, mask, (unsigned long)cNUMA_MASK_BITS, nullptr, cMPOL_F_MEMS_ALLOWED) == 0)
+            {
+                for (u32 node = 0; node < cNUMA_MAX_NODES; ++node)
+                {
+                    if ((mask[node / cNUMA_WORD_BITS] >> (node % cNUMA_WORD_BITS)) & 1)
+                        num_nodes = node + 1;
+                }
+            }
+            s_numa_num_nodes = num_nodes;
+        }
+        return s_numa_num_nodes;
+    }
+
+    s32 v_numa_current_node()
+    {
+        unsigned cpu  = 0;
+        unsigned node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+            return 0;
+        return (s32)node;
+    }
+
+    bool v_numa_bind(void* addr, uint_t size, s32 node)
+    {
+        if (node < 0 || (u32)node >= v_numa_num_nodes())
+            return false;
+
+        // the kernel reads 'maxnode - 1' bits of the mask
+        unsigned long mask[cNUMA_MAX_NODES / cNUMA_WORD_BITS];
+        g_memclr(mask, sizeof(mask));
+        mask[node / cNUMA_WORD_BITS] = 1ul << (node % cNUMA_WORD_BITS);
+        return syscall(SYS_mbind, addr, (unsigned long)size, cMPOL_PREFERRED, mask, (unsigned long)cNUMA_MAX_NODES + 1, 0ul) == 0;
+    }
+    #else
+    u32  v_numa_num_nodes() { return 1; }
+    s32  v_numa_current_node() { return 0; }
+    bool v_numa_bind(void* addr, uint_t size, s32 node)
+    {
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        CC_UNUSED(node);
+        return false;
+    }
+    #endif
 }  // namespace ncore
 
 #else
 
     #include "ccore/c_arena.h"
+    #include "ccore/c_atomic.h"
     #include "ccore/c_math.h"
     #include "ccore/c_memory.h"
 
@@ -137,6 +516,103 @@ namespace ncore
         CC_UNUSED(size);
         return false;
     }
+    u32   v_alloc_get_large_page_size() { return 2 * cMB; }
+    void* v_alloc_reserve(uint_t size, vmem_pages_t& pages)
+    {
+        CC_UNUSED(size);
+        pages = VMEM_PAGES_DEFAULT;
+        return nullptr;
+    }
+    bool v_alloc_lazy_free(void* addr, uint_t size)
+    {
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_alloc_prefault(void* addr, uint_t size)
+    {
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    u32  v_numa_num_nodes() { return 1; }
+    s32  v_numa_current_node() { return 0; }
+    bool v_numa_bind(void* addr, uint_t size, s32 node)
+    {
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        CC_UNUSED(node);
+        return false;
+    }
+    void* v_alloc_reserve_at(void* address, uint_t size)
+    {
+        CC_UNUSED(address);
+        CC_UNUSED(size);
+        return nullptr;
+    }
+    vmem_file_t v_file_open(const char* path)
+    {
+        CC_UNUSED(path);
+        return cINVALID_VMEM_FILE;
+    }
+    vmem_file_t v_file_open_anonymous() { return cINVALID_VMEM_FILE; }
+    void v_file_close(vmem_file_t file) { CC_UNUSED(file); }
+    u64  v_file_size(vmem_file_t file)
+    {
+        CC_UNUSED(file);
+        return 0;
+    }
+    bool v_file_resize(vmem_file_t file, u64 size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_read(vmem_file_t file, u64 offset, void* dst, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(dst);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_write(vmem_file_t file, u64 offset, void const* src, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(src);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_map(vmem_file_t file, u64 offset, void* addr, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_map_private(vmem_file_t file, u64 offset, void* addr, uint_t size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_sync(void* addr, uint_t size)
+    {
+        CC_UNUSED(addr);
+        CC_UNUSED(size);
+        return false;
+    }
+    bool v_file_punch(vmem_file_t file, u64 offset, u64 size)
+    {
+        CC_UNUSED(file);
+        CC_UNUSED(offset);
+        CC_UNUSED(size);
+        return false;
+    }
 }  // namespace ncore
 
 #endif
@@ -154,3 +630,64 @@ namespace ncore
         return s_page_size_shift;
     }
 }  // namespace ncore
+
+namespace ncore
+{
+    // Write fault every page without changing its content, an atomic 'or 0' is used since other threads may
+    // already be writing to these pages.
+    static void s_touch_pages(void* addr, uint_t size)
+    {
+        const uint_t page_size = v_alloc_get_page_size();
+        byte*        ptr       = (byte*)addr;
+        byte* const  end       = ptr + size;
+        for (; ptr < end; ptr += page_size)
+            natomic::fetch_or((u32 volatile*)ptr, 0);
+    }
+
+    void v_decommit_policy_init(vmem_decommit_policy_t* policy, vmem_decommit_mode_t mode, uint_t retained_budget)
+    {
+        g_memclr(policy, sizeof(vmem_decommit_policy_t));
+        policy->m_mode            = (u32)mode;
+        policy->m_retained_budget = retained_budget;
+    }
+
+    static uint_t s_decommit_eager(vmem_decommit_policy_t* policy, void* addr, uint_t size)
+    {
+        if (size > 0 && v_alloc_decommit(addr, size) && policy != nullptr)
+        {
+            natomic::fetch_add_relaxed(&policy->m_stats.m_decommit_calls, (u64)1);
+            natomic::fetch_add_relaxed(&policy->m_stats.m_decommitted_bytes, (u64)size);
+        }
+        return 0;
+    }
+
+    uint_t v_decommit(vmem_decommit_policy_t* policy, void* addr, uint_t size, uint_t retained, u8 page_size_shift)
+    {
+        if (policy == nullptr || size == 0)
+            return s_decommit_eager(policy, addr, size);
+
+        switch (policy->m_mode)
+        {
+            case VMEM_DECOMMIT_LAZY:
+                if (!v_alloc_lazy_free(addr, size))
+                    return s_decommit_eager(policy, addr, size);
+                natomic::fetch_add_relaxed(&policy->m_stats.m_lazy_freed_bytes, (u64)size);
+                natomic::fetch_add_relaxed(&policy->m_stats.m_faults_avoided, (u64)(size >> page_size_shift));
+                return size;
+
+            case VMEM_DECOMMIT_HYSTERESIS:
+            {
+                // keep (page aligned) as much of the start of the range committed as the budget allows
+                const uint_t page_mask = ((uint_t)1 << page_size_shift) - 1;
+                uint_t       keep      = (policy->m_retained_budget > retained) ? (policy->m_retained_budget - retained) : 0;
+                keep                   = (keep < size ? keep : size) & ~page_mask;
+                s_decommit_eager(policy, (byte*)addr + keep, size - keep);
+                natomic::fetch_add_relaxed(&policy->m_stats.m_retained_bytes, (u64)keep);
+                natomic::fetch_add_relaxed(&policy->m_stats.m_faults_avoided, (u64)(keep >> page_size_shift));
+                return keep;
+            }
+
+            default: return s_decommit_eager(policy, addr, size);
+        }
+    }
+}  // namespace ncore
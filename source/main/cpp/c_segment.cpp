@@ -21,8 +21,10 @@ namespace ncore
         {
             u16 m_next;                  // index of the next node in the chain, or 0 if this is the last node in the chain
             u16 m_prev;                  // index of the previous node in the chain, or 0 if this is the first node in the chain
-            u32 m_committed_pages : 24;  // number of pages currently committed for this node (for used nodes) or for the buddy (for free nodes)
-            u32 m_flags : 8;             // flags for this node (e.g. free/used, left/right buddy)
+            u16 m_committed_lo;  // number of pages currently committed for this node (24 bits, low 16 bits)
+            u8  m_committed_hi;  // number of pages currently committed for this node (24 bits, high 8 bits)
+            u8  m_flags;         // flags for this node (e.g. free/used, left/right buddy), a byte of its own so that
+                                 // reading the flags does not race with the owner of a used node committing pages
         };
 
         const u16 cINVALID_INDEX = (u16)~0u;
@@ -55,6 +57,13 @@ namespace ncore
         static inline flags_t set_right(flags_t flags) { return flags | FLAG_LEFT_RIGHT; }
         static inline flags_t set_side(flags_t flags, i32 side) { return (flags & ~FLAG_LEFT_RIGHT) | ((side & 1) << FLAG_LEFT_RIGHT_SHIFT); }
 
+        static inline u32  s_get_committed(chain_t const* node) { return (u32)node->m_committed_lo | ((u32)node->m_committed_hi << 16); }
+        static inline void s_set_committed(chain_t* node, u32 pages)
+        {
+            node->m_committed_lo = (u16)pages;
+            node->m_committed_hi = (u8)(pages >> 16);
+        }
+
         // 888    888 8888888888 888      8888888b.  8888888888 8888888b.   .d8888b.
         // 888    888 888        888      888   Y88b 888        888   Y88b d88P  Y88b
         // 888    888 888        888      888    888 888        888    888 Y88b.
@@ -173,9 +182,23 @@ namespace ncore
             return true;
         }
 
+        // In concurrent mode the chain links of the neighbours of a node can change while they are checked, a used node
+        // is only changed by its owner so then only the node itself is checked.
+        static inline bool s_is_used_node(allocator_t* allocator, u16 node_index)
+        {
+            if (allocator->m_merge_batch != 0)
+            {
+                if (allocator->m_chain == nullptr || node_index >= allocator->m_total_minsize_segments)
+                    return false;
+                chain_t const* node = &allocator->m_chain[node_index];
+                return is_used(node->m_flags) && (node->m_next == cINVALID_INDEX || node->m_next > node_index);
+            }
+            return s_is_active_node(allocator, node_index) && is_used(allocator->m_chain[node_index].m_flags);
+        }
+
         static inline i32 s_node_class(allocator_t* allocator, u16 node_index)
         {
-            ASSERT(s_is_active_node(allocator, node_index));
+            ASSERT(allocator->m_merge_batch != 0 || s_is_active_node(allocator, node_index));
             chain_t const* node = &allocator->m_chain[node_index];
             const u32 span = node->m_next != cINVALID_INDEX ? (u32)node->m_next - node_index : allocator->m_total_minsize_segments - node_index;
             if (span == 0 || !math::ispo2(span))
@@ -188,12 +211,10 @@ namespace ncore
 
         static inline bool s_set_committed_pages(allocator_t* allocator, u16 node_index, u32 target_pages)
         {
-            if (!s_is_active_node(allocator, node_index))
+            if (!s_is_used_node(allocator, node_index))
                 return false;
 
             chain_t* node = &allocator->m_chain[node_index];
-            if (!is_used(node->m_flags))
-                return false;
 
             const i32 class_index = s_node_class(allocator, node_index);
             if (class_index < 0)
@@ -204,7 +225,7 @@ namespace ncore
             if (target_pages > available_pages || target_pages > 0x00ffffffu)
                 return false;
 
-            const u32 current_pages = node->m_committed_pages;
+            const u32 current_pages = s_get_committed(node);
             if (target_pages == current_pages)
                 return true;
 
@@ -226,7 +247,7 @@ namespace ncore
             if (!result)
                 return false;
 
-            node->m_committed_pages = target_pages;
+            s_set_committed(node, (u32)target_pages);
             return true;
         }
 
@@ -334,10 +355,10 @@ namespace ncore
                     chain_t* current_node_next = s_chain_index_to_ptr(allocator, current_node->m_next);
                     current_node_next->m_prev  = right_buddy_index;
                 }
-                current_node->m_next                        = right_buddy_index;
-                right_buddy->m_committed_pages              = 0;
+                current_node->m_next                                = right_buddy_index;
                 allocator->m_nodes[right_buddy_index].m_free.m_next = cINVALID_INDEX;
                 allocator->m_nodes[right_buddy_index].m_free.m_prev = cINVALID_INDEX;
+                s_set_committed(right_buddy, 0);
 
                 // Push right buddy to lower class free list
                 current_class--;
@@ -407,20 +428,20 @@ namespace ncore
                 if (left_node->m_next != right_index || right_node->m_prev != left_index)
                     break;
 
-                ASSERT(current_node->m_committed_pages == 0);
-                ASSERT(buddy_node->m_committed_pages == 0);
+                ASSERT(s_get_committed(current_node) == 0);
+                ASSERT(s_get_committed(buddy_node) == 0);
                 s_remove_from_free_list(allocator, current_class, buddy_index);
 
                 left_node->m_next = right_node->m_next;
                 if (right_node->m_next != cINVALID_INDEX)
                     allocator->m_chain[right_node->m_next].m_prev = left_index;
 
-                right_node->m_next            = cINVALID_INDEX;
-                right_node->m_prev            = cINVALID_INDEX;
-                right_node->m_committed_pages = 0;
-                right_node->m_flags           = 0;
+                right_node->m_next                            = cINVALID_INDEX;
+                right_node->m_prev                            = cINVALID_INDEX;
+                right_node->m_flags                           = 0;
                 allocator->m_nodes[right_index].m_free.m_next = cINVALID_INDEX;
                 allocator->m_nodes[right_index].m_free.m_prev = cINVALID_INDEX;
+                s_set_committed(right_node, 0);
 
                 ++current_class;
                 current_index         = left_index;
@@ -437,7 +458,7 @@ namespace ncore
                 return;
 
             const u16 node_index = (u16)node;
-            if (!s_is_active_node(allocator, node_index) || !is_used(allocator->m_chain[node_index].m_flags))
+            if (!s_is_used_node(allocator, node_index))
                 return;
 
             allocator->m_nodes[node_index].m_user.m_tag = tag;
@@ -450,7 +471,7 @@ namespace ncore
                 return false;
 
             const u16 node_index = (u16)node;
-            if (!s_is_active_node(allocator, node_index) || !is_used(allocator->m_chain[node_index].m_flags))
+            if (!s_is_used_node(allocator, node_index))
                 return false;
 
             tag = allocator->m_nodes[node_index].m_user.m_tag;
@@ -536,7 +557,7 @@ namespace ncore
 
                 const u64 node_offset        = (u64)candidate << allocator->m_segment_minsize_shift;
                 const u64 offset_within_node = address_offset - node_offset;
-                const u64 committed_size     = (u64)node->m_committed_pages << allocator->m_pagesize_shift;
+                const u64 committed_size     = (u64)s_get_committed(node) << allocator->m_pagesize_shift;
                 if (offset_within_node < committed_size)
                     return (node_t)candidate;
             }
@@ -563,10 +584,10 @@ namespace ncore
                 return;
 
             const u16 node_index = (u16)node;
-            if (!s_is_active_node(allocator, node_index) || !is_used(allocator->m_chain[node_index].m_flags))
+            if (!s_is_used_node(allocator, node_index))
                 return;
 
-            if (num_pages < allocator->m_chain[node_index].m_committed_pages)
+            if (num_pages < s_get_committed(&allocator->m_chain[node_index]))
                 return;
 
             const bool result = s_set_committed_pages(allocator, node_index, num_pages);
@@ -588,16 +609,307 @@ namespace ncore
                 return;
 
             const u16 node_index = (u16)node;
-            if (!s_is_active_node(allocator, node_index) || !is_used(allocator->m_chain[node_index].m_flags))
+            if (!s_is_used_node(allocator, node_index))
                 return;
 
-            if (num_pages > allocator->m_chain[node_index].m_committed_pages)
+            if (num_pages > s_get_committed(&allocator->m_chain[node_index]))
                 return;
 
             const bool result = s_set_committed_pages(allocator, node_index, num_pages);
             ASSERT(result);
         }
 
+        u32 committed_pages(allocator_t* allocator, node_t node)
+        {
+            if (allocator == nullptr || allocator->m_base_address == nullptr || node < 0 || (u32)node >= allocator->m_total_minsize_segments)
+                return 0;
+
+            const u16 node_index = (u16)node;
+            if (!s_is_used_node(allocator, node_index))
+                return 0;
+            return s_get_committed(&allocator->m_chain[node_index]);
+        }
+
+        // 88888888888 888    888 8888888b.  8888888888        d8888 8888888b.   .d8888b.
+        //     888     888    888 888   Y88b 888              d88888 888  "Y88b d88P  Y88b
+        //     888     888    888 888    888 888             d88P888 888    888 Y88b.
+        //     888     8888888888 888   d88P 8888888        d88P 888 888    888  "Y888b.
+        //     888     888    888 8888888P"  888           d88P  888 888    888     "Y88b.
+        //     888     888    888 888 T88b   888          d88P   888 888    888       "888
+        //     888     888    888 888  T88b  888         d8888888888 888  .d88P Y88b  d88P
+        //     888     888    888 888   T88b 8888888888 d88P     888 8888888P"   "Y8888P"
+
+        // Concurrent mode locking:
+        // - the free list of a size class is only touched while holding the lock of that class, a node that is on a
+        //   free list is free, popping it and marking it used happens under the same lock.
+        // - splitting and merging change the chain links of neighbouring nodes, these are serialized by the merge lock,
+        //   merging holds the lock of class c and c+1 (in that order), all other paths hold a single class lock.
+        // - a used node (flags, m_next, committed pages and user data) is only changed by its owner.
+
+        void enable_concurrent(allocator_t* allocator, u32 merge_batch)
+        {
+            ASSERT(allocator != nullptr);
+            for (u32 i = 0; i < 32; ++i)
+                nspinlock::init(allocator->m_class_locks[i]);
+            nspinlock::init(allocator->m_merge_lock);
+            natomic::store(&allocator->m_frees, 0u);
+            allocator->m_coalesce_class = 0;
+            allocator->m_coalesce_node  = cINVALID_INDEX;
+            allocator->m_merge_batch = merge_batch > 0 ? merge_batch : 1;
+        }
+
+        static inline u16 s_pop_locked(allocator_t* allocator, i32 class_index)
+        {
+            spinlock_scope_t lock(allocator->m_class_locks[class_index]);
+            const u16        node_index = (u16)s_pop_from_free_list(allocator, class_index);
+            if (node_index != cINVALID_INDEX)
+            {
+                chain_t* node = &allocator->m_chain[node_index];
+                node->m_flags = set_used(node->m_flags);
+            }
+            return node_index;
+        }
+
+        static inline void s_push_locked(allocator_t* allocator, i32 class_index, u16 node_index)
+        {
+            spinlock_scope_t lock(allocator->m_class_locks[class_index]);
+            chain_t*         node = &allocator->m_chain[node_index];
+            node->m_flags         = set_free(node->m_flags);
+            s_push_on_free_list(allocator, class_index, node_index);
+        }
+
+        // the free buddy of a free node of class @class_index, or cINVALID_INDEX when the buddy is used or split, the caller
+        // holds the merge lock and the lock of the class
+        static inline u16 s_free_buddy(allocator_t* allocator, i32 class_index, u16 node_index)
+        {
+            const u32 buddy_index = (u32)node_index ^ (1u << class_index);
+            if (buddy_index >= allocator->m_total_minsize_segments)
+                return cINVALID_INDEX;
+
+            // the chain links are only changed under the merge lock, check them before the flags, a buddy of this class
+            // that is deallocated concurrently writes its flags under the lock of this class
+            const u16      left_index  = math::min(node_index, (u16)buddy_index);
+            const u16      right_index = math::max(node_index, (u16)buddy_index);
+            chain_t const* left_node   = &allocator->m_chain[left_index];
+            chain_t const* right_node  = &allocator->m_chain[right_index];
+            if (left_node->m_next != right_index || right_node->m_prev != left_index || s_node_class(allocator, (u16)buddy_index) != class_index || !is_free(allocator->m_chain[buddy_index].m_flags))
+                return cINVALID_INDEX;
+            return (u16)buddy_index;
+        }
+
+        // merge the free buddies of every class from the bottom up, so that merged nodes are merged further in the same
+        // pass. The pass resumes at the coalesce cursor and stops after visiting @max_steps free nodes or at the end of the
+        // pass, the caller holds the merge lock.
+        static u32 s_merge_free_nodes(allocator_t* allocator, u32 max_steps)
+        {
+            if (allocator->m_coalesce_class == 0 && allocator->m_coalesce_node == cINVALID_INDEX)
+                natomic::store(&allocator->m_frees, 0u);
+
+            u32       merges    = 0;
+            const i32 top_class = allocator->m_segment_maxsize_shift - allocator->m_segment_minsize_shift;
+            while (max_steps > 0)
+            {
+                const i32 class_index = allocator->m_coalesce_class;
+                if (class_index >= top_class)
+                {
+                    allocator->m_coalesce_class = 0;
+                    allocator->m_coalesce_node  = cINVALID_INDEX;
+                    break;
+                }
+
+                spinlock_scope_t lock(allocator->m_class_locks[class_index]);
+
+                // resume at the cursor when that node is still on the free list of this class
+                u16 node_index = allocator->m_coalesce_node;
+                if (node_index == cINVALID_INDEX || !s_is_active_node(allocator, node_index) || s_node_class(allocator, node_index) != class_index || !is_free(allocator->m_chain[node_index].m_flags))
+                    node_index = allocator->m_free_list_heads[class_index];
+
+                for (; node_index != cINVALID_INDEX && max_steps > 0; --max_steps)
+                {
+                    u16       next_index  = allocator->m_nodes[node_index].m_free.m_next;
+                    const u16 buddy_index = s_free_buddy(allocator, class_index, node_index);
+                    if (buddy_index != cINVALID_INDEX)
+                    {
+                        if (next_index == buddy_index)
+                            next_index = allocator->m_nodes[buddy_index].m_free.m_next;
+                        s_remove_from_free_list(allocator, class_index, node_index);
+                        s_remove_from_free_list(allocator, class_index, buddy_index);
+
+                        const u16 left_index  = math::min(node_index, buddy_index);
+                        chain_t*  left_node   = &allocator->m_chain[left_index];
+                        chain_t*  right_node  = &allocator->m_chain[math::max(node_index, buddy_index)];
+                        left_node->m_next     = right_node->m_next;
+                        if (right_node->m_next != cINVALID_INDEX)
+                            allocator->m_chain[right_node->m_next].m_prev = left_index;
+
+                        right_node->m_next  = cINVALID_INDEX;
+                        right_node->m_prev  = cINVALID_INDEX;
+                        right_node->m_flags = 0;
+                        s_set_committed(right_node, 0);
+
+                        left_node->m_flags = set_side(left_node->m_flags, (left_index >> (class_index + 1)) & 1);
+                        s_push_locked(allocator, class_index + 1, left_index);
+                        merges += 1;
+                    }
+                    node_index = next_index;
+                }
+
+                allocator->m_coalesce_node = node_index;
+                if (node_index == cINVALID_INDEX)
+                    allocator->m_coalesce_class += 1;
+            }
+            return merges;
+        }
+
+        // a complete merge pass that starts at the smallest class, the caller holds the merge lock
+        static u32 s_merge_all_free_nodes(allocator_t* allocator)
+        {
+            allocator->m_coalesce_class = 0;
+            allocator->m_coalesce_node  = cINVALID_INDEX;
+            return s_merge_free_nodes(allocator, 0xffffffffu);
+        }
+
+        u32 merge_free_nodes(allocator_t* allocator)
+        {
+            ASSERT(allocator != nullptr && allocator->m_merge_batch != 0);
+            spinlock_scope_t lock(allocator->m_merge_lock);
+            return s_merge_all_free_nodes(allocator);
+        }
+
+        u32 coalesce(allocator_t* allocator, u32 max_steps)
+        {
+            ASSERT(allocator != nullptr);
+            if (allocator->m_base_address == nullptr)
+                return 0;
+            spinlock_scope_t lock(allocator->m_merge_lock);
+            return s_merge_free_nodes(allocator, max_steps);
+        }
+
+        void get_stats(allocator_t* allocator, stats_t& stats)
+        {
+            g_memset(&stats, 0, sizeof(stats_t));
+            if (allocator == nullptr || allocator->m_base_address == nullptr)
+                return;
+
+            spinlock_scope_t merge_lock(allocator->m_merge_lock);
+
+            const i32 top_class = allocator->m_segment_maxsize_shift - allocator->m_segment_minsize_shift;
+            for (i32 class_index = 0; class_index <= top_class; ++class_index)
+            {
+                spinlock_scope_t lock(allocator->m_class_locks[class_index]);
+
+                u32 num_free = 0;
+                for (u16 node_index = allocator->m_free_list_heads[class_index]; node_index != cINVALID_INDEX; node_index = allocator->m_nodes[node_index].m_free.m_next)
+                {
+                    num_free += 1;
+                    if (class_index < top_class)
+                    {
+                        const u16 buddy_index = s_free_buddy(allocator, class_index, node_index);
+                        if (buddy_index != cINVALID_INDEX && node_index < buddy_index)
+                            stats.m_mergeable_pairs[class_index] += 1;
+                    }
+                }
+
+                const u8 size_shift             = (u8)(allocator->m_segment_minsize_shift + class_index);
+                stats.m_free_nodes[class_index] = num_free;
+                stats.m_free_bytes[class_index] = (u64)num_free << size_shift;
+                stats.m_total_free_bytes += stats.m_free_bytes[class_index];
+                if (num_free > 0)
+                    stats.m_largest_free = (u64)1 << size_shift;
+            }
+            stats.m_used_bytes = ((u64)allocator->m_total_minsize_segments << allocator->m_segment_minsize_shift) - stats.m_total_free_bytes;
+        }
+
+        // pop a node of the target class or split a larger one, the caller holds the merge lock
+        static u16 s_alloc_split(allocator_t* allocator, i32 target_class)
+        {
+            i32 source_class = target_class;
+            u16 source_node  = cINVALID_INDEX;
+            for (i32 class_idx = target_class; class_idx < 32 && source_node == cINVALID_INDEX; ++class_idx)
+            {
+                source_node  = s_pop_locked(allocator, class_idx);
+                source_class = class_idx;
+            }
+            if (source_node == cINVALID_INDEX)
+                return cINVALID_INDEX;
+
+            // the node is marked used, the nodes that are split off are not visible until they are pushed
+            u32      current_node_index = source_node;
+            chain_t* current_node       = s_chain_index_to_ptr(allocator, source_node);
+            for (i32 current_class = source_class; current_class > target_class;)
+            {
+                const u32 right_buddy_index = current_node_index + (1u << (current_class - 1));
+                ASSERT(right_buddy_index < allocator->m_total_minsize_segments);
+                chain_t* right_buddy = s_chain_index_to_ptr(allocator, (u16)right_buddy_index);
+
+                current_node->m_flags = set_left(current_node->m_flags);
+                right_buddy->m_flags  = set_right(set_free(current_node->m_flags));
+
+                right_buddy->m_prev = current_node_index;
+                right_buddy->m_next = current_node->m_next;
+                if (current_node->m_next != cINVALID_INDEX)
+                    s_chain_index_to_ptr(allocator, current_node->m_next)->m_prev = right_buddy_index;
+                current_node->m_next                                = right_buddy_index;
+                allocator->m_nodes[right_buddy_index].m_free.m_next = cINVALID_INDEX;
+                allocator->m_nodes[right_buddy_index].m_free.m_prev = cINVALID_INDEX;
+                s_set_committed(right_buddy, 0);
+
+                current_class--;
+                s_push_locked(allocator, current_class, (u16)right_buddy_index);
+            }
+            return source_node;
+        }
+
+        node_t alloc_node_concurrent(allocator_t* allocator, u64 size)
+        {
+            ASSERT(allocator != nullptr && allocator->m_merge_batch != 0);
+
+            const u32 required_size_shift = s_bytes_to_size_shift(size);
+            const i32 target_class        = s_pages_to_class_index(required_size_shift, allocator->m_segment_minsize_shift, allocator->m_segment_maxsize_shift);
+            if (target_class < 0 || allocator->m_base_address == nullptr)
+                return cINVALID_NODE;
+
+            // fast path, a free node of the requested class only takes the lock of that class
+            u16 node_index = s_pop_locked(allocator, target_class);
+            if (node_index == cINVALID_INDEX)
+            {
+                spinlock_scope_t lock(allocator->m_merge_lock);
+                node_index = s_alloc_split(allocator, target_class);
+                if (node_index == cINVALID_INDEX && s_merge_all_free_nodes(allocator) > 0)
+                    node_index = s_alloc_split(allocator, target_class);
+                if (node_index == cINVALID_INDEX)
+                    return cINVALID_NODE;
+            }
+
+            allocator->m_nodes[node_index].m_user.m_tag    = 0;
+            allocator->m_nodes[node_index].m_user.m_unused = 0;
+            return (node_t)node_index;
+        }
+
+        void dealloc_node_concurrent(allocator_t* allocator, node_t node)
+        {
+            ASSERT(allocator != nullptr && allocator->m_merge_batch != 0);
+            if (allocator->m_base_address == nullptr || node < 0 || (u32)node >= allocator->m_total_minsize_segments)
+                return;
+
+            // the pages are given back before taking any lock
+            const u16 node_index = (u16)node;
+            if (!s_set_committed_pages(allocator, node_index, 0))
+                return;
+
+            const i32 class_index = s_node_class(allocator, node_index);
+            if (class_index < 0)
+                return;
+            s_push_locked(allocator, class_index, node_index);
+
+            // merge in a batch, when another thread is merging it will also see this node
+            if (natomic::fetch_add(&allocator->m_frees, 1u) + 1 >= allocator->m_merge_batch && nspinlock::try_lock(allocator->m_merge_lock))
+            {
+                s_merge_all_free_nodes(allocator);
+                nspinlock::unlock(allocator->m_merge_lock);
+            }
+        }
+
         // 8888888 888b    888 8888888 88888888888 8888888        d8888 888      8888888 8888888888P 8888888888
         //   888   8888b   888   888       888       888         d88888 888        888         d88P  888
         //   888   88888b  888   888       888       888        d88P888 888        888        d88P   888
@@ -607,15 +919,24 @@ namespace ncore
         //   888   888   Y8888   888       888       888    d8888888888 888        888    d88P       888
         // 8888888 888    Y888 8888888     888     8888888 d88P     888 88888888 8888888 d8888888888 8888888888
 
-        void initialize(allocator_t* allocator, u64 address_space_size, u64 segment_min_size, u64 segment_max_size)
+        void initialize(allocator_t* allocator, u64 address_space_size, u64 segment_min_size, u64 segment_max_size, vmem_pages_t pages, s32 numa_node)
         {
             ASSERT(allocator != nullptr);
             ASSERT(address_space_size > 0);
             ASSERT(math::ispo2(address_space_size));
             ASSERT(math::ispo2(segment_min_size) != 0 && math::ispo2(segment_max_size) != 0);
 
-            u32 const page_size       = v_alloc_get_page_size();
-            u8 const  page_size_shift = v_alloc_get_page_size_shift();
+            // A segment must be able to hold whole large pages
+            if (pages != VMEM_PAGES_DEFAULT && segment_min_size < v_alloc_get_large_page_size())
+                pages = VMEM_PAGES_DEFAULT;
+
+            u32 page_size       = v_alloc_get_page_size();
+            u8  page_size_shift = v_alloc_get_page_size_shift();
+            if (pages != VMEM_PAGES_DEFAULT)
+            {
+                page_size       = v_alloc_get_large_page_size();
+                page_size_shift = (u8)math::ilog2(page_size);
+            }
             ASSERT(segment_min_size >= page_size && segment_max_size >= segment_min_size);
             u8 const address_space_size_shift = s_bytes_to_size_shift(address_space_size);
             u8 const segment_minsize_shift    = s_bytes_to_size_shift(segment_min_size);
@@ -629,6 +950,7 @@ namespace ncore
             g_memset(allocator, 0, sizeof(allocator_t));
             for (u32 i = 0; i < 32; ++i)
                 allocator->m_free_list_heads[i] = cINVALID_INDEX;
+            allocator->m_coalesce_node = cINVALID_INDEX;
 
             const u32 size_class_count = (u32)segment_maxsize_shift - segment_minsize_shift;
             ASSERT(size_class_count < 32);
@@ -646,7 +968,22 @@ namespace ncore
 
             allocator->m_total_minsize_segments = (u32)(address_space_size >> segment_minsize_shift);
             const u64 reserve_size_bytes        = ((u64)allocator->m_total_minsize_segments << segment_minsize_shift) + ((u64)allocator->m_bookkeeping_num_pages << page_size_shift);
-            allocator->m_base_address           = (byte*)v_alloc_reserve(reserve_size_bytes);
+            if (pages == VMEM_PAGES_DEFAULT)
+            {
+                allocator->m_base_address = (byte*)v_alloc_reserve(reserve_size_bytes);
+            }
+            else
+            {
+                allocator->m_base_address = (byte*)v_alloc_reserve(reserve_size_bytes, pages);
+                if (allocator->m_base_address != nullptr && pages == VMEM_PAGES_DEFAULT)
+                {
+                    // No large pages could be obtained, the bookkeeping was computed with the large page
+                    // size, so start over using the system page size.
+                    v_alloc_release(allocator->m_base_address, reserve_size_bytes);
+                    initialize(allocator, address_space_size, segment_min_size, segment_max_size, VMEM_PAGES_DEFAULT, numa_node);
+                    return;
+                }
+            }
             if (allocator->m_base_address == nullptr)
             {
                 g_memset(allocator, 0, sizeof(allocator_t));
@@ -655,9 +992,14 @@ namespace ncore
                 return;
             }
 
+            // node affinity is best effort, this includes the bookkeeping that is committed below
+            if (numa_node != cNUMA_ANY_NODE)
+                v_numa_bind(allocator->m_base_address, (uint_t)reserve_size_bytes, numa_node);
+
             allocator->m_segment_minsize_shift = segment_minsize_shift;
             allocator->m_segment_maxsize_shift = segment_maxsize_shift;
             allocator->m_pagesize_shift        = page_size_shift;
+            allocator->m_page_backing          = (u8)pages;
 
             allocator->m_chain = (chain_t*)(allocator->m_base_address + ((u64)allocator->m_total_minsize_segments << segment_minsize_shift));
             allocator->m_nodes = (node_data_t*)((byte*)allocator->m_chain + max_nodes * sizeof(chain_t));
@@ -691,14 +1033,14 @@ namespace ncore
                 const u16 iprev    = (i > 0) ? icurrent - step : cINVALID_INDEX;
                 const u16 inext    = (i < num_top_nodes - 1) ? icurrent + step : cINVALID_INDEX;
 
-                chain_t* current                   = &allocator->m_chain[icurrent];
-                current->m_prev                    = iprev;
-                current->m_next                    = inext;
-                current->m_flags                   = set_free(0);
-                current->m_flags                   = set_side(current->m_flags, i & 1);
-                current->m_committed_pages         = 0;
+                chain_t* current                           = &allocator->m_chain[icurrent];
+                current->m_prev                            = iprev;
+                current->m_next                            = inext;
+                current->m_flags                           = set_free(0);
+                current->m_flags                           = set_side(current->m_flags, i & 1);
                 allocator->m_nodes[icurrent].m_free.m_next = inext;
                 allocator->m_nodes[icurrent].m_free.m_prev = iprev;
+                s_set_committed(current, 0);
             }
         }
 
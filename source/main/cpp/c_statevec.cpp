@@ -1,5 +1,6 @@
 #include "ccore/c_math.h"
 
+#include "ccore/c_bitvec.h"
 #include "ccore/c_statevec.h"
 
 namespace ncore
@@ -12,6 +13,127 @@ namespace ncore
 #define D_BIT_SET(word, bit)   ((word) | ((bintype)1 << (bit)))
 #define D_BIT_TEST(word, bit)  (((word) & ((bintype)1 << (bit))) != 0)
 
+    // --------------------------------------------------------------------------------
+    // --------------------------------------------------------------------------------
+    // Ranges of contiguous '0' bits, 'free[0]' .. 'free[num_levels - 2]' are the free summary levels and 'bin' holds
+    // the bits. The search only visits words that have a '0' bit, carries a run from one word into the next, and finds
+    // a run inside a word with a few shift-and steps instead of testing bit by bit.
+
+    template <typename bintype, u32 binshift, u32 num_levels>
+    class statevec_range_t
+    {
+    public:
+        static constexpr u32     binbits     = sizeof(bintype) * 8;
+        static constexpr u32     binmask     = binbits - 1;
+        static constexpr bintype binconstant = (bintype) ~(bintype)0;
+
+        static inline bintype mask_for_count(u32 count) { return (count >= binbits) ? binconstant : (bintype)(((bintype)1 << count) - 1); }
+        static inline bintype mask_from(u32 bit) { return (bit == 0) ? binconstant : (bintype)(binconstant << bit); }
+
+        // the mask of the bits [bit, end) that are in the word of 'bit', advances 'bit' to the start of the next word
+        static inline bintype next_word_mask(u32& bit, u32 end)
+        {
+            u32 const offset = bit & binmask;
+            u32 const count  = ((end - bit) < (binbits - offset)) ? (end - bit) : (binbits - offset);
+            bit += count;
+            return (bintype)(mask_for_count(count) << offset);
+        }
+
+        // the first set bit at or after 'pos' at summary 'level', -1 if there is none
+        static s32 next_set(bintype const* const* free, u32 const* counts, u32 level, u32 pos)
+        {
+            while (pos < counts[level])
+            {
+                u32 const     wi   = pos >> binshift;
+                bintype const word = free[level][wi] & mask_from(pos & binmask);
+                if (word != 0)
+                {
+                    u32 const bit = (wi << binshift) + (u32)math::findFirstBit(word);
+                    return bit < counts[level] ? (s32)bit : -1;
+                }
+                if (level == 0)
+                    return -1;
+                s32 const next = next_set(free, counts, level - 1, wi + 1);
+                if (next < 0)
+                    return -1;
+                pos = (u32)next << binshift;
+            }
+            return -1;
+        }
+
+        // the lowest position in a word where 'n' (n <= binbits) set bits start, -1 if there is none
+        static inline s32 find_run(bintype word, u32 n)
+        {
+            for (u32 len = 1; len < n && word != 0;)
+            {
+                u32 const step = (len < (n - len)) ? len : (n - len);
+                word &= (bintype)(word >> step);
+                len += step;
+            }
+            return word != 0 ? (s32)math::findFirstBit(word) : -1;
+        }
+
+        static s32 find_free_range(bintype const* const* free, bintype const* bin, u32 maxbits, u32 n)
+        {
+            if (n == 0 || n > maxbits)
+                return -1;
+
+            u32 counts[num_levels];  // number of valid bits per level
+            counts[num_levels - 1] = maxbits;
+            for (s32 l = (s32)num_levels - 2; l >= 0; --l)
+                counts[l] = (counts[l + 1] + binmask) >> binshift;
+
+            u32 const summary    = num_levels - 2;
+            u32 const full_words = maxbits >> binshift;  // words that have all their bits below maxbits
+            u32       run_start  = 0;  // the run of '0' bits that ends at the top of the previous word
+            u32       run_len    = 0;
+            u32       expected   = 0;  // a word that is skipped has no '0' bits and breaks the run
+            for (s32 wi = next_set(free, counts, summary, 0); wi >= 0; wi = next_set(free, counts, summary, expected))
+            {
+                if ((u32)wi != expected)
+                    run_len = 0;
+                expected = (u32)wi + 1;
+
+                // a '1' bit in 'word' is a free bit, the bits beyond maxbits are used
+                bintype const word = D_INVERT(bin[wi]) & mask_for_count(maxbits - ((u32)wi << binshift));
+                if (word == binconstant)
+                {
+                    if (run_len == 0)
+                        run_start = (u32)wi << binshift;
+                    run_len += binbits;
+                    if (run_len >= n)
+                        return (s32)run_start;
+
+                    // the free words that follow extend the run, they are compared many at a time
+                    u32 const need = (n - run_len + binmask) >> binshift;
+                    u32 const to   = ((u32)wi + 1 + need) < full_words ? ((u32)wi + 1 + need) : full_words;
+                    u32 const end  = nbitvec::scan_equal(bin, (u32)wi + 1, to, (bintype)0);
+                    run_len += (end - ((u32)wi + 1)) << binshift;
+                    if (run_len >= n)
+                        return (s32)run_start;
+                    expected = end;
+                    continue;
+                }
+
+                // the run continues into the low bits of this word
+                u32 const low = (u32)math::findFirstBit(D_INVERT(word));
+                if (run_len > 0 && (run_len + low) >= n)
+                    return (s32)run_start;
+                if (n <= binbits)
+                {
+                    s32 const bit = find_run(word, n);
+                    if (bit >= 0)
+                        return (s32)(((u32)wi << binshift) + (u32)bit);
+                }
+
+                // the high bits of this word start a new run
+                run_len   = binmask - (u32)math::findLastBit(D_INVERT(word));
+                run_start = (((u32)wi + 1) << binshift) - run_len;
+            }
+            return -1;
+        }
+    };
+
     // --------------------------------------------------------------------------------
     // --------------------------------------------------------------------------------
     // state-vectors with two levels
@@ -417,6 +539,44 @@ namespace ncore
 
             return -1;
         }
+
+        static s32 find_free_range(bintype const * _free0, bintype const * _used0, bintype const * _bin1, u32 maxbits, u32 n)
+        {
+            bintype const* free[] = {_free0};
+            return statevec_range_t<bintype, binshift, binlevels>::find_free_range(free, _bin1, maxbits, n);
+        }
+
+        static void set_used_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const     wi   = bit >> binshift;
+                bintype const mask = statevec_range_t<bintype, binshift, binlevels>::next_word_mask(bit, end);
+                _bin1[wi] |= mask;
+                update_summary_bits(_free0, _used0, _bin1, maxbits, wi);
+            }
+        }
+
+        static void set_free_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const     wi   = bit >> binshift;
+                bintype const mask = statevec_range_t<bintype, binshift, binlevels>::next_word_mask(bit, end);
+                _bin1[wi] &= D_INVERT(mask);
+                update_summary_bits(_free0, _used0, _bin1, maxbits, wi);
+            }
+        }
+
+        static s32 alloc_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 n)
+        {
+            s32 const start = find_free_range(_free0, _used0, _bin1, maxbits, n);
+            if (start >= 0)
+                set_used_range(_free0, _used0, _bin1, maxbits, (u32)start, n);
+            return start;
+        }
     };
 
     namespace nstatevec10
@@ -444,6 +604,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits) { return statevec_free0_used0_bin1_t<u32, 5>::free(_free0, _used0, _bin1, maxbits); }
         s32 alloc_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits) { return statevec_free0_used0_bin1_t<u32, 5>::alloc_last(_free0, _used0, _bin1, maxbits); }
         s32 free_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits) { return statevec_free0_used0_bin1_t<u32, 5>::free_last(_free0, _used0, _bin1, maxbits); }
+
+        s32 find_free_range(bintype const * _free0, bintype const * _used0, bintype const * _bin1, u32 maxbits, u32 n) { return statevec_free0_used0_bin1_t<u32, 5>::find_free_range(_free0, _used0, _bin1, maxbits, n); }
+        s32 alloc_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 n) { return statevec_free0_used0_bin1_t<u32, 5>::alloc_range(_free0, _used0, _bin1, maxbits, n); }
+        void free_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 start, u32 n) { statevec_free0_used0_bin1_t<u32, 5>::set_free_range(_free0, _used0, _bin1, maxbits, start, n); }
     }  // namespace nstatevec10
 
     namespace nstatevec12
@@ -471,6 +635,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits) { return statevec_free0_used0_bin1_t<u64, 6>::free(_free0, _used0, _bin1, maxbits); }
         s32 alloc_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits) { return statevec_free0_used0_bin1_t<u64, 6>::alloc_last(_free0, _used0, _bin1, maxbits); }
         s32 free_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits) { return statevec_free0_used0_bin1_t<u64, 6>::free_last(_free0, _used0, _bin1, maxbits); }
+
+        s32 find_free_range(bintype const * _free0, bintype const * _used0, bintype const * _bin1, u32 maxbits, u32 n) { return statevec_free0_used0_bin1_t<u64, 6>::find_free_range(_free0, _used0, _bin1, maxbits, n); }
+        s32 alloc_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 n) { return statevec_free0_used0_bin1_t<u64, 6>::alloc_range(_free0, _used0, _bin1, maxbits, n); }
+        void free_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 start, u32 n) { statevec_free0_used0_bin1_t<u64, 6>::set_free_range(_free0, _used0, _bin1, maxbits, start, n); }
     }  // namespace nstate-vector12
 
     // --------------------------------------------------------------------------------
@@ -932,6 +1100,44 @@ namespace ncore
             }
             return -1;
         }
+
+        static s32 find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _used0, bintype const * _used1, bintype const * _bin2, u32 maxbits, u32 n)
+        {
+            bintype const* free[] = {_free0, _free1};
+            return statevec_range_t<bintype, binshift, binlevels>::find_free_range(free, _bin2, maxbits, n);
+        }
+
+        static void set_used_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const     wi   = bit >> binshift;
+                bintype const mask = statevec_range_t<bintype, binshift, binlevels>::next_word_mask(bit, end);
+                _bin2[wi] |= mask;
+                update_summary_bits(_free0, _free1, _used0, _used1, _bin2, maxbits, wi);
+            }
+        }
+
+        static void set_free_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const     wi   = bit >> binshift;
+                bintype const mask = statevec_range_t<bintype, binshift, binlevels>::next_word_mask(bit, end);
+                _bin2[wi] &= D_INVERT(mask);
+                update_summary_bits(_free0, _free1, _used0, _used1, _bin2, maxbits, wi);
+            }
+        }
+
+        static s32 alloc_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 n)
+        {
+            s32 const start = find_free_range(_free0, _free1, _used0, _used1, _bin2, maxbits, n);
+            if (start >= 0)
+                set_used_range(_free0, _free1, _used0, _used1, _bin2, maxbits, (u32)start, n);
+            return start;
+        }
     };
 
     namespace nstatevec15
@@ -967,6 +1173,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits) { return statevec_free0_free1_used0_used1_bin2_t<u32, 5>::free(_free0, _free1, _used0, _used1, _bin2, maxbits); }
         s32 alloc_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits) { return statevec_free0_free1_used0_used1_bin2_t<u32, 5>::alloc_last(_free0, _free1, _used0, _used1, _bin2, maxbits); }
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits) { return statevec_free0_free1_used0_used1_bin2_t<u32, 5>::free_last(_free0, _free1, _used0, _used1, _bin2, maxbits); }
+
+        s32 find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _used0, bintype const * _used1, bintype const * _bin2, u32 maxbits, u32 n) { return statevec_free0_free1_used0_used1_bin2_t<u32, 5>::find_free_range(_free0, _free1, _used0, _used1, _bin2, maxbits, n); }
+        s32 alloc_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 n) { return statevec_free0_free1_used0_used1_bin2_t<u32, 5>::alloc_range(_free0, _free1, _used0, _used1, _bin2, maxbits, n); }
+        void free_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 start, u32 n) { statevec_free0_free1_used0_used1_bin2_t<u32, 5>::set_free_range(_free0, _free1, _used0, _used1, _bin2, maxbits, start, n); }
     }  // namespace nstatevec15
 
     namespace nstatevec18
@@ -1002,6 +1212,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits) { return statevec_free0_free1_used0_used1_bin2_t<u64, 6>::free(_free0, _free1, _used0, _used1, _bin2, maxbits); }
         s32 alloc_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits) { return statevec_free0_free1_used0_used1_bin2_t<u64, 6>::alloc_last(_free0, _free1, _used0, _used1, _bin2, maxbits); }
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits) { return statevec_free0_free1_used0_used1_bin2_t<u64, 6>::free_last(_free0, _free1, _used0, _used1, _bin2, maxbits); }
+
+        s32 find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _used0, bintype const * _used1, bintype const * _bin2, u32 maxbits, u32 n) { return statevec_free0_free1_used0_used1_bin2_t<u64, 6>::find_free_range(_free0, _free1, _used0, _used1, _bin2, maxbits, n); }
+        s32 alloc_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 n) { return statevec_free0_free1_used0_used1_bin2_t<u64, 6>::alloc_range(_free0, _free1, _used0, _used1, _bin2, maxbits, n); }
+        void free_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 start, u32 n) { statevec_free0_free1_used0_used1_bin2_t<u64, 6>::set_free_range(_free0, _free1, _used0, _used1, _bin2, maxbits, start, n); }
     }  // namespace nstatevec18
 
     // --------------------------------------------------------------------------------
@@ -1159,6 +1373,38 @@ namespace ncore
             }
         }
 
+        // Lowers the lazy highwater mark, the bits in [new_maxbits, maxbits) are put back in the lazy state (used)
+        // and the summary bits of the words above the new highwater mark are cleared, so that tick_used_lazy
+        // can grow the range again.
+        static void trim_used_lazy(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 new_maxbits)
+        {
+            ASSERT(new_maxbits <= maxbits);
+            if (new_maxbits == 0)
+            {
+                _free0[0] = 0;
+                _used0[0] = 0;
+                return;
+            }
+
+            // only the path from the word holding the last bit up to level 0 has to be recomputed
+            u32 const w3 = (new_maxbits - 1) >> binshift;
+            u32 const i2 = w3 >> binshift;
+            u32 const b2 = w3 & binmask;
+            u32 const i1 = i2 >> binshift;
+            u32 const b1 = i2 & binmask;
+
+            bintype const valid3 = valid_level3_mask(w3, new_maxbits);
+            _bin3[w3]            = _bin3[w3] | D_INVERT(valid3);
+            bintype const word3  = _bin3[w3] & valid3;
+
+            _free2[i2] = (_free2[i2] & mask_for_count(b2)) | (word3 != valid3 ? ((bintype)1 << b2) : 0);
+            _used2[i2] = (_used2[i2] & mask_for_count(b2)) | (word3 != 0 ? ((bintype)1 << b2) : 0);
+            _free1[i1] = (_free1[i1] & mask_for_count(b1)) | (_free2[i2] != 0 ? ((bintype)1 << b1) : 0);
+            _used1[i1] = (_used1[i1] & mask_for_count(b1)) | (_used2[i2] != 0 ? ((bintype)1 << b1) : 0);
+            _free0[0]  = (_free0[0] & mask_for_count(i1)) | (_free1[i1] != 0 ? ((bintype)1 << i1) : 0);
+            _used0[0]  = (_used0[0] & mask_for_count(i1)) | (_used1[i1] != 0 ? ((bintype)1 << i1) : 0);
+        }
+
         static void clear_all_free(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits)
         {
             u32 const level3_words = word_count_for_bits(maxbits);
@@ -1558,6 +1804,44 @@ namespace ncore
             }
             return -1;
         }
+
+        static s32 find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _free2, bintype const * _used0, bintype const * _used1, bintype const * _used2, bintype const * _bin3, u32 maxbits, u32 n)
+        {
+            bintype const* free[] = {_free0, _free1, _free2};
+            return statevec_range_t<bintype, binshift, binlevels>::find_free_range(free, _bin3, maxbits, n);
+        }
+
+        static void set_used_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const     wi   = bit >> binshift;
+                bintype const mask = statevec_range_t<bintype, binshift, binlevels>::next_word_mask(bit, end);
+                _bin3[wi] |= mask;
+                update_summary_bits(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, wi);
+            }
+        }
+
+        static void set_free_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 start, u32 n)
+        {
+            u32 const end = (start + n) < maxbits ? (start + n) : maxbits;
+            for (u32 bit = start; bit < end;)
+            {
+                u32 const     wi   = bit >> binshift;
+                bintype const mask = statevec_range_t<bintype, binshift, binlevels>::next_word_mask(bit, end);
+                _bin3[wi] &= D_INVERT(mask);
+                update_summary_bits(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, wi);
+            }
+        }
+
+        static s32 alloc_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 n)
+        {
+            s32 const start = find_free_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, n);
+            if (start >= 0)
+                set_used_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, (u32)start, n);
+            return start;
+        }
     };
 
     namespace nstatevec20
@@ -1606,6 +1890,13 @@ namespace ncore
         { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u32, 5>::alloc_last(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits); }
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits)
         { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u32, 5>::free_last(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits); }
+
+        s32 find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _free2, bintype const * _used0, bintype const * _used1, bintype const * _used2, bintype const * _bin3, u32 maxbits, u32 n)
+        { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u32, 5>::find_free_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, n); }
+        s32 alloc_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 n)
+        { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u32, 5>::alloc_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, n); }
+        void free_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 start, u32 n)
+        { statevec_free0_free1_free2_used0_used1_used2_bin3_t<u32, 5>::set_free_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, start, n); }
     }  // namespace nstatevec20
 
     namespace nstatevec24
@@ -1616,6 +1907,8 @@ namespace ncore
         { statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::setup_used_lazy(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits); }
         void tick_used_lazy(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 bit)
         { statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::tick_used_lazy(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, bit); }
+        void trim_used_lazy(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 new_maxbits)
+        { statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::trim_used_lazy(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, new_maxbits); }
 
         void clear_all_free(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits)
         { statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::clear_all_free(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits); }
@@ -1654,6 +1947,13 @@ namespace ncore
         { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::alloc_last(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits); }
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits)
         { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::free_last(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits); }
+
+        s32 find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _free2, bintype const * _used0, bintype const * _used1, bintype const * _used2, bintype const * _bin3, u32 maxbits, u32 n)
+        { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::find_free_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, n); }
+        s32 alloc_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 n)
+        { return statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::alloc_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, n); }
+        void free_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 start, u32 n)
+        { statevec_free0_free1_free2_used0_used1_used2_bin3_t<u64, 6>::set_free_range(_free0, _free1, _free2, _used0, _used1, _used2, _bin3, maxbits, start, n); }
     }  // namespace nstate-vector24
 
 }  // namespace ncore
@@ -0,0 +1,128 @@
+#ifndef __CCORE_ALLOC_STATS_H__
+#define __CCORE_ALLOC_STATS_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+
+namespace ncore
+{
+    class writer_t;
+
+    // Allocation statistics, all counters are updated with relaxed atomic operations so that a statistics
+    // block can be shared by multiple threads. Sizes and lifetimes are bucketed into power-of-two
+    // classes, class N holds the values in [2^(N-1), 2^N), class 0 holds the value 0.
+    // Lifetimes are measured in 'allocations', the number of allocations that were made by the
+    // allocator between allocating and deallocating a block (no clock is needed).
+    const u32 c_alloc_stats_classes = 32;
+
+    struct alloc_stats_t
+    {
+        u64 m_count[c_alloc_stats_classes];     // number of allocations per size class
+        u64 m_bytes[c_alloc_stats_classes];     // number of bytes allocated per size class
+        u64 m_lifetime[c_alloc_stats_classes];  // number of deallocations per lifetime class
+        u64 m_allocs;                           // total number of allocations
+        u64 m_frees;                            // total number of deallocations
+        u64 m_live_count;                       // number of live allocations
+        u64 m_live_bytes;                       // number of live bytes (gauge)
+        u64 m_peak_bytes;                       // highest number of live bytes
+    };
+
+    namespace nalloc_stats
+    {
+        void reset(alloc_stats_t* stats);
+        u32  size_class(u64 value);  // index of the power-of-two class of 'value'
+
+        void on_alloc(alloc_stats_t* stats, u32 size);
+        void on_free(alloc_stats_t* stats, u32 size, u64 lifetime);
+
+        // Scopes, a scope is a (file, line) that is registered once in a global table and identified by
+        // a 16-bit index, scope index 0 means 'no scope'. Every thread has a stack of active scopes.
+        const u32 c_max_scopes = 1024;
+
+        u16         register_scope(const char* file, s32 line);  // returns 0 when the scope table is full
+        const char* scope_file(u16 scope);
+        s32         scope_line(u16 scope);
+        void        push_scope(const char* file, s32 line);  // calling thread
+        void        pop_scope();                             // calling thread
+        u16         current_scope();                         // calling thread, 0 when no scope is active
+
+        // An alloc_tracker_t that feeds DALLOCATION_SCOPE into the scope stack of the calling thread.
+        // usage: g_set_alloc_tracker(nalloc_stats::tracker());
+        alloc_tracker_t* tracker();
+    }  // namespace nalloc_stats
+
+    // An allocation event as it is recorded in a ring buffer and written to a trace dump (24 bytes)
+    struct alloc_event_t
+    {
+        enum
+        {
+            ALLOC = 1,
+            FREE  = 2,
+        };
+
+        u64 m_address;   // address of the allocation
+        u64 m_sequence;  // allocation sequence number of the allocator at the time of the event
+        u32 m_size;      // size of the allocation
+        u16 m_scope;     // scope that was active when the block was allocated
+        u8  m_type;      // ALLOC or FREE
+        u8  m_padding;
+    };
+
+    // Single-writer (lock-free) ring of allocation events, the owner thread writes events without
+    // any synchronization and older events are overwritten when the ring is full.
+    struct alloc_ring_t
+    {
+        alloc_event_t* m_events;    // caller provided array of events
+        u32            m_mask;      // capacity - 1, capacity is a power of two
+        u32 volatile   m_head;      // total number of events written
+    };
+
+    namespace nalloc_trace
+    {
+        void init(alloc_ring_t* ring, alloc_event_t* events, u32 capacity);  // capacity must be a power of two
+        void set_thread_ring(alloc_ring_t* ring);                            // ring of the calling thread (nullptr = no tracing)
+        alloc_ring_t* thread_ring();
+        void record(alloc_ring_t* ring, u8 type, void* address, u32 size, u16 scope, u64 sequence);
+
+        // Write the events of a ring, oldest first, to 'writer' in a compact binary format:
+        //     header: u32 magic ('ATRC'), u32 version, u32 event size, u32 event count
+        //     events: alloc_event_t[event count]
+        // Returns the number of bytes written, the ring should not be written to while dumping.
+        s64 dump(alloc_ring_t const* ring, writer_t* writer);
+    }  // namespace nalloc_trace
+
+    // Instrumentation layer that wraps any alloc_t, it records sizes, counts, lifetimes, live bytes and
+    // peak bytes in a global statistics block and in the statistics block of the active scope. When the
+    // calling thread has a ring buffer, alloc/free events are recorded in that ring as well.
+    // Every allocation carries a 16 byte header that holds the size, scope and sequence number.
+    // Note: 'scope_stats' is indexed by scope index (index 0 collects the allocations made outside of any scope),
+    //       scopes beyond 'max_scopes' are only counted globally.
+    class alloc_stats_alloc_t : public alloc_t
+    {
+    public:
+        alloc_stats_alloc_t(alloc_t* allocator, alloc_stats_t* scope_stats = nullptr, u32 max_scopes = 0);
+        virtual ~alloc_stats_alloc_t() {}
+
+        inline alloc_stats_t const& stats() const { return m_stats; }
+        inline alloc_stats_t const* scope_stats(u16 scope) const { return (m_scope_stats != nullptr && scope < m_max_scopes) ? &m_scope_stats[scope] : nullptr; }
+        void                        reset();
+
+        DCORE_CLASS_PLACEMENT_NEW_DELETE
+
+    protected:
+        virtual void* v_allocate(u32 size, u32 alignment);
+        virtual void  v_deallocate(void* ptr);
+
+        alloc_t*       m_allocator;
+        alloc_stats_t* m_scope_stats;
+        u32            m_max_scopes;
+        u64 volatile   m_sequence;
+        alloc_stats_t  m_stats;
+    };
+
+}  // namespace ncore
+
+#endif  // __CCORE_ALLOC_STATS_H__
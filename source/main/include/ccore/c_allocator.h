@@ -76,6 +76,7 @@ namespace ncore
 
     // Note: thread_local alloc_tracker_t* sAllocTracker = &sEmptyAllocTracker;
     alloc_tracker_t* g_alloc_tracker();
+    void             g_set_alloc_tracker(alloc_tracker_t* tracker);  // tracker of the calling thread (nullptr = empty tracker)
 
     class alloc_scope_t
     {
@@ -6,38 +6,111 @@
 #endif
 
 #include "ccore/c_allocator.h"
+#include "ccore/c_atomic.h"
+#include "ccore/c_memory.h"
 
 namespace ncore
 {
-    struct arena_t                 // 32 bytes
-    {                              //
-        byte*  m_base;             // base address of the arena (after header)
-        uint_t m_pos;              // current position in the arena to allocate from (relative to m_base)
-        u32    m_reserved_pages;   // (unit = pages) reserved number of pages for this arena (relative to arena)
-        u32    m_committed_pages;  // (unit = pages) number of committed pages (relative to arena)
-        u8     m_page_size_shift;  // page size in shift (from system)
-        u8     m_ownership;        // ownership
-        u8     m_active;           // whether this arena is in use
-        u8     m_padding1;         // padding
-        u32    m_padding2;         // padding
+    namespace nsegment
+    {
+        struct allocator_t;
+    }
+
+    struct arena_t                     // 32 bytes
+    {                                  //
+        byte*      m_base;             // base address of the arena (after header)
+        uint_t     m_pos;              // current position in the arena to allocate from (relative to m_base)
+        u32        m_reserved_pages;   // (unit = pages) reserved number of pages for this arena (relative to arena)
+        u32        m_committed_pages;  // (unit = pages) number of committed pages (relative to arena)
+        u8         m_page_size_shift;  // page size in shift (from system)
+        u8         m_flags;            // ownership, in-use and prefault flags
+        u8         m_commit_ahead;     // commit-ahead window (0 = none, otherwise (1 << (n-1)) pages)
+        u8         m_pages;            // page backing (vmem_pages_t) that was obtained
+        spinlock_t m_commit_lock;      // serializes committing of pages (see alloc_concurrent)
+    };
+
+    // A set of arenas, one per NUMA node, the arena of a node is bound to that node
+    struct numa_arenas_t
+    {
+        u32      m_num_nodes;                // number of nodes (and arenas)
+        arena_t* m_arenas[cNUMA_MAX_NODES];  // arena per node
+    };
+
+    // Frozen content of an arena, new arenas can be forked from it (see narena::snapshot)
+    struct arena_snapshot_t
+    {
+        vmem_file_t m_file;             // anonymous file with the content of the arena
+        uint_t      m_pos;              // position of the arena when the snapshot was taken
+        u32         m_reserved_pages;   // reserved number of pages of the arena
+        u32         m_committed_pages;  // committed number of pages of the arena (size of the file)
+        u8          m_page_size_shift;  // page size in shift of the arena
+        u8          m_flags;            // flags of the arena that carry over to a fork
     };
 
     namespace narena
     {
         // usage: arena, owns the virtual that it reserves, and will do an initial commit for 'commit_size'
         arena_t* new_arena(uint_t reserve_size, uint_t commit_size);
+        // usage: same as above, but opt-in to large page backing, the reservation is aligned to the large page size
+        //        and when huge pages are obtained the page size (commit granularity) of the arena is the large page size.
+        //        'numa_node' binds the reserved memory to a NUMA node (best effort, see v_numa_bind).
+        arena_t* new_arena(uint_t reserve_size, uint_t commit_size, vmem_pages_t pages, s32 numa_node = cNUMA_ANY_NODE);
         // usage: create arena with virtual memory already reserved, and NOTHING yet committed, arena will
         //        not be responsible for releasing the reserved virtual memory.
         arena_t* init_arena(void* base, uint_t reserved_size, uint_t commit_size);
+        // usage: chained arena, reserves 'link_reserve_size' and when the arena is full it chains another reservation (link)
+        //        of at least 'link_reserve_size' (larger when an allocation does not fit), so there is no need to reserve
+        //        address space for the worst case. restore_address (restore_point) releases the links that were chained
+        //        after the saved address, reset releases all links except the first.
+        // Note: the base pointer is the base of the current link, so do not take differences between addresses of different links.
+        // Note: the concurrent alloc functions do not chain, they fail when the current link is full.
+        arena_t* new_chained_arena(uint_t link_reserve_size, uint_t commit_size);
+        // usage: same as above, but the links are nodes from a segment allocator, node sizes are a power-of-two
+        //        number of pages and the arena (not nsegment::commit) commits the pages of its nodes.
+        arena_t* new_chained_arena(nsegment::allocator_t* segments, uint_t link_reserve_size, uint_t commit_size);
+        // usage: file backed arena, the file at 'path' is mapped shared and committing pages grows the file, the content of
+        //        the arena is the content of the file. The position is kept in a header at the start of the file when the
+        //        arena is synced or destroyed, and reopening the file continues at that position. The file is mapped at its
+        //        previous address when that range is free, otherwise '*relocation' is the new minus the old base address,
+        //        absolute pointers stored in the arena have to be adjusted by it.
+        // Note: shrink/reset/decommit drop pages from memory but do not truncate the file.
+        // Note: POSIX only, a file that is not empty and is not an arena file is not opened.
+        arena_t* open_file_arena(const char* path, uint_t reserve_size, uint_t commit_size, int_t* relocation = nullptr);
+        bool     sync(arena_t* arena);       // keep the position in the file header and write the changed pages to the file
+        void*    file_root(arena_t* arena);  // address of the first allocation (with an alignment up to 64) of a file or copy-on-write arena
+        // usage: copy-on-write arena, the pages live in an anonymous memory file (memfd) so that a snapshot of the arena
+        //        does not have to copy anything. It has a header like a file backed arena (see file_root).
+        // Note: until it is snapshotted, shrink/reset/recommit also punch the released pages out of the memory file (Linux),
+        //       otherwise the memory file would keep them until the arena is destroyed.
+        arena_t* new_cow_arena(uint_t reserve_size, uint_t commit_size);
+        // usage: snapshot freezes the content of an arena and fork creates a new arena that is a private copy-on-write mapping
+        //        of a snapshot, the arena and every fork mutate their own copy and a page is only copied when it is first
+        //        written. A fork can be destroyed at any time, also after the snapshot is released.
+        // Note: snapshot of a copy-on-write arena that has not been snapshotted (or forked) yet does not copy any pages, after
+        //       that the arena is private and the next snapshot copies the used pages into a new memory file once, so take
+        //       one snapshot and fork it many times.
+        // Note: POSIX only, not for chained, file backed, large page or non-owning arenas, and not while other threads allocate.
+        bool     snapshot(arena_t* arena, arena_snapshot_t& snapshot);
+        arena_t* fork(arena_snapshot_t const& snapshot);
+        void     release(arena_snapshot_t& snapshot);
         // usage: destroy arena, if the arena does not own the virtual memory, then we just nullify the
         //        pointer and return true, otherwise we release the virtual memory.
         bool destroy(arena_t*& arena);
 
+        // usage: an arena per NUMA node ('reserve_size' and 'commit_size' are per node), a thread allocates from the arena
+        //        of the node it is running on. Threads on the same node share an arena, so use the concurrent alloc functions.
+        bool     new_numa_arenas(numa_arenas_t* set, uint_t reserve_size, uint_t commit_size);
+        void     destroy(numa_arenas_t* set);
+        arena_t* local_arena(numa_arenas_t* set);  // arena of the node of the calling thread
+
         inline uint_t reserved_size(arena_t* arena) { return (uint_t)arena->m_reserved_pages << arena->m_page_size_shift; }
         inline uint_t committed_size(arena_t* arena) { return (uint_t)arena->m_committed_pages << arena->m_page_size_shift; }
         inline byte*  base_ptr(arena_t* arena) { return arena->m_base; }
         inline byte*  current_ptr(arena_t* arena) { return arena->m_base + arena->m_pos; }
         inline uint_t current_pos(arena_t* arena) { return (uint_t)arena->m_pos; }
+        inline uint_t page_size(arena_t* arena) { return (uint_t)1 << arena->m_page_size_shift; }
+        inline vmem_pages_t page_backing(arena_t* arena) { return (vmem_pages_t)arena->m_pages; }  // page backing that was actually obtained
+        u32                 num_links(arena_t* arena);                                                // number of reservations (links) of a chained arena, 1 for a normal arena
 
         // clang-format off
         template <typename T> inline T* base_ptr_as(arena_t* arena) { return (T*)arena->m_base; }
@@ -58,6 +131,24 @@ namespace ncore
         void  restore_address(arena_t* arena, void* ptr);                           // restore the arena to the given address
         void  shrink(arena_t* arena);                                               // decommit any 'extra' pages
         void  reset(arena_t* arena);                                                // make all memory available for reuse without releasing it
+        void  shrink(arena_t* arena, vmem_decommit_policy_t* policy);                // give 'extra' pages back according to the decommit policy
+        void  reset(arena_t* arena, vmem_decommit_policy_t* policy);                 // make all memory available for reuse and give pages back according to the decommit policy
+
+        // Page fault avoidance, when committing pages for an allocation the commit-ahead window is committed
+        // as well, and in prefault mode all newly committed pages are prefaulted (populated).
+        // 'warm' commits and prefaults the next 'num_pages' from the current position, it can be driven
+        // from a background thread while the owner thread is allocating (not while it restores/shrinks/resets).
+        void set_commit_ahead(arena_t* arena, uint_t size_in_bytes);  // commit-ahead window (rounded up to a power-of-two number of pages, 0 = off)
+        void set_prefault(arena_t* arena, bool prefault);             // prefault newly committed pages (also prefaults committed pages that are not used yet)
+        u32  warm(arena_t* arena, u32 num_pages);                     // commit and prefault the next 'num_pages', returns the number of pages warmed
+
+        // Concurrent bump allocation, 'm_pos' is advanced atomically and committing pages is serialized so that
+        // multiple threads can allocate from the same arena without any further locking.
+        // Note: do not mix these with the other alloc/restore/shrink/reset functions while other threads are allocating.
+        void* alloc_concurrent(arena_t* arena, uint_t size);                             // allocate 'size' from the reserved region (thread-safe)
+        void* alloc_concurrent(arena_t* arena, uint_t size, u32 alignment);              // allocate 'size' from the reserved region with the given alignment (thread-safe)
+        void* alloc_and_zero_concurrent(arena_t* arena, uint_t size);                    // allocate 'size' from the reserved region and zero it (thread-safe)
+        void* alloc_and_zero_concurrent(arena_t* arena, uint_t size, u32 alignment);     // allocate 'size' from the reserved region with the given alignment and zero it (thread-safe)
     }  // namespace narena
 
     // clang-format off
@@ -193,6 +284,44 @@ namespace ncore
         s.m_arena = nullptr;
     }
 
+    // Per-thread scratch arenas
+    // Every thread has two scratch arenas which are reserved lazily on first use. When a function
+    // produces output into an arena and also needs temporary memory, it passes the output arena as
+    // 'conflict' so that it will receive the other scratch arena, this way the temporary memory of
+    // a callee never aliases the output of its caller.
+    // There is no locking involved, each thread only ever touches its own scratch arenas.
+    namespace nscratch
+    {
+        void     configure(uint_t reserve_size, uint_t commit_size);  // size of scratch arenas created after this call (call before spawning threads)
+        arena_t* get(arena_t* conflict = nullptr);                    // return a scratch arena of the calling thread that is not 'conflict'
+        arena_t* get(arena_t* const* conflicts, u32 count);           // return a scratch arena of the calling thread that is none of 'conflicts'
+        uint_t   high_water();                                        // highest number of bytes ever used by a scratch arena of the calling thread
+        void     reset_high_water();                                  // reset the high-water mark of the calling thread
+        void     release();                                           // release the scratch arenas of the calling thread
+    }  // namespace nscratch
+
+    // RAII scope on a scratch arena, everything allocated from the scope is released when
+    // the scope is destroyed. Scopes can be nested.
+    // usage:
+    //     scratch_t scratch(output_arena);
+    //     u32* temp = g_allocate_array<u32>(scratch.arena(), 1024);
+    class scratch_t
+    {
+    public:
+        scratch_t(arena_t* conflict = nullptr);
+        scratch_t(arena_t* const* conflicts, u32 count);
+        ~scratch_t();
+
+        inline arena_t* arena() const { return m_point.m_arena; }
+        inline operator arena_t*() const { return m_point.m_arena; }
+
+    private:
+        scratch_t(scratch_t const&);
+        scratch_t& operator=(scratch_t const&);
+
+        arena_point_t m_point;
+    };
+
 }  // namespace ncore
 
 #endif  // __CCORE_VMEM_ALLOC_H__
@@ -0,0 +1,98 @@
+#ifndef __CCORE_ATOMIC_H__
+#define __CCORE_ATOMIC_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+namespace ncore
+{
+    // Minimal set of atomic operations on 32-bit and 64-bit words and pointers.
+    // Loads have acquire semantics, stores have release semantics and all read-modify-write
+    // operations are sequentially consistent.
+    namespace natomic
+    {
+        inline u32 load(u32 const volatile* ptr);
+        inline u64 load(u64 const volatile* ptr);
+        inline u32 load_relaxed(u32 const volatile* ptr);
+        inline u64 load_relaxed(u64 const volatile* ptr);
+        inline void store(u32 volatile* ptr, u32 value);
+        inline void store(u64 volatile* ptr, u64 value);
+        inline void store_relaxed(u32 volatile* ptr, u32 value);
+        inline void store_relaxed(u64 volatile* ptr, u64 value);
+
+        inline u32 fetch_add(u32 volatile* ptr, u32 value);  // returns the previous value
+        inline u64 fetch_add(u64 volatile* ptr, u64 value);  // returns the previous value
+        inline u32 fetch_sub(u32 volatile* ptr, u32 value);  // returns the previous value
+        inline u64 fetch_sub(u64 volatile* ptr, u64 value);  // returns the previous value
+        inline u32 fetch_add_relaxed(u32 volatile* ptr, u32 value);  // no ordering, for counters and statistics
+        inline u64 fetch_add_relaxed(u64 volatile* ptr, u64 value);  // no ordering, for counters and statistics
+        inline u32 fetch_sub_relaxed(u32 volatile* ptr, u32 value);  // no ordering, for counters and statistics
+        inline u64 fetch_sub_relaxed(u64 volatile* ptr, u64 value);  // no ordering, for counters and statistics
+        inline u32 fetch_or(u32 volatile* ptr, u32 value);   // returns the previous value
+        inline u64 fetch_or(u64 volatile* ptr, u64 value);   // returns the previous value
+        inline u32 fetch_and(u32 volatile* ptr, u32 value);  // returns the previous value
+        inline u64 fetch_and(u64 volatile* ptr, u64 value);  // returns the previous value
+        inline u32 exchange(u32 volatile* ptr, u32 value);   // returns the previous value
+        inline u64 exchange(u64 volatile* ptr, u64 value);   // returns the previous value
+
+        // when '*ptr == expected' then '*ptr = desired' and return true, otherwise return false
+        inline bool cas(u32 volatile* ptr, u32 expected, u32 desired);
+        inline bool cas(u64 volatile* ptr, u64 expected, u64 desired);
+
+        // clang-format off
+        template <typename T> inline T*   load_ptr(T* const volatile* ptr);
+        template <typename T> inline void store_ptr(T* volatile* ptr, T* value);
+        template <typename T> inline bool cas_ptr(T* volatile* ptr, T* expected, T* desired);
+        // clang-format on
+
+        inline void fence();  // full memory barrier
+        inline void pause();  // cpu hint to use in spin-wait loops
+    }  // namespace natomic
+
+    // A simple test-and-test-and-set spin lock, meant for short critical sections
+    struct spinlock_t
+    {
+        u32 volatile m_lock;
+    };
+
+    namespace nspinlock
+    {
+        inline void init(spinlock_t& s) { natomic::store(&s.m_lock, 0); }
+        inline bool try_lock(spinlock_t& s) { return natomic::load_relaxed(&s.m_lock) == 0 && natomic::exchange(&s.m_lock, 1) == 0; }
+        inline void lock(spinlock_t& s)
+        {
+            while (natomic::exchange(&s.m_lock, 1) != 0)
+            {
+                while (natomic::load_relaxed(&s.m_lock) != 0)
+                    natomic::pause();
+            }
+        }
+        inline void unlock(spinlock_t& s) { natomic::store(&s.m_lock, 0); }
+    }  // namespace nspinlock
+
+    class spinlock_scope_t
+    {
+    public:
+        inline spinlock_scope_t(spinlock_t& s) : m_lock(s) { nspinlock::lock(m_lock); }
+        inline ~spinlock_scope_t() { nspinlock::unlock(m_lock); }
+
+    private:
+        spinlock_scope_t(spinlock_scope_t const&);
+        spinlock_scope_t& operator=(spinlock_scope_t const&);
+
+        spinlock_t& m_lock;
+    };
+
+};  // namespace ncore
+
+//==============================================================================
+// INLINES
+//==============================================================================
+#if defined TARGET_PC && defined CC_COMPILER_MSVC
+#    include "ccore/private/c_atomic_inline_win32.h"
+#else
+#    include "ccore/private/c_atomic_inline_generic.h"
+#endif
+
+#endif  // __CCORE_ATOMIC_H__
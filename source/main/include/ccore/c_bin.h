@@ -11,6 +11,23 @@ namespace ncore
 {
     struct arena_t;
 
+    // Iteration over the used items of a bin in runs of consecutive items, the bitmaps are used to skip over
+    // the free items and the first item of the next run is prefetched while the current run is processed.
+    //     bin_used_iter_t it;
+    //     bin_iter_begin(bin, it);
+    //     while (bin_iter_next(bin, it))
+    //         for (u32 i = 0; i < it.m_count; ++i)
+    //             update(it.m_items + (i * item_size), it.m_index + i);
+    // Note: items of the current run can be freed while iterating, other items can not be allocated or freed.
+    struct bin_used_iter_t
+    {
+        byte* m_items;       // first item of the current run
+        u32   m_index;       // index of the first item of the current run
+        u32   m_count;       // number of items in the current run
+        u32   m_next_index;  // first index of the next run
+        u32   m_next_count;  // number of items in the next run, 0 when there is no next run
+    };
+
     // This is an allocation bin that can allocate small fixed size items, however you can
     // make a bin for any size you want (soft limit to 1 KiB per item).
     // The maximum number of items you can have in a single bin is 16,777,216 (16 Million),
@@ -21,15 +38,55 @@ namespace ncore
         void* m_memory;
     };
 
-    void  bin_setup(bin32_t* bin, u16 item_size, u32 max_items);  // e.g. item_size = 256, max_items = 65535, 16 MiB
-    void  bin_destroy(bin32_t* bin);                              // destroy the bin
-    u32   bin_size(bin32_t const * bin);                          // number of items currently in the bin
-    void* bin_alloc(bin32_t* bin);                                // allocate an item from the bin
-    void  bin_free(bin32_t* bin, void* ptr);                      // free an item back to the bin
-    u32   bin_ptr2idx(bin32_t const * bin, void* ptr);            // convert a pointer to an index within the bin
-    void* bin_idx2ptr(bin32_t* bin, u32 index);                   // convert an index to a pointer within the bin
-    u32   bin_highwater_mark(bin32_t const * bin);                // highest number of items that have been in the bin
-    s32   bin_highest_free(bin32_t const * bin);                  // highest index of free item in the bin
+    void  bin_setup(bin32_t* bin, u16 item_size, u32 max_items);   // e.g. item_size = 256, max_items = 65535, 16 MiB
+    void  bin_destroy(bin32_t* bin);                               // destroy the bin
+    u32   bin_size(bin32_t const * bin);                           // number of items currently in the bin
+    void* bin_alloc(bin32_t* bin);                                 // allocate an item from the bin
+    void  bin_free(bin32_t* bin, void* ptr);                       // free an item back to the bin
+    u32   bin_alloc_n(bin32_t* bin, void** out_ptrs, u32 count);   // allocate up to 'count' items, returns the number of items allocated
+    void  bin_free_n(bin32_t* bin, void* const* ptrs, u32 count);  // free 'count' items back to the bin
+    u32   bin_ptr2idx(bin32_t const * bin, void* ptr);             // convert a pointer to an index within the bin
+    void* bin_idx2ptr(bin32_t* bin, u32 index);                    // convert an index to a pointer within the bin
+    u32   bin_highwater_mark(bin32_t const * bin);                 // highest number of items that have been in the bin
+    s32   bin_highest_free(bin32_t const * bin);                   // highest index of free item in the bin
+
+    // Generational index, an index and the generation of the item, the generation is bumped when the item is freed, which
+    // makes the generational index stale. 32-bit packing is the index (24 bits) and the lower 8 bits of the generation,
+    // 64-bit packing is the index (32 bits) and the generation (16 bits). The last 24-bit index (0xFFFFFF) has no 32-bit
+    // generational index, since it could be equal to c_null_gidx32, use the 64-bit packing for it.
+    const u32 c_null_gidx32 = 0xFFFFFFFF;
+    const u64 c_null_gidx64 = 0xFFFFFFFFFFFFFFFFull;
+
+    u32   bin_ptr2gidx(bin32_t const * bin, void* ptr);                               // 32-bit generational index of an item (c_null_gidx32 if ptr is invalid)
+    u64   bin_ptr2gidx64(bin32_t const * bin, void* ptr);                             // 64-bit generational index of an item (c_null_gidx64 if ptr is invalid)
+    void* bin_gidx2ptr(bin32_t* bin, u32 gidx);                                       // pointer to the item, or nullptr if the generational index is stale
+    void* bin_gidx2ptr(bin32_t* bin, u64 gidx);                                       // pointer to the item, or nullptr if the generational index is stale
+    u32   bin_gidx2ptr_n(bin32_t* bin, u32 const* gidx, void** out_ptrs, u32 count);  // resolve 'count' generational indices (nullptr when stale), returns the number of valid ones
+
+    void bin_iter_begin(bin32_t const * bin, bin_used_iter_t& it);  // start iterating over the used items
+    bool bin_iter_next(bin32_t const * bin, bin_used_iter_t& it);   // move to the next run of used items, returns false when done
+
+    // Thread-safe frontend of a bin32_t, alloc and free go through a magazine (a small stack of free
+    // items) and only when a magazine runs empty or full are items moved, in a batch, between the
+    // magazine and the shared bin while holding the lock of the bin.
+    // A thread is mapped to one of the magazines by its thread slot, every magazine has its own lock
+    // which is uncontended as long as there are no more threads than magazines. A thread that finds
+    // its magazine taken goes directly to the shared bin.
+    // Note: items in the magazines are counted as 'in use' by the shared bin, use bin_flush to
+    //       return them.
+
+    struct mbin32_t
+    {
+        void* m_memory;
+    };
+
+    void  bin_setup(mbin32_t* bin, u16 item_size, u32 max_items, u32 num_magazines = 64);  // num_magazines is rounded up to a power of two
+    void  bin_destroy(mbin32_t* bin);                                                      // destroy the bin, no thread may use the bin anymore
+    void* bin_alloc(mbin32_t* bin);                                                        // allocate an item (thread-safe)
+    void  bin_free(mbin32_t* bin, void* ptr);                                              // free an item (thread-safe)
+    void  bin_flush(mbin32_t* bin);                                                        // return the items of all magazines to the shared bin (thread-safe)
+    u32   bin_size(mbin32_t const * bin);                                                  // number of items in use, excluding the items in the magazines
+    u32   bin_cached(mbin32_t const * bin);                                                // number of free items that are held by the magazines
 
     // This is an allocation bin that can allocate small fixed size items, however you can
     // make a bin for any size you want (soft limit to 1 KiB per item).
@@ -41,17 +98,19 @@ namespace ncore
         void* m_memory;
     };
 
-    void  bin_setup(bin16_t* bin, u16 item_size, u32 max_items);  // e.g. item_size = 256, max_items = 65535, 16 MiB
-    void  bin_destroy(bin16_t* bin);                              // destroy the bin
-    u32   bin_size(bin16_t const * bin);                          // number of items currently in the bin
-    u32   bin_capacity(bin16_t const * bin);                      // maximum number of items the bin can hold
-    void* bin_alloc(bin16_t* bin);                                // allocate an item from the bin
-    void  bin_free(bin16_t* bin, void* ptr);                      // free an item back to the bin
-    u32   bin_item_sizeof(bin16_t const * bin);                   // sizeof(item)
-    i32   bin_ptr2idx(bin16_t const * bin, void* ptr);            // convert a pointer to an index within the bin
-    void* bin_idx2ptr(bin16_t* bin, u16 index);                   // convert an index to a pointer within the bin
-    u32   bin_highwater_mark(bin16_t const * bin);                // highest number of items that have been in the bin
-    s32   bin_highest_free(bin16_t const * bin);                  // highest index of free item in the bin
+    void  bin_setup(bin16_t* bin, u16 item_size, u32 max_items);   // e.g. item_size = 256, max_items = 65535, 16 MiB
+    void  bin_destroy(bin16_t* bin);                               // destroy the bin
+    u32   bin_size(bin16_t const * bin);                           // number of items currently in the bin
+    u32   bin_capacity(bin16_t const * bin);                       // maximum number of items the bin can hold
+    void* bin_alloc(bin16_t* bin);                                 // allocate an item from the bin
+    void  bin_free(bin16_t* bin, void* ptr);                       // free an item back to the bin
+    u32   bin_alloc_n(bin16_t* bin, void** out_ptrs, u32 count);   // allocate up to 'count' items, returns the number of items allocated
+    void  bin_free_n(bin16_t* bin, void* const* ptrs, u32 count);  // free 'count' items back to the bin
+    u32   bin_item_sizeof(bin16_t const * bin);                    // sizeof(item)
+    i32   bin_ptr2idx(bin16_t const * bin, void* ptr);             // convert a pointer to an index within the bin
+    void* bin_idx2ptr(bin16_t* bin, u16 index);                    // convert an index to a pointer within the bin
+    u32   bin_highwater_mark(bin16_t const * bin);                 // highest number of items that have been in the bin
+    s32   bin_highest_free(bin16_t const * bin);                   // highest index of free item in the bin
 
     template <typename T>
     T* g_allocate(bin16_t* bin)
@@ -45,8 +45,30 @@ namespace ncore
         void compute_l4(u32 number_of_bits, layout32_t& l);
         u32  sizeof_data(layout32_t const & l);  // u32[N], where N is computed based on layout
 
+        // Returns the index of the first word in [from, to) that is not equal to 'value', or 'to' when there is none.
+        // Compares 128 or 256 bits at a time when the target has SSE2, AVX2 or NEON, otherwise one word at a time.
+        u32 scan_equal(u32 const* words, u32 from, u32 to, u32 value);
+        u32 scan_equal(u64 const* words, u32 from, u32 to, u64 value);
+
+        // Whole-set operations on bit-vectors that share the same layout, 'data' is u64[sizeof_data(l)] holding bin0, bin1,
+        // bin2 and bin3 one after the other (only the bins up to l.m_levels are used). The leaf words are combined a vector
+        // at a time, words that the summary levels show as all zero are skipped and only the summary bits of the leaf words
+        // that became (non-)zero are updated. The summary levels of both bit-vectors have to be up to date.
+        void bulk_and(u64* dst, u64 const* src, layout64_t const& l);     // dst = dst & src
+        void bulk_or(u64* dst, u64 const* src, layout64_t const& l);      // dst = dst | src
+        void bulk_andnot(u64* dst, u64 const* src, layout64_t const& l);  // dst = dst & ~src
+        void bulk_xor(u64* dst, u64 const* src, layout64_t const& l);     // dst = dst ^ src
+        u32  popcount(u64 const* data, layout64_t const& l);              // number of '1' bits
+        bool any(u64 const* data, layout64_t const& l);                   // true when at least one bit is '1'
+
     }  // namespace nbitvec
 
+    // --------------------------------------------------------------------------------------------
+    // The 2, 3 and 4 level bit-vectors have thread-safe (lock-free) variants of find_free_and_remove,
+    // set_free and set_used with a '_concurrent' suffix. Multiple threads can claim and release bits
+    // of the same bit-vector, the other functions should not be used while this is going on.
+    // --------------------------------------------------------------------------------------------
+
     // --------------------------------------------------------------------------------------------
     // 1 level binmaps
     // --------------------------------------------------------------------------------------------
@@ -120,6 +142,17 @@ namespace ncore
         s32 find_free_last_and_remove(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits);                  // Finds the last free bit and sets it to used and returns the bit index
         s32 find_free_after(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, u32 maxbits, u32 pivot);   // Finds the first free bit after the pivot
         s32 find_free_before(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, u32 maxbits, u32 pivot);  // Finds the first free bit before the pivot (high to low)
+
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32* out_bits, u32 count);  // Finds up to 'count' free bits (a word at a time), sets them to used and returns the number of bits found
+        void set_free_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 const* bits, u32 count);  // Sets the bits to free, consecutive bits that share a word are set at once
+
+        s32  find_free_range(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, u32 maxbits, u32 n);  // Finds the first run of 'n' free bits and returns the index of its first bit
+        s32  alloc_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 n);                    // Finds the first run of 'n' free bits, sets them to used and returns the index of its first bit
+        void free_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 start, u32 n);          // Sets the bits [start, start + n) to free
+
+        s32  find_free_and_remove_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits);  // thread-safe find_free_and_remove
+        void set_free_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 bit);     // thread-safe set_free
+        void set_used_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 bit);     // thread-safe set_used
     }  // namespace nbitvec10
 
     // 2^12 bit-vector, can handle a maximum of 4096 bits.
@@ -145,6 +178,17 @@ namespace ncore
         s32 find_free_last_and_remove(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits);                  // Finds the last free bit and sets it to used and returns the bit index
         s32 find_free_after(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, u32 maxbits, u32 pivot);   // Finds the first free bit after the pivot
         s32 find_free_before(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, u32 maxbits, u32 pivot);  // Finds the first free bit before the pivot (high to low)
+
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32* out_bits, u32 count);  // Finds up to 'count' free bits (a word at a time), sets them to used and returns the number of bits found
+        void set_free_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 const* bits, u32 count);  // Sets the bits to free, consecutive bits that share a word are set at once
+
+        s32  find_free_range(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, u32 maxbits, u32 n);  // Finds the first run of 'n' free bits and returns the index of its first bit
+        s32  alloc_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 n);                    // Finds the first run of 'n' free bits, sets them to used and returns the index of its first bit
+        void free_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 start, u32 n);          // Sets the bits [start, start + n) to free
+
+        s32  find_free_and_remove_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits);  // thread-safe find_free_and_remove
+        void set_free_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 bit);     // thread-safe set_free
+        void set_used_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, u32 maxbits, u32 bit);     // thread-safe set_used
     }  // namespace nbitvec12
 
     // --------------------------------------------------------------------------------------------
@@ -175,6 +219,17 @@ namespace ncore
         s32 find_free_last_and_remove(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits);                         // Finds the last free bit and sets it to used and returns the bit index
         s32 find_free_after(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, u32 maxbits, u32 pivot);   // Finds the first free bit after the pivot
         s32 find_free_before(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, u32 maxbits, u32 pivot);  // Finds the first free bit before the pivot (high to low)
+
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32* out_bits, u32 count);  // Finds up to 'count' free bits (a word at a time), sets them to used and returns the number of bits found
+        void set_free_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 const* bits, u32 count);  // Sets the bits to free, consecutive bits that share a word are set at once
+
+        s32  find_free_range(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, u32 maxbits, u32 n);  // Finds the first run of 'n' free bits and returns the index of its first bit
+        s32  alloc_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 n);                           // Finds the first run of 'n' free bits, sets them to used and returns the index of its first bit
+        void free_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 start, u32 n);                 // Sets the bits [start, start + n) to free
+
+        s32  find_free_and_remove_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits);  // thread-safe find_free_and_remove
+        void set_free_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 bit);     // thread-safe set_free
+        void set_used_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 bit);     // thread-safe set_used
     }  // namespace nbitvec15
 
     namespace nbitvec18
@@ -200,6 +255,17 @@ namespace ncore
         s32 find_free_last_and_remove(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits);                         // Finds the last free bit and sets it to used and returns the bit index
         s32 find_free_after(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, u32 maxbits, u32 pivot);   // Finds the first free bit after the pivot
         s32 find_free_before(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, u32 maxbits, u32 pivot);  // Finds the first free bit before the pivot (high to low)
+
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32* out_bits, u32 count);  // Finds up to 'count' free bits (a word at a time), sets them to used and returns the number of bits found
+        void set_free_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 const* bits, u32 count);  // Sets the bits to free, consecutive bits that share a word are set at once
+
+        s32  find_free_range(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, u32 maxbits, u32 n);  // Finds the first run of 'n' free bits and returns the index of its first bit
+        s32  alloc_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 n);                           // Finds the first run of 'n' free bits, sets them to used and returns the index of its first bit
+        void free_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 start, u32 n);                 // Sets the bits [start, start + n) to free
+
+        s32  find_free_and_remove_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits);  // thread-safe find_free_and_remove
+        void set_free_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 bit);     // thread-safe set_free
+        void set_used_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, u32 maxbits, u32 bit);     // thread-safe set_used
     }  // namespace nbitvec18
 
     // --------------------------------------------------------------------------------------------
@@ -233,6 +299,17 @@ namespace ncore
         s32 find_free_after(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, bintype_t const * CC_RESTRICT bin3, u32 maxbits, u32 pivot);  // Finds the first free bit after the pivot
         s32 find_free_before(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, bintype_t const * CC_RESTRICT bin3, u32 maxbits,
                              u32 pivot);  // Finds the first free bit before the pivot (high to low)
+
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32* out_bits, u32 count);  // Finds up to 'count' free bits (a word at a time), sets them to used and returns the number of bits found
+        void set_free_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 const* bits, u32 count);  // Sets the bits to free, consecutive bits that share a word are set at once
+
+        s32  find_free_range(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, bintype_t const * CC_RESTRICT bin3, u32 maxbits, u32 n);  // Finds the first run of 'n' free bits and returns the index of its first bit
+        s32  alloc_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 n);                                  // Finds the first run of 'n' free bits, sets them to used and returns the index of its first bit
+        void free_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 start, u32 n);                        // Sets the bits [start, start + n) to free
+
+        s32  find_free_and_remove_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits);  // thread-safe find_free_and_remove
+        void set_free_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 bit);     // thread-safe set_free
+        void set_used_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 bit);     // thread-safe set_used
     }  // namespace nbitvec20
 
     namespace nbitvec24
@@ -262,8 +339,67 @@ namespace ncore
         s32 find_free_after(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, bintype_t const * CC_RESTRICT bin3, u32 maxbits, u32 pivot);  // Finds the first free bit after the pivot
         s32 find_free_before(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, bintype_t const * CC_RESTRICT bin3, u32 maxbits,
                              u32 pivot);  // Finds the first free bit before the pivot (high to low)
+
+        u32  find_free_and_remove_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32* out_bits, u32 count);  // Finds up to 'count' free bits (a word at a time), sets them to used and returns the number of bits found
+        void set_free_n(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 const* bits, u32 count);  // Sets the bits to free, consecutive bits that share a word are set at once
+
+        s32  find_free_range(bintype_t const * CC_RESTRICT bin0, bintype_t const * CC_RESTRICT bin1, bintype_t const * CC_RESTRICT bin2, bintype_t const * CC_RESTRICT bin3, u32 maxbits, u32 n);  // Finds the first run of 'n' free bits and returns the index of its first bit
+        s32  alloc_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 n);                                  // Finds the first run of 'n' free bits, sets them to used and returns the index of its first bit
+        void free_range(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 start, u32 n);                        // Sets the bits [start, start + n) to free
+
+        s32  find_free_and_remove_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits);  // thread-safe find_free_and_remove
+        void set_free_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 bit);     // thread-safe set_free
+        void set_used_concurrent(bintype_t* CC_RESTRICT bin0, bintype_t* CC_RESTRICT bin1, bintype_t* CC_RESTRICT bin2, bintype_t* CC_RESTRICT bin3, u32 maxbits, u32 bit);     // thread-safe set_used
     }  // namespace nbitvec24
 
+    // --------------------------------------------------------------------------------------------
+    // Runtime sized bit-vector, the number of levels follows from nbitvec::compute for the capacity
+    // (with a minimum of 2 levels) and the functions dispatch to the 2, 3 or 4 level implementation.
+    // The levels are one block of memory, every level starts on a cache line and the level that holds
+    // the bits is last. The block is reserved for the capacity and only what the current number of bits
+    // needs is committed, so growing commits more of the last level and nothing has to be moved.
+    // --------------------------------------------------------------------------------------------
+    struct arena_t;
+
+    struct bitvec_t
+    {
+        arena_t* m_arena;     // reserves the block for the capacity
+        u64*     m_bins[4];   // bin0 (a single u64) .. the level that holds the bits, nullptr for unused levels
+        u32      m_maxbits;   // current number of bits
+        u32      m_capacity;  // maximum number of bits
+        u8       m_levels;    // index of the level that holds the bits (1, 2 or 3), as layout64_t::m_levels
+    };
+
+    namespace nbitvec
+    {
+        bool setup(bitvec_t* bv, u32 maxbits, u32 capacity);   // all bits are used ('0'), maxbits <= capacity <= 16M
+        void destroy(bitvec_t* bv);                            // releases the memory of the levels
+        bool grow(bitvec_t* bv, u32 maxbits);                  // grows in place up to the capacity, the new bits are used ('0')
+
+        void set_all_free(bitvec_t* bv);
+        void set_all_used(bitvec_t* bv);
+        void set_free(bitvec_t* bv, u32 bit);
+        void set_used(bitvec_t* bv, u32 bit);
+        bool get(bitvec_t const* bv, u32 bit);
+        s32  find_free(bitvec_t const* bv);
+        s32  find_free_and_remove(bitvec_t* bv);
+        s32  find_free_last(bitvec_t const* bv);               // Finds the last free bit and returns the bit index
+        s32  find_free_after(bitvec_t const* bv, u32 pivot);   // Finds the first free bit after the pivot
+        s32  find_free_before(bitvec_t const* bv, u32 pivot);  // Finds the first free bit before the pivot (high to low)
+
+        s32  find_free_range(bitvec_t const* bv, u32 n);       // Finds the first run of 'n' free bits and returns the index of its first bit
+        s32  alloc_range(bitvec_t* bv, u32 n);                 // Finds the first run of 'n' free bits, sets them to used and returns the index of its first bit
+        void free_range(bitvec_t* bv, u32 start, u32 n);       // Sets the bits [start, start + n) to free
+
+        // whole-set operations, both bit-vectors have the same number of bits and levels
+        void bulk_and(bitvec_t* dst, bitvec_t const* src);     // dst = dst & src
+        void bulk_or(bitvec_t* dst, bitvec_t const* src);      // dst = dst | src
+        void bulk_andnot(bitvec_t* dst, bitvec_t const* src);  // dst = dst & ~src
+        void bulk_xor(bitvec_t* dst, bitvec_t const* src);     // dst = dst ^ src
+        u32  popcount(bitvec_t const* bv);                     // number of '1' bits
+        bool any(bitvec_t const* bv);                          // true when at least one bit is '1'
+    }  // namespace nbitvec
+
 }  // namespace ncore
 
 #endif  // __CCORE_BITVEC_V2_H__
@@ -15,6 +15,7 @@ namespace ncore
     // Note: Reserved size must be a multiple of block size
     // Note: Bin metadata is supplied and owned by the caller
     struct bbin_t;
+    struct vmem_decommit_policy_t;
 
     u32     bin_calculate_size(uint_t reserved_size, u32 block_size);                                         // number of pages needed for the bin and block metadata
     bbin_t* bin_setup(void* bin_address, u32 bin_size_in_pages, void* base_address, uint_t reserved_size, u32 block_size);  // 16 KiB <= block size <= 512 MiB
@@ -22,6 +23,11 @@ namespace ncore
     u32     bin_size(bbin_t const* bin);                                                                      // number of items currently allocated in the bin
     void*   bin_alloc(bbin_t* bin, u32 size);                                                                 // allocate an item
     void    bin_free(bbin_t* bin, void* item);                                                                // free an item back to the bin
+    u32     bin_alloc_n(bbin_t* bin, u32 size, void** out_ptrs, u32 count);                                   // allocate up to 'count' items, returns the number of items allocated
+    void    bin_free_n(bbin_t* bin, void* const* ptrs, u32 count);                                            // free 'count' items back to the bin
+
+    // How the pages of freed blocks are given back (see c_memory.h), default (nullptr) is eager decommit
+    void bin_set_decommit_policy(bbin_t* bin, vmem_decommit_policy_t* policy);
 
 }  // namespace ncore
 
@@ -5,6 +5,8 @@
 #    pragma once
 #endif
 
+#include "ccore/c_bin.h"
+
 namespace ncore
 {
     // A cbin manages a virtual address range that is divided into fixed-size chunks.
@@ -19,13 +21,24 @@ namespace ncore
 
     // Note: Bin metadata is supplied and owned by the caller
     struct cbin_t;
+    struct vmem_decommit_policy_t;
 
     u32     bin_calculate_size(uint_t base_size, u16 item_sizeof);  // number of pages needed for the bin and chunk metadata
     cbin_t* bin_setup(void* bin_address, u32 bin_size_in_pages, void* base_address, uint_t base_size, u16 item_sizeof);
-    void    bin_destroy(cbin_t* bin);           // destroy the bin
-    u32     bin_size(cbin_t const * bin);       // number of items currently allocated in the bin
-    void*   bin_alloc(cbin_t* bin);             // allocate an item from the bin
-    void    bin_free(cbin_t* bin, void* item);  // free an item back to the bin
+    void    bin_destroy(cbin_t* bin);                               // destroy the bin
+    u32     bin_size(cbin_t const * bin);                           // number of items currently allocated in the bin
+    void*   bin_alloc(cbin_t* bin);                                 // allocate an item from the bin
+    void    bin_free(cbin_t* bin, void* item);                      // free an item back to the bin
+    u32     bin_alloc_n(cbin_t* bin, void** out_ptrs, u32 count);   // allocate up to 'count' items, returns the number of items allocated
+    void    bin_free_n(cbin_t* bin, void* const* ptrs, u32 count);  // free 'count' items back to the bin
+
+    // iterate over the used items in runs of consecutive items (see bin_used_iter_t), empty chunks are skipped and
+    // runs do not cross chunks, the index of an item is 'chunk index * items per chunk + item index in the chunk'
+    void bin_iter_begin(cbin_t const * bin, bin_used_iter_t& it);  // start iterating over the used items
+    bool bin_iter_next(cbin_t const * bin, bin_used_iter_t& it);   // move to the next run of used items, returns false when done
+
+    // How the pages of chunks that become empty are given back (see c_memory.h), default (nullptr) is eager decommit
+    void bin_set_decommit_policy(cbin_t* bin, vmem_decommit_policy_t* policy);
 
 }  // namespace ncore
 
@@ -0,0 +1,61 @@
+#ifndef __CCORE_HEAP_H__
+#define __CCORE_HEAP_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_allocator.h"
+
+namespace ncore
+{
+    // General purpose heap that routes arbitrary sizes to size-class segregated bins.
+    //
+    // Size classes (jemalloc-like), 8, 16, 32, 48 .. 128 and then 4 classes per doubling:
+    //   - small,  8 B .. 1 KiB    : bin32_t per class
+    //   - medium, 1 KiB .. 32 KiB : cbin_t (chunk bin) per class
+    //   - block,  32 KiB .. 1 MiB : bbin_t per power-of-two block size, only the used pages are committed
+    //   - large,  > 1 MiB         : nsegment node, only the used pages are committed
+    // Every thread has a small cache per small/medium class, a thread refills/flushes its cache in batches
+    // while holding the lock of that class. When a thread that flushes finds the class lock taken it pushes
+    // the items on the lock-free remote-free list of the class, which is drained by the next lock holder.
+    //
+    // Note: alignment up to the system page size is supported
+    // Note: the thread cache of a thread is flushed when the thread exits, destroy a heap only after the
+    //       threads that used it have exited or have called flush_thread_cache.
+    struct heap_t;
+
+    namespace nheap
+    {
+        heap_t* create(u64 large_address_space = 64 * cGB);  // address space for allocations larger than 1 MiB (power of two)
+        void    destroy(heap_t*& heap);
+
+        void* alloc(heap_t* heap, uint_t size, u32 alignment = 16);  // size 0 returns a unique pointer
+        void  free(heap_t* heap, void* ptr);
+        void  flush_thread_cache(heap_t* heap);  // return the items in the cache of the calling thread to the bins
+
+        u32 size_class(uint_t size);  // size class of 'size', returns num_size_classes() for large sizes
+        u32 class_size(u32 size_class);
+        u32 num_size_classes();
+    }  // namespace nheap
+
+    // clang-format off
+    class heap_alloc_t : public alloc_t
+    {
+    public:
+        inline heap_alloc_t() : m_heap(nullptr) {}
+        inline heap_alloc_t(heap_t* heap) : m_heap(heap) {}
+        virtual ~heap_alloc_t() {}
+
+        heap_t* m_heap;
+
+        virtual void* v_allocate(u32 size, u32 alignment) { return nheap::alloc(m_heap, size, alignment); }
+        virtual void  v_deallocate(void* ptr) { nheap::free(m_heap, ptr); }
+
+        DCORE_CLASS_PLACEMENT_NEW_DELETE
+    };
+    // clang-format on
+
+}  // namespace ncore
+
+#endif  // __CCORE_HEAP_H__
@@ -5,9 +5,12 @@
 #    pragma once
 #endif
 
+#include "ccore/c_bin.h"
+
 namespace ncore
 {
     struct arena_t;
+    struct tag_index_t;
 
     // An indexed allocation bin that can allocate small fixed size items that are tracked by index.
     // This bin can maintain an array of items that can be compacted when calling  compact, so that
@@ -20,58 +23,124 @@ namespace ncore
 
     struct ibin16_t
     {
-        arena_t* m_tags;         // tags array (u16[])
-        arena_t* m_items;        // items array (item[])
-        u32      m_items_count;  // number of items currently in use
-        u32      m_item_sizeof;  // sizeof(item)
-        arena_t* m_binmap;       // duomap
+        arena_t*     m_tags;         // tags array ({u16 tag, u16 generation}[])
+        arena_t*     m_items;        // items array (item[])
+        u32          m_items_count;  // number of items currently in use
+        u32          m_item_sizeof;  // sizeof(item)
+        arena_t*     m_binmap;       // duomap
+        tag_index_t* m_tag_index;    // secondary index on the tags (nullptr unless bin_tag_index_setup was called)
     };
 
-    void  bin_setup(ibin16_t* bin, u16 element_size);           // create an indexed bin that can hold max elements of size element_size
-    void  bin_commit(ibin16_t* bin, u32 num_elements);          // prepare the bin (commit pages) to allocate without page commits
-    void  bin_destroy(ibin16_t* bin);                           // destroy the index bin
-    i32   bin_alloc(ibin16_t* bin, u16 tag);                    // allocate an item from the bin, and associate it with the given tag (returns index of allocated item, or -1 if full)
-    i32   bin_get_tag(ibin16_t const * bin, u32 item_index);    // get the tag associated with an item index, or -1 if index is out of range
-    void  bin_set_tag(ibin16_t* bin, u32 item_index, u16 tag);  // set the tag associated with an item index
-    void  bin_free(ibin16_t* bin, u32 item_index);              // free the index (no compaction, just mark as free)
-    void* bin_idx2ptr(ibin16_t const * bin, u32 index);         // convert an index to a pointer to the element
-    i32   bin_ptr2idx(ibin16_t const * bin, void const * ptr);  // convert a pointer to an index (returns -1 if pointer is out of range)
-    u32   bin_size(ibin16_t const * bin);                       // current number of items in the bin
+    void  bin_setup(ibin16_t* bin, u16 element_size);                        // create an indexed bin that can hold max elements of size element_size
+    void  bin_commit(ibin16_t* bin, u32 num_elements);                       // prepare the bin (commit pages) to allocate without page commits
+    void  bin_destroy(ibin16_t* bin);                                        // destroy the index bin
+    i32   bin_alloc(ibin16_t* bin, u16 tag);                                 // allocate an item from the bin, and associate it with the given tag (returns index of allocated item, or -1 if full)
+    i32   bin_get_tag(ibin16_t const * bin, u32 item_index);                 // get the tag associated with an item index, or -1 if index is out of range
+    void  bin_set_tag(ibin16_t* bin, u32 item_index, u16 tag);               // set the tag associated with an item index
+    void  bin_free(ibin16_t* bin, u32 item_index);                           // free the index (no compaction, just mark as free)
+    u32   bin_alloc_n(ibin16_t* bin, u16 tag, u32* out_indices, u32 count);  // allocate up to 'count' items with the same tag, returns the number of items allocated
+    void  bin_free_n(ibin16_t* bin, u32 const* indices, u32 count);          // free 'count' indices (no compaction)
+    void* bin_idx2ptr(ibin16_t const * bin, u32 index);                      // convert an index to a pointer to the element
+    i32   bin_ptr2idx(ibin16_t const * bin, void const * ptr);               // convert a pointer to an index (returns -1 if pointer is out of range)
+    u32   bin_size(ibin16_t const * bin);                                    // current number of items in the bin
 
     // executes one compaction step, which moves the last used item to the first free slot
     // @out_item_index: if compaction was performed, this will be set to the new index of the item that was moved to fill the hole
     // returns the index of the item that was moved, or -1 if no compaction was performed
     i32 bin_compact(ibin16_t* bin, u32& out_item_index);
 
-    // TODO: add helper functions to iterate over all items in the bin, and get their tags and indices
+    // Generational index, the index (16 bits) and the generation (16 bits) of an item, the generation is bumped
+    // when the item is freed or moved by compaction, which makes the generational index stale.
+    u32 bin_idx2gidx(ibin16_t const * bin, u32 index);                                       // generational index of an item (c_null_gidx32 if index is out of range)
+    i32 bin_gidx2idx(ibin16_t const * bin, u32 gidx);                                        // index of the item, or -1 if the generational index is stale
+    u32 bin_gidx2idx_n(ibin16_t const * bin, u32 const* gidx, i32* out_indices, u32 count);  // resolve 'count' generational indices (-1 when stale), returns the number of valid ones
+
+    // iterate over the used items in runs of consecutive items (see bin_used_iter_t), empty regions are skipped using
+    // the summary levels of the binmap
+    void bin_iter_begin(ibin16_t const * bin, bin_used_iter_t& it);  // start iterating over the used items
+    bool bin_iter_next(ibin16_t const * bin, bin_used_iter_t& it);   // move to the next run of used items, returns false when done
+
+    // Tag index, an optional secondary index on the tags that is kept up to date by alloc, free, set_tag and compaction.
+    // A domain of up to c_ibin_tag_bitsets tags (tag < num_tags) has a bitset per tag, the items of a tag are enumerated
+    // in index order. A larger domain uses a hash table of tag to a list of items, enumerated in no particular order.
+    // Counting is O(1) and enumerating is O(matches), the current item may be freed while enumerating.
+    const u32 c_ibin_tag_bitsets = 64;
+
+    void bin_tag_index_setup(ibin16_t* bin, u32 num_tags);             // create the tag index, the items already in the bin are indexed
+    u32  bin_tag_count(ibin16_t const * bin, u16 tag);                 // number of items with the tag
+    i32  bin_tag_first(ibin16_t const * bin, u16 tag);                 // first item with the tag, or -1 if there is none
+    i32  bin_tag_next(ibin16_t const * bin, u16 tag, u32 item_index);  // next item with the tag after 'item_index', or -1 when done
 
     struct ibin32_t
     {
-        arena_t* m_tags;         // tags array (u32[])
-        arena_t* m_items;        // items array (item[])
-        u32      m_items_count;  // number of items currently in use
-        u16      m_item_sizeof;  // sizeof(item)
-        arena_t* m_binmap;       // duomap level 0, 1 and 2(f)
-        arena_t* m_binmap2u;     // duomap level 2(u)
-        arena_t* m_binmap3;      // duomap level 3
+        arena_t*     m_tags;          // tags array ({u32 tag, u32 generation}[])
+        arena_t*     m_items;         // items array (item[])
+        u32          m_items_count;   // number of items currently in use
+        u16          m_item_sizeof;   // sizeof(item)
+        arena_t*     m_binmap;        // duomap level 0, 1 and 2(f)
+        arena_t*     m_binmap2u;      // duomap level 2(u)
+        arena_t*     m_binmap3;       // duomap level 3
+        arena_t*     m_handles;       // handle table (u32[]), generation and item index per handle (nullptr until the first handle)
+        arena_t*     m_owners;        // handle of each item (u32[])
+        u32          m_handles_free;  // head of the list of free handles
+        tag_index_t* m_tag_index;     // secondary index on the tags (nullptr unless bin_tag_index_setup was called)
     };
 
-    void  bin_setup(ibin32_t* bin, u16 element_size);           // create an indexed bin that can hold max elements of size element_size
-    void  bin_commit(ibin32_t* bin, u32 num_elements);          // prepare the bin (commit pages) to allocate without page commits
-    void  bin_destroy(ibin32_t* bin);                           // destroy the index bin
-    i32   bin_alloc(ibin32_t* bin, u32 tag);                    // allocate an item from the bin, and associate it with the given tag (returns index of allocated item, or -1 if full)
-    i32   bin_get_tag(ibin32_t const * bin, u32 item_index);    // get the tag associated with an item index, or -1 if index is out of range
-    void  bin_set_tag(ibin32_t* bin, u32 item_index, u32 tag);  // set the tag associated with an item index
-    void  bin_free(ibin32_t* bin, u32 item_index);              // free the index (no compaction, just mark as free)
-    void* bin_idx2ptr(ibin32_t const * bin, u32 index);         // convert an index to a pointer to the element
-    i32   bin_ptr2idx(ibin32_t const * bin, void const * ptr);  // convert a pointer to an index (returns -1 if pointer is out of range)
-    u32   bin_size(ibin32_t const * bin);                       // current number of items in the bin
+    void  bin_setup(ibin32_t* bin, u16 element_size);                        // create an indexed bin that can hold max elements of size element_size
+    void  bin_commit(ibin32_t* bin, u32 num_elements);                       // prepare the bin (commit pages) to allocate without page commits
+    void  bin_destroy(ibin32_t* bin);                                        // destroy the index bin
+    i32   bin_alloc(ibin32_t* bin, u32 tag);                                 // allocate an item from the bin, and associate it with the given tag (returns index of allocated item, or -1 if full)
+    i32   bin_get_tag(ibin32_t const * bin, u32 item_index);                 // get the tag associated with an item index, or -1 if index is out of range
+    void  bin_set_tag(ibin32_t* bin, u32 item_index, u32 tag);               // set the tag associated with an item index
+    void  bin_free(ibin32_t* bin, u32 item_index);                           // free the index (no compaction, just mark as free)
+    u32   bin_alloc_n(ibin32_t* bin, u32 tag, u32* out_indices, u32 count);  // allocate up to 'count' items with the same tag, returns the number of items allocated
+    void  bin_free_n(ibin32_t* bin, u32 const* indices, u32 count);          // free 'count' indices (no compaction)
+    void* bin_idx2ptr(ibin32_t const * bin, u32 index);                      // convert an index to a pointer to the element
+    i32   bin_ptr2idx(ibin32_t const * bin, void const * ptr);               // convert a pointer to an index (returns -1 if pointer is out of range)
+    u32   bin_size(ibin32_t const * bin);                                    // current number of items in the bin
 
     // executes one compaction step, which moves the last used item to the first free slot
     // @out_item_index: if compaction was performed, this will be set to the new index of the item that was moved to fill the hole
     // returns the index of the item that was moved, or -1 if no compaction was performed
     i32 bin_compact(ibin32_t* bin, u32& out_item_index);
 
+    // Generational index, 32-bit packing is the index (24 bits) and the lower 8 bits of the generation, 64-bit packing is
+    // the index (32 bits) and the generation (32 bits). The generation is bumped when the item is freed or moved by
+    // compaction or defrag, which makes the generational index stale. The last index (0xFFFFFF) has no 32-bit generational
+    // index, since it could be equal to c_null_gidx32, use the 64-bit packing for it.
+    u32 bin_idx2gidx(ibin32_t const * bin, u32 index);                                       // 32-bit generational index of an item (c_null_gidx32 if index is out of range)
+    u64 bin_idx2gidx64(ibin32_t const * bin, u32 index);                                     // 64-bit generational index of an item (c_null_gidx64 if index is out of range)
+    i32 bin_gidx2idx(ibin32_t const * bin, u32 gidx);                                        // index of the item, or -1 if the generational index is stale
+    i32 bin_gidx2idx(ibin32_t const * bin, u64 gidx);                                        // index of the item, or -1 if the generational index is stale
+    u32 bin_gidx2idx_n(ibin32_t const * bin, u32 const* gidx, i32* out_indices, u32 count);  // resolve 'count' generational indices (-1 when stale), returns the number of valid ones
+    u32 bin_gidx2idx_n(ibin32_t const * bin, u64 const* gidx, i32* out_indices, u32 count);  // resolve 'count' generational indices (-1 when stale), returns the number of valid ones
+
+    // iterate over the used items in runs of consecutive items (see bin_used_iter_t), empty regions of 64x64 items are
+    // skipped using the summary levels of the binmap
+    void bin_iter_begin(ibin32_t const * bin, bin_used_iter_t& it);  // start iterating over the used items
+    bool bin_iter_next(ibin32_t const * bin, bin_used_iter_t& it);   // move to the next run of used items, returns false when done
+
+    // Tag index, see the ibin16 version, a bitset of a tag commits its pages with the items that have the tag
+    void bin_tag_index_setup(ibin32_t* bin, u32 num_tags);             // create the tag index, the items already in the bin are indexed
+    u32  bin_tag_count(ibin32_t const * bin, u32 tag);                 // number of items with the tag
+    i32  bin_tag_first(ibin32_t const * bin, u32 tag);                 // first item with the tag, or -1 if there is none
+    i32  bin_tag_next(ibin32_t const * bin, u32 tag, u32 item_index);  // next item with the tag after 'item_index', or -1 when done
+
+    // Relocation, an item allocated with a handle can be moved by compaction, the handle keeps referring to it.
+    // A handle is a generation (8 bits) and a slot (24 bits), freeing the item makes the handle stale.
+    const u32 c_ibin32_null_handle = 0xFFFFFFFF;
+
+    u32   bin_alloc_handle(ibin32_t* bin, u32 tag);          // allocate an item and a handle to it (returns c_ibin32_null_handle if full)
+    void  bin_free_handle(ibin32_t* bin, u32 handle);        // free the item of the handle, the handle becomes stale
+    i32   bin_handle2idx(ibin32_t const * bin, u32 handle);  // current index of the item of the handle, or -1 if the handle is stale
+    void* bin_handle2ptr(ibin32_t const * bin, u32 handle);  // current pointer to the item of the handle, or nullptr if the handle is stale
+
+    // incremental compaction, moves up to 'max_moves' of the highest used items into the lowest free slots, then lowers the
+    // highwater mark to the last used item and decommits the pages (also the ones from bin_commit) above it.
+    // pointers and indices of moved items are invalid afterwards, items allocated with a handle can be found again through it.
+    // returns the number of items that were moved
+    u32 bin_defrag(ibin32_t* bin, u32 max_moves);
+
 }  // namespace ncore
 
 #endif  // __CCORE_INDEX_BIN_H__
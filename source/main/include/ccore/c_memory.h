@@ -70,6 +70,98 @@ namespace ncore
     bool  v_alloc_commit(void* addr, uint_t size);
     bool  v_alloc_decommit(void* addr, uint_t extra_size);
     bool  v_alloc_release(void* addr, uint_t size);
+
+    // Large (huge) page backing of reserved virtual memory
+    enum vmem_pages_t
+    {
+        VMEM_PAGES_DEFAULT          = 0,  // system page size
+        VMEM_PAGES_TRANSPARENT_HUGE = 1,  // transparent huge pages (Linux, madvise(MADV_HUGEPAGE))
+        VMEM_PAGES_HUGE             = 2,  // explicit huge pages (Linux, MAP_HUGETLB), falls back to transparent huge pages
+    };
+
+    // Size (and alignment) of a large page, 2 MiB on the supported platforms
+    u32 v_alloc_get_large_page_size();
+    // Reserve 'size' bytes (must be a multiple of the large page size) aligned to the large page size.
+    // 'pages' is the requested backing and on return holds the backing that was actually obtained, when
+    // this is anything other than VMEM_PAGES_DEFAULT then commit/decommit should use the large page size.
+    void* v_alloc_reserve(uint_t size, vmem_pages_t& pages);
+
+    // Tell the OS that the pages in the range are no longer needed but keep them committed, the OS may reclaim
+    // them lazily (MADV_FREE / MEM_RESET), until then reusing them does not fault. The content is undefined
+    // after this call (it can be the old content or zero).
+    bool v_alloc_lazy_free(void* addr, uint_t size);
+
+    // Prefault committed pages so that the first touch does not fault in a latency critical path, this does not change
+    // the content of the pages and is safe to call while other threads are using the same pages.
+    bool v_alloc_prefault(void* addr, uint_t size);
+
+    // Reserve 'size' bytes at 'address' when that range is available, otherwise anywhere (like v_alloc_reserve)
+    void* v_alloc_reserve_at(void* address, uint_t size);
+
+    // Memory mapped files, a range of a file is mapped shared into a reserved range, the pages are backed by the file
+    // and changes are written to the file by the OS (or by v_file_sync).
+    // Note: POSIX only (mmap MAP_SHARED), on other platforms opening a file fails.
+    typedef s64       vmem_file_t;  // file descriptor
+    const vmem_file_t cINVALID_VMEM_FILE = -1;
+
+    vmem_file_t v_file_open(const char* path);                                              // open or create a file for reading and writing
+    vmem_file_t v_file_open_anonymous();                                                    // memory backed file without a name (memfd), gone when closed and unmapped
+    void        v_file_close(vmem_file_t file);
+    u64         v_file_size(vmem_file_t file);
+    bool        v_file_resize(vmem_file_t file, u64 size);                                  // grow (zero filled) or truncate the file
+    bool        v_file_read(vmem_file_t file, u64 offset, void* dst, uint_t size);          // read without mapping
+    bool        v_file_write(vmem_file_t file, u64 offset, void const* src, uint_t size);   // write without mapping
+    bool        v_file_map(vmem_file_t file, u64 offset, void* addr, uint_t size);          // map [offset, offset + size) at a reserved address
+    bool        v_file_map_private(vmem_file_t file, u64 offset, void* addr, uint_t size);  // same, but copy-on-write, changes are not written to the file
+    bool        v_file_sync(void* addr, uint_t size);                                       // write the changed pages of a mapped range to the file
+    bool        v_file_punch(vmem_file_t file, u64 offset, u64 size);                       // give the storage of a range back, it reads as zeros (Linux)
+
+    // NUMA, memory node affinity of reserved virtual memory (Linux, through raw system calls). On other platforms there
+    // is a single node and binding is not supported.
+    const s32 cNUMA_ANY_NODE  = -1;  // no node affinity
+    const u32 cNUMA_MAX_NODES = 64;  // nodes beyond this are not used
+
+    u32 v_numa_num_nodes();     // number of memory nodes, 1 when NUMA is not available
+    s32 v_numa_current_node();  // memory node of the cpu the calling thread is running on, 0 when not available
+
+    // Bind the pages of a reserved range to a memory node, pages that are faulted in later are allocated on that node
+    // (preferred, when the node is out of memory pages come from other nodes). Returns false when not supported.
+    bool v_numa_bind(void* addr, uint_t size, s32 node);
+
+    // Decommit policy, shared by the allocators that hand pages back to the OS (arena shrink/reset, chunk
+    // and block bins). A nullptr policy means eager decommit. A policy can be shared across threads, the
+    // statistics are updated with relaxed atomics (read them when the allocators are idle for exact numbers).
+    enum vmem_decommit_mode_t
+    {
+        VMEM_DECOMMIT_EAGER      = 0,  // decommit immediately, reuse pays a commit syscall and page faults
+        VMEM_DECOMMIT_LAZY       = 1,  // keep pages committed, let the OS reclaim them lazily (v_alloc_lazy_free)
+        VMEM_DECOMMIT_HYSTERESIS = 2,  // keep unused pages committed up to a retained-bytes budget, decommit the rest
+    };
+
+    struct vmem_decommit_stats_t
+    {
+        u64 m_decommit_calls;     // number of eager decommit calls made to the OS
+        u64 m_decommitted_bytes;  // bytes decommitted eagerly
+        u64 m_lazy_freed_bytes;   // bytes handed to the OS lazily
+        u64 m_retained_bytes;     // bytes kept committed (and resident) because of the budget
+        u64 m_faults_avoided;     // pages that stayed mapped and do not need a commit+fault when reused (for lazy pages this is an upper bound)
+    };
+
+    // Note: the hysteresis budget is per allocator (each one passes the unused bytes it retains), so N allocators
+    //       that share a policy can retain up to N x budget.
+    struct vmem_decommit_policy_t
+    {
+        u32                   m_mode;             // vmem_decommit_mode_t
+        uint_t                m_retained_budget;  // (hysteresis) maximum number of unused bytes an allocator keeps committed
+        vmem_decommit_stats_t m_stats;
+    };
+
+    void v_decommit_policy_init(vmem_decommit_policy_t* policy, vmem_decommit_mode_t mode, uint_t retained_budget = 0);
+
+    // Give the pages in [addr, addr + size) back according to the policy, 'retained' is the number of unused bytes
+    // the allocator already keeps committed. Returns the number of bytes at the start of the range that are still
+    // committed after the call (0 = all decommitted, size = nothing decommitted).
+    uint_t v_decommit(vmem_decommit_policy_t* policy, void* addr, uint_t size, uint_t retained, u8 page_size_shift);
 }  // namespace ncore
 
 namespace ncore
@@ -0,0 +1,289 @@
+#ifndef __CCORE_RELPTR_H__
+#define __CCORE_RELPTR_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+#include "ccore/c_arena.h"
+#include "ccore/c_array.h"
+#include "ccore/c_hash.h"
+#include "ccore/c_math.h"
+
+namespace ncore
+{
+    // Self-relative pointer, holds the distance from its own address to the target (0 = nullptr). A structure that only
+    // uses relptr's to point into the memory block it lives in (e.g. an arena) keeps working when that block is copied,
+    // written to a file and loaded or mapped again at another address. Copying a relptr re-encodes the target for the
+    // address of the copy, so a relptr should only be copied within the same block.
+    // Note: a 32-bit relptr reaches targets within +/- 2 GiB, use relptr64_t for larger blocks.
+    // Note: offset 0 is the null encoding, so a relptr cannot point at itself (it would read back as nullptr), this keeps
+    //       zero-cleared memory a valid set of null relptr's.
+    template <typename T, typename O = s32>
+    class relptr_t
+    {
+    public:
+        inline relptr_t() : m_offset(0) {}
+        inline relptr_t(T* ptr) { set(ptr); }
+        inline relptr_t(relptr_t const& other) { set(other.get()); }
+
+        inline relptr_t& operator=(relptr_t const& other)
+        {
+            set(other.get());
+            return *this;
+        }
+        inline relptr_t& operator=(T* ptr)
+        {
+            set(ptr);
+            return *this;
+        }
+
+        // the arithmetic is done on integers, the target is not part of the object that holds the relptr
+        inline T* get() const { return m_offset == 0 ? nullptr : (T*)((ptr_t)this + (ptr_t)(int_t)m_offset); }
+        inline void set(T* ptr)
+        {
+            const int_t offset = ptr == nullptr ? 0 : (int_t)((ptr_t)ptr - (ptr_t)this);
+            m_offset           = (O)offset;
+            ASSERTS((int_t)m_offset == offset, "relptr: target out of range of the offset type");
+        }
+
+        inline bool is_null() const { return m_offset == 0; }
+        inline T*   operator->() const { return get(); }
+        inline T&   operator*() const { return *get(); }
+        inline T&   operator[](uint_t index) const { return get()[index]; }
+
+        O m_offset;  // distance in bytes from this relptr to the target
+    };
+
+    template <typename T>
+    using relptr32_t = relptr_t<T, s32>;
+    template <typename T>
+    using relptr64_t = relptr_t<T, s64>;
+
+    namespace narena
+    {
+        // Offsets relative to the base of an arena, e.g. to keep a root of a structure outside of the arena
+        inline uint_t offset_of(arena_t* arena, void const* ptr) { return (uint_t)((byte const*)ptr - base_ptr(arena)); }
+        template <typename T>
+        inline T* ptr_at(arena_t* arena, uint_t offset)
+        {
+            return (T*)(base_ptr(arena) + offset);
+        }
+    }  // namespace narena
+
+    // Relocatable array with a fixed capacity, the items are allocated from an arena.
+    // Note: T should be trivially copyable and only use relptr's for pointers (the same holds for the list and the map).
+    template <typename T, typename O = s32>
+    struct relarray_t
+    {
+        relptr_t<T, O> m_items;
+        u32            m_count;
+        u32            m_capacity;
+
+        bool init(arena_t* arena, u32 capacity)
+        {
+            m_items    = g_allocate_array<T>(arena, capacity, alignof(T));
+            m_count    = 0;
+            m_capacity = m_items.is_null() ? 0 : capacity;
+            return !m_items.is_null();
+        }
+
+        inline u32 size() const { return m_count; }
+        inline u32 capacity() const { return m_capacity; }
+        inline T*  data() const { return m_items.get(); }
+        inline T&  operator[](u32 index) const { return g_array_at(m_items.get(), m_count, index); }
+
+        inline bool push_back(T const& item)
+        {
+            if (m_count >= m_capacity)
+                return false;
+            m_items[m_count++] = item;
+            return true;
+        }
+        inline bool pop_back(T& item)
+        {
+            if (m_count == 0)
+                return false;
+            item = m_items[--m_count];
+            return true;
+        }
+    };
+
+    // Relocatable doubly linked list, the nodes are allocated from an arena. A removed node is not freed, that is up
+    // to the arena (restore/reset).
+    template <typename T, typename O = s32>
+    struct rellist_t
+    {
+        struct node_t
+        {
+            relptr_t<node_t, O> m_next;
+            relptr_t<node_t, O> m_prev;
+            T                   m_item;
+        };
+
+        relptr_t<node_t, O> m_head;
+        relptr_t<node_t, O> m_tail;
+        u32                 m_count;
+
+        void init()
+        {
+            m_head  = nullptr;
+            m_tail  = nullptr;
+            m_count = 0;
+        }
+
+        inline u32     size() const { return m_count; }
+        inline node_t* head() const { return m_head.get(); }
+        inline node_t* tail() const { return m_tail.get(); }
+
+        node_t* push_back(arena_t* arena, T const& item)
+        {
+            node_t* node = g_allocate<node_t>(arena, alignof(node_t));
+            if (node == nullptr)
+                return nullptr;
+            node->m_item = item;
+            node->m_next = nullptr;
+            node->m_prev = m_tail.get();
+            if (m_tail.is_null())
+                m_head = node;
+            else
+                m_tail->m_next = node;
+            m_tail = node;
+            m_count += 1;
+            return node;
+        }
+
+        node_t* push_front(arena_t* arena, T const& item)
+        {
+            node_t* node = g_allocate<node_t>(arena, alignof(node_t));
+            if (node == nullptr)
+                return nullptr;
+            node->m_item = item;
+            node->m_prev = nullptr;
+            node->m_next = m_head.get();
+            if (m_head.is_null())
+                m_tail = node;
+            else
+                m_head->m_prev = node;
+            m_head = node;
+            m_count += 1;
+            return node;
+        }
+
+        void remove(node_t* node)
+        {
+            if (node->m_prev.is_null())
+                m_head = node->m_next.get();
+            else
+                node->m_prev->m_next = node->m_next.get();
+            if (node->m_next.is_null())
+                m_tail = node->m_prev.get();
+            else
+                node->m_next->m_prev = node->m_prev.get();
+            node->m_next = nullptr;
+            node->m_prev = nullptr;
+            m_count -= 1;
+        }
+    };
+
+    // Relocatable hash map with a fixed capacity, open addressing with linear probing and backward shift deletion. The
+    // table size is a power of two with at least one slot that always stays empty, that empty slot is what ends a probe
+    // sequence and the backward shift. Keys are hashed and compared by their bytes, so a key type should not have padding.
+    template <typename K, typename V, typename O = s32>
+    struct relmap_t
+    {
+        struct slot_t
+        {
+            u32 m_hash;  // 0 = empty slot
+            K   m_key;
+            V   m_value;
+        };
+
+        relptr_t<slot_t, O> m_slots;
+        u32                 m_count;
+        u32                 m_mask;
+
+        bool init(arena_t* arena, u32 capacity)
+        {
+            capacity = math::ceilpo2(capacity + 1);
+            m_slots = (slot_t*)narena::alloc_and_zero(arena, (uint_t)capacity * sizeof(slot_t), alignof(slot_t));
+            m_count = 0;
+            m_mask  = m_slots.is_null() ? 0 : capacity - 1;
+            return !m_slots.is_null();
+        }
+
+        inline u32 size() const { return m_count; }
+        inline u32 capacity() const { return m_mask; }
+
+        static inline u32 s_hash(K const& key)
+        {
+            const u32 hash = nhash::datahash32((u8 const*)&key, (u32)sizeof(K));
+            return hash != 0 ? hash : 1;
+        }
+
+        // find the slot of a key, or the empty slot where it would be inserted (nullptr when the map is full)
+        slot_t* find_slot(K const& key, u32 hash) const
+        {
+            slot_t* slots = m_slots.get();
+            for (u32 i = 0, index = hash & m_mask; i <= m_mask; ++i, index = (index + 1) & m_mask)
+            {
+                slot_t* slot = &slots[index];
+                if (slot->m_hash == 0 || (slot->m_hash == hash && g_memequal(&slot->m_key, &key, sizeof(K))))
+                    return slot;
+            }
+            return nullptr;
+        }
+
+        // insert or replace, returns false when the map is full
+        bool insert(K const& key, V const& value)
+        {
+            const u32 hash = s_hash(key);
+            slot_t*   slot = find_slot(key, hash);
+            if (slot == nullptr)
+                return false;
+            if (slot->m_hash == 0)
+            {
+                if (m_count >= m_mask)
+                    return false;  // keep one slot empty
+
+                slot->m_hash = hash;
+                slot->m_key  = key;
+                m_count += 1;
+            }
+            slot->m_value = value;
+            return true;
+        }
+
+        V* find(K const& key) const
+        {
+            slot_t* slot = find_slot(key, s_hash(key));
+            return (slot == nullptr || slot->m_hash == 0) ? nullptr : &slot->m_value;
+        }
+
+        bool remove(K const& key)
+        {
+            slot_t* slots = m_slots.get();
+            slot_t* slot  = find_slot(key, s_hash(key));
+            if (slot == nullptr || slot->m_hash == 0)
+                return false;
+
+            // shift the following entries of the probe sequence back into the hole
+            u32 hole = (u32)(slot - slots);
+            for (u32 index = (hole + 1) & m_mask; slots[index].m_hash != 0; index = (index + 1) & m_mask)
+            {
+                const u32 home = slots[index].m_hash & m_mask;
+                if (((index - home) & m_mask) >= ((index - hole) & m_mask))
+                {
+                    slots[hole] = slots[index];
+                    hole        = index;
+                }
+            }
+            slots[hole].m_hash = 0;
+            m_count -= 1;
+            return true;
+        }
+    };
+
+}  // namespace ncore
+
+#endif  // __CCORE_RELPTR_H__
@@ -5,6 +5,9 @@
 #    pragma once
 #endif
 
+#include "ccore/c_memory.h"
+#include "ccore/c_atomic.h"
+
 namespace ncore
 {
     namespace nsegment
@@ -45,18 +48,58 @@ namespace ncore
             u8           m_pagesize_shift;          // page size (1u << m_pagesize_shift)
             u8           m_bookkeeping_num_pages;   // bookkeeping num pages
             u16          m_free_list_heads[32];     // free list heads for each size class (0 = smallest, 31 = largest)
+            u8           m_page_backing;            // page backing (vmem_pages_t) that was obtained for the address space
             chain_t*     m_chain;                   // m_chain[max_nodes]
             node_data_t* m_nodes;                   // m_nodes[max_nodes], free-list links or allocated-node user data
+            spinlock_t   m_class_locks[32];         // concurrent mode, lock of the free list of each size class
+            spinlock_t   m_merge_lock;              // concurrent mode, serializes the splitting and merging of nodes
+            u32 volatile m_frees;                   // concurrent mode, number of deallocations since the last merge
+            u32          m_merge_batch;             // concurrent mode, number of deallocations that trigger a merge (0 = not concurrent)
+            u8           m_coalesce_class;          // coalescing, size class at which the merge pass continues
+            u16          m_coalesce_node;           // coalescing, free node at which the merge pass continues (checked before use)
         };
 
         // Note: @address_space_num_pages MUST be a power of two
-        void initialize(allocator_t* allocator, u64 address_space_size = 128 * cGB, u64 segment_min_size = 8 * cMB, u64 segment_max_size = 1 * cGB);
+        // Note: @pages opts in to large page backing, it is only honored when @segment_min_size is at least the large page
+        //       size, check 'm_page_backing' for the backing that was obtained, with large pages 'm_pagesize_shift' is the
+        //       large page size and thus the page unit of commit/decommit/get_address.
+        // Note: @numa_node binds the address space to a NUMA node (best effort, see v_numa_bind)
+        void initialize(allocator_t* allocator, u64 address_space_size = 128 * cGB, u64 segment_min_size = 8 * cMB, u64 segment_max_size = 1 * cGB, vmem_pages_t pages = VMEM_PAGES_DEFAULT, s32 numa_node = cNUMA_ANY_NODE);
         void teardown(allocator_t* allocator);
 
         // Note: size should be a power-of-two number of pages
         node_t alloc_node(allocator_t* allocator, u64 size);
         void   dealloc_node(allocator_t* allocator, node_t node);
 
+        // Concurrent mode, alloc_node_concurrent and dealloc_node_concurrent can be called from any thread, every size class
+        // has its own lock. Splitting a larger node is serialized, and free buddies are not merged on deallocation but in a
+        // batch (merge_free_nodes) once @merge_batch nodes have been deallocated or when an allocation finds no free node.
+        // Note: do not mix with alloc_node/dealloc_node, the node functions below may be called concurrently for nodes that
+        //       are owned by the calling thread, address_to_node is not thread-safe.
+        void   enable_concurrent(allocator_t* allocator, u32 merge_batch = 64);
+        node_t alloc_node_concurrent(allocator_t* allocator, u64 size);
+        void   dealloc_node_concurrent(allocator_t* allocator, node_t node);
+        u32    merge_free_nodes(allocator_t* allocator);  // merge the free buddies (thread-safe), returns the number of merges
+
+        // Fragmentation report, size class 'i' holds nodes of (segment_min_size << i) bytes. A mergeable pair is a pair of
+        // free buddies that can be merged into a node of the next class, these only exist in concurrent mode.
+        struct stats_t
+        {
+            u64 m_free_bytes[32];       // free bytes per size class
+            u32 m_free_nodes[32];       // number of free nodes per size class
+            u32 m_mergeable_pairs[32];  // number of free buddy pairs per size class
+            u64 m_total_free_bytes;     // total number of free bytes
+            u64 m_used_bytes;           // total number of bytes in allocated nodes
+            u64 m_largest_free;         // size of the largest free node, the largest allocation that can succeed
+        };
+
+        void get_stats(allocator_t* allocator, stats_t& stats);  // thread-safe
+
+        // Incremental coalescing, e.g. from an idle thread. Every call continues the merge pass where the previous call
+        // stopped and visits at most @max_steps free nodes, which bounds the time the merge lock is held.
+        // Returns the number of merges, thread-safe.
+        u32 coalesce(allocator_t* allocator, u32 max_steps);
+
         // Set or get a 16-bit tag for a node, only valid for allocated nodes
         void set_node_tag(allocator_t* allocator, node_t node, u16 tag);
         bool get_node_tag(allocator_t* allocator, node_t node, u16& tag);
@@ -74,6 +117,7 @@ namespace ncore
         // Targets must fit the node and the 24-bit committed-page counter.
         void commit(allocator_t* allocator, node_t node, u32 target_pages);    // target_pages >= current committed pages
         void decommit(allocator_t* allocator, node_t node, u32 target_pages);  // target_pages <= current committed pages
+        u32  committed_pages(allocator_t* allocator, node_t node);             // number of committed pages, 0 for invalid or free nodes
 
     }  // namespace nsegment
 }  // namespace ncore
@@ -46,6 +46,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits);        // Finds the first '1' bit and sets it to free and returns the bit index
         s32 alloc_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits);  // Finds the last '0' bit and sets it to used and returns the bit index
         s32 free_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits);   // Finds the last '1' bit and sets it to used and returns the bit index
+
+        s32  find_free_range(bintype const * _free0, bintype const * _used0, bintype const * _bin1, u32 maxbits, u32 n);  // Finds the first run of 'n' '0' bits and returns the index of its first bit
+        s32  alloc_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 n);                           // Finds the first run of 'n' '0' bits, sets them to used and returns the index of its first bit
+        void free_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 start, u32 n);                 // Sets the bits [start, start + n) to free
     }  // namespace nstatevec10
 
     // 2^12 state-vector, can handle a maximum of 4096 bits.
@@ -79,6 +83,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits);
         s32 alloc_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits);  // Finds the last '0' bit and sets it to used and returns the bit index
         s32 free_last(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits);   // Finds the last '1' bit and sets it to used and returns the bit index
+
+        s32  find_free_range(bintype const * _free0, bintype const * _used0, bintype const * _bin1, u32 maxbits, u32 n);  // Finds the first run of 'n' '0' bits and returns the index of its first bit
+        s32  alloc_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 n);                           // Finds the first run of 'n' '0' bits, sets them to used and returns the index of its first bit
+        void free_range(bintype* _free0, bintype* _used0, bintype* _bin1, u32 maxbits, u32 start, u32 n);                 // Sets the bits [start, start + n) to free
     }  // namespace nstatevec12
 
     // --------------------------------------------------------------------------------------------
@@ -115,6 +123,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits);
         s32 alloc_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits);  // Finds the last '0' bit and sets it to used and returns the bit index
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits);   // Finds the last '1' bit and sets it to used and returns the bit index
+
+        s32  find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _used0, bintype const * _used1, bintype const * _bin2, u32 maxbits, u32 n);  // Finds the first run of 'n' '0' bits and returns the index of its first bit
+        s32  alloc_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 n);                                         // Finds the first run of 'n' '0' bits, sets them to used and returns the index of its first bit
+        void free_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 start, u32 n);                               // Sets the bits [start, start + n) to free
     }  // namespace nstatevec15
 
     namespace nstatevec18
@@ -147,6 +159,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits);
         s32 alloc_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits);  // Finds the last '0' bit and sets it to used and returns the bit index
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits);   // Finds the last '1' bit and sets it to used and returns the bit index
+
+        s32  find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _used0, bintype const * _used1, bintype const * _bin2, u32 maxbits, u32 n);  // Finds the first run of 'n' '0' bits and returns the index of its first bit
+        s32  alloc_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 n);                                         // Finds the first run of 'n' '0' bits, sets them to used and returns the index of its first bit
+        void free_range(bintype* _free0, bintype* _free1, bintype* _used0, bintype* _used1, bintype* _bin2, u32 maxbits, u32 start, u32 n);                               // Sets the bits [start, start + n) to free
     }  // namespace nstatevec18
 
     // --------------------------------------------------------------------------------------------
@@ -185,6 +201,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
         s32 alloc_last(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
+
+        s32  find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _free2, bintype const * _used0, bintype const * _used1, bintype const * _used2, bintype const * _bin3, u32 maxbits, u32 n);  // Finds the first run of 'n' '0' bits and returns the index of its first bit
+        s32  alloc_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 n);                                                       // Finds the first run of 'n' '0' bits, sets them to used and returns the index of its first bit
+        void free_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 start, u32 n);                                             // Sets the bits [start, start + n) to free
     }  // namespace nstatevec20
 
     namespace nstatevec24
@@ -198,6 +218,7 @@ namespace ncore
 
         void setup_used_lazy(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
         void tick_used_lazy(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 bit);
+        void trim_used_lazy(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 new_maxbits);
 
         void clear_all_free(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
         void clear_all_used(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
@@ -219,6 +240,10 @@ namespace ncore
         s32 free(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
         s32 alloc_last(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
         s32 free_last(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits);
+
+        s32  find_free_range(bintype const * _free0, bintype const * _free1, bintype const * _free2, bintype const * _used0, bintype const * _used1, bintype const * _used2, bintype const * _bin3, u32 maxbits, u32 n);  // Finds the first run of 'n' '0' bits and returns the index of its first bit
+        s32  alloc_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 n);                                                       // Finds the first run of 'n' '0' bits, sets them to used and returns the index of its first bit
+        void free_range(bintype* _free0, bintype* _free1, bintype* _free2, bintype* _used0, bintype* _used1, bintype* _used2, bintype* _bin3, u32 maxbits, u32 start, u32 n);                                             // Sets the bits [start, start + n) to free
     }  // namespace nstatevec24
 
 }  // namespace ncore
@@ -1559,6 +1559,19 @@ namespace ncore
     #endif
 #endif
 
+// CC_THREAD_LOCAL
+//
+// Storage class for per-thread variables, falls back to plain static storage when the compiler
+// has no C++11 thread_local support (in which case only single-threaded use is valid).
+//
+#if !defined(CC_THREAD_LOCAL)
+    #if defined(CC_COMPILER_NO_THREAD_LOCAL)
+        #define CC_THREAD_LOCAL
+    #else
+        #define CC_THREAD_LOCAL thread_local
+    #endif
+#endif
+
 };  // namespace ncore
 
 #endif
@@ -33,6 +33,7 @@ namespace ncore
     //
     //    CC_LIKELY()
     //    CC_UNLIKELY()
+    //    CC_PREFETCH()
     //    CC_INIT_PRIORITY()
     //    CC_MAY_ALIAS()
     //    CC_ASSUME()
@@ -444,6 +445,24 @@ namespace ncore
 #    endif
 #endif
 
+// ------------------------------------------------------------------------
+// CC_PREFETCH
+//
+// Hints the processor to bring the cache line of an address into the cache
+// for reading, it does not fault on invalid addresses. Defined as nothing on
+// compilers that do not support it.
+//
+// Example usage:
+//    CC_PREFETCH(&items[next]);
+//
+#ifndef CC_PREFETCH
+#    if (defined(__GNUC__) && (__GNUC__ >= 3)) || defined(__clang__)
+#        define CC_PREFETCH(addr) __builtin_prefetch((const void*)(addr), 0, 3)
+#    else
+#        define CC_PREFETCH(addr)
+#    endif
+#endif
+
 // ------------------------------------------------------------------------
 // CC_HAS_INCLUDE_AVAILABLE
 //
@@ -0,0 +1,51 @@
+namespace ncore
+{
+    namespace natomic
+    {
+        // GCC and Clang builtins
+
+        inline u32 load(u32 const volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+        inline u64 load(u64 const volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+        inline u32 load_relaxed(u32 const volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_RELAXED); }
+        inline u64 load_relaxed(u64 const volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_RELAXED); }
+        inline void store(u32 volatile* ptr, u32 value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+        inline void store(u64 volatile* ptr, u64 value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+        inline void store_relaxed(u32 volatile* ptr, u32 value) { __atomic_store_n(ptr, value, __ATOMIC_RELAXED); }
+        inline void store_relaxed(u64 volatile* ptr, u64 value) { __atomic_store_n(ptr, value, __ATOMIC_RELAXED); }
+
+        inline u32 fetch_add(u32 volatile* ptr, u32 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u64 fetch_add(u64 volatile* ptr, u64 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u32 fetch_sub(u32 volatile* ptr, u32 value) { return __atomic_fetch_sub(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u64 fetch_sub(u64 volatile* ptr, u64 value) { return __atomic_fetch_sub(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u32 fetch_add_relaxed(u32 volatile* ptr, u32 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED); }
+        inline u64 fetch_add_relaxed(u64 volatile* ptr, u64 value) { return __atomic_fetch_add(ptr, value, __ATOMIC_RELAXED); }
+        inline u32 fetch_sub_relaxed(u32 volatile* ptr, u32 value) { return __atomic_fetch_sub(ptr, value, __ATOMIC_RELAXED); }
+        inline u64 fetch_sub_relaxed(u64 volatile* ptr, u64 value) { return __atomic_fetch_sub(ptr, value, __ATOMIC_RELAXED); }
+        inline u32 fetch_or(u32 volatile* ptr, u32 value) { return __atomic_fetch_or(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u64 fetch_or(u64 volatile* ptr, u64 value) { return __atomic_fetch_or(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u32 fetch_and(u32 volatile* ptr, u32 value) { return __atomic_fetch_and(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u64 fetch_and(u64 volatile* ptr, u64 value) { return __atomic_fetch_and(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u32 exchange(u32 volatile* ptr, u32 value) { return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST); }
+        inline u64 exchange(u64 volatile* ptr, u64 value) { return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST); }
+
+        inline bool cas(u32 volatile* ptr, u32 expected, u32 desired) { return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+        inline bool cas(u64 volatile* ptr, u64 expected, u64 desired) { return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+        // clang-format off
+        template <typename T> inline T*   load_ptr(T* const volatile* ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+        template <typename T> inline void store_ptr(T* volatile* ptr, T* value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+        template <typename T> inline bool cas_ptr(T* volatile* ptr, T* expected, T* desired) { return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+        // clang-format on
+
+        inline void fence() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+        inline void pause()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+            __asm__ __volatile__("yield");
+#endif
+        }
+    }  // namespace natomic
+}  // namespace ncore
@@ -0,0 +1,81 @@
+#include <intrin.h>
+
+namespace ncore
+{
+    namespace natomic
+    {
+        // MSVC intrinsics, x86/x64 is a strongly ordered platform so a plain (volatile) load has acquire
+        // semantics and a plain (volatile) store has release semantics, we only need to stop the compiler
+        // from reordering.
+
+        inline u32 load(u32 const volatile* ptr)
+        {
+            u32 const value = *ptr;
+            _ReadWriteBarrier();
+            return value;
+        }
+        inline u64 load(u64 const volatile* ptr)
+        {
+            u64 const value = *ptr;
+            _ReadWriteBarrier();
+            return value;
+        }
+        inline u32 load_relaxed(u32 const volatile* ptr) { return *ptr; }
+        inline u64 load_relaxed(u64 const volatile* ptr) { return *ptr; }
+        inline void store(u32 volatile* ptr, u32 value)
+        {
+            _ReadWriteBarrier();
+            *ptr = value;
+        }
+        inline void store(u64 volatile* ptr, u64 value)
+        {
+            _ReadWriteBarrier();
+            *ptr = value;
+        }
+        inline void store_relaxed(u32 volatile* ptr, u32 value) { *ptr = value; }
+        inline void store_relaxed(u64 volatile* ptr, u64 value) { *ptr = value; }
+
+        inline u32 fetch_add(u32 volatile* ptr, u32 value) { return (u32)_InterlockedExchangeAdd((long volatile*)ptr, (long)value); }
+        inline u64 fetch_add(u64 volatile* ptr, u64 value) { return (u64)_InterlockedExchangeAdd64((__int64 volatile*)ptr, (__int64)value); }
+        inline u32 fetch_sub(u32 volatile* ptr, u32 value) { return (u32)_InterlockedExchangeAdd((long volatile*)ptr, -(long)value); }
+        inline u64 fetch_sub(u64 volatile* ptr, u64 value) { return (u64)_InterlockedExchangeAdd64((__int64 volatile*)ptr, -(__int64)value); }
+        // x86/x64 has no cheaper form of an interlocked add
+        inline u32 fetch_add_relaxed(u32 volatile* ptr, u32 value) { return fetch_add(ptr, value); }
+        inline u64 fetch_add_relaxed(u64 volatile* ptr, u64 value) { return fetch_add(ptr, value); }
+        inline u32 fetch_sub_relaxed(u32 volatile* ptr, u32 value) { return fetch_sub(ptr, value); }
+        inline u64 fetch_sub_relaxed(u64 volatile* ptr, u64 value) { return fetch_sub(ptr, value); }
+        inline u32 fetch_or(u32 volatile* ptr, u32 value) { return (u32)_InterlockedOr((long volatile*)ptr, (long)value); }
+        inline u64 fetch_or(u64 volatile* ptr, u64 value) { return (u64)_InterlockedOr64((__int64 volatile*)ptr, (__int64)value); }
+        inline u32 fetch_and(u32 volatile* ptr, u32 value) { return (u32)_InterlockedAnd((long volatile*)ptr, (long)value); }
+        inline u64 fetch_and(u64 volatile* ptr, u64 value) { return (u64)_InterlockedAnd64((__int64 volatile*)ptr, (__int64)value); }
+        inline u32 exchange(u32 volatile* ptr, u32 value) { return (u32)_InterlockedExchange((long volatile*)ptr, (long)value); }
+        inline u64 exchange(u64 volatile* ptr, u64 value) { return (u64)_InterlockedExchange64((__int64 volatile*)ptr, (__int64)value); }
+
+        inline bool cas(u32 volatile* ptr, u32 expected, u32 desired) { return (u32)_InterlockedCompareExchange((long volatile*)ptr, (long)desired, (long)expected) == expected; }
+        inline bool cas(u64 volatile* ptr, u64 expected, u64 desired) { return (u64)_InterlockedCompareExchange64((__int64 volatile*)ptr, (__int64)desired, (__int64)expected) == expected; }
+
+        template <typename T>
+        inline T* load_ptr(T* const volatile* ptr)
+        {
+            T* const value = *ptr;
+            _ReadWriteBarrier();
+            return value;
+        }
+
+        template <typename T>
+        inline void store_ptr(T* volatile* ptr, T* value)
+        {
+            _ReadWriteBarrier();
+            *ptr = value;
+        }
+
+        template <typename T>
+        inline bool cas_ptr(T* volatile* ptr, T* expected, T* desired)
+        {
+            return _InterlockedCompareExchangePointer((void* volatile*)ptr, (void*)desired, (void*)expected) == (void*)expected;
+        }
+
+        inline void fence() { _mm_mfence(); }
+        inline void pause() { _mm_pause(); }
+    }  // namespace natomic
+}  // namespace ncore
@@ -63,6 +63,9 @@ namespace ncore
 
         // find the number of trailing zeros in 32-bit value
         // if 'v==0' this function returns 32
+#if defined(CC_COMPILER_GNUC) || defined(CC_COMPILER_CLANG)
+        inline s8 countTrailingZeros(u32 value) { return (value == 0) ? (s8)32 : (s8)__builtin_ctz(value); }
+#else
         inline s8 countTrailingZeros(u32 value)
         {
             s8 count = 0;
@@ -98,8 +101,12 @@ namespace ncore
             }
             return 32;
         }
+#endif
         // find the number of trailing zeros in 64-bit value
         // if 'v==0' this function returns 64
+#if defined(CC_COMPILER_GNUC) || defined(CC_COMPILER_CLANG)
+        inline s8 countTrailingZeros(u64 value) { return (value == 0) ? (s8)64 : (s8)__builtin_ctzll(value); }
+#else
         inline s8 countTrailingZeros(u64 value)
         {
             s8 count = 0;
@@ -139,6 +146,7 @@ namespace ncore
             }
             return 64;
         }
+#endif
 
         // find the number of leading zeros in 8-bit
         // if 'v==0' this function returns 8
@@ -205,6 +213,9 @@ namespace ncore
         }
         // find the number of leading zeros in 32-bit v
         // if 'v==0' this function returns 32
+#if defined(CC_COMPILER_GNUC) || defined(CC_COMPILER_CLANG)
+        inline s8 countLeadingZeros(u32 value) { return (value == 0) ? (s8)32 : (s8)__builtin_clz(value); }
+#else
         inline s8 countLeadingZeros(u32 value)
         {
             if (value == 0)
@@ -242,8 +253,12 @@ namespace ncore
             }
             return count;
         }
+#endif
         // find the number of leading zeros in 64-bit v
         // if 'v==0' this function returns 64
+#if defined(CC_COMPILER_GNUC) || defined(CC_COMPILER_CLANG)
+        inline s8 countLeadingZeros(u64 value) { return (value == 0) ? (s8)64 : (s8)__builtin_clzll(value); }
+#else
         inline s8 countLeadingZeros(u64 value)
         {
             if (value == 0)
@@ -286,6 +301,7 @@ namespace ncore
             }
             return count;
         }
+#endif
 
         // Return v but with only the Least Significant Bit "1"
         inline u32 leastSignificantOneBit(u32 value) { return (value ^ (value & (value - 1))); }
@@ -372,6 +388,9 @@ namespace ncore
         /**
          * count one bits in 32 bit word
          */
+#if defined(CC_COMPILER_GNUC) || defined(CC_COMPILER_CLANG)
+        inline s8 countBits(u32 value) { return (s8)__builtin_popcount(value); }
+#else
         inline s8 countBits(u32 value)
         {
             value -= ((value >> 1) & 0x55555555);
@@ -381,10 +400,14 @@ namespace ncore
             value += (value >> 16);
             return (s8)(value & 0x0000003f);
         }
+#endif
 
         /**
          * count one bits in 64 bit word
          */
+#if defined(CC_COMPILER_GNUC) || defined(CC_COMPILER_CLANG)
+        inline s8 countBits(u64 value) { return (s8)__builtin_popcountll(value); }
+#else
         inline s8 countBits(u64 value)
         {
             u32 high = (u64(value) >> 32) & 0xffffffff;
@@ -401,5 +424,6 @@ namespace ncore
             low += (low >> 16);
             return (s8)(low & 0x0000003f) + (s8)(high & 0x0000003f);
         }
+#endif
     }  // namespace math
 }  // namespace ncore
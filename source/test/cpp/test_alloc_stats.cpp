@@ -0,0 +1,171 @@
+#include "ccore/c_target.h"
+#include "ccore/c_alloc_stats.h"
+#include "ccore/c_arena.h"
+#include "ccore/c_stream.h"
+
+#include "cunittest/cunittest.h"
+
+using namespace ncore;
+
+namespace
+{
+    class memory_writer_t : public writer_t
+    {
+    public:
+        memory_writer_t(u8* buffer, s64 size) : m_buffer(buffer), m_size(size), m_pos(0) {}
+
+        u8* m_buffer;
+        s64 m_size;
+        s64 m_pos;
+
+    protected:
+        virtual s64 v_write(u8 const* data, s64 len)
+        {
+            if (m_pos + len > m_size)
+                len = m_size - m_pos;
+            for (s64 i = 0; i < len; ++i)
+                m_buffer[m_pos + i] = data[i];
+            m_pos += len;
+            return len;
+        }
+    };
+}  // namespace
+
+UNITTEST_SUITE_BEGIN(alloc_stats)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(size_class)
+        {
+            CHECK_EQUAL(0, nalloc_stats::size_class(0));
+            CHECK_EQUAL(1, nalloc_stats::size_class(1));
+            CHECK_EQUAL(2, nalloc_stats::size_class(2));
+            CHECK_EQUAL(2, nalloc_stats::size_class(3));
+            CHECK_EQUAL(5, nalloc_stats::size_class(16));
+            CHECK_EQUAL(5, nalloc_stats::size_class(31));
+            CHECK_EQUAL(31, nalloc_stats::size_class((u64)1 << 40));
+        }
+
+        UNITTEST_TEST(counts_live_and_peak)
+        {
+            arena_t*            arena = narena::new_arena(16 * cMB, 1 * cMB);
+            arena_alloc_t       arena_alloc(arena);
+            alloc_stats_alloc_t stats_alloc(&arena_alloc);
+
+            void* a = stats_alloc.allocate(16);
+            void* b = stats_alloc.allocate(100, 64);
+            void* c = stats_alloc.allocate(1000);
+            CHECK_EQUAL(0, (ptr_t)b & 63);
+
+            alloc_stats_t const& stats = stats_alloc.stats();
+            CHECK_EQUAL(3, stats.m_allocs);
+            CHECK_EQUAL(3, stats.m_live_count);
+            CHECK_EQUAL(1116, stats.m_live_bytes);
+            CHECK_EQUAL(1116, stats.m_peak_bytes);
+            CHECK_EQUAL(1, stats.m_count[nalloc_stats::size_class(16)]);
+            CHECK_EQUAL(100, stats.m_bytes[nalloc_stats::size_class(100)]);
+
+            stats_alloc.deallocate(c);
+            stats_alloc.deallocate(a);
+            CHECK_EQUAL(2, stats.m_frees);
+            CHECK_EQUAL(1, stats.m_live_count);
+            CHECK_EQUAL(100, stats.m_live_bytes);
+            CHECK_EQUAL(1116, stats.m_peak_bytes);
+
+            // 'c' lived for 0 allocations, 'a' lived for 2 allocations
+            CHECK_EQUAL(1, stats.m_lifetime[0]);
+            CHECK_EQUAL(1, stats.m_lifetime[nalloc_stats::size_class(3)]);
+
+            stats_alloc.deallocate(b);
+            CHECK_EQUAL(0, stats.m_live_bytes);
+            narena::destroy(arena);
+        }
+
+        static void* s_alloc_in_scope(alloc_t* allocator, u32 size, u16& scope)
+        {
+            DALLOCATION_SCOPE;
+            scope = nalloc_stats::current_scope();
+            return allocator->allocate(size);
+        }
+
+        UNITTEST_TEST(scopes)
+        {
+            g_set_alloc_tracker(nalloc_stats::tracker());
+
+            alloc_stats_t       scope_stats[nalloc_stats::c_max_scopes];
+            arena_t*            arena = narena::new_arena(16 * cMB, 1 * cMB);
+            arena_alloc_t       arena_alloc(arena);
+            alloc_stats_alloc_t stats_alloc(&arena_alloc, scope_stats, nalloc_stats::c_max_scopes);
+
+            CHECK_EQUAL(0, nalloc_stats::current_scope());
+            u16   scope   = 0;
+            void* outside = stats_alloc.allocate(32);
+            void* inside  = s_alloc_in_scope(&stats_alloc, 64, scope);
+            s_alloc_in_scope(&stats_alloc, 64, scope);
+            CHECK_EQUAL(0, nalloc_stats::current_scope());
+
+            CHECK_EQUAL(1, scope_stats[0].m_allocs);
+            CHECK_EQUAL(32, scope_stats[0].m_live_bytes);
+
+            CHECK_NOT_EQUAL(0, scope);
+            CHECK_EQUAL(scope, nalloc_stats::register_scope(nalloc_stats::scope_file(scope), nalloc_stats::scope_line(scope)));
+            CHECK_EQUAL(__FILE__, nalloc_stats::scope_file(scope));
+            CHECK_EQUAL(2, scope_stats[scope].m_allocs);
+            CHECK_EQUAL(128, scope_stats[scope].m_live_bytes);
+
+            stats_alloc.deallocate(inside);
+            stats_alloc.deallocate(outside);
+            CHECK_EQUAL(64, scope_stats[scope].m_live_bytes);
+            CHECK_EQUAL(0, scope_stats[0].m_live_bytes);
+            CHECK_EQUAL(64, stats_alloc.stats().m_live_bytes);
+
+            g_set_alloc_tracker(nullptr);
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(trace_ring_and_dump)
+        {
+            alloc_event_t events[8];
+            alloc_ring_t  ring;
+            nalloc_trace::init(&ring, events, 8);
+            nalloc_trace::set_thread_ring(&ring);
+
+            arena_t*            arena = narena::new_arena(16 * cMB, 1 * cMB);
+            arena_alloc_t       arena_alloc(arena);
+            alloc_stats_alloc_t stats_alloc(&arena_alloc);
+
+            void* ptrs[6];
+            for (s32 i = 0; i < 6; ++i)
+                ptrs[i] = stats_alloc.allocate((u32)(i + 1) * 8);
+            for (s32 i = 0; i < 6; ++i)
+                stats_alloc.deallocate(ptrs[i]);
+            nalloc_trace::set_thread_ring(nullptr);
+            CHECK_EQUAL(12, ring.m_head);
+
+            u8              buffer[16 + 8 * sizeof(alloc_event_t)];
+            memory_writer_t writer(buffer, sizeof(buffer));
+            CHECK_EQUAL((s64)sizeof(buffer), nalloc_trace::dump(&ring, &writer));
+
+            u32 const* header = (u32 const*)buffer;
+            CHECK_EQUAL((u32)(('A' << 24) | ('T' << 16) | ('R' << 8) | 'C'), header[0]);
+            CHECK_EQUAL(sizeof(alloc_event_t), header[2]);
+            CHECK_EQUAL(8, header[3]);
+
+            // the ring wrapped, the oldest event that survived is the allocation of ptrs[4]
+            alloc_event_t const* dumped = (alloc_event_t const*)(buffer + 16);
+            CHECK_EQUAL(alloc_event_t::ALLOC, dumped[0].m_type);
+            CHECK_EQUAL((u64)(ptr_t)ptrs[4], dumped[0].m_address);
+            CHECK_EQUAL(40, dumped[0].m_size);
+            for (s32 i = 2; i < 8; ++i)
+            {
+                CHECK_EQUAL(alloc_event_t::FREE, dumped[i].m_type);
+                CHECK_EQUAL((u64)(ptr_t)ptrs[i - 2], dumped[i].m_address);
+            }
+            narena::destroy(arena);
+        }
+    }
+}
+UNITTEST_SUITE_END
@@ -1,8 +1,15 @@
 #include "ccore/c_target.h"
 #include "ccore/c_arena.h"
+#include "ccore/c_atomic.h"
+#include "ccore/c_qsort.h"
+#include "ccore/c_segment.h"
 
 #include "cunittest/cunittest.h"
 
+#include "test_thread.h"
+
+#include <stdio.h>
+
 using namespace ncore;
 
 UNITTEST_SUITE_BEGIN(arena)
@@ -41,6 +48,936 @@ UNITTEST_SUITE_BEGIN(arena)
 
             narena::destroy(arena);  // release the reserved memory
         }
+
+        UNITTEST_TEST(large_pages)
+        {
+            const u32 large_page_size = v_alloc_get_large_page_size();
+            arena_t*  arena           = narena::new_arena(64 * cMB, 1, VMEM_PAGES_TRANSPARENT_HUGE);
+            CHECK_NOT_NULL(arena);
+            CHECK_EQUAL(0, (ptr_t)narena::base_ptr(arena) & (large_page_size - 1));
+
+            // report which backing we got, with huge pages the commit granularity is the large page size
+            if (narena::page_backing(arena) != VMEM_PAGES_DEFAULT)
+            {
+                CHECK_EQUAL(large_page_size, narena::page_size(arena));
+                CHECK_EQUAL(large_page_size, narena::committed_size(arena));
+            }
+            else
+            {
+                CHECK_EQUAL(v_alloc_get_page_size(), narena::page_size(arena));
+            }
+            CHECK_EQUAL(64 * cMB, narena::reserved_size(arena));
+
+            byte* ptr = (byte*)narena::alloc(arena, 3 * cMB);
+            CHECK_NOT_NULL(ptr);
+            ptr[0]           = 1;
+            ptr[3 * cMB - 1] = 2;
+            narena::reset(arena);
+            narena::shrink(arena);
+            narena::destroy(arena);
+
+            arena = narena::new_arena(1 * cMB, 0);
+            CHECK_EQUAL(VMEM_PAGES_DEFAULT, narena::page_backing(arena));
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(decommit_policy)
+        {
+            vmem_decommit_policy_t eager, lazy, hysteresis;
+            v_decommit_policy_init(&eager, VMEM_DECOMMIT_EAGER);
+            v_decommit_policy_init(&lazy, VMEM_DECOMMIT_LAZY);
+            v_decommit_policy_init(&hysteresis, VMEM_DECOMMIT_HYSTERESIS, 256 * cKB);
+            const u8 page_size_shift = v_alloc_get_page_size_shift();
+
+            arena_t* arena = narena::new_arena(16 * cMB, 0);
+            CHECK_NOT_NULL(narena::alloc_and_zero(arena, 1 * cMB));
+            narena::reset(arena, &eager);
+            CHECK_EQUAL(0, narena::committed_size(arena));
+            CHECK_EQUAL(1, eager.m_stats.m_decommit_calls);
+            CHECK_EQUAL(1 * cMB, eager.m_stats.m_decommitted_bytes);
+            CHECK_EQUAL(0, eager.m_stats.m_faults_avoided);
+
+            // lazy, pages stay committed and can be reused without committing again
+            CHECK_NOT_NULL(narena::alloc_and_zero(arena, 1 * cMB));
+            narena::reset(arena, &lazy);
+            CHECK_EQUAL(1 * cMB, narena::committed_size(arena));
+            CHECK_EQUAL(0, lazy.m_stats.m_decommit_calls);
+            CHECK_EQUAL(1 * cMB, lazy.m_stats.m_lazy_freed_bytes);
+            CHECK_EQUAL((1 * cMB) >> page_size_shift, lazy.m_stats.m_faults_avoided);
+            CHECK_NOT_NULL(narena::alloc_and_zero(arena, 1 * cMB));
+            CHECK_EQUAL(1 * cMB, narena::committed_size(arena));
+
+            // hysteresis, keep the budget committed and decommit the rest
+            narena::reset(arena, &hysteresis);
+            CHECK_EQUAL(256 * cKB, narena::committed_size(arena));
+            CHECK_EQUAL(256 * cKB, hysteresis.m_stats.m_retained_bytes);
+            CHECK_EQUAL(768 * cKB, hysteresis.m_stats.m_decommitted_bytes);
+
+            // shrink keeps the used pages
+            CHECK_NOT_NULL(narena::alloc(arena, 1 * cMB));
+            CHECK_NOT_NULL(narena::alloc(arena, 64 * cKB));
+            narena::restore_address(arena, narena::base_ptr(arena) + 1 * cMB);
+            narena::shrink(arena, &hysteresis);
+            CHECK_EQUAL(1 * cMB + 64 * cKB, narena::committed_size(arena));
+            narena::shrink(arena, &eager);
+            CHECK_EQUAL(1 * cMB, narena::committed_size(arena));
+
+            narena::destroy(arena);
+        }
+    }
+
+    UNITTEST_FIXTURE(chained)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(grows_beyond_link)
+        {
+            arena_t* arena = narena::new_chained_arena(256 * cKB, 0);
+            CHECK_NOT_NULL(arena);
+            CHECK_EQUAL(1, narena::num_links(arena));
+
+            u32* blocks[64];
+            for (s32 i = 0; i < 64; ++i)
+            {
+                blocks[i] = (u32*)narena::alloc(arena, 16 * cKB, 16);
+                CHECK_NOT_NULL(blocks[i]);
+                CHECK_EQUAL(0, (ptr_t)blocks[i] & 15);
+                for (s32 j = 0; j < 4 * 1024; ++j)
+                    blocks[i][j] = (u32)i;
+            }
+            CHECK_TRUE(narena::num_links(arena) >= 4);
+
+            bool ok = true;
+            for (s32 i = 0; i < 64; ++i)
+                for (s32 j = 0; j < 4 * 1024; ++j)
+                    ok = ok && (blocks[i][j] == (u32)i);
+            CHECK_TRUE(ok);
+
+            // an allocation that is larger than a link gets a link of its own
+            byte* large = (byte*)narena::alloc_and_zero(arena, 1 * cMB);
+            CHECK_NOT_NULL(large);
+            CHECK_EQUAL(0, large[1 * cMB - 1]);
+
+            narena::reset(arena);
+            CHECK_EQUAL(1, narena::num_links(arena));
+            CHECK_NOT_NULL(narena::alloc(arena, 1024));
+            CHECK_TRUE(narena::destroy(arena));
+        }
+
+        UNITTEST_TEST(recommit_keeps_link_header)
+        {
+            arena_t* arena = narena::new_chained_arena(64 * cKB, 0);
+            narena::alloc(arena, 40 * cKB);
+            CHECK_TRUE(narena::recommit(arena, 0));
+            CHECK_TRUE(narena::current_pos(arena) > 0);  // never below the link header
+            narena::reset(arena);
+            CHECK_NOT_NULL(narena::alloc(arena, 1024));
+
+            // the same on a link that is not the first one
+            for (s32 i = 0; i < 16; ++i)
+                narena::alloc(arena, 16 * cKB);
+            CHECK_TRUE(narena::num_links(arena) > 1);
+            CHECK_TRUE(narena::recommit(arena, 0));
+            narena::reset(arena);
+            CHECK_EQUAL(1, narena::num_links(arena));
+            CHECK_NOT_NULL(narena::alloc(arena, 1024));
+            CHECK_TRUE(narena::destroy(arena));
+        }
+
+        UNITTEST_TEST(save_restore_across_links)
+        {
+            arena_t* arena = narena::new_chained_arena(64 * cKB, 0);
+            narena::alloc(arena, 40 * cKB);
+            arena_point_t point   = save_point(arena);
+            void*         address = point.m_address;
+
+            for (s32 i = 0; i < 32; ++i)
+                narena::alloc(arena, 8 * cKB);
+            CHECK_TRUE(narena::num_links(arena) > 1);
+
+            restore_point(point);
+            CHECK_EQUAL(1, narena::num_links(arena));
+            CHECK_EQUAL(address, narena::current_address(arena));
+
+            // nested points, restore the inner point first
+            point               = save_point(arena);
+            void* outer_address = point.m_address;
+            narena::alloc(arena, 60 * cKB);
+            arena_point_t inner         = save_point(arena);
+            void*         inner_address = inner.m_address;
+            narena::alloc(arena, 60 * cKB);
+            narena::alloc(arena, 60 * cKB);
+            const u32 links = narena::num_links(arena);
+            CHECK_TRUE(links >= 3);
+            restore_point(inner);
+            CHECK_EQUAL(inner_address, narena::current_address(arena));
+            CHECK_TRUE(narena::num_links(arena) < links);
+            restore_point(point);
+            CHECK_EQUAL(outer_address, narena::current_address(arena));
+            CHECK_EQUAL(1, narena::num_links(arena));
+
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(segment_links)
+        {
+            nsegment::allocator_t segments;
+            nsegment::initialize(&segments, (u64)8u * cMB, 1 * cMB, 8 * cMB);
+
+            arena_t* arena = narena::new_chained_arena(&segments, 1 * cMB, 64 * cKB);
+            CHECK_NOT_NULL(arena);
+            for (s32 i = 0; i < 6; ++i)
+                CHECK_NOT_NULL(narena::alloc_and_zero(arena, 512 * cKB));
+            CHECK_TRUE(narena::num_links(arena) >= 4);
+
+            // releasing the links returns the nodes to the segment allocator
+            narena::destroy(arena);
+            nsegment::node_t node = nsegment::alloc_node(&segments, 8 * cMB);
+            CHECK_NOT_EQUAL(nsegment::cINVALID_NODE, node);
+            nsegment::dealloc_node(&segments, node);
+
+            nsegment::teardown(&segments);
+        }
+    }
+
+    UNITTEST_FIXTURE(prefault)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(commit_ahead)
+        {
+            const uint_t page_size = v_alloc_get_page_size();
+            arena_t*     arena     = narena::new_arena(16 * cMB, 0);
+            narena::set_commit_ahead(arena, 3 * page_size);  // rounded up to 4 pages
+
+            CHECK_NOT_NULL(narena::alloc(arena, 100));
+            CHECK_EQUAL(5 * page_size, narena::committed_size(arena));
+            CHECK_NOT_NULL(narena::alloc(arena, 4 * page_size));
+            CHECK_EQUAL(5 * page_size, narena::committed_size(arena));
+            CHECK_NOT_NULL(narena::alloc(arena, page_size));
+            CHECK_EQUAL(10 * page_size, narena::committed_size(arena));
+
+            // the window is clamped to the reserved size
+            narena::set_commit_ahead(arena, 64 * cMB);
+            CHECK_NOT_NULL(narena::alloc(arena, 5 * page_size));
+            CHECK_EQUAL(16 * cMB, narena::committed_size(arena));
+
+            narena::set_commit_ahead(arena, 0);
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(prefault_and_warm)
+        {
+            const uint_t page_size = v_alloc_get_page_size();
+            arena_t*     arena     = narena::new_arena(16 * cMB, 64 * cKB);
+            narena::set_prefault(arena, true);
+
+            byte* ptr = (byte*)narena::alloc_and_zero(arena, 128 * cKB);
+            CHECK_NOT_NULL(ptr);
+            CHECK_EQUAL(128 * cKB, narena::committed_size(arena));
+
+            CHECK_EQUAL(48, narena::warm(arena, 48));
+            CHECK_EQUAL(128 * cKB + 48 * page_size, narena::committed_size(arena));
+            CHECK_EQUAL(0, narena::warm(arena, 48));
+            CHECK_EQUAL((u32)((16 * cMB - 128 * cKB) / page_size) - 48, narena::warm(arena, 0xFFFFFF));
+            CHECK_EQUAL(16 * cMB, narena::committed_size(arena));
+
+            // warm pages keep their content
+            ptr[0] = 0x55;
+            v_alloc_prefault(ptr, page_size);
+            CHECK_EQUAL(0x55, ptr[0]);
+
+            narena::destroy(arena);
+        }
+
+        struct warm_shared_t
+        {
+            arena_t*     m_arena;
+            u32 volatile m_done;
+            u32          m_warmed;
+        };
+
+        static void s_warm_thread(void* arg, s32 index)
+        {
+            warm_shared_t* shared = (warm_shared_t*)arg;
+            while (natomic::load(&shared->m_done) == 0)
+            {
+                shared->m_warmed += narena::warm(shared->m_arena, 64);
+                natomic::pause();
+            }
+        }
+
+        static void s_alloc_thread(void* arg, s32 index)
+        {
+            warm_shared_t* shared = (warm_shared_t*)arg;
+            for (s32 i = 0; i < 2048; ++i)
+            {
+                u32* ptr = (u32*)narena::alloc(shared->m_arena, 1000, 8);
+                for (s32 j = 0; j < 250; ++j)
+                    ptr[j] = (u32)i;
+            }
+            natomic::store(&shared->m_done, 1);
+        }
+
+        static void s_run_thread(void* arg, s32 index)
+        {
+            if (index == 0)
+                s_alloc_thread(arg, index);
+            else
+                s_warm_thread(arg, index);
+        }
+
+        UNITTEST_TEST(background_warm)
+        {
+            warm_shared_t shared;
+            shared.m_arena  = narena::new_arena(16 * cMB, 0);
+            shared.m_done   = 0;
+            shared.m_warmed = 0;
+            ntest::run_threads(2, s_run_thread, &shared);
+
+            bool ok = true;
+            for (s32 i = 0; i < 2048; ++i)
+            {
+                u32 const* ptr = (u32 const*)(narena::base_ptr(shared.m_arena) + i * 1000);
+                for (s32 j = 0; j < 250; ++j)
+                    ok = ok && (ptr[j] == (u32)i);
+            }
+            CHECK_TRUE(ok);
+            narena::destroy(shared.m_arena);
+        }
+
+#ifdef CCORE_BENCHMARKS
+        static u64 s_alloc_latency_p99(arena_t* arena, u64& max_ns)
+        {
+            const u32 count   = 2048;
+            u32*      samples = (u32*)narena::alloc(nscratch::get(), count * sizeof(u32));
+            for (u32 i = 0; i < count; ++i)
+            {
+                const u64 start = ntest::time_ns();
+                byte*     ptr   = (byte*)narena::alloc(arena, 2 * cKB, 16);
+                ptr[0] = ptr[2 * cKB - 1] = (byte)i;
+                samples[i] = (u32)(ntest::time_ns() - start);
+            }
+            nsort::sort(samples, count);
+            max_ns = samples[count - 1];
+            const u64 p99 = samples[(count * 99) / 100];
+            narena::reset(nscratch::get());
+            return p99;
+        }
+
+        // Allocation latency benchmark, on-demand commit versus commit-ahead with prefault
+        UNITTEST_TEST(benchmark)
+        {
+            u64      max_ns;
+            arena_t* arena = narena::new_arena(64 * cMB, 0);
+            const u64 on_demand_p99 = s_alloc_latency_p99(arena, max_ns);
+            printf("arena alloc latency, on demand commit:           p99 %6d ns, max %6d ns\n", (s32)on_demand_p99, (s32)max_ns);
+            narena::destroy(arena);
+
+            arena = narena::new_arena(64 * cMB, 4 * cMB);
+            narena::set_commit_ahead(arena, 1 * cMB);
+            narena::set_prefault(arena, true);
+            const u64 prefault_p99 = s_alloc_latency_p99(arena, max_ns);
+            printf("arena alloc latency, commit-ahead with prefault: p99 %6d ns, max %6d ns\n", (s32)prefault_p99, (s32)max_ns);
+            narena::destroy(arena);
+        }
+#endif
+    }
+
+    UNITTEST_FIXTURE(scratch)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() { nscratch::release(); }
+
+        static void s_produce(arena_t* output, u32 count, u32*& result)
+        {
+            scratch_t scratch(output);  // temporary memory may not alias 'output'
+            CHECK_NOT_NULL(scratch.arena());
+            CHECK_NOT_EQUAL(scratch.arena(), output);
+
+            u32* temp = g_allocate_array<u32>(scratch, count);
+            for (u32 i = 0; i < count; ++i)
+                temp[i] = i * 2;
+
+            result = g_allocate_array<u32>(output, count);
+            for (u32 i = 0; i < count; ++i)
+                result[i] = temp[i] + 1;
+        }
+
+        UNITTEST_TEST(scope_restore)
+        {
+            arena_t* arena = nscratch::get();
+            CHECK_NOT_NULL(arena);
+            void* start = narena::current_address(arena);
+            {
+                scratch_t scratch;
+                CHECK_EQUAL(arena, scratch.arena());
+                CHECK_NOT_NULL(narena::alloc(scratch, 1000));
+                {
+                    scratch_t nested;
+                    CHECK_EQUAL(arena, nested.arena());
+                    CHECK_NOT_NULL(narena::alloc(nested, 5000));
+                }
+                CHECK_EQUAL((byte*)start + 1000, (byte*)narena::current_address(arena));
+            }
+            CHECK_EQUAL(start, narena::current_address(arena));
+        }
+
+        UNITTEST_TEST(conflict)
+        {
+            arena_t* a = nscratch::get();
+            arena_t* b = nscratch::get(a);
+            CHECK_NOT_NULL(a);
+            CHECK_NOT_NULL(b);
+            CHECK_NOT_EQUAL(a, b);
+            CHECK_EQUAL(a, nscratch::get(b));
+
+            arena_t* both[] = {a, b};
+            CHECK_NULL(nscratch::get(both, 2));
+
+            // the caller writes into a scratch arena, the callee gets the other one
+            scratch_t outer;
+            u32*      result = nullptr;
+            s_produce(outer, 256, result);
+            CHECK_NOT_NULL(result);
+            for (u32 i = 0; i < 256; ++i)
+                CHECK_EQUAL(i * 2 + 1, result[i]);
+        }
+
+        UNITTEST_TEST(high_water)
+        {
+            nscratch::reset_high_water();
+            CHECK_EQUAL(0, nscratch::high_water());
+            {
+                scratch_t scratch;
+                narena::alloc(scratch, 4096);
+                CHECK_TRUE(nscratch::high_water() >= 4096);
+            }
+            {
+                scratch_t scratch;
+                narena::alloc(scratch, 100);
+            }
+            CHECK_TRUE(nscratch::high_water() >= 4096);
+            nscratch::reset_high_water();
+            CHECK_EQUAL(0, nscratch::high_water());
+        }
+    }
+
+    UNITTEST_FIXTURE(concurrent)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        static const s32 cMaxThreads       = 64;
+        static const s32 cAllocsPerThread = 2048;
+
+        struct shared_t
+        {
+            arena_t*     m_shared;
+            arena_t*     m_arenas[cMaxThreads];
+            u32 volatile m_ready;
+            s32          m_num_threads;
+            u64          m_duration_ns[cMaxThreads];
+            s32          m_failed[cMaxThreads];
+            byte*        m_blocks[8][cAllocsPerThread];
+        };
+
+        // spin until all threads have arrived, so that they all start allocating at the same time
+        static void s_wait_for_all(shared_t* shared)
+        {
+            natomic::fetch_add(&shared->m_ready, 1);
+            while (natomic::load(&shared->m_ready) < (u32)shared->m_num_threads)
+                natomic::pause();
+        }
+
+        static void s_fill_blocks(void* arg, s32 index)
+        {
+            shared_t* shared = (shared_t*)arg;
+            s_wait_for_all(shared);
+            for (s32 i = 0; i < cAllocsPerThread; ++i)
+            {
+                const u32 size  = 16 + (i % 48);
+                byte*     block = (byte*)((i & 1) ? narena::alloc_concurrent(shared->m_shared, size, 16) : narena::alloc_and_zero_concurrent(shared->m_shared, size));
+                for (u32 b = 0; b < size; ++b)
+                    block[b] = (byte)index;
+                shared->m_blocks[index][i] = block;
+            }
+        }
+
+        UNITTEST_TEST(no_overlap)
+        {
+            shared_t* shared      = (shared_t*)narena::alloc_and_zero(nscratch::get(), sizeof(shared_t), 64);
+            shared->m_shared      = narena::new_arena(4 * cMB, 0);
+            shared->m_num_threads = 8;
+            ntest::run_threads(shared->m_num_threads, s_fill_blocks, shared);
+
+            for (s32 t = 0; t < shared->m_num_threads; ++t)
+            {
+                for (s32 i = 0; i < cAllocsPerThread; ++i)
+                {
+                    byte* block = shared->m_blocks[t][i];
+                    CHECK_NOT_NULL(block);
+                    if ((i & 1) == 1)
+                        CHECK_EQUAL(0, (ptr_t)block & 15);
+                    const u32 size = 16 + (i % 48);
+                    bool      ok   = true;
+                    for (u32 b = 0; b < size; ++b)
+                        ok = ok && (block[b] == (byte)t);
+                    CHECK_TRUE(ok);
+                }
+            }
+
+            narena::destroy(shared->m_shared);
+            narena::reset(nscratch::get());
+        }
+
+        static void s_bench_shared(void* arg, s32 index)
+        {
+            shared_t* shared = (shared_t*)arg;
+            s_wait_for_all(shared);
+            s32       failed = 0;
+            const u64 start  = ntest::time_ns();
+            for (s32 i = 0; i < cAllocsPerThread; ++i)
+            {
+                u32* ptr = (u32*)narena::alloc_concurrent(shared->m_shared, 64, 8);
+                if (ptr == nullptr)
+                    failed += 1;
+                else
+                    *ptr = (u32)i;
+            }
+            shared->m_duration_ns[index] = ntest::time_ns() - start;
+            shared->m_failed[index]      = failed;
+        }
+
+        static s32 s_num_failed(shared_t* shared)
+        {
+            s32 failed = 0;
+            for (s32 t = 0; t < shared->m_num_threads; ++t)
+                failed += shared->m_failed[t];
+            return failed;
+        }
+
+        // an arena that is sized exactly for the aligned allocations of all threads is filled without failures
+        UNITTEST_TEST(exact_fill)
+        {
+            const uint_t per_thread_size = (uint_t)cAllocsPerThread * 64;
+
+            shared_t* shared      = (shared_t*)narena::alloc_and_zero(nscratch::get(), sizeof(shared_t), 64);
+            shared->m_num_threads = 8;
+            shared->m_shared      = narena::new_arena(per_thread_size * shared->m_num_threads, 0);
+            ntest::run_threads(shared->m_num_threads, s_bench_shared, shared);
+            CHECK_EQUAL(0, s_num_failed(shared));
+            CHECK_TRUE(narena::current_pos(shared->m_shared) == per_thread_size * shared->m_num_threads);  // no alignment padding was wasted
+
+            narena::destroy(shared->m_shared);
+            narena::reset(nscratch::get());
+        }
+
+#ifdef CCORE_BENCHMARKS
+        static void s_bench_per_thread(void* arg, s32 index)
+        {
+            shared_t* shared = (shared_t*)arg;
+            s_wait_for_all(shared);
+            s32       failed = 0;
+            const u64 start  = ntest::time_ns();
+            for (s32 i = 0; i < cAllocsPerThread; ++i)
+            {
+                u32* ptr = (u32*)narena::alloc(shared->m_arenas[index], 64, 8);
+                if (ptr == nullptr)
+                    failed += 1;
+                else
+                    *ptr = (u32)i;
+            }
+            shared->m_duration_ns[index] = ntest::time_ns() - start;
+            shared->m_failed[index]      = failed;
+        }
+
+        static u64 s_max_duration(shared_t* shared)
+        {
+            u64 duration = 0;
+            for (s32 t = 0; t < shared->m_num_threads; ++t)
+                duration = duration < shared->m_duration_ns[t] ? shared->m_duration_ns[t] : duration;
+            return duration;
+        }
+
+        // Contention benchmark, one shared arena with concurrent bump allocation versus one arena per thread
+        UNITTEST_TEST(benchmark)
+        {
+            shared_t* shared = (shared_t*)narena::alloc_and_zero(nscratch::get(), sizeof(shared_t), 64);
+            for (s32 num_threads = 1; num_threads <= cMaxThreads; num_threads *= 2)
+            {
+                const uint_t per_thread_size = (uint_t)cAllocsPerThread * 64;
+
+                shared->m_num_threads = num_threads;
+                shared->m_ready       = 0;
+                shared->m_shared      = narena::new_arena(per_thread_size * num_threads, 0);
+                ntest::run_threads(num_threads, s_bench_shared, shared);
+                const u64 shared_ns = s_max_duration(shared);
+                CHECK_EQUAL(0, s_num_failed(shared));
+                CHECK_TRUE(narena::current_pos(shared->m_shared) == per_thread_size * num_threads);  // no alignment padding was wasted
+                narena::destroy(shared->m_shared);
+
+                // each thread has its own arena, each sized for the worst case
+                shared->m_ready = 0;
+                for (s32 t = 0; t < num_threads; ++t)
+                    shared->m_arenas[t] = narena::new_arena(per_thread_size, 0);
+                ntest::run_threads(num_threads, s_bench_per_thread, shared);
+                const u64 per_thread_ns = s_max_duration(shared);
+                CHECK_EQUAL(0, s_num_failed(shared));
+                for (s32 t = 0; t < num_threads; ++t)
+                    narena::destroy(shared->m_arenas[t]);
+
+                printf("arena alloc, %2d threads: shared concurrent %6.1f ns/alloc, per-thread %6.1f ns/alloc\n", num_threads, (double)shared_ns / cAllocsPerThread, (double)per_thread_ns / cAllocsPerThread);
+            }
+            narena::reset(nscratch::get());
+        }
+#endif
+    }
+
+    UNITTEST_FIXTURE(file)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        static const char* s_path = "test_arena_file.bin";
+
+        struct table_t
+        {
+            u32  m_count;
+            u32* m_items;  // absolute pointer into the arena
+        };
+
+        UNITTEST_TEST(persist_and_reopen)
+        {
+            ::remove(s_path);
+            int_t    relocation = 1;
+            arena_t* arena      = narena::open_file_arena(s_path, 64 * cMB, 64 * cKB, &relocation);
+            CHECK_NOT_NULL(arena);
+            CHECK_EQUAL(0, relocation);
+
+            // the table is larger than the initial commit, so the file grows
+            table_t* table = g_allocate<table_t>(arena);
+            CHECK_EQUAL(narena::file_root(arena), (void*)table);
+            table->m_count = 256 * 1024;
+            table->m_items = g_allocate_array<u32>(arena, table->m_count);
+            for (u32 i = 0; i < table->m_count; ++i)
+                table->m_items[i] = i * 3;
+            const uint_t pos  = narena::current_pos(arena);
+            byte* const  base = narena::base_ptr(arena);
+            narena::destroy(arena);
+
+            arena = narena::open_file_arena(s_path, 64 * cMB, 64 * cKB, &relocation);
+            CHECK_NOT_NULL(arena);
+            CHECK_EQUAL(pos, narena::current_pos(arena));
+            CHECK_EQUAL(narena::base_ptr(arena) - base, relocation);
+
+            table          = (table_t*)narena::file_root(arena);
+            table->m_items = (u32*)((byte*)table->m_items + relocation);
+            CHECK_EQUAL(256 * 1024, table->m_count);
+            bool ok = true;
+            for (u32 i = 0; i < table->m_count; ++i)
+                ok = ok && table->m_items[i] == i * 3;
+            CHECK_TRUE(ok);
+
+            // continue allocating where the arena left off
+            u32* more = g_allocate_array<u32>(arena, 16);
+            CHECK_TRUE((byte*)more >= narena::base_ptr(arena) + pos);
+            narena::destroy(arena);
+            ::remove(s_path);
+        }
+
+        UNITTEST_TEST(relocated_base)
+        {
+            ::remove(s_path);
+            arena_t* arena = narena::open_file_arena(s_path, 16 * cMB, 64 * cKB);
+            CHECK_NOT_NULL(arena);
+            table_t* table = g_allocate<table_t>(arena);
+            table->m_count = 1000;
+            table->m_items = g_allocate_array<u32>(arena, table->m_count);
+            for (u32 i = 0; i < table->m_count; ++i)
+                table->m_items[i] = i + 7;
+            byte* const base = narena::base_ptr(arena);
+            narena::destroy(arena);
+
+            // occupy the previous address range so that the file has to be mapped elsewhere
+            void* blocker = v_alloc_reserve_at(base, 16 * cMB);
+            CHECK_EQUAL((void*)base, blocker);
+
+            int_t relocation = 0;
+            arena            = narena::open_file_arena(s_path, 16 * cMB, 64 * cKB, &relocation);
+            CHECK_NOT_NULL(arena);
+            CHECK_NOT_EQUAL((void*)base, (void*)narena::base_ptr(arena));
+            CHECK_EQUAL(narena::base_ptr(arena) - base, relocation);
+
+            table      = (table_t*)narena::file_root(arena);
+            u32* items = (u32*)((byte*)table->m_items + relocation);
+            CHECK_EQUAL(7, items[0]);
+            CHECK_EQUAL(1006, items[999]);
+            narena::destroy(arena);
+            v_alloc_release(blocker, 16 * cMB);
+            ::remove(s_path);
+        }
+
+        UNITTEST_TEST(rejects_other_files)
+        {
+            FILE* f = ::fopen(s_path, "wb");
+            ::fputs("not an arena", f);
+            ::fclose(f);
+            CHECK_NULL(narena::open_file_arena(s_path, 16 * cMB, 64 * cKB));
+            ::remove(s_path);
+        }
+    }
+
+    UNITTEST_FIXTURE(numa)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(node_arena)
+        {
+            const u32 num_nodes = v_numa_num_nodes();
+            CHECK_TRUE(num_nodes >= 1 && num_nodes <= cNUMA_MAX_NODES);
+            const s32 node = v_numa_current_node();
+            CHECK_TRUE(node >= 0 && (u32)node < num_nodes);
+
+            arena_t* arena = narena::new_arena(16 * cMB, 64 * cKB, VMEM_PAGES_DEFAULT, node);
+            CHECK_NOT_NULL(arena);
+            u32* array = g_allocate_array<u32>(arena, 1024 * 1024);
+            CHECK_NOT_NULL(array);
+            for (u32 i = 0; i < 1024 * 1024; ++i)
+                array[i] = i;
+            CHECK_EQUAL(1024 * 1024 - 1, array[1024 * 1024 - 1]);
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(local_arena)
+        {
+            numa_arenas_t set;
+            CHECK_TRUE(narena::new_numa_arenas(&set, 16 * cMB, 64 * cKB));
+            CHECK_EQUAL(v_numa_num_nodes(), set.m_num_nodes);
+
+            arena_t* arena = narena::local_arena(&set);
+            CHECK_NOT_NULL(arena);
+            CHECK_TRUE(arena == set.m_arenas[0] || set.m_num_nodes > 1);
+            void* ptr = narena::alloc_concurrent(arena, 1000);
+            CHECK_NOT_NULL(ptr);
+            CHECK_TRUE(narena::within_committed(arena, ptr));
+
+            narena::destroy(&set);
+            CHECK_EQUAL(0, set.m_num_nodes);
+        }
+
+#ifdef CCORE_BENCHMARKS
+        // Read bandwidth of memory bound to the node of the calling thread against memory bound to another node, with a
+        // single node both are local.
+        static double s_read_bandwidth(s32 node)
+        {
+            const uint_t size  = 64 * cMB;
+            arena_t*     arena = narena::new_arena(size, size, VMEM_PAGES_DEFAULT, node);
+            u64*         data  = (u64*)narena::alloc(arena, size);
+            const uint_t count = size / sizeof(u64);
+            for (uint_t i = 0; i < count; ++i)
+                data[i] = i;
+
+            u64       sum   = 0;
+            const u64 start = ntest::time_ns();
+            for (s32 pass = 0; pass < 4; ++pass)
+                for (uint_t i = 0; i < count; ++i)
+                    sum += data[i];
+            const u64 duration = ntest::time_ns() - start;
+            CHECK_NOT_EQUAL(0, sum);
+
+            narena::destroy(arena);
+            return (double)(4 * size) / (double)duration;
+        }
+
+        UNITTEST_TEST(benchmark)
+        {
+            const u32    num_nodes   = v_numa_num_nodes();
+            const s32    local_node  = v_numa_current_node();
+            const s32    remote_node = (s32)(((u32)local_node + 1) % num_nodes);
+            const double local       = s_read_bandwidth(local_node);
+            const double remote      = s_read_bandwidth(remote_node);
+            printf("numa read bandwidth, %d nodes: local (node %d) %5.2f GB/s, remote (node %d) %5.2f GB/s\n", (s32)num_nodes, local_node, local, remote_node, remote);
+        }
+#endif
+    }
+
+    UNITTEST_FIXTURE(snapshot)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        static bool s_check_values(u32 const* values, u32 count, u32 add)
+        {
+            bool ok = true;
+            for (u32 i = 0; i < count; ++i)
+                ok = ok && values[i] == i + add;
+            return ok;
+        }
+
+        UNITTEST_TEST(fork_cow_arena)
+        {
+            const u32 count  = 256 * 1024;
+            arena_t*  arena  = narena::new_cow_arena(64 * cMB, 64 * cKB);
+            u32*      values = g_allocate_array<u32>(arena, count);
+            CHECK_TRUE((void*)values == narena::file_root(arena));
+            for (u32 i = 0; i < count; ++i)
+                values[i] = i;
+
+            arena_snapshot_t snapshot;
+            CHECK_TRUE(narena::snapshot(arena, snapshot));
+            arena_t* a = narena::fork(snapshot);
+            arena_t* b = narena::fork(snapshot);
+            narena::release(snapshot);  // the forks keep the content alive
+            CHECK_NOT_NULL(a);
+            CHECK_NOT_NULL(b);
+            CHECK_EQUAL(narena::current_pos(arena), narena::current_pos(a));
+
+            // every arena mutates its own copy
+            u32* a_values = (u32*)narena::file_root(a);
+            u32* b_values = (u32*)narena::file_root(b);
+            for (u32 i = 0; i < count; ++i)
+                a_values[i] += 1;
+            for (u32 i = 0; i < count; i += 1024)
+                b_values[i] = 0;
+            values[0] = 12345;
+            CHECK_TRUE(s_check_values(a_values, count, 1));
+            CHECK_EQUAL(0, b_values[0]);
+            CHECK_EQUAL(1025, b_values[1025]);
+            CHECK_EQUAL(0, b_values[1024]);
+            CHECK_EQUAL(12345, values[0]);
+            CHECK_EQUAL(1, values[1]);
+            CHECK_EQUAL(count - 1, values[count - 1]);
+
+            // a fork can grow beyond the snapshot
+            u32* more = g_allocate_array<u32>(a, count);
+            CHECK_NOT_NULL(more);
+            more[count - 1] = 7;
+            CHECK_EQUAL(7, more[count - 1]);
+
+            narena::destroy(a);
+            CHECK_EQUAL(1, b_values[1]);
+            narena::destroy(b);
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(cow_arena_releases_pages)
+        {
+            const u32 count  = 1024 * 1024;
+            arena_t*  arena  = narena::new_cow_arena(64 * cMB, 64 * cKB);
+            u32*      values = g_allocate_array<u32>(arena, count);
+            for (u32 i = 0; i < count; ++i)
+                values[i] = i + 1;
+
+            // the released pages are gone from the memory file, when they are committed again they read as zero
+            vmem_decommit_policy_t policy;
+            v_decommit_policy_init(&policy, VMEM_DECOMMIT_EAGER);
+            narena::reset(arena, &policy);
+            CHECK_TRUE(narena::committed_size(arena) < count * sizeof(u32));
+            u32* again = g_allocate_array<u32>(arena, count);
+            CHECK_TRUE(again == values);
+            bool zero = true;
+            for (u32 i = (u32)(narena::page_size(arena) / sizeof(u32)); i < count; i += 1024)  // the page with the header stays
+                zero = zero && again[i] == 0;
+            CHECK_TRUE(zero);
+
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(fork_plain_arena)
+        {
+            const u32 count  = 64 * 1024;
+            arena_t*  arena  = narena::new_arena(16 * cMB, 64 * cKB);
+            u32*      values = g_allocate_array<u32>(arena, count);
+            for (u32 i = 0; i < count; ++i)
+                values[i] = i;
+
+            // the pages of a plain arena are copied once, the second snapshot is of an arena that is already private
+            arena_snapshot_t first;
+            CHECK_TRUE(narena::snapshot(arena, first));
+            for (u32 i = 0; i < count; ++i)
+                values[i] += 2;
+            arena_snapshot_t second;
+            CHECK_TRUE(narena::snapshot(arena, second));
+            values[0] = 0;
+
+            arena_t* a = narena::fork(first);
+            arena_t* b = narena::fork(second);
+            narena::release(first);
+            narena::release(second);
+            CHECK_TRUE(s_check_values((u32*)narena::base_ptr(a), count, 0));
+            CHECK_TRUE(s_check_values((u32*)narena::base_ptr(b), count, 2));
+            CHECK_EQUAL(0, values[0]);
+
+            narena::destroy(a);
+            narena::destroy(b);
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(unsupported)
+        {
+            arena_snapshot_t snapshot;
+            arena_t*         chained = narena::new_chained_arena(1 * cMB, 64 * cKB);
+            CHECK_FALSE(narena::snapshot(chained, snapshot));
+            CHECK_NULL(narena::fork(snapshot));
+            narena::destroy(chained);
+
+            const char* path = "test_arena_snapshot.bin";
+            ::remove(path);
+            arena_t* file = narena::open_file_arena(path, 1 * cMB, 64 * cKB);
+            CHECK_NOT_NULL(file);
+            CHECK_FALSE(narena::snapshot(file, snapshot));
+            narena::destroy(file);
+            ::remove(path);
+        }
+
+#ifdef CCORE_BENCHMARKS
+        // Clone a 'size' arena and write to 1 of every 'stride' pages of the clone, a fork only copies the pages that
+        // are written while a plain clone copies everything up front.
+        static const uint_t cCloneSize = 128 * cMB;
+
+        static u64 s_clone_run(arena_t* source, arena_snapshot_t const* snapshot, u32 stride)
+        {
+            const uint_t page  = narena::page_size(source);
+            const u64    start = ntest::time_ns();
+            arena_t*     clone = nullptr;
+            if (snapshot != nullptr)
+            {
+                clone = narena::fork(*snapshot);
+            }
+            else
+            {
+                clone = narena::new_arena(cCloneSize + page, cCloneSize + page);
+                g_memcpy(narena::alloc(clone, narena::current_pos(source)), narena::base_ptr(source), narena::current_pos(source));
+            }
+            for (uint_t offset = page; offset < cCloneSize; offset += page * stride)
+                narena::base_ptr(clone)[offset] += 1;
+            narena::destroy(clone);
+            return ntest::time_ns() - start;
+        }
+
+        UNITTEST_TEST(benchmark)
+        {
+            arena_t* arena = narena::new_cow_arena(cCloneSize + cMB, cCloneSize);
+            u64*     data  = (u64*)narena::alloc(arena, cCloneSize);
+            for (uint_t i = 0; i < cCloneSize / sizeof(u64); ++i)
+                data[i] = i;
+
+            arena_snapshot_t snapshot;
+            CHECK_TRUE(narena::snapshot(arena, snapshot));
+            for (u32 stride = 1; stride <= 1024; stride *= 32)
+            {
+                const u64 fork_ns = s_clone_run(arena, &snapshot, stride);
+                const u64 copy_ns = s_clone_run(arena, nullptr, stride);
+                printf("arena clone of %d MB, writing 1/%-4d of the pages: fork %7.2f ms, memcpy %7.2f ms\n", (s32)(cCloneSize / cMB), (s32)stride, (double)fork_ns / 1e6, (double)copy_ns / 1e6);
+            }
+            narena::release(snapshot);
+            narena::destroy(arena);
+        }
+#endif
     }
 }
 UNITTEST_SUITE_END
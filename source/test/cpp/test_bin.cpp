@@ -1,11 +1,14 @@
 #include "ccore/c_target.h"
 #include "ccore/c_allocator.h"
+#include "ccore/c_atomic.h"
 #include "ccore/c_bin.h"
 #include "ccore/c_memory.h"
 #include "ccore/c_random.h"
 
 #include "cunittest/cunittest.h"
 
+#include "test_thread.h"
+
 using namespace ncore;
 
 UNITTEST_SUITE_BEGIN(bin)
@@ -112,6 +115,112 @@ UNITTEST_SUITE_BEGIN(bin)
             bin_destroy(&bin);
         }
 
+        UNITTEST_TEST(alloc_n_free_n)
+        {
+            bin32_t bin;
+            bin_setup(&bin, 64, 4096);
+
+            void** ptrs = g_allocate_array<void*>(Allocator, 4096);
+            void** odd  = g_allocate_array<void*>(Allocator, 500);
+
+            CHECK_EQUAL((u32)1000, bin_alloc_n(&bin, ptrs, 1000));
+            for (u32 i = 0; i < 500; ++i)
+                odd[i] = ptrs[i * 2 + 1];
+            bin_free_n(&bin, odd, 500);
+            CHECK_EQUAL((u32)500, bin_size(&bin));
+
+            // compact the live items to the front, then reuse the 500 free slots and take 200 fresh ones
+            for (u32 i = 0; i < 500; ++i)
+                ptrs[i] = ptrs[i * 2];
+            CHECK_EQUAL((u32)700, bin_alloc_n(&bin, ptrs + 500, 700));
+            CHECK_EQUAL((u32)1200, bin_size(&bin));
+
+            // the bin holds 4096 items, the request is capped
+            CHECK_EQUAL((u32)(4096 - 1200), bin_alloc_n(&bin, ptrs + 1200, 10000));
+            CHECK_EQUAL((u32)4096, bin_size(&bin));
+            CHECK_EQUAL((u32)0, bin_alloc_n(&bin, odd, 1));
+
+            // every item is unique, writing its index does not overwrite any other item
+            for (u32 i = 0; i < 4096; ++i)
+                *(u32*)ptrs[i] = i;
+            bool unique = true;
+            for (u32 i = 0; i < 4096; ++i)
+                unique = unique && *(u32*)ptrs[i] == i;
+            CHECK_TRUE(unique);
+
+            bin_free_n(&bin, ptrs, 4096);
+            CHECK_EQUAL((u32)0, bin_size(&bin));
+            CHECK_EQUAL((u32)4096, bin_alloc_n(&bin, ptrs, 4096));
+            bin_free_n(&bin, ptrs, 4096);
+
+            g_deallocate_array(Allocator, odd);
+            g_deallocate_array(Allocator, ptrs);
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(generational_index)
+        {
+            bin32_t bin;
+            bin_setup(&bin, 16, 4096);
+
+            void* ptrs[100];
+            u32   gidx[100];
+            CHECK_EQUAL(100u, bin_alloc_n(&bin, ptrs, 100));
+            for (u32 i = 0; i < 100; ++i)
+                gidx[i] = bin_ptr2gidx(&bin, ptrs[i]);
+            CHECK_EQUAL(ptrs[42], bin_gidx2ptr(&bin, gidx[42]));
+            CHECK_EQUAL(c_null_gidx32, bin_ptr2gidx(&bin, (byte*)ptrs[99] + 16));
+            CHECK_NULL(bin_gidx2ptr(&bin, c_null_gidx32));
+
+            const u64 gidx64 = bin_ptr2gidx64(&bin, ptrs[42]);
+            CHECK_EQUAL(ptrs[42], bin_gidx2ptr(&bin, gidx64));
+
+            // the item is freed and allocated again at the same address, the old generational indices are stale
+            bin_free(&bin, ptrs[42]);
+            CHECK_EQUAL(ptrs[42], bin_alloc(&bin));
+            CHECK_NULL(bin_gidx2ptr(&bin, gidx[42]));
+            CHECK_NULL(bin_gidx2ptr(&bin, gidx64));
+
+            bin_free_n(&bin, ptrs + 50, 50);
+            void* resolved[100];
+            CHECK_EQUAL(49u, bin_gidx2ptr_n(&bin, gidx, resolved, 100));
+            CHECK_EQUAL(ptrs[0], resolved[0]);
+            CHECK_NULL(resolved[42]);
+            CHECK_NULL(resolved[50]);
+
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(iterate_used)
+        {
+            bin32_t bin;
+            bin_setup(&bin, 16, 8192);
+
+            void** ptrs = g_allocate_array<void*>(Allocator, 5000);
+            CHECK_EQUAL(5000u, bin_alloc_n(&bin, ptrs, 5000));
+            for (u32 i = 0; i < 5000; ++i)
+            {
+                *(u32*)ptrs[i] = i;
+                if (!((i >= 62 && i < 130) || i == 4999))
+                    bin_free(&bin, ptrs[i]);
+            }
+
+            bin_used_iter_t it;
+            bin_iter_begin(&bin, it);
+            CHECK_TRUE(bin_iter_next(&bin, it));
+            CHECK_EQUAL(62u, it.m_index);
+            CHECK_EQUAL(68u, it.m_count);
+            CHECK_EQUAL(ptrs[62], (void*)it.m_items);
+            CHECK_EQUAL(62u, *(u32*)it.m_items);
+            CHECK_TRUE(bin_iter_next(&bin, it));
+            CHECK_EQUAL(4999u, it.m_index);
+            CHECK_EQUAL(1u, it.m_count);
+            CHECK_FALSE(bin_iter_next(&bin, it));
+
+            g_deallocate_array(Allocator, ptrs);
+            bin_destroy(&bin);
+        }
+
         UNITTEST_TEST(a_lot_more_alloc_free)
         {
             bin32_t bin;
@@ -236,6 +345,49 @@ UNITTEST_SUITE_BEGIN(bin)
             bin_destroy(&bin);
         }
 
+        UNITTEST_TEST(alloc_n_free_n)
+        {
+            bin16_t bin;
+            bin_setup(&bin, 64, 4096);
+
+            void** ptrs = g_allocate_array<void*>(Allocator, 4096);
+            void** odd  = g_allocate_array<void*>(Allocator, 500);
+
+            CHECK_EQUAL((u32)1000, bin_alloc_n(&bin, ptrs, 1000));
+            for (u32 i = 0; i < 500; ++i)
+                odd[i] = ptrs[i * 2 + 1];
+            bin_free_n(&bin, odd, 500);
+            CHECK_EQUAL((u32)500, bin_size(&bin));
+
+            // compact the live items to the front, then reuse the 500 free slots and take 200 fresh ones
+            for (u32 i = 0; i < 500; ++i)
+                ptrs[i] = ptrs[i * 2];
+            CHECK_EQUAL((u32)700, bin_alloc_n(&bin, ptrs + 500, 700));
+            CHECK_EQUAL((u32)1200, bin_size(&bin));
+
+            // the bin holds 4096 items, the request is capped
+            CHECK_EQUAL((u32)(4096 - 1200), bin_alloc_n(&bin, ptrs + 1200, 10000));
+            CHECK_EQUAL((u32)4096, bin_size(&bin));
+            CHECK_EQUAL((u32)0, bin_alloc_n(&bin, odd, 1));
+
+            // every item is unique, writing its index does not overwrite any other item
+            for (u32 i = 0; i < 4096; ++i)
+                *(u32*)ptrs[i] = i;
+            bool unique = true;
+            for (u32 i = 0; i < 4096; ++i)
+                unique = unique && *(u32*)ptrs[i] == i;
+            CHECK_TRUE(unique);
+
+            bin_free_n(&bin, ptrs, 4096);
+            CHECK_EQUAL((u32)0, bin_size(&bin));
+            CHECK_EQUAL((u32)4096, bin_alloc_n(&bin, ptrs, 4096));
+            bin_free_n(&bin, ptrs, 4096);
+
+            g_deallocate_array(Allocator, odd);
+            g_deallocate_array(Allocator, ptrs);
+            bin_destroy(&bin);
+        }
+
         UNITTEST_TEST(a_lot_more_alloc_free)
         {
             bin16_t bin;
@@ -270,5 +422,125 @@ UNITTEST_SUITE_BEGIN(bin)
             bin_destroy(&bin);
         }
     }
+
+    UNITTEST_FIXTURE(mbin32)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(alloc_free_flush)
+        {
+            mbin32_t bin;
+            bin_setup(&bin, 64, 64 * cKB, 4);
+
+            void* ptrs[100];
+            for (u32 i = 0; i < 100; ++i)
+            {
+                ptrs[i] = bin_alloc(&bin);
+                CHECK_NOT_NULL(ptrs[i]);
+                for (u32 j = 0; j < i; ++j)
+                    CHECK_NOT_EQUAL(ptrs[j], ptrs[i]);
+            }
+            CHECK_EQUAL(100, bin_size(&bin) + 0);
+
+            for (u32 i = 0; i < 100; ++i)
+                bin_free(&bin, ptrs[i]);
+            CHECK_EQUAL(0, bin_size(&bin));
+            CHECK_TRUE(bin_cached(&bin) > 0);
+
+            // the most recently freed item is handed out first
+            void* ptr = bin_alloc(&bin);
+            CHECK_EQUAL(ptrs[99], ptr);
+            bin_free(&bin, ptr);
+
+            bin_flush(&bin);
+            CHECK_EQUAL(0, bin_cached(&bin));
+            CHECK_EQUAL(0, bin_size(&bin));
+
+            bin_destroy(&bin);
+            CHECK_NULL(bin.m_memory);
+        }
+
+        UNITTEST_TEST(full)
+        {
+            mbin32_t bin;
+            bin_setup(&bin, 32, 64, 1);
+
+            void* ptrs[64];
+            for (u32 i = 0; i < 64; ++i)
+                ptrs[i] = bin_alloc(&bin);
+            CHECK_NULL(bin_alloc(&bin));
+            for (u32 i = 0; i < 64; ++i)
+                bin_free(&bin, ptrs[i]);
+            bin_flush(&bin);
+            CHECK_EQUAL(0, bin_size(&bin));
+            bin_destroy(&bin);
+        }
+
+        static const s32 cThreads = 4;
+        static const s32 cItems   = 2048;
+        static const s32 cRounds  = 64;
+
+        struct shared_t
+        {
+            mbin32_t     m_bin;
+            u32 volatile m_errors;
+        };
+
+        static void s_thread(void* arg, s32 index)
+        {
+            shared_t* shared = (shared_t*)arg;
+            u32*      items[cItems];
+            for (s32 round = 0; round < cRounds; ++round)
+            {
+                for (s32 i = 0; i < cItems; ++i)
+                {
+                    items[i] = (u32*)bin_alloc(&shared->m_bin);
+                    if (items[i] == nullptr)
+                    {
+                        natomic::fetch_add(&shared->m_errors, 1u);
+                        return;
+                    }
+                    items[i][0] = ((u32)index << 16) | (u32)i;
+                }
+                for (s32 i = 0; i < cItems; ++i)
+                {
+                    if (items[i][0] != (((u32)index << 16) | (u32)i))
+                        natomic::fetch_add(&shared->m_errors, 1u);
+                    bin_free(&shared->m_bin, items[i]);
+                }
+            }
+        }
+
+        UNITTEST_TEST(threads)
+        {
+            shared_t shared;
+            shared.m_errors = 0;
+            bin_setup(&shared.m_bin, 16, cThreads * cItems + 1024);
+            ntest::run_threads(cThreads, s_thread, &shared);
+
+            CHECK_EQUAL(0, shared.m_errors);
+            bin_flush(&shared.m_bin);
+            CHECK_EQUAL(0, bin_size(&shared.m_bin));
+            bin_destroy(&shared.m_bin);
+        }
+
+#ifdef CCORE_BENCHMARKS
+        UNITTEST_TEST(benchmark)
+        {
+            shared_t shared;
+            shared.m_errors = 0;
+            bin_setup(&shared.m_bin, 16, cThreads * cItems + 1024);
+
+            const u64 start = ntest::time_ns();
+            ntest::run_threads(cThreads, s_thread, &shared);
+            const u64 duration = ntest::time_ns() - start;
+            printf("mbin32, %d threads: %.1f ns per alloc+free\n", cThreads, (double)duration / (cThreads * cItems * cRounds));
+
+            CHECK_EQUAL(0, shared.m_errors);
+            bin_destroy(&shared.m_bin);
+        }
+#endif
+    }
 }
 UNITTEST_SUITE_END
@@ -1,8 +1,14 @@
+#include "ccore/c_target.h"
+#include "ccore/c_arena.h"
+#include "ccore/c_atomic.h"
 #include "ccore/c_bitvec.h"
 #include "ccore/c_memory.h"
+#include "ccore/c_random.h"
 
 #include "cunittest/cunittest.h"
 
+#include "test_thread.h"
+
 using namespace ncore;
 
 UNITTEST_SUITE_BEGIN(bitvec)
@@ -118,6 +124,36 @@ UNITTEST_SUITE_BEGIN(bitvec)
             CHECK_EQUAL((s32)-1, nbitvec12::find_free_last(&bin0, bin1, maxbits));
         }
 
+        UNITTEST_TEST(find_free_and_remove_n)
+        {
+            u64       bin0;
+            u64       bin1[64];
+            u32 const bits[] = {5, 6, 7, 64, 129};
+            u32       found[8];
+
+            g_memclr(&bin0, sizeof(bin0));
+            g_memclr(bin1, sizeof(bin1));
+
+            const u32 maxbits = 130;
+
+            CHECK_EQUAL((u32)0, nbitvec12::find_free_and_remove_n(&bin0, bin1, maxbits, found, 8));
+
+            nbitvec12::set_free_n(&bin0, bin1, maxbits, bits, DARRAYSIZE(bits));
+            for (u32 i = 0; i < DARRAYSIZE(bits); ++i)
+                CHECK_TRUE(nbitvec12::get(&bin0, bin1, maxbits, bits[i]));
+
+            CHECK_EQUAL((u32)2, nbitvec12::find_free_and_remove_n(&bin0, bin1, maxbits, found, 2));
+            CHECK_EQUAL((u32)5, found[0]);
+            CHECK_EQUAL((u32)6, found[1]);
+
+            CHECK_EQUAL((u32)3, nbitvec12::find_free_and_remove_n(&bin0, bin1, maxbits, found, 8));
+            CHECK_EQUAL((u32)7, found[0]);
+            CHECK_EQUAL((u32)64, found[1]);
+            CHECK_EQUAL((u32)129, found[2]);
+            CHECK_EQUAL((s32)-1, nbitvec12::find_free(&bin0, bin1, maxbits));
+            CHECK_EQUAL((s32)-1, nbitvec12::find_free_last(&bin0, bin1, maxbits));
+        }
+
         UNITTEST_TEST(find_free_last_and_remove)
         {
             u64       bin0;
@@ -247,6 +283,37 @@ UNITTEST_SUITE_BEGIN(bitvec)
             CHECK_EQUAL((s32)-1, nbitvec18::find_free(&bin0, bin1, bin2, maxbits));
         }
 
+        UNITTEST_TEST(find_free_and_remove_n)
+        {
+            u64       bin0;
+            u64       bin1[64];
+            u64       bin2[128];
+            u32 const bits[] = {3, 65, 66, 4096, 4999};
+            u32       found[8];
+
+            g_memclr(&bin0, sizeof(bin0));
+            g_memclr(bin1, sizeof(bin1));
+            g_memclr(bin2, sizeof(bin2));
+
+            const u32 maxbits = 5000;
+
+            nbitvec18::set_free_n(&bin0, bin1, bin2, maxbits, bits, DARRAYSIZE(bits));
+            CHECK_EQUAL((s32)3, nbitvec18::find_free(&bin0, bin1, bin2, maxbits));
+            CHECK_EQUAL((s32)4999, nbitvec18::find_free_last(&bin0, bin1, bin2, maxbits));
+
+            CHECK_EQUAL((u32)5, nbitvec18::find_free_and_remove_n(&bin0, bin1, bin2, maxbits, found, 8));
+            for (u32 i = 0; i < DARRAYSIZE(bits); ++i)
+                CHECK_EQUAL(bits[i], found[i]);
+            CHECK_EQUAL((s32)-1, nbitvec18::find_free(&bin0, bin1, bin2, maxbits));
+
+            // freeing part of the bits again only makes those bits available
+            nbitvec18::set_free_n(&bin0, bin1, bin2, maxbits, &bits[2], 2);
+            CHECK_EQUAL((u32)2, nbitvec18::find_free_and_remove_n(&bin0, bin1, bin2, maxbits, found, 8));
+            CHECK_EQUAL((u32)66, found[0]);
+            CHECK_EQUAL((u32)4096, found[1]);
+            CHECK_EQUAL((s32)-1, nbitvec18::find_free_last(&bin0, bin1, bin2, maxbits));
+        }
+
         UNITTEST_TEST(find_last_and_directional)
         {
             u64       bin0;
@@ -362,13 +429,47 @@ UNITTEST_SUITE_BEGIN(bitvec)
             CHECK_EQUAL((s32)-1, nbitvec24::find_free(&bin0, bin1, bin2, bin3, maxbits));
         }
 
+        UNITTEST_TEST(find_free_and_remove_n)
+        {
+            u64 bin0;
+            u64 bin1[64];
+            u64 bin2[128];
+            u64 bin3[5000];
+            u32 bits[200];
+            u32 found[256];
+
+            g_memclr(&bin0, sizeof(bin0));
+            g_memclr(bin1, sizeof(bin1));
+            g_memclr(bin2, sizeof(bin2));
+            g_memclr(bin3, sizeof(bin3));
+
+            const u32 maxbits = 300000;
+
+            // 100 bits in the first words and 100 bits spread over the upper levels
+            for (u32 i = 0; i < 100; ++i)
+                bits[i] = i + 10;
+            for (u32 i = 0; i < 100; ++i)
+                bits[100 + i] = 200000 + i * 997;
+
+            nbitvec24::set_free_n(&bin0, bin1, bin2, bin3, maxbits, bits, 200);
+            CHECK_EQUAL((s32)10, nbitvec24::find_free(&bin0, bin1, bin2, bin3, maxbits));
+            CHECK_EQUAL((s32)(200000 + 99 * 997), nbitvec24::find_free_last(&bin0, bin1, bin2, bin3, maxbits));
+
+            CHECK_EQUAL((u32)64, nbitvec24::find_free_and_remove_n(&bin0, bin1, bin2, bin3, maxbits, found, 64));
+            CHECK_EQUAL((u32)136, nbitvec24::find_free_and_remove_n(&bin0, bin1, bin2, bin3, maxbits, found + 64, 192));
+            for (u32 i = 0; i < 200; ++i)
+                CHECK_EQUAL(bits[i], found[i]);
+            CHECK_EQUAL((s32)-1, nbitvec24::find_free(&bin0, bin1, bin2, bin3, maxbits));
+            CHECK_EQUAL((u32)0, nbitvec24::find_free_and_remove_n(&bin0, bin1, bin2, bin3, maxbits, found, 8));
+        }
+
         UNITTEST_TEST(find_last_and_directional)
         {
             u64       bin0;
             u64       bin1[64];
             u64       bin2[128];
             u64       bin3[5000];
-            u32 const bits[] = {2, 65, 262144, 262146, 299999};
+            u32 const bits[] = {2, 65, 128, 262144, 262146, 299999};
 
             g_memclr(&bin0, sizeof(bin0));
             g_memclr(bin1, sizeof(bin1));
@@ -384,12 +485,14 @@ UNITTEST_SUITE_BEGIN(bitvec)
             CHECK_EQUAL((s32)262146, nbitvec24::find_free_last(&bin0, bin1, bin2, bin3, maxbits));
 
             CHECK_EQUAL((s32)65, nbitvec24::find_free_after(&bin0, bin1, bin2, bin3, maxbits, 2));
-            CHECK_EQUAL((s32)262144, nbitvec24::find_free_after(&bin0, bin1, bin2, bin3, maxbits, 65));
+            CHECK_EQUAL((s32)128, nbitvec24::find_free_after(&bin0, bin1, bin2, bin3, maxbits, 65));
+            CHECK_EQUAL((s32)262144, nbitvec24::find_free_after(&bin0, bin1, bin2, bin3, maxbits, 128));
             CHECK_EQUAL((s32)262146, nbitvec24::find_free_after(&bin0, bin1, bin2, bin3, maxbits, 262144));
             CHECK_EQUAL((s32)-1, nbitvec24::find_free_after(&bin0, bin1, bin2, bin3, maxbits, 262146));
 
             CHECK_EQUAL((s32)262144, nbitvec24::find_free_before(&bin0, bin1, bin2, bin3, maxbits, 262146));
-            CHECK_EQUAL((s32)65, nbitvec24::find_free_before(&bin0, bin1, bin2, bin3, maxbits, 262144));
+            CHECK_EQUAL((s32)128, nbitvec24::find_free_before(&bin0, bin1, bin2, bin3, maxbits, 262144));
+            CHECK_EQUAL((s32)65, nbitvec24::find_free_before(&bin0, bin1, bin2, bin3, maxbits, 128));
             CHECK_EQUAL((s32)2, nbitvec24::find_free_before(&bin0, bin1, bin2, bin3, maxbits, 65));
             CHECK_EQUAL((s32)-1, nbitvec24::find_free_before(&bin0, bin1, bin2, bin3, maxbits, 2));
         }
@@ -418,5 +521,959 @@ UNITTEST_SUITE_BEGIN(bitvec)
             CHECK_EQUAL((s32)-1, nbitvec24::find_free_before(&bin0, bin1, bin2, bin3, maxbits, 262144));
         }
     }
+
+    UNITTEST_FIXTURE(range)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        // a 2 level (u64), 3 level (u32) and 4 level (u64) bit-vector behind one interface, level 0 is bin0
+        struct bv12_t
+        {
+            typedef u64 T;
+            static const u32 cLevels = 2;
+            static void      layout(u32 maxbits, u32* words)
+            {
+                nbitvec::layout64_t l;
+                nbitvec::compute_l2(maxbits, l);
+                words[0] = l.m_bin0;
+                words[1] = l.m_bin1;
+            }
+            static void set_all_free(T** b, u32 maxbits) { nbitvec12::set_all_free(b[0], b[1], maxbits); }
+            static void set_used(T** b, u32 maxbits, u32 bit) { nbitvec12::set_used(b[0], b[1], maxbits, bit); }
+            static s32  find_free_range(T** b, u32 maxbits, u32 n) { return nbitvec12::find_free_range(b[0], b[1], maxbits, n); }
+            static s32  alloc_range(T** b, u32 maxbits, u32 n) { return nbitvec12::alloc_range(b[0], b[1], maxbits, n); }
+            static void free_range(T** b, u32 maxbits, u32 start, u32 n) { nbitvec12::free_range(b[0], b[1], maxbits, start, n); }
+        };
+
+        struct bv15_t
+        {
+            typedef u32 T;
+            static const u32 cLevels = 3;
+            static void      layout(u32 maxbits, u32* words)
+            {
+                nbitvec::layout32_t l;
+                nbitvec::compute_l3(maxbits, l);
+                words[0] = l.m_bin0;
+                words[1] = l.m_bin1;
+                words[2] = l.m_bin2;
+            }
+            static void set_all_free(T** b, u32 maxbits) { nbitvec15::set_all_free(b[0], b[1], b[2], maxbits); }
+            static void set_used(T** b, u32 maxbits, u32 bit) { nbitvec15::set_used(b[0], b[1], b[2], maxbits, bit); }
+            static s32  find_free_range(T** b, u32 maxbits, u32 n) { return nbitvec15::find_free_range(b[0], b[1], b[2], maxbits, n); }
+            static s32  alloc_range(T** b, u32 maxbits, u32 n) { return nbitvec15::alloc_range(b[0], b[1], b[2], maxbits, n); }
+            static void free_range(T** b, u32 maxbits, u32 start, u32 n) { nbitvec15::free_range(b[0], b[1], b[2], maxbits, start, n); }
+        };
+
+        struct bv24_t
+        {
+            typedef u64 T;
+            static const u32 cLevels = 4;
+            static void      layout(u32 maxbits, u32* words)
+            {
+                nbitvec::layout64_t l;
+                nbitvec::compute_l4(maxbits, l);
+                words[0] = l.m_bin0;
+                words[1] = l.m_bin1;
+                words[2] = l.m_bin2;
+                words[3] = l.m_bin3;
+            }
+            static void set_all_free(T** b, u32 maxbits) { nbitvec24::set_all_free(b[0], b[1], b[2], b[3], maxbits); }
+            static void set_used(T** b, u32 maxbits, u32 bit) { nbitvec24::set_used(b[0], b[1], b[2], b[3], maxbits, bit); }
+            static s32  find_free_range(T** b, u32 maxbits, u32 n) { return nbitvec24::find_free_range(b[0], b[1], b[2], b[3], maxbits, n); }
+            static s32  alloc_range(T** b, u32 maxbits, u32 n) { return nbitvec24::alloc_range(b[0], b[1], b[2], b[3], maxbits, n); }
+            static void free_range(T** b, u32 maxbits, u32 start, u32 n) { nbitvec24::free_range(b[0], b[1], b[2], b[3], maxbits, start, n); }
+        };
+
+        // first fit on a plain array of flags
+        static s32 s_first_fit(u8 const* used, u32 maxbits, u32 n)
+        {
+            u32 run = 0;
+            for (u32 i = 0; i < maxbits; ++i)
+            {
+                run = used[i] ? 0 : run + 1;
+                if (run == n)
+                    return (s32)(i + 1 - n);
+            }
+            return -1;
+        }
+
+        // random range allocations and frees on a fragmented bit-vector, compared with first fit on an array of flags
+        template <typename BV>
+        static bool s_test(u32 maxbits, s32 ops)
+        {
+            arena_t* arena        = narena::new_arena(16 * cMB, 64 * cKB);
+            u32      words[4]     = {0, 0, 0, 0};
+            typename BV::T* b[4] = {nullptr, nullptr, nullptr, nullptr};
+            BV::layout(maxbits, words);
+            for (u32 l = 0; l < BV::cLevels; ++l)
+                b[l] = g_allocate_array_and_clear<typename BV::T>(arena, words[l]);
+            u8* used = g_allocate_array_and_clear<u8>(arena, maxbits);
+
+            BV::set_all_free(b, maxbits);
+            xor_random_t rnd(0x1234);
+            for (u32 i = 0; i < maxbits / 16; ++i)
+            {
+                u32 const bit = rnd.rand32() % maxbits;
+                BV::set_used(b, maxbits, bit);
+                used[bit] = 1;
+            }
+
+            bool ok = true;
+            u32  held_start[64];
+            u32  held_count[64];
+            u32  held = 0;
+            for (s32 i = 0; i < ops && ok; ++i)
+            {
+                u32 const r = rnd.rand32();
+                if ((r & 3) != 0 && held < 64)
+                {
+                    u32 const sizes[] = {1, 5, 31, 64, 100, 257, 1000};
+                    u32 const n       = 1 + ((r >> 2) % sizes[(r >> 16) % 7]);
+                    s32 const expect  = s_first_fit(used, maxbits, n);
+                    ok                = ok && BV::find_free_range(b, maxbits, n) == expect;
+                    s32 const start   = BV::alloc_range(b, maxbits, n);
+                    ok                = ok && start == expect;
+                    if (start >= 0)
+                    {
+                        g_memset(used + start, 1, n);
+                        held_start[held]   = (u32)start;
+                        held_count[held++] = n;
+                    }
+                }
+                else if (held > 0)
+                {
+                    u32 const h = (r >> 2) % held;
+                    BV::free_range(b, maxbits, held_start[h], held_count[h]);
+                    g_memclr(used + held_start[h], held_count[h]);
+                    held_start[h] = held_start[--held];
+                    held_count[h] = held_count[held];
+                }
+            }
+
+            // the whole range is only free when the summary levels are right
+            while (held > 0)
+            {
+                held -= 1;
+                BV::free_range(b, maxbits, held_start[held], held_count[held]);
+            }
+            BV::free_range(b, maxbits, 0, maxbits);
+            ok = ok && BV::find_free_range(b, maxbits, maxbits) == 0;
+            ok = ok && BV::alloc_range(b, maxbits, maxbits) == 0 && BV::find_free_range(b, maxbits, 1) == -1;
+            ok = ok && BV::find_free_range(b, maxbits, 0) == -1 && BV::find_free_range(b, maxbits, maxbits + 1) == -1;
+
+            narena::destroy(arena);
+            return ok;
+        }
+
+        UNITTEST_TEST(scan_equal)
+        {
+            // a single mismatch at every position, the vector loop and the word loop have to agree
+            u64  words64[77];
+            u32  words32[77];
+            bool ok = true;
+            for (u32 pos = 0; pos <= 77; ++pos)
+            {
+                for (u32 i = 0; i < 77; ++i)
+                {
+                    words64[i] = (i == pos) ? 0xFFFFFFFF7FFFFFFFull : ~(u64)0;
+                    words32[i] = (i == pos) ? 0x00010000u : 0;
+                }
+                for (u32 from = 0; from < 9; ++from)
+                {
+                    for (u32 to = 70; to <= 77; ++to)
+                    {
+                        u32 const expect = (pos >= from && pos < to) ? pos : to;
+                        ok               = ok && nbitvec::scan_equal(words64, from, to, ~(u64)0) == expect;
+                        ok               = ok && nbitvec::scan_equal(words32, from, to, (u32)0) == expect;
+                    }
+                }
+            }
+            CHECK_TRUE(ok);
+            CHECK_EQUAL(5, nbitvec::scan_equal(words32, 5, 5, (u32)0));
+        }
+
+        UNITTEST_TEST(bitvec12)
+        {
+            CHECK_TRUE(s_test<bv12_t>(4000, 2000));
+            CHECK_TRUE(s_test<bv12_t>(64, 200));
+        }
+
+        UNITTEST_TEST(bitvec15)
+        {
+            CHECK_TRUE(s_test<bv15_t>(30000, 2000));
+            CHECK_TRUE(s_test<bv15_t>(1000, 500));
+        }
+
+        UNITTEST_TEST(bitvec24)
+        {
+            CHECK_TRUE(s_test<bv24_t>(200000, 1000));
+            CHECK_TRUE(s_test<bv24_t>(5000, 500));
+        }
+
+#ifdef CCORE_BENCHMARKS
+        // Latency of find_free and find_free_range on a 4M bit-vector with an increasing number of used bits,
+        // the used bits are spread at random so that at a high occupancy a long run does not exist and the
+        // range search has to visit every word that still has a free bit.
+        UNITTEST_TEST(benchmark)
+        {
+            u32 const maxbits  = 1 << 22;
+            arena_t*  arena    = narena::new_arena(64 * cMB, 64 * cKB);
+            u32       words[4] = {0, 0, 0, 0};
+            bv24_t::T* b[4];
+            bv24_t::layout(maxbits, words);
+            for (u32 l = 0; l < 4; ++l)
+                b[l] = g_allocate_array_and_clear<bv24_t::T>(arena, words[l]);
+
+            u32 const per_mille[] = {0, 500, 900, 990, 999};
+            for (u32 p = 0; p < DARRAYSIZE(per_mille); ++p)
+            {
+                bv24_t::set_all_free(b, maxbits);
+                xor_random_t rnd(0xBEEF);
+                for (u32 bit = 0; bit < maxbits; ++bit)
+                {
+                    if ((rnd.rand32() % 1000) < per_mille[p])
+                        bv24_t::set_used(b, maxbits, bit);
+                }
+
+                u32 const lengths[] = {1, 64, 4096};
+                u64       ns[3];
+                s32       found[3];
+                for (u32 l = 0; l < 3; ++l)
+                {
+                    s32 const rounds = 64;
+                    u64 const start  = ntest::time_ns();
+                    for (s32 r = 0; r < rounds; ++r)
+                        found[l] = bv24_t::find_free_range(b, maxbits, lengths[l]);
+                    ns[l] = (ntest::time_ns() - start) / rounds;
+                }
+                printf("bitvec find_free_range, %4.1f%% used: n=1 %8llu ns (%d), n=64 %8llu ns (%d), n=4096 %8llu ns (%d)\n", per_mille[p] / 10.0, (unsigned long long)ns[0], found[0], (unsigned long long)ns[1], found[1],
+                       (unsigned long long)ns[2], found[2]);
+            }
+
+            // the full words of a free run, compared by scan_equal and one word at a time
+            bv24_t::set_all_free(b, maxbits);
+            u32 const leaf_words = words[3];
+            u32       end        = 0;
+            u64       start      = ntest::time_ns();
+            for (s32 r = 0; r < 64; ++r)
+                end += nbitvec::scan_equal(b[3], 0, leaf_words, ~(u64)0);
+            u64 const scan_ns = (ntest::time_ns() - start) / 64;
+            start             = ntest::time_ns();
+            for (s32 r = 0; r < 64; ++r)
+            {
+                u64 const volatile* w = b[3];
+                u32                 i = 0;
+                while (i < leaf_words && w[i] == ~(u64)0)
+                    i += 1;
+                end += i;
+            }
+            u64 const word_ns = (ntest::time_ns() - start) / 64;
+            printf("bitvec scan of %u full words: scan_equal %llu ns, word by word %llu ns (%u)\n", leaf_words, (unsigned long long)scan_ns, (unsigned long long)word_ns, end / 128);
+
+            narena::destroy(arena);
+        }
+#endif
+    }
+
+    UNITTEST_FIXTURE(bulk)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        // builds the leaf and the summary levels of a bit-vector from an array of flags
+        static void s_build(u64* data, nbitvec::layout64_t const& l, u8 const* flags)
+        {
+            u32 const sizes[] = {l.m_bin0, l.m_bin1, l.m_bin2, l.m_bin3};
+            u64*      levels[4];
+            u64*      ptr = data;
+            for (u32 i = 0; i <= l.m_levels; ++i)
+            {
+                levels[i] = ptr;
+                ptr += sizes[i];
+            }
+            g_memclr(data, nbitvec::sizeof_data(l) * sizeof(u64));
+            for (u32 bit = 0; bit < l.m_maxbits; ++bit)
+            {
+                if (flags[bit])
+                    levels[l.m_levels][bit >> 6] |= (u64)1 << (bit & 63);
+            }
+            for (s32 i = (s32)l.m_levels; i > 0; --i)
+            {
+                for (u32 w = 0; w < sizes[i]; ++w)
+                {
+                    if (levels[i][w] != 0)
+                        levels[i - 1][w >> 6] |= (u64)1 << (w & 63);
+                }
+            }
+        }
+
+        // blocks of 4096 bits that are empty, sparse, half full, dense or full
+        static void s_random_flags(xor_random_t& rnd, u8* flags, u32 maxbits)
+        {
+            u32 const per_mille[] = {0, 1, 500, 999, 1000};
+            for (u32 block = 0; block < maxbits; block += 4096)
+            {
+                u32 const density = per_mille[rnd.rand32() % DARRAYSIZE(per_mille)];
+                for (u32 bit = block; bit < maxbits && bit < (block + 4096); ++bit)
+                    flags[bit] = (rnd.rand32() % 1000) < density ? 1 : 0;
+            }
+        }
+
+        static bool s_test(u32 maxbits)
+        {
+            arena_t*            arena = narena::new_arena(64 * cMB, 64 * cKB);
+            nbitvec::layout64_t l;
+            nbitvec::compute(maxbits, l);
+            u32 const size   = nbitvec::sizeof_data(l);
+            u64*      a      = g_allocate_array_and_clear<u64>(arena, size);
+            u64*      b      = g_allocate_array_and_clear<u64>(arena, size);
+            u64*      expect = g_allocate_array_and_clear<u64>(arena, size);
+            u8*       fa     = g_allocate_array_and_clear<u8>(arena, maxbits);
+            u8*       fb     = g_allocate_array_and_clear<u8>(arena, maxbits);
+            u8*       fr     = g_allocate_array_and_clear<u8>(arena, maxbits);
+
+            bool         ok = true;
+            xor_random_t rnd(maxbits);
+            for (s32 round = 0; round < 4 && ok; ++round)
+            {
+                s_random_flags(rnd, fa, maxbits);
+                s_random_flags(rnd, fb, maxbits);
+                s_build(b, l, fb);
+                for (s32 op = 0; op < 4; ++op)
+                {
+                    u32 count = 0;
+                    for (u32 bit = 0; bit < maxbits; ++bit)
+                    {
+                        switch (op)
+                        {
+                            case 0: fr[bit] = fa[bit] & fb[bit]; break;
+                            case 1: fr[bit] = fa[bit] | fb[bit]; break;
+                            case 2: fr[bit] = fa[bit] & (fb[bit] ^ 1); break;
+                            default: fr[bit] = fa[bit] ^ fb[bit]; break;
+                        }
+                        count += fr[bit];
+                    }
+
+                    s_build(a, l, fa);
+                    switch (op)
+                    {
+                        case 0: nbitvec::bulk_and(a, b, l); break;
+                        case 1: nbitvec::bulk_or(a, b, l); break;
+                        case 2: nbitvec::bulk_andnot(a, b, l); break;
+                        default: nbitvec::bulk_xor(a, b, l); break;
+                    }
+
+                    // leaf and summary levels have to be identical to a bit-vector built from the result
+                    s_build(expect, l, fr);
+                    ok = ok && g_memequal(a, expect, size * sizeof(u64));
+                    ok = ok && nbitvec::popcount(a, l) == count;
+                    ok = ok && nbitvec::any(a, l) == (count > 0);
+                }
+            }
+
+            narena::destroy(arena);
+            return ok;
+        }
+
+        UNITTEST_TEST(operations)
+        {
+            CHECK_TRUE(s_test(50));
+            CHECK_TRUE(s_test(4096));
+            CHECK_TRUE(s_test(5000));
+            CHECK_TRUE(s_test(262144));
+            CHECK_TRUE(s_test(300000));
+            CHECK_TRUE(s_test((1 << 20) + 3));
+        }
+
+        UNITTEST_TEST(find_free)
+        {
+            // the bulk operations keep the summary levels that the level specific functions depend on
+            arena_t*            arena = narena::new_arena(16 * cMB, 64 * cKB);
+            nbitvec::layout64_t l;
+            nbitvec::compute(300000, l);
+            CHECK_EQUAL(3, l.m_levels);
+            u64* a  = g_allocate_array_and_clear<u64>(arena, nbitvec::sizeof_data(l));
+            u64* b  = g_allocate_array_and_clear<u64>(arena, nbitvec::sizeof_data(l));
+            u64* a1 = a + l.m_bin0;
+            u64* a2 = a1 + l.m_bin1;
+            u64* a3 = a2 + l.m_bin2;
+            u64* b1 = b + l.m_bin0;
+            u64* b2 = b1 + l.m_bin1;
+            u64* b3 = b2 + l.m_bin2;
+            nbitvec24::set_all_free(a, a1, a2, a3, l.m_maxbits);
+            nbitvec24::set_all_free(b, b1, b2, b3, l.m_maxbits);
+            for (u32 bit = 0; bit < 250000; ++bit)
+                nbitvec24::set_used(b, b1, b2, b3, l.m_maxbits, bit);
+
+            nbitvec::bulk_and(a, b, l);
+            CHECK_EQUAL(50000, nbitvec::popcount(a, l));
+            CHECK_EQUAL(250000, nbitvec24::find_free(a, a1, a2, a3, l.m_maxbits));
+            nbitvec24::set_used(b, b1, b2, b3, l.m_maxbits, 299999);
+            nbitvec::bulk_xor(a, b, l);
+            CHECK_EQUAL(1, nbitvec::popcount(a, l));
+            CHECK_EQUAL(299999, nbitvec24::find_free(a, a1, a2, a3, l.m_maxbits));
+            nbitvec::bulk_andnot(a, a, l);
+            CHECK_FALSE(nbitvec::any(a, l));
+            CHECK_EQUAL(-1, nbitvec24::find_free(a, a1, a2, a3, l.m_maxbits));
+
+            narena::destroy(arena);
+        }
+
+#ifdef CCORE_BENCHMARKS
+        // Intersection and population count of two 4M bit-vectors, half full or sparse (a few non-empty blocks of
+        // 4096 bits), compared with a word at a time without summary levels and with the bit at a time functions.
+        UNITTEST_TEST(benchmark)
+        {
+            u32 const           maxbits = 1 << 22;
+            arena_t*            arena   = narena::new_arena(64 * cMB, 64 * cKB);
+            nbitvec::layout64_t l;
+            nbitvec::compute(maxbits, l);
+            u32 const size = nbitvec::sizeof_data(l);
+            u64*      a    = g_allocate_array_and_clear<u64>(arena, size);
+            u64*      b    = g_allocate_array_and_clear<u64>(arena, size);
+            u64*      c    = g_allocate_array_and_clear<u64>(arena, size);
+            u8*       fa   = g_allocate_array_and_clear<u8>(arena, maxbits);
+            u8*       fb   = g_allocate_array_and_clear<u8>(arena, maxbits);
+            u64*      c1   = c + l.m_bin0;
+            u64*      c2   = c1 + l.m_bin1;
+            u64*      c3   = c2 + l.m_bin2;
+
+            char const* names[] = {"half full", "sparse"};
+            for (u32 p = 0; p < 2; ++p)
+            {
+                xor_random_t rnd(0xFACE);
+                for (u32 bit = 0; bit < maxbits; ++bit)
+                {
+                    bool const block = p == 0 || ((bit >> 12) % 64) == 0;
+                    fa[bit]          = (block && (rnd.rand32() & 1)) ? 1 : 0;
+                    fb[bit]          = (block && (rnd.rand32() & 1)) ? 1 : 0;
+                }
+                s_build(b, l, fb);
+
+                s32 const rounds  = 16;
+                u64       bulk_ns = 0;
+                for (s32 r = 0; r < rounds; ++r)
+                {
+                    s_build(a, l, fa);
+                    u64 const start = ntest::time_ns();
+                    nbitvec::bulk_and(a, b, l);
+                    bulk_ns += ntest::time_ns() - start;
+                }
+                bulk_ns /= rounds;
+
+                u64 start = ntest::time_ns();
+                u32 count = 0;
+                for (s32 r = 0; r < rounds; ++r)
+                    count += nbitvec::popcount(a, l);
+                u64 const popcount_ns = (ntest::time_ns() - start) / rounds;
+
+                u64 word_ns = 0;
+                for (s32 r = 0; r < rounds; ++r)
+                {
+                    s_build(c, l, fa);
+                    u64 volatile* w = c3;
+                    start           = ntest::time_ns();
+                    for (u32 i = 0; i < l.m_bin3; ++i)
+                        w[i] = w[i] & b[l.m_bin0 + l.m_bin1 + l.m_bin2 + i];
+                    word_ns += ntest::time_ns() - start;
+                }
+                word_ns /= rounds;
+
+                // bit at a time, a bit is cleared when it is not set in the other bit-vector
+                s_build(c, l, fa);
+                start = ntest::time_ns();
+                for (u32 bit = 0; bit < maxbits; ++bit)
+                {
+                    if (!fb[bit] && nbitvec24::get(c, c1, c2, c3, maxbits, bit))
+                        nbitvec24::set_used(c, c1, c2, c3, maxbits, bit);
+                }
+                u64 const bit_ns = ntest::time_ns() - start;
+
+                start       = ntest::time_ns();
+                u32 counted = 0;
+                for (u32 bit = 0; bit < maxbits; ++bit)
+                    counted += nbitvec24::get(c, c1, c2, c3, maxbits, bit) ? 1 : 0;
+                u64 const bit_count_ns = ntest::time_ns() - start;
+
+                printf("bitvec bulk_and 4M bits, %s: bulk %llu ns, word by word %llu ns, bit by bit %llu ns\n", names[p], (unsigned long long)bulk_ns, (unsigned long long)word_ns, (unsigned long long)bit_ns);
+                printf("bitvec popcount 4M bits, %s: popcount %llu ns, bit by bit %llu ns (%u, %u)\n", names[p], (unsigned long long)popcount_ns, (unsigned long long)bit_count_ns, count / rounds, counted);
+                CHECK_EQUAL(counted, count / rounds);
+                CHECK_TRUE(g_memequal(a, c, size * sizeof(u64)));
+            }
+            narena::destroy(arena);
+        }
+#endif
+    }
+
+    UNITTEST_FIXTURE(runtime)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        // compares the bit-vector with an array of flags
+        static bool s_verify(bitvec_t const* bv, u8 const* is_free)
+        {
+            bool ok    = true;
+            s32  first = -1;
+            s32  last  = -1;
+            u32  count = 0;
+            for (u32 bit = 0; bit < bv->m_maxbits; ++bit)
+            {
+                ok = ok && nbitvec::get(bv, bit) == (is_free[bit] != 0);
+                if (is_free[bit])
+                {
+                    first = first < 0 ? (s32)bit : first;
+                    last  = (s32)bit;
+                    count += 1;
+                }
+            }
+            ok = ok && nbitvec::find_free(bv) == first && nbitvec::find_free_last(bv) == last;
+            ok = ok && nbitvec::popcount(bv) == count && nbitvec::any(bv) == (count > 0);
+            return ok;
+        }
+
+        UNITTEST_TEST(levels)
+        {
+            u32 const capacity[] = {10, 64, 4096, 4097, 262144, 262145, 16 * 1024 * 1024};
+            u8 const  levels[]   = {1, 1, 1, 2, 2, 3, 3};
+            for (u32 i = 0; i < DARRAYSIZE(capacity); ++i)
+            {
+                bitvec_t bv;
+                CHECK_TRUE(nbitvec::setup(&bv, capacity[i] / 2, capacity[i]));
+                CHECK_EQUAL(levels[i], bv.m_levels);
+                for (u32 l = 0; l <= bv.m_levels; ++l)
+                    CHECK_EQUAL(0, (u32)((ptr_t)bv.m_bins[l] & (CC_CACHE_LINE_SIZE - 1)));
+                CHECK_NULL(bv.m_levels < 3 ? bv.m_bins[3] : nullptr);
+                CHECK_EQUAL(-1, nbitvec::find_free(&bv));
+                nbitvec::set_all_free(&bv);
+                CHECK_EQUAL(capacity[i] / 2, nbitvec::popcount(&bv));
+                CHECK_EQUAL((s32)(capacity[i] / 2) - 1, nbitvec::find_free_last(&bv));
+                nbitvec::destroy(&bv);
+                CHECK_NULL(bv.m_arena);
+            }
+        }
+
+        UNITTEST_TEST(grow)
+        {
+            u32 const capacity = 300000;
+            arena_t*  arena    = narena::new_arena(4 * cMB, 64 * cKB);
+            u8*       is_free  = g_allocate_array_and_clear<u8>(arena, capacity);
+
+            bitvec_t bv;
+            CHECK_TRUE(nbitvec::setup(&bv, 1000, capacity));
+            CHECK_EQUAL(3, bv.m_levels);
+            uint_t committed = narena::committed_size(bv.m_arena);
+            CHECK_TRUE(committed < narena::reserved_size(bv.m_arena));
+            nbitvec::set_all_free(&bv);
+            g_memset(is_free, 1, 1000);
+
+            bool         ok = true;
+            xor_random_t rnd(0x5EED);
+            u32 const    sizes[] = {1000, 5000, 70000, 200000, capacity};
+            for (u32 s = 0; s < DARRAYSIZE(sizes); ++s)
+            {
+                // the bits that are there stay, the new bits are used
+                CHECK_TRUE(nbitvec::grow(&bv, sizes[s]));
+                CHECK_EQUAL(sizes[s], bv.m_maxbits);
+                CHECK_TRUE(narena::committed_size(bv.m_arena) >= committed);
+                committed = narena::committed_size(bv.m_arena);
+                ok        = ok && s_verify(&bv, is_free);
+
+                for (u32 i = 0; i < 2000; ++i)
+                {
+                    u32 const r   = rnd.rand32();
+                    u32 const bit = (r >> 4) % bv.m_maxbits;
+                    switch (r & 7)
+                    {
+                        case 0:
+                        case 1:
+                        case 2:
+                            nbitvec::set_free(&bv, bit);
+                            is_free[bit] = 1;
+                            break;
+                        case 3:
+                        case 4:
+                            nbitvec::set_used(&bv, bit);
+                            is_free[bit] = 0;
+                            break;
+                        case 5:
+                        {
+                            s32 const found = nbitvec::find_free_and_remove(&bv);
+                            ok              = ok && (found < 0 || is_free[found] == 1);
+                            if (found >= 0)
+                                is_free[found] = 0;
+                            break;
+                        }
+                        case 6:
+                        {
+                            u32 const n = 1 + (r >> 24) % 100;
+                            u32 const m = (bit + n) <= bv.m_maxbits ? n : (bv.m_maxbits - bit);
+                            nbitvec::free_range(&bv, bit, m);
+                            g_memset(is_free + bit, 1, m);
+                            break;
+                        }
+                        default:
+                        {
+                            s32 const start = nbitvec::alloc_range(&bv, 1 + (r >> 24) % 16);
+                            if (start >= 0)
+                            {
+                                for (u32 b = (u32)start; b < (u32)start + 1 + (r >> 24) % 16; ++b)
+                                {
+                                    ok      = ok && is_free[b] == 1;
+                                    is_free[b] = 0;
+                                }
+                            }
+                            break;
+                        }
+                    }
+                }
+                ok = ok && s_verify(&bv, is_free);
+
+                s32 const pivot = (s32)(bv.m_maxbits / 2);
+                s32       after = -1;
+                for (u32 b = (u32)pivot + 1; b < bv.m_maxbits && after < 0; ++b)
+                    after = is_free[b] ? (s32)b : -1;
+                ok = ok && nbitvec::find_free_after(&bv, (u32)pivot) == after;
+            }
+            CHECK_TRUE(ok);
+            CHECK_FALSE(nbitvec::grow(&bv, capacity + 1));
+            CHECK_EQUAL(capacity, bv.m_maxbits);
+
+            nbitvec::destroy(&bv);
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(bulk)
+        {
+            bitvec_t a;
+            bitvec_t b;
+            CHECK_TRUE(nbitvec::setup(&a, 100000, 1 << 20));
+            CHECK_TRUE(nbitvec::setup(&b, 100000, 1 << 20));
+            nbitvec::set_all_free(&a);
+            for (u32 bit = 0; bit < 100000; bit += 3)
+                nbitvec::set_free(&b, bit);
+
+            nbitvec::bulk_and(&a, &b);
+            CHECK_EQUAL(33334, nbitvec::popcount(&a));
+            nbitvec::bulk_xor(&a, &b);
+            CHECK_FALSE(nbitvec::any(&a));
+            CHECK_EQUAL(-1, nbitvec::find_free(&a));
+            nbitvec::bulk_or(&a, &b);
+            nbitvec::bulk_andnot(&b, &a);
+            CHECK_EQUAL(33334, nbitvec::popcount(&a));
+            CHECK_EQUAL(99999, nbitvec::find_free_last(&a));
+            CHECK_FALSE(nbitvec::any(&b));
+
+            // both grow the same, the bulk operations cover the new bits
+            CHECK_TRUE(nbitvec::grow(&a, 1 << 20));
+            CHECK_TRUE(nbitvec::grow(&b, 1 << 20));
+            nbitvec::free_range(&b, 500000, 1000);
+            nbitvec::bulk_or(&a, &b);
+            CHECK_EQUAL(33334 + 1000, nbitvec::popcount(&a));
+            CHECK_EQUAL(500999, nbitvec::find_free_last(&a));
+
+            nbitvec::destroy(&a);
+            nbitvec::destroy(&b);
+        }
+    }
+
+    UNITTEST_FIXTURE(concurrent)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        // A 2 level (u64), 3 level (u32) and 4 level (u64) bit-vector behind one interface, level 0 is bin0
+        struct bv12_t
+        {
+            typedef u64 T;
+            static void layout(u32 maxbits, u32* words)
+            {
+                nbitvec::layout64_t l;
+                nbitvec::compute_l2(maxbits, l);
+                words[0] = l.m_bin0;
+                words[1] = l.m_bin1;
+            }
+            static void set_all_free(T** b, u32 maxbits) { nbitvec12::set_all_free(b[0], b[1], maxbits); }
+            static s32  find_free_and_remove(T** b, u32 maxbits) { return nbitvec12::find_free_and_remove(b[0], b[1], maxbits); }
+            static s32  claim(T** b, u32 maxbits) { return nbitvec12::find_free_and_remove_concurrent(b[0], b[1], maxbits); }
+            static void release(T** b, u32 maxbits, u32 bit) { nbitvec12::set_free_concurrent(b[0], b[1], maxbits, bit); }
+            static void take(T** b, u32 maxbits, u32 bit) { nbitvec12::set_used_concurrent(b[0], b[1], maxbits, bit); }
+        };
+
+        struct bv15_t
+        {
+            typedef u32 T;
+            static void layout(u32 maxbits, u32* words)
+            {
+                nbitvec::layout32_t l;
+                nbitvec::compute_l3(maxbits, l);
+                words[0] = l.m_bin0;
+                words[1] = l.m_bin1;
+                words[2] = l.m_bin2;
+            }
+            static void set_all_free(T** b, u32 maxbits) { nbitvec15::set_all_free(b[0], b[1], b[2], maxbits); }
+            static s32  find_free_and_remove(T** b, u32 maxbits) { return nbitvec15::find_free_and_remove(b[0], b[1], b[2], maxbits); }
+            static s32  claim(T** b, u32 maxbits) { return nbitvec15::find_free_and_remove_concurrent(b[0], b[1], b[2], maxbits); }
+            static void release(T** b, u32 maxbits, u32 bit) { nbitvec15::set_free_concurrent(b[0], b[1], b[2], maxbits, bit); }
+            static void take(T** b, u32 maxbits, u32 bit) { nbitvec15::set_used_concurrent(b[0], b[1], b[2], maxbits, bit); }
+        };
+
+        struct bv24_t
+        {
+            typedef u64 T;
+            static void layout(u32 maxbits, u32* words)
+            {
+                nbitvec::layout64_t l;
+                nbitvec::compute_l4(maxbits, l);
+                words[0] = l.m_bin0;
+                words[1] = l.m_bin1;
+                words[2] = l.m_bin2;
+                words[3] = l.m_bin3;
+            }
+            static void set_all_free(T** b, u32 maxbits) { nbitvec24::set_all_free(b[0], b[1], b[2], b[3], maxbits); }
+            static s32  find_free_and_remove(T** b, u32 maxbits) { return nbitvec24::find_free_and_remove(b[0], b[1], b[2], b[3], maxbits); }
+            static s32  claim(T** b, u32 maxbits) { return nbitvec24::find_free_and_remove_concurrent(b[0], b[1], b[2], b[3], maxbits); }
+            static void release(T** b, u32 maxbits, u32 bit) { nbitvec24::set_free_concurrent(b[0], b[1], b[2], b[3], maxbits, bit); }
+            static void take(T** b, u32 maxbits, u32 bit) { nbitvec24::set_used_concurrent(b[0], b[1], b[2], b[3], maxbits, bit); }
+        };
+
+        static const s32 cThreads = 8;
+
+        template <typename BV>
+        struct shared_t
+        {
+            arena_t*        m_arena;
+            typename BV::T* m_levels[4];
+            u32             m_maxbits;
+            u32 volatile*   m_owners;  // number of threads that hold a bit, should never be more than 1
+            u32 volatile    m_claimed;
+            u32 volatile    m_failed;
+            s32             m_ops;
+
+            void init(u32 maxbits)
+            {
+                u32 words[4] = {0, 0, 0, 0};
+                BV::layout(maxbits, words);
+                m_arena = narena::new_arena(16 * cMB, 64 * cKB);
+                for (s32 l = 0; l < 4; ++l)
+                    m_levels[l] = words[l] > 0 ? g_allocate_array_and_clear<typename BV::T>(m_arena, words[l]) : nullptr;
+                m_owners = g_allocate_array_and_clear<u32>(m_arena, maxbits);
+                m_maxbits = maxbits;
+                m_claimed = 0;
+                m_failed  = 0;
+                BV::set_all_free(m_levels, maxbits);
+            }
+
+            void exit() { narena::destroy(m_arena); }
+
+            void own(s32 bit)
+            {
+                if (bit < 0 || bit >= (s32)m_maxbits || natomic::fetch_add(&m_owners[bit], 1u) != 0)
+                    natomic::fetch_add(&m_failed, 1u);
+            }
+            void disown(s32 bit) { natomic::fetch_sub(&m_owners[bit], 1u); }
+
+            // single threaded, every bit has to be found exactly once
+            bool all_free()
+            {
+                bool ok = true;
+                for (u32 i = 0; i < m_maxbits; ++i)
+                {
+                    const s32 bit = BV::find_free_and_remove(m_levels, m_maxbits);
+                    ok            = ok && bit >= 0 && bit < (s32)m_maxbits && m_owners[bit] == 0;
+                    if (bit >= 0 && bit < (s32)m_maxbits)
+                        m_owners[bit] = 1;
+                }
+                return ok && BV::find_free_and_remove(m_levels, m_maxbits) == -1;
+            }
+        };
+
+        // every thread claims until the bit-vector is full
+        template <typename BV>
+        static void s_exhaust_thread(void* arg, s32 index)
+        {
+            shared_t<BV>* shared = (shared_t<BV>*)arg;
+            for (;;)
+            {
+                const s32 bit = BV::claim(shared->m_levels, shared->m_maxbits);
+                if (bit < 0)
+                    break;
+                shared->own(bit);
+                natomic::fetch_add(&shared->m_claimed, 1u);
+            }
+        }
+
+        // every thread holds up to 64 bits and randomly claims, releases, or takes a specific bit
+        template <typename BV>
+        static void s_churn_thread(void* arg, s32 index)
+        {
+            shared_t<BV>* shared = (shared_t<BV>*)arg;
+            xor_random_t  rnd((u64)index * 31 + 7);
+            s32           held[64];
+            s32           count = 0;
+            for (s32 i = 0; i < shared->m_ops; ++i)
+            {
+                const u32 r = rnd.rand32();
+                if ((r & 1) != 0 && count < 64)
+                {
+                    const s32 bit = BV::claim(shared->m_levels, shared->m_maxbits);
+                    if (bit >= 0)
+                    {
+                        shared->own(bit);
+                        held[count++] = bit;
+                    }
+                }
+                else if (count > 0)
+                {
+                    const s32 slot = (s32)((r >> 1) % (u32)count);
+                    const s32 bit  = held[slot];
+                    held[slot]     = held[--count];
+                    shared->disown(bit);
+                    BV::release(shared->m_levels, shared->m_maxbits, (u32)bit);
+                }
+            }
+            while (count > 0)
+            {
+                const s32 bit = held[--count];
+                shared->disown(bit);
+                BV::release(shared->m_levels, shared->m_maxbits, (u32)bit);
+            }
+        }
+
+        template <typename BV>
+        static void s_test(u32 maxbits, bool& exhaust_ok, bool& churn_ok)
+        {
+            shared_t<BV> shared;
+            shared.init(maxbits);
+            ntest::run_threads(cThreads, s_exhaust_thread<BV>, &shared);
+            exhaust_ok = shared.m_failed == 0 && shared.m_claimed == maxbits;
+            for (u32 bit = 0; bit < maxbits; ++bit)
+            {
+                shared.m_owners[bit] = 0;
+                BV::release(shared.m_levels, maxbits, bit);
+            }
+
+            // claim everything but the bits that will be churned over, so that the threads fight over few bits
+            const u32 keep = maxbits - 256;
+            for (u32 bit = 0; bit < keep; ++bit)
+                BV::take(shared.m_levels, maxbits, (bit * 7919) % maxbits);
+            for (u32 bit = 0; bit < maxbits; ++bit)
+                shared.m_owners[bit] = 0;
+            for (u32 i = 0; i < keep; ++i)
+                shared.m_owners[(i * 7919) % maxbits] = 1;
+            shared.m_ops = 100000;
+            ntest::run_threads(cThreads, s_churn_thread<BV>, &shared);
+            churn_ok = shared.m_failed == 0;
+            for (u32 i = 0; i < keep; ++i)
+            {
+                shared.m_owners[(i * 7919) % maxbits] = 0;
+                BV::release(shared.m_levels, maxbits, (i * 7919) % maxbits);
+            }
+            churn_ok = churn_ok && shared.all_free();
+            shared.exit();
+        }
+
+        UNITTEST_TEST(bitvec12)
+        {
+            bool exhaust_ok, churn_ok;
+            s_test<bv12_t>(4000, exhaust_ok, churn_ok);
+            CHECK_TRUE(exhaust_ok);
+            CHECK_TRUE(churn_ok);
+        }
+
+        UNITTEST_TEST(bitvec15)
+        {
+            bool exhaust_ok, churn_ok;
+            s_test<bv15_t>(30000, exhaust_ok, churn_ok);
+            CHECK_TRUE(exhaust_ok);
+            CHECK_TRUE(churn_ok);
+        }
+
+        UNITTEST_TEST(bitvec24)
+        {
+            bool exhaust_ok, churn_ok;
+            s_test<bv24_t>(200000, exhaust_ok, churn_ok);
+            CHECK_TRUE(exhaust_ok);
+            CHECK_TRUE(churn_ok);
+        }
+
+#ifdef CCORE_BENCHMARKS
+        static const s32 cBenchOps = 1 << 20;
+
+        struct bench_shared_t
+        {
+            shared_t<bv24_t> m_bitvec;
+            spinlock_t       m_lock;
+            bool             m_use_lock;
+            u32 volatile     m_ready;
+            s32              m_num_threads;
+            u64              m_duration_ns[64];
+        };
+
+        // claim and release with a window of 16 bits per thread, either lock-free or with a spinlock around the plain functions
+        static void s_bench_thread(void* arg, s32 index)
+        {
+            bench_shared_t*  shared  = (bench_shared_t*)arg;
+            bv24_t::T**      levels  = shared->m_bitvec.m_levels;
+            const u32        maxbits = shared->m_bitvec.m_maxbits;
+            s32              held[16];
+            for (s32 i = 0; i < 16; ++i)
+                held[i] = -1;
+
+            natomic::fetch_add(&shared->m_ready, 1u);
+            while (natomic::load(&shared->m_ready) < (u32)shared->m_num_threads)
+                natomic::pause();
+
+            const u64 start = ntest::time_ns();
+            for (s32 i = 0; i < cBenchOps; ++i)
+            {
+                s32& slot = held[i & 15];
+                if (shared->m_use_lock)
+                {
+                    nspinlock::lock(shared->m_lock);
+                    if (slot >= 0)
+                        nbitvec24::set_free(levels[0], levels[1], levels[2], levels[3], maxbits, (u32)slot);
+                    slot = nbitvec24::find_free_and_remove(levels[0], levels[1], levels[2], levels[3], maxbits);
+                    nspinlock::unlock(shared->m_lock);
+                }
+                else
+                {
+                    if (slot >= 0)
+                        bv24_t::release(levels, maxbits, (u32)slot);
+                    slot = bv24_t::claim(levels, maxbits);
+                }
+            }
+            shared->m_duration_ns[index] = ntest::time_ns() - start;
+        }
+
+        static u64 s_bench_run(bench_shared_t* shared, s32 num_threads, bool use_lock)
+        {
+            shared->m_bitvec.init(1 << 18);
+            nspinlock::init(shared->m_lock);
+            shared->m_use_lock    = use_lock;
+            shared->m_num_threads = num_threads;
+            shared->m_ready       = 0;
+            ntest::run_threads(num_threads, s_bench_thread, shared);
+            shared->m_bitvec.exit();
+            u64 duration = 0;
+            for (s32 t = 0; t < num_threads; ++t)
+                duration = duration < shared->m_duration_ns[t] ? shared->m_duration_ns[t] : duration;
+            return duration;
+        }
+
+        UNITTEST_TEST(benchmark)
+        {
+            bench_shared_t shared;
+            for (s32 num_threads = 1; num_threads <= 16; num_threads *= 2)
+            {
+                const u64    lock_free_ns = s_bench_run(&shared, num_threads, false);
+                const u64    spinlock_ns  = s_bench_run(&shared, num_threads, true);
+                const double ops          = (double)cBenchOps * num_threads * 1000.0;  // claims per second in millions
+                printf("bitvec claim+release, %2d threads: lock-free %6.1f M/s, spinlock %6.1f M/s\n", num_threads, ops / (double)lock_free_ns, ops / (double)spinlock_ns);
+            }
+        }
+#endif
+    }
 }
 UNITTEST_SUITE_END
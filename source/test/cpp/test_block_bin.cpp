@@ -227,6 +227,44 @@ UNITTEST_SUITE_BEGIN(block_bin)
             s_destroy_bin(storage);
         }
 
+        UNITTEST_TEST(alloc_n_free_n)
+        {
+            bin_storage_t storage = s_create_bin(8 * s_item_size, s_item_size);
+            bbin_t*       bin     = storage.m_bin;
+
+            // fresh full-size blocks are contiguous and committed at once
+            void* ptrs[8];
+            CHECK_EQUAL((u32)5, bin_alloc_n(bin, s_item_size, ptrs, 5));
+            for (u32 i = 0; i < 5; ++i)
+            {
+                CHECK_EQUAL((void*)((byte*)ptrs[0] + i * s_item_size), ptrs[i]);
+                ((byte*)ptrs[i])[0]               = (byte)i;
+                ((byte*)ptrs[i])[s_item_size - 1] = (byte)i;
+            }
+
+            bin_free_n(bin, ptrs + 1, 2);
+            CHECK_EQUAL((u32)3, bin_size(bin));
+
+            // two blocks come from the free list, the remaining three are fresh and partially committed
+            ptrs[1] = ptrs[3];
+            ptrs[2] = ptrs[4];
+            CHECK_EQUAL((u32)5, bin_alloc_n(bin, s_item_size / 2, ptrs + 3, 10));
+            CHECK_EQUAL((u32)8, bin_size(bin));
+            CHECK_EQUAL((u32)0, bin_alloc_n(bin, s_item_size, ptrs, 1));
+            for (u32 i = 3; i < 8; ++i)
+            {
+                ((byte*)ptrs[i])[0]                   = (byte)i;
+                ((byte*)ptrs[i])[s_item_size / 2 - 1] = (byte)i;
+            }
+            CHECK_EQUAL((byte)3, ((byte*)ptrs[1])[s_item_size - 1]);
+            CHECK_EQUAL((byte)4, ((byte*)ptrs[2])[s_item_size - 1]);
+
+            bin_free_n(bin, ptrs, 8);
+            CHECK_EQUAL((u32)0, bin_size(bin));
+
+            s_destroy_bin(storage);
+        }
+
         UNITTEST_TEST(exhausts_reserved_capacity_and_reuses_free_block)
         {
             bin_storage_t storage = s_create_bin(2 * s_item_size, s_item_size);
@@ -250,6 +288,37 @@ UNITTEST_SUITE_BEGIN(block_bin)
 
             s_destroy_bin(storage);
         }
+
+        UNITTEST_TEST(decommit_policy_retains_budget)
+        {
+            bin_storage_t storage = s_create_bin(4 * s_item_size, s_item_size);
+            bbin_t*       bin     = storage.m_bin;
+
+            vmem_decommit_policy_t policy;
+            v_decommit_policy_init(&policy, VMEM_DECOMMIT_HYSTERESIS, s_item_size);
+            bin_set_decommit_policy(bin, &policy);
+
+            byte* first  = (byte*)bin_alloc(bin, s_item_size);
+            byte* second = (byte*)bin_alloc(bin, s_item_size);
+            first[0]     = 0x5A;
+            second[0]    = 0xA5;
+
+            // the first freed block fits in the budget and stays committed, the second one is decommitted
+            bin_free(bin, first);
+            bin_free(bin, second);
+            CHECK_EQUAL(s_item_size, policy.m_stats.m_retained_bytes);
+            CHECK_EQUAL(s_item_size, policy.m_stats.m_decommitted_bytes);
+
+            // lifo, so first we get the decommitted block back and then the retained block
+            CHECK_EQUAL(second, (byte*)bin_alloc(bin, s_item_size));
+            CHECK_EQUAL(first, (byte*)bin_alloc(bin, s_item_size));
+            CHECK_EQUAL((u32)0x5A, (u32)first[0]);
+            CHECK_EQUAL(1, policy.m_stats.m_decommit_calls);
+
+            bin_free(bin, first);
+            bin_free(bin, second);
+            s_destroy_bin(storage);
+        }
     }
 }
 UNITTEST_SUITE_END
@@ -291,6 +291,116 @@ UNITTEST_SUITE_BEGIN(chunk_bin)
 
             s_destroy_bin(storage);
         }
+
+        UNITTEST_TEST(alloc_n_free_n_across_chunks)
+        {
+            bin_storage_t storage = s_create_bin(64 * cKB, sizeof(item_t));
+            cbin_t*       bin     = storage.m_bin;
+
+            // 4 chunks of 1024 items
+            const u32 max_items = 4096;
+            void*     ptrs[max_items];
+
+            CHECK_EQUAL((u32)3000, bin_alloc_n(bin, ptrs, 3000));
+            CHECK_EQUAL((u32)3000, bin_size(bin));
+
+            // the first chunk becomes empty, the second and third chunk are partially used
+            bin_free_n(bin, ptrs, 1024);
+            bin_free_n(bin, ptrs + 2000, 100);
+            CHECK_EQUAL((u32)1876, bin_size(bin));
+
+            for (u32 i = 0; i < 1876; ++i)
+                ptrs[i] = i < 976 ? ptrs[1024 + i] : ptrs[2100 + (i - 976)];
+            CHECK_EQUAL((u32)(max_items - 1876), bin_alloc_n(bin, ptrs + 1876, max_items));
+            CHECK_EQUAL(max_items, bin_size(bin));
+            CHECK_NULL(bin_alloc(bin));
+
+            for (u32 i = 0; i < max_items; ++i)
+                ((item_t*)ptrs[i])->m_value = i;
+            bool unique = true;
+            for (u32 i = 0; i < max_items; ++i)
+                unique = unique && ((item_t*)ptrs[i])->m_value == i;
+            CHECK_TRUE(unique);
+
+            bin_free_n(bin, ptrs, max_items);
+            CHECK_EQUAL((u32)0, bin_size(bin));
+
+            s_destroy_bin(storage);
+        }
+
+        UNITTEST_TEST(iterate_used)
+        {
+            bin_storage_t storage = s_create_bin(64 * cKB, sizeof(item_t));
+            cbin_t*       bin     = storage.m_bin;
+
+            // 4 chunks of 1024 items, the first chunk becomes empty and the second chunk keeps a few runs
+            void* ptrs[3000];
+            CHECK_EQUAL((u32)3000, bin_alloc_n(bin, ptrs, 3000));
+            for (u32 i = 0; i < 3000; ++i)
+                ((item_t*)ptrs[i])->m_value = i;
+            bin_free_n(bin, ptrs, 1030);
+            bin_free_n(bin, ptrs + 1040, 960);
+
+            u32  runs    = 0;
+            u32  visited = 0;
+            bool ok      = true;
+
+            bin_used_iter_t it;
+            bin_iter_begin(bin, it);
+            while (bin_iter_next(bin, it))
+            {
+                for (u32 i = 0; i < it.m_count; ++i)
+                    ok = ok && ((item_t*)(it.m_items + (i * sizeof(item_t))))->m_value == it.m_index + i;
+                visited += it.m_count;
+                runs += 1;
+            }
+            CHECK_TRUE(ok);
+            CHECK_EQUAL(3u, runs);  // [1030, 1040), [2000, 2048) and [2048, 3000), runs end at a chunk boundary
+            CHECK_EQUAL(bin_size(bin), visited);
+
+            bin_free_n(bin, ptrs + 1030, 10);
+            bin_free_n(bin, ptrs + 2000, 1000);
+            bin_iter_begin(bin, it);
+            CHECK_FALSE(bin_iter_next(bin, it));
+
+            s_destroy_bin(storage);
+        }
+
+        UNITTEST_TEST(decommit_policy_retains_budget)
+        {
+            bin_storage_t storage = s_create_bin(256 * 4 * cKB, sizeof(item_t));
+            cbin_t*       bin     = storage.m_bin;
+
+            // one chunk (16 KiB) worth of pages may stay committed
+            vmem_decommit_policy_t policy;
+            v_decommit_policy_init(&policy, VMEM_DECOMMIT_HYSTERESIS, 16 * cKB);
+            bin_set_decommit_policy(bin, &policy);
+
+            const u32 num_allocs = 3 * 1024;  // 3 chunks
+            item_t**  ptrs       = (item_t**)narena::alloc(nscratch::get(), num_allocs * sizeof(item_t*));
+            for (u32 round = 0; round < 2; ++round)
+            {
+                for (u32 i = 0; i < num_allocs; ++i)
+                {
+                    ptrs[i] = (item_t*)bin_alloc(bin);
+                    CHECK_NOT_NULL(ptrs[i]);
+                    ptrs[i]->m_value = i;
+                }
+                for (u32 i = 0; i < num_allocs; ++i)
+                {
+                    CHECK_EQUAL(i, ptrs[i]->m_value);
+                    bin_free(bin, ptrs[i]);
+                }
+            }
+
+            // every round, one empty chunk is retained and the other two are decommitted
+            CHECK_EQUAL(2 * 16 * cKB, policy.m_stats.m_retained_bytes);
+            CHECK_EQUAL(4, policy.m_stats.m_decommit_calls);
+            CHECK_EQUAL(2 * ((16 * cKB) >> v_alloc_get_page_size_shift()), policy.m_stats.m_faults_avoided);
+
+            narena::reset(nscratch::get());
+            s_destroy_bin(storage);
+        }
     }
 }
 UNITTEST_SUITE_END
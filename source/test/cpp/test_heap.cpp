@@ -0,0 +1,267 @@
+#include "ccore/c_target.h"
+#include "ccore/c_arena.h"
+#include "ccore/c_atomic.h"
+#include "ccore/c_heap.h"
+#include "ccore/c_random.h"
+
+#include "cunittest/cunittest.h"
+
+#include "test_thread.h"
+
+#include <stdlib.h>
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(heap)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        UNITTEST_TEST(size_classes)
+        {
+            CHECK_EQUAL(0, nheap::size_class(1));
+            CHECK_EQUAL(0, nheap::size_class(8));
+            CHECK_EQUAL(1, nheap::size_class(9));
+            CHECK_EQUAL(8, nheap::size_class(128));
+            CHECK_EQUAL(160, nheap::class_size(nheap::size_class(129)));
+            CHECK_EQUAL(1024, nheap::class_size(nheap::size_class(1000)));
+            CHECK_EQUAL(32 * cKB, nheap::class_size(nheap::size_class(30000)));
+            CHECK_EQUAL(64 * cKB, nheap::class_size(nheap::size_class(32 * cKB + 1)));
+            CHECK_EQUAL(1 * cMB, nheap::class_size(nheap::size_class(1 * cMB)));
+            CHECK_EQUAL(nheap::num_size_classes(), nheap::size_class(1 * cMB + 1));
+
+            // every size maps to the smallest class that holds it
+            bool ok = true;
+            for (u32 size = 1; size <= 1 * cMB; size += (size < 4096) ? 1 : 61)
+            {
+                const u32 c = nheap::size_class(size);
+                ok          = ok && nheap::class_size(c) >= size && (c == 0 || nheap::class_size(c - 1) < size);
+            }
+            CHECK_TRUE(ok);
+        }
+
+        UNITTEST_TEST(alloc_free_all_tiers)
+        {
+            heap_t* heap = nheap::create(64 * cMB);
+            CHECK_NOT_NULL(heap);
+
+            const uint_t sizes[] = {0, 1, 8, 24, 100, 1000, 1500, 4000, 20000, 40000, 300000, 1 * cMB, 3 * cMB};
+            void*        ptrs[g_array_size(sizes)][8];
+            for (u32 s = 0; s < g_array_size(sizes); ++s)
+            {
+                for (u32 i = 0; i < 8; ++i)
+                {
+                    u8* ptr = (u8*)nheap::alloc(heap, sizes[s]);
+                    CHECK_NOT_NULL(ptr);
+                    CHECK_EQUAL(0, (ptr_t)ptr & 15);
+                    if (sizes[s] > 0)
+                    {
+                        ptr[0]            = (u8)(s + i);
+                        ptr[sizes[s] - 1] = (u8)(s + i);
+                    }
+                    ptrs[s][i] = ptr;
+                }
+            }
+
+            bool ok = true;
+            for (u32 s = 0; s < g_array_size(sizes); ++s)
+            {
+                for (u32 i = 0; i < 8; ++i)
+                {
+                    u8 const* ptr = (u8 const*)ptrs[s][i];
+                    if (sizes[s] > 0)
+                        ok = ok && ptr[0] == (u8)(s + i) && ptr[sizes[s] - 1] == (u8)(s + i);
+                    for (u32 j = 0; j < i; ++j)
+                        ok = ok && ptrs[s][j] != ptr;
+                }
+            }
+            CHECK_TRUE(ok);
+
+            for (u32 s = 0; s < g_array_size(sizes); ++s)
+                for (u32 i = 0; i < 8; ++i)
+                    nheap::free(heap, ptrs[s][i]);
+
+            // all the large nodes were returned, so the whole large address space can be allocated
+            void* ptr = nheap::alloc(heap, 64 * cMB);
+            CHECK_NOT_NULL(ptr);
+            nheap::free(heap, ptr);
+
+            nheap::flush_thread_cache(heap);
+            nheap::destroy(heap);
+            CHECK_NULL(heap);
+        }
+
+        UNITTEST_TEST(alignment)
+        {
+            heap_t* heap = nheap::create(4 * cGB);
+            for (u32 align = 8; align <= 4096; align <<= 1)
+            {
+                void* a = nheap::alloc(heap, 8, align);
+                void* b = nheap::alloc(heap, 3000, align);
+                void* c = nheap::alloc(heap, 100000, align);
+                CHECK_EQUAL(0, (ptr_t)a & (align - 1));
+                CHECK_EQUAL(0, (ptr_t)b & (align - 1));
+                CHECK_EQUAL(0, (ptr_t)c & (align - 1));
+                nheap::free(heap, a);
+                nheap::free(heap, b);
+                nheap::free(heap, c);
+            }
+            nheap::destroy(heap);
+        }
+
+        UNITTEST_TEST(heap_alloc)
+        {
+            heap_t*      heap = nheap::create(4 * cGB);
+            heap_alloc_t allocator(heap);
+            u32*         array = g_allocate_array<u32>(&allocator, 1000);
+            for (u32 i = 0; i < 1000; ++i)
+                array[i] = i;
+            CHECK_EQUAL(999, array[999]);
+            g_deallocate_array(&allocator, array);
+            CHECK_NULL(array);
+            nheap::destroy(heap);
+        }
+
+        // Items are allocated by one thread and freed by another, this goes through the thread caches
+        // and the remote-free lists of the classes.
+        static const s32 cRemoteThreads = 4;
+        static const s32 cRemoteItems   = 4096;
+
+        struct remote_shared_t
+        {
+            heap_t*      m_heap;
+            void*        m_items[cRemoteThreads][cRemoteItems];
+            u32 volatile m_allocated;
+            u32 volatile m_failed;
+        };
+
+        static void s_remote_thread(void* arg, s32 index)
+        {
+            remote_shared_t* shared = (remote_shared_t*)arg;
+            for (s32 i = 0; i < cRemoteItems; ++i)
+            {
+                const u32 size = 16 + (u32)((i * 37) % 2000);
+                u32*      item = (u32*)nheap::alloc(shared->m_heap, size);
+                if (item == nullptr)
+                {
+                    natomic::fetch_add(&shared->m_failed, 1u);
+                    continue;
+                }
+                item[0]                   = (u32)index;
+                shared->m_items[index][i] = item;
+            }
+
+            natomic::fetch_add(&shared->m_allocated, 1u);
+            while (natomic::load(&shared->m_allocated) < (u32)cRemoteThreads)
+                natomic::pause();
+
+            // free the items of the next thread
+            const s32 other = (index + 1) % cRemoteThreads;
+            for (s32 i = 0; i < cRemoteItems; ++i)
+            {
+                u32* item = (u32*)shared->m_items[other][i];
+                if (item[0] != (u32)other)
+                    natomic::fetch_add(&shared->m_failed, 1u);
+                nheap::free(shared->m_heap, item);
+            }
+        }
+
+        UNITTEST_TEST(remote_free)
+        {
+            remote_shared_t* shared = (remote_shared_t*)narena::alloc_and_zero(nscratch::get(), sizeof(remote_shared_t));
+            shared->m_heap          = nheap::create(4 * cGB);
+            for (s32 round = 0; round < 3; ++round)
+            {
+                shared->m_allocated = 0;
+                ntest::run_threads(cRemoteThreads, s_remote_thread, shared);
+            }
+            CHECK_EQUAL(0, shared->m_failed);
+            nheap::destroy(shared->m_heap);
+            narena::reset(nscratch::get());
+        }
+
+#ifdef CCORE_BENCHMARKS
+        static const s32 cBenchSlots = 1024;
+        static const s32 cBenchOps   = 1 << 20;
+
+        struct bench_shared_t
+        {
+            heap_t*      m_heap;
+            bool         m_use_heap;
+            u32 volatile m_ready;
+            s32          m_num_threads;
+            u64          m_duration_ns[8];
+        };
+
+        // Random sizes (mostly small) with a random free pattern over a set of slots
+        static void s_bench_thread(void* arg, s32 index)
+        {
+            bench_shared_t* shared = (bench_shared_t*)arg;
+            void*           slots[cBenchSlots];
+            for (s32 i = 0; i < cBenchSlots; ++i)
+                slots[i] = nullptr;
+
+            xor_random_t rnd((u64)index + 1);
+            natomic::fetch_add(&shared->m_ready, 1u);
+            while (natomic::load(&shared->m_ready) < (u32)shared->m_num_threads)
+                natomic::pause();
+
+            const u64 start = ntest::time_ns();
+            for (s32 i = 0; i < cBenchOps; ++i)
+            {
+                const u32 r    = rnd.rand32();
+                const s32 slot = (s32)(r & (cBenchSlots - 1));
+                const u32 size = ((r >> 10) & 15) == 0 ? 1024 + ((r >> 14) & 16383) : 8 + ((r >> 14) & 255);
+                if (shared->m_use_heap)
+                {
+                    nheap::free(shared->m_heap, slots[slot]);
+                    slots[slot] = nheap::alloc(shared->m_heap, size);
+                }
+                else
+                {
+                    ::free(slots[slot]);
+                    slots[slot] = ::malloc(size);
+                }
+                *(u8*)slots[slot] = (u8)i;
+            }
+            for (s32 i = 0; i < cBenchSlots; ++i)
+            {
+                if (shared->m_use_heap)
+                    nheap::free(shared->m_heap, slots[i]);
+                else
+                    ::free(slots[i]);
+            }
+            shared->m_duration_ns[index] = ntest::time_ns() - start;
+        }
+
+        static u64 s_bench_run(bench_shared_t* shared, s32 num_threads, bool use_heap)
+        {
+            shared->m_num_threads = num_threads;
+            shared->m_use_heap    = use_heap;
+            shared->m_ready       = 0;
+            ntest::run_threads(num_threads, s_bench_thread, shared);
+            u64 duration = 0;
+            for (s32 t = 0; t < num_threads; ++t)
+                duration = duration < shared->m_duration_ns[t] ? shared->m_duration_ns[t] : duration;
+            return duration;
+        }
+
+        // Benchmark against the system allocator (glibc malloc on Linux)
+        UNITTEST_TEST(benchmark)
+        {
+            bench_shared_t shared;
+            shared.m_heap = nheap::create(4 * cGB);
+            for (s32 num_threads = 1; num_threads <= 8; num_threads *= 2)
+            {
+                const u64 heap_ns   = s_bench_run(&shared, num_threads, true);
+                const u64 malloc_ns = s_bench_run(&shared, num_threads, false);
+                printf("heap alloc+free, %d threads: nheap %6.1f ns/op, malloc %6.1f ns/op\n", num_threads, (double)heap_ns / cBenchOps, (double)malloc_ns / cBenchOps);
+            }
+            nheap::destroy(shared.m_heap);
+        }
+#endif
+    }
+}
+UNITTEST_SUITE_END
@@ -1,6 +1,8 @@
 #include "ccore/c_target.h"
 #include "ccore/c_allocator.h"
+#include "ccore/c_arena.h"
 #include "ccore/c_index_bin.h"
+#include "ccore/c_math.h"
 #include "ccore/c_memory.h"
 #include "ccore/c_random.h"
 
@@ -59,6 +61,162 @@ UNITTEST_SUITE_BEGIN(index_bin)
             bin_destroy(&bin);
         }
 
+        UNITTEST_TEST(alloc_n_free_n)
+        {
+            ibin16_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            u32 indices[300];
+            CHECK_EQUAL((u32)200, bin_alloc_n(&bin, 7, indices, 200));
+            for (u32 i = 0; i < 200; ++i)
+            {
+                CHECK_EQUAL(i, indices[i]);
+                CHECK_EQUAL(7, bin_get_tag(&bin, indices[i]));
+            }
+
+            // free every other index, the next batch reuses those before appending
+            u32 odd[100];
+            for (u32 i = 0; i < 100; ++i)
+                odd[i] = i * 2 + 1;
+            bin_free_n(&bin, odd, 100);
+            CHECK_EQUAL((u32)100, bin_size(&bin));
+
+            CHECK_EQUAL((u32)150, bin_alloc_n(&bin, 9, indices, 150));
+            CHECK_EQUAL((u32)250, bin_size(&bin));
+            for (u32 i = 0; i < 100; ++i)
+                CHECK_EQUAL(i * 2 + 1, indices[i]);
+            for (u32 i = 100; i < 150; ++i)
+            {
+                CHECK_EQUAL(200 + (i - 100), indices[i]);
+                CHECK_NOT_NULL(bin_idx2ptr(&bin, indices[i]));
+            }
+            CHECK_EQUAL(9, bin_get_tag(&bin, 249));
+
+            bin_free_n(&bin, indices, 150);
+            CHECK_EQUAL((u32)100, bin_size(&bin));
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(generational_index)
+        {
+            ibin16_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            u32 gidx[8];
+            for (u32 i = 0; i < 8; ++i)
+            {
+                CHECK_EQUAL((i32)i, bin_alloc(&bin, (u16)i));
+                gidx[i] = bin_idx2gidx(&bin, i);
+                CHECK_EQUAL((i32)i, bin_gidx2idx(&bin, gidx[i]));
+            }
+            CHECK_EQUAL(c_null_gidx32, bin_idx2gidx(&bin, 8));
+
+            // a freed and reused slot does not resolve through the old generational index
+            bin_free(&bin, 2);
+            CHECK_EQUAL(-1, bin_gidx2idx(&bin, gidx[2]));
+            CHECK_EQUAL(2, bin_alloc(&bin, 20));
+            CHECK_EQUAL(-1, bin_gidx2idx(&bin, gidx[2]));
+            CHECK_EQUAL(20, bin_get_tag(&bin, 2));
+            gidx[2] = bin_idx2gidx(&bin, 2);
+
+            // compaction moves item 7 into the hole of item 5, both old generational indices become stale
+            bin_free(&bin, 5);
+            u32 new_index = 0;
+            CHECK_EQUAL(7, bin_compact(&bin, new_index));
+            CHECK_EQUAL(5u, new_index);
+            CHECK_EQUAL(7, bin_get_tag(&bin, 5));
+
+            i32 indices[8];
+            CHECK_EQUAL(6u, bin_gidx2idx_n(&bin, gidx, indices, 8));
+            CHECK_EQUAL(2, indices[2]);
+            CHECK_EQUAL(-1, indices[5]);
+            CHECK_EQUAL(6, indices[6]);
+            CHECK_EQUAL(-1, indices[7]);
+
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(iterate_used)
+        {
+            ibin16_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            u32 indices[5000];
+            CHECK_EQUAL(5000u, bin_alloc_n(&bin, 1, indices, 5000));
+            for (u32 i = 0; i < 5000; ++i)
+            {
+                if (!(i == 0 || (i >= 60 && i < 70) || i == 4999))
+                    bin_free(&bin, i);
+            }
+
+            bin_used_iter_t it;
+            bin_iter_begin(&bin, it);
+            CHECK_TRUE(bin_iter_next(&bin, it));
+            CHECK_EQUAL(0u, it.m_index);
+            CHECK_EQUAL(1u, it.m_count);
+            CHECK_TRUE(bin_iter_next(&bin, it));
+            CHECK_EQUAL(60u, it.m_index);
+            CHECK_EQUAL(10u, it.m_count);
+            CHECK_EQUAL(bin_idx2ptr(&bin, 60), (void*)it.m_items);
+            CHECK_TRUE(bin_iter_next(&bin, it));
+            CHECK_EQUAL(4999u, it.m_index);
+            CHECK_EQUAL(1u, it.m_count);
+            CHECK_FALSE(bin_iter_next(&bin, it));
+
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(tag_index)
+        {
+            ibin16_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            // items allocated before the tag index is created are indexed by the setup
+            for (u32 i = 0; i < 100; ++i)
+                CHECK_EQUAL((i32)i, bin_alloc(&bin, (u16)(i & 3)));
+            bin_tag_index_setup(&bin, 8);
+            for (u32 i = 100; i < 300; ++i)
+                CHECK_EQUAL((i32)i, bin_alloc(&bin, (u16)(i & 3)));
+
+            CHECK_EQUAL(75u, bin_tag_count(&bin, 1));
+            CHECK_EQUAL(0u, bin_tag_count(&bin, 5));
+            CHECK_EQUAL(-1, bin_tag_first(&bin, 5));
+
+            // items are enumerated in index order
+            bool ok   = true;
+            u32  n    = 0;
+            i32  prev = -1;
+            for (i32 i = bin_tag_first(&bin, 1); i >= 0; i = bin_tag_next(&bin, 1, (u32)i))
+            {
+                ok   = ok && i > prev && bin_get_tag(&bin, (u32)i) == 1;
+                prev = i;
+                n += 1;
+            }
+            CHECK_TRUE(ok);
+            CHECK_EQUAL(75u, n);
+
+            bin_free(&bin, 5);
+            bin_set_tag(&bin, 9, 6);
+            CHECK_EQUAL(73u, bin_tag_count(&bin, 1));
+            CHECK_EQUAL(9, bin_tag_first(&bin, 6));
+
+            // compaction moves item 299 (tag 3) into the hole at 5
+            u32 moved_to = 0;
+            CHECK_EQUAL(299, bin_compact(&bin, moved_to));
+            CHECK_EQUAL(5u, moved_to);
+            CHECK_EQUAL(3, bin_tag_next(&bin, 3, 0));
+            CHECK_EQUAL(5, bin_tag_next(&bin, 3, 3));
+
+            // free the items of a tag while enumerating them
+            for (i32 i = bin_tag_first(&bin, 2); i >= 0; i = bin_tag_next(&bin, 2, (u32)i))
+                bin_free(&bin, (u32)i);
+            CHECK_EQUAL(0u, bin_tag_count(&bin, 2));
+            CHECK_EQUAL(-1, bin_tag_first(&bin, 2));
+            CHECK_EQUAL(224u, bin_size(&bin));
+
+            bin_destroy(&bin);
+        }
+
         UNITTEST_TEST(a_lot_more_alloc_free)
         {
             ibin16_t bin;
@@ -105,6 +263,8 @@ UNITTEST_SUITE_BEGIN(index_bin)
         UNITTEST_FIXTURE_SETUP() {}
         UNITTEST_FIXTURE_TEARDOWN() {}
 
+        UNITTEST_ALLOCATOR;
+
         UNITTEST_TEST(create_destroy)
         {
             ibin32_t bin;
@@ -152,6 +312,42 @@ UNITTEST_SUITE_BEGIN(index_bin)
             bin_destroy(&bin);
         }
 
+        UNITTEST_TEST(alloc_n_free_n)
+        {
+            ibin32_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            u32 indices[300];
+            CHECK_EQUAL((u32)200, bin_alloc_n(&bin, 7, indices, 200));
+            for (u32 i = 0; i < 200; ++i)
+            {
+                CHECK_EQUAL(i, indices[i]);
+                CHECK_EQUAL(7, bin_get_tag(&bin, indices[i]));
+            }
+
+            // free every other index, the next batch reuses those before appending
+            u32 odd[100];
+            for (u32 i = 0; i < 100; ++i)
+                odd[i] = i * 2 + 1;
+            bin_free_n(&bin, odd, 100);
+            CHECK_EQUAL((u32)100, bin_size(&bin));
+
+            CHECK_EQUAL((u32)150, bin_alloc_n(&bin, 9, indices, 150));
+            CHECK_EQUAL((u32)250, bin_size(&bin));
+            for (u32 i = 0; i < 100; ++i)
+                CHECK_EQUAL(i * 2 + 1, indices[i]);
+            for (u32 i = 100; i < 150; ++i)
+            {
+                CHECK_EQUAL(200 + (i - 100), indices[i]);
+                CHECK_NOT_NULL(bin_idx2ptr(&bin, indices[i]));
+            }
+            CHECK_EQUAL(9, bin_get_tag(&bin, 249));
+
+            bin_free_n(&bin, indices, 150);
+            CHECK_EQUAL((u32)100, bin_size(&bin));
+            bin_destroy(&bin);
+        }
+
         UNITTEST_TEST(compact_moves_last_item_into_first_hole)
         {
             ibin32_t bin;
@@ -189,6 +385,273 @@ UNITTEST_SUITE_BEGIN(index_bin)
 
             bin_destroy(&bin);
         }
+
+        UNITTEST_TEST(generational_index)
+        {
+            ibin32_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            u32 indices[300];
+            CHECK_EQUAL(300u, bin_alloc_n(&bin, 7, indices, 300));
+
+            // the 8-bit generation of the 32-bit packing wraps after 256 reuses, the 64-bit packing does not
+            const u32 gidx32 = bin_idx2gidx(&bin, 10);
+            const u64 gidx64 = bin_idx2gidx64(&bin, 10);
+            for (u32 i = 0; i < 256; ++i)
+            {
+                bin_free(&bin, 10);
+                CHECK_EQUAL(-1, bin_gidx2idx(&bin, gidx64));
+                CHECK_EQUAL(10, bin_alloc(&bin, 7));
+            }
+            CHECK_EQUAL(10, bin_gidx2idx(&bin, gidx32));
+            CHECK_EQUAL(-1, bin_gidx2idx(&bin, gidx64));
+            CHECK_EQUAL(((u64)256 << 32) | 10, bin_idx2gidx64(&bin, 10));
+
+            // the last 24-bit index is never packed, so the null generational index never resolves
+            CHECK_EQUAL(c_null_gidx32, bin_idx2gidx(&bin, 0x00FFFFFF));
+            CHECK_EQUAL(-1, bin_gidx2idx(&bin, c_null_gidx32));
+
+            // batched resolve, every third item is freed
+            u64 gidx[300];
+            for (u32 i = 0; i < 300; ++i)
+                gidx[i] = bin_idx2gidx64(&bin, i);
+            for (u32 i = 0; i < 300; i += 3)
+                bin_free(&bin, i);
+
+            i32 resolved[300];
+            CHECK_EQUAL(200u, bin_gidx2idx_n(&bin, gidx, resolved, 300));
+            bool ok = true;
+            for (u32 i = 0; i < 300; ++i)
+                ok = ok && resolved[i] == ((i % 3) == 0 ? -1 : (i32)i);
+            CHECK_TRUE(ok);
+
+            // defrag moves items, the generational indices of the moved items become stale, the others stay valid
+            const u32 moves = bin_defrag(&bin, 1000);
+            CHECK_EQUAL(200u - moves, bin_gidx2idx_n(&bin, gidx, resolved, 300));
+            CHECK_EQUAL(-1, bin_gidx2idx(&bin, gidx[299]));
+            CHECK_EQUAL(1, bin_gidx2idx(&bin, gidx[1]));
+
+            // slots above the lowered highwater mark keep their generation when they are allocated again
+            CHECK_EQUAL(100u, bin_alloc_n(&bin, 7, indices, 100));
+            CHECK_EQUAL(-1, bin_gidx2idx(&bin, gidx[299]));
+
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(iterate_used)
+        {
+            ibin32_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            bin_used_iter_t it;
+            bin_iter_begin(&bin, it);
+            CHECK_FALSE(bin_iter_next(&bin, it));
+
+            // a sparse bin, the used items are in a few runs with whole 64x64 regions free in between
+            const u32 num_items = 3 * 4096 + 100;
+            u32*      indices   = g_allocate_array<u32>(Allocator, num_items);
+            CHECK_EQUAL(num_items, bin_alloc_n(&bin, 9, indices, num_items));
+            for (u32 i = 0; i < num_items; ++i)
+            {
+                ((ibin_item_t*)bin_idx2ptr(&bin, i))->value = i;
+                const bool keep = (i >= 3 && i < 5) || (i >= 4090 && i < 4200) || i == 8191 || i == 8192 || i == num_items - 1;
+                if (!keep)
+                    bin_free(&bin, i);
+            }
+
+            const u32 expected_index[] = {3, 4090, 8191, num_items - 1};
+            const u32 expected_count[] = {2, 110, 2, 1};
+
+            u32  runs    = 0;
+            u32  visited = 0;
+            bool ok      = true;
+            bin_iter_begin(&bin, it);
+            while (bin_iter_next(&bin, it))
+            {
+                ok = ok && runs < 4 && it.m_index == expected_index[runs] && it.m_count == expected_count[runs];
+                for (u32 i = 0; i < it.m_count; ++i)
+                    ok = ok && ((ibin_item_t*)it.m_items)[i].value == it.m_index + i;
+                visited += it.m_count;
+                runs += 1;
+            }
+            CHECK_TRUE(ok);
+            CHECK_EQUAL(4u, runs);
+            CHECK_EQUAL(bin_size(&bin), visited);
+
+            g_deallocate_array(Allocator, indices);
+            bin_destroy(&bin);
+        }
+
+        // the tag index agrees with a scan over all the used items
+        static bool s_check_tag_index(ibin32_t const* bin, u32 tag)
+        {
+            u32             scanned = 0;
+            bin_used_iter_t it;
+            bin_iter_begin(bin, it);
+            while (bin_iter_next(bin, it))
+            {
+                for (u32 i = it.m_index; i < it.m_index + it.m_count; ++i)
+                    scanned += (bin_get_tag(bin, i) == (i32)tag) ? 1 : 0;
+            }
+
+            bool ok = true;
+            u32  n  = 0;
+            for (i32 i = bin_tag_first(bin, tag); i >= 0 && n <= scanned; i = bin_tag_next(bin, tag, (u32)i))
+            {
+                ok = ok && bin_get_tag(bin, (u32)i) == (i32)tag;
+                n += 1;
+            }
+            return ok && n == scanned && bin_tag_count(bin, tag) == scanned;
+        }
+
+        UNITTEST_TEST(tag_index_bitsets)
+        {
+            ibin32_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+            bin_tag_index_setup(&bin, 4);
+
+            // the bitset pages of a tag are committed as the items grow
+            const u32 num_items = 70000;
+            u32*      indices   = g_allocate_array<u32>(Allocator, num_items);
+            for (u32 t = 0; t < 4; ++t)
+                CHECK_EQUAL(num_items / 4, bin_alloc_n(&bin, t, indices + t * (num_items / 4), num_items / 4));
+            for (u32 i = 0; i < num_items; i += 3)
+                bin_free(&bin, i);
+            bin_set_tag(&bin, 1, 3);
+            CHECK_EQUAL(3u, bin_defrag(&bin, 3));
+
+            for (u32 t = 0; t < 4; ++t)
+                CHECK_TRUE(s_check_tag_index(&bin, t));
+            CHECK_EQUAL(-1, bin_tag_next(&bin, 3, num_items - 1));
+
+            g_deallocate_array(Allocator, indices);
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(tag_index_hash)
+        {
+            ibin32_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+            bin_tag_index_setup(&bin, 1000);
+
+            // a large and sparse tag domain, the hash table grows past its initial capacity
+            for (u32 i = 0; i < 8000; ++i)
+                CHECK_EQUAL((i32)i, bin_alloc(&bin, (i % 2000) * 7919 + 13));
+            CHECK_EQUAL(4u, bin_tag_count(&bin, 13));
+            CHECK_EQUAL(0u, bin_tag_count(&bin, 14));
+            CHECK_EQUAL(-1, bin_tag_first(&bin, 14));
+
+            for (u32 i = 0; i < 8000; i += 5)
+                bin_free(&bin, i);
+            bin_set_tag(&bin, 1, 13);
+            bin_set_tag(&bin, 2, 42);
+            u32 moved_to = 0;
+            CHECK_EQUAL(7999, bin_compact(&bin, moved_to));
+            CHECK_EQUAL(10u, bin_defrag(&bin, 10));
+
+            CHECK_TRUE(s_check_tag_index(&bin, 13));
+            CHECK_TRUE(s_check_tag_index(&bin, 42));
+            CHECK_TRUE(s_check_tag_index(&bin, 1999 * 7919 + 13));
+            CHECK_EQUAL(2, bin_tag_first(&bin, 42));
+
+            // free the items of a tag while enumerating them
+            for (i32 i = bin_tag_first(&bin, 13); i >= 0; i = bin_tag_next(&bin, 13, (u32)i))
+                bin_free(&bin, (u32)i);
+            CHECK_EQUAL(0u, bin_tag_count(&bin, 13));
+            CHECK_TRUE(s_check_tag_index(&bin, 13));
+
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(handles_survive_defrag)
+        {
+            ibin32_t bin;
+            bin_setup(&bin, 256);
+
+            const u32 num_allocs = 1000;
+            u32       handles[num_allocs];
+            for (u32 i = 0; i < num_allocs; ++i)
+            {
+                handles[i] = bin_alloc_handle(&bin, i);
+                CHECK_NOT_EQUAL(c_ibin32_null_handle, handles[i]);
+                ((ibin_item_t*)bin_handle2ptr(&bin, handles[i]))->value = i;
+            }
+            const uint_t committed_before = narena::committed_size(bin.m_items);
+
+            // keep every third item, the others leave holes all over the bin
+            for (u32 i = 0; i < num_allocs; ++i)
+                if ((i % 3) != 0)
+                    bin_free_handle(&bin, handles[i]);
+            CHECK_EQUAL(334u, bin_size(&bin));
+            CHECK_EQUAL(-1, bin_handle2idx(&bin, handles[1]));
+
+            // incremental, at most 50 items per step, the 222 live items above index 333 are moved
+            u32 steps = 0, moves = 0, step_moves = 0;
+            while ((step_moves = bin_defrag(&bin, 50)) > 0)
+            {
+                CHECK_TRUE(step_moves <= 50);
+                moves += step_moves;
+                steps += 1;
+            }
+            CHECK_EQUAL(222u, moves);
+            CHECK_EQUAL(5u, steps);
+            CHECK_EQUAL(0u, bin_defrag(&bin, 50));
+            CHECK_EQUAL(334u, bin_size(&bin));
+
+            bool ok = true;
+            for (u32 i = 0; i < num_allocs; ++i)
+            {
+                const i32 index = bin_handle2idx(&bin, handles[i]);
+                if ((i % 3) != 0)
+                {
+                    ok = ok && index == -1;
+                    continue;
+                }
+                ibin_item_t const* item = (ibin_item_t const*)bin_handle2ptr(&bin, handles[i]);
+                ok                      = ok && index >= 0 && index < 334 && item != nullptr && item->value == i && bin_get_tag(&bin, (u32)index) == (i32)i;
+            }
+            CHECK_TRUE(ok);
+
+            // the pages above the new highwater mark were given back
+            CHECK_NULL(bin_idx2ptr(&bin, 334));
+            CHECK_TRUE(narena::committed_size(bin.m_items) < committed_before);
+            CHECK_TRUE(narena::committed_size(bin.m_items) <= math::alignUp((uint_t)334 * 256, narena::page_size(bin.m_items)));
+
+            // the bin grows again from the new highwater mark, freed handles stay stale when their slots are reused
+            const u32 handle = bin_alloc_handle(&bin, 5000);
+            CHECK_EQUAL(334, bin_handle2idx(&bin, handle));
+            CHECK_EQUAL(-1, bin_handle2idx(&bin, handles[1]));
+            CHECK_EQUAL(-1, bin_handle2idx(&bin, handles[2]));
+            CHECK_EQUAL(335, bin_alloc(&bin, 5001));
+
+            bin_free(&bin, 10);
+            CHECK_EQUAL(10, bin_alloc(&bin, 5002));
+            bin_destroy(&bin);
+        }
+
+        UNITTEST_TEST(defrag_empty_and_regrow)
+        {
+            ibin32_t bin;
+            bin_setup(&bin, sizeof(ibin_item_t));
+
+            u32 indices[130];
+            CHECK_EQUAL(130u, bin_alloc_n(&bin, 1, indices, 130));
+            bin_free_n(&bin, indices, 130);
+            CHECK_EQUAL(0u, bin_defrag(&bin, 100));
+            CHECK_NULL(bin_idx2ptr(&bin, 0));
+
+            // after trimming to zero the bin behaves like a new one
+            CHECK_EQUAL(130u, bin_alloc_n(&bin, 2, indices, 130));
+            for (u32 i = 0; i < 130; ++i)
+                CHECK_EQUAL(i, indices[i]);
+            bin_free(&bin, 64);
+            bin_free(&bin, 129);
+            CHECK_EQUAL(1u, bin_defrag(&bin, 100));  // item 128 moves to slot 64
+            CHECK_EQUAL(128u, bin_size(&bin));
+            CHECK_EQUAL(128, bin_alloc(&bin, 3));
+            CHECK_EQUAL(129, bin_alloc(&bin, 3));
+            bin_destroy(&bin);
+        }
     }
 }
 UNITTEST_SUITE_END
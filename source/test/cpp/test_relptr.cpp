@@ -0,0 +1,188 @@
+#include "ccore/c_target.h"
+#include "ccore/c_arena.h"
+#include "ccore/c_memory.h"
+#include "ccore/c_relptr.h"
+
+#include "cunittest/cunittest.h"
+
+using namespace ncore;
+
+UNITTEST_SUITE_BEGIN(relptr)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        struct item_t
+        {
+            u32 m_id;
+            u32 m_value;
+        };
+
+        struct root_t
+        {
+            relarray_t<item_t> m_array;
+            rellist_t<u32>     m_list;
+            relmap_t<u32, u64> m_map;
+            relptr64_t<item_t> m_last;
+        };
+
+        static root_t* s_build(arena_t* arena, u32 count)
+        {
+            root_t* root = g_allocate_and_clear<root_t>(arena);
+            root->m_array.init(arena, count);
+            root->m_list.init();
+            root->m_map.init(arena, 2 * count);
+            for (u32 i = 0; i < count; ++i)
+            {
+                item_t item = {i, i * 3};
+                root->m_array.push_back(item);
+                if (i & 1)
+                    root->m_list.push_back(arena, i);
+                else
+                    root->m_list.push_front(arena, i);
+                root->m_map.insert(i * 7, (u64)i << 32);
+            }
+            root->m_last = &root->m_array[count - 1];
+            return root;
+        }
+
+        static bool s_verify(root_t* root, u32 count)
+        {
+            bool ok = root->m_array.size() == count && root->m_list.size() == count && root->m_map.size() == count;
+            for (u32 i = 0; i < count; ++i)
+            {
+                ok       = ok && root->m_array[i].m_id == i && root->m_array[i].m_value == i * 3;
+                u64* val = root->m_map.find(i * 7);
+                ok       = ok && val != nullptr && *val == ((u64)i << 32);
+            }
+            ok = ok && root->m_map.find(1) == nullptr;
+            ok = ok && root->m_last.get() == &root->m_array[count - 1];
+
+            // list: even numbers descending, then odd numbers ascending
+            u32 n = 0;
+            for (rellist_t<u32>::node_t* node = root->m_list.head(); node != nullptr; node = node->m_next.get(), ++n)
+            {
+                const u32 expected = n < (count + 1) / 2 ? (((count - 1) & ~1u) - 2 * n) : 2 * (n - (count + 1) / 2) + 1;
+                ok                 = ok && node->m_item == expected;
+            }
+            return ok && n == count;
+        }
+
+        UNITTEST_TEST(relptr)
+        {
+            u32             values[4] = {1, 2, 3, 4};
+            relptr32_t<u32> p32;
+            relptr64_t<u32> p64;
+            CHECK_TRUE(p32.is_null());
+            CHECK_NULL(p64.get());
+
+            struct pair_t
+            {
+                relptr32_t<u32> m_a;
+                relptr32_t<u32> m_b;
+            } pair;
+            pair.m_a = &values[2];
+            CHECK_EQUAL(3, *pair.m_a);
+            CHECK_EQUAL(4, pair.m_a[1]);
+            pair.m_b = pair.m_a;  // re-encoded for the address of m_b
+            CHECK_TRUE(pair.m_b.get() == &values[2]);
+            CHECK_TRUE(pair.m_a.m_offset != pair.m_b.m_offset);
+
+            p64 = &values[0];
+            CHECK_EQUAL(1, *p64);
+            p64 = nullptr;
+            CHECK_TRUE(p64.is_null());
+        }
+
+        UNITTEST_TEST(containers)
+        {
+            arena_t* arena = narena::new_arena(16 * cMB, 64 * cKB);
+            root_t*  root  = s_build(arena, 1000);
+            CHECK_TRUE(s_verify(root, 1000));
+
+            // remove from the map (backward shift) and from the list
+            bool ok = true;
+            for (u32 i = 0; i < 1000; i += 2)
+                ok = ok && root->m_map.remove(i * 7);
+            CHECK_TRUE(ok);
+            CHECK_FALSE(root->m_map.remove(0));
+            CHECK_EQUAL(500, root->m_map.size());
+            for (u32 i = 0; i < 1000; ++i)
+                ok = ok && ((root->m_map.find(i * 7) != nullptr) == ((i & 1) != 0));
+            CHECK_TRUE(ok);
+
+            root->m_list.remove(root->m_list.head());
+            root->m_list.remove(root->m_list.tail());
+            CHECK_EQUAL(998, root->m_list.size());
+            CHECK_EQUAL(996, root->m_list.head()->m_item);
+            CHECK_EQUAL(997, root->m_list.tail()->m_item);
+
+            item_t item;
+            CHECK_TRUE(root->m_array.pop_back(item));
+            CHECK_EQUAL(999, item.m_id);
+
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(map_full)
+        {
+            arena_t* arena = narena::new_arena(1 * cMB, 64 * cKB);
+
+            relmap_t<u32, u32>& map = *g_allocate_and_clear<relmap_t<u32, u32>>(arena);  // relptr's live in the arena
+            CHECK_TRUE(map.init(arena, 4));
+            CHECK_TRUE(map.capacity() >= 4);
+
+            u32 n = 0;
+            while (map.insert(n, n + 100))
+                n += 1;
+            CHECK_EQUAL(map.capacity(), n);
+            CHECK_EQUAL(n, map.size());
+            CHECK_TRUE(map.insert(0, 200));  // replacing still works on a full map
+            CHECK_EQUAL(200, *map.find(0));
+            CHECK_NULL(map.find(n));
+            CHECK_FALSE(map.remove(n));
+
+            bool ok = true;
+            for (u32 i = 0; i < n; ++i)
+            {
+                ok = ok && map.remove(i);
+                for (u32 j = i + 1; j < n; ++j)
+                    ok = ok && map.find(j) != nullptr && *map.find(j) == j + 100;
+            }
+            CHECK_TRUE(ok);
+            CHECK_EQUAL(0, map.size());
+
+            narena::destroy(arena);
+        }
+
+        UNITTEST_TEST(relocate)
+        {
+            arena_t*     arena  = narena::new_arena(16 * cMB, 64 * cKB);
+            root_t*      root   = s_build(arena, 1000);
+            const uint_t offset = narena::offset_of(arena, root);
+            const uint_t used   = narena::current_pos(arena);
+
+            // copy the used part of the arena to another arena, as if it was written to a file and loaded again
+            arena_t* copy = narena::new_arena(16 * cMB, 64 * cKB);
+            byte*    dst  = (byte*)narena::alloc(copy, used, 16);
+            CHECK_TRUE(dst == narena::base_ptr(copy));
+            g_memcpy(dst, narena::base_ptr(arena), used);
+            g_memset(narena::base_ptr(arena), 0xCD, used);
+            narena::destroy(arena);
+
+            root_t* moved = narena::ptr_at<root_t>(copy, offset);
+            CHECK_TRUE(s_verify(moved, 1000));
+
+            // the relocated structures can still grow
+            CHECK_TRUE(moved->m_list.push_back(copy, 12345) != nullptr);
+            CHECK_EQUAL(12345, moved->m_list.tail()->m_item);
+            CHECK_TRUE(moved->m_map.insert(1, 2));
+            CHECK_EQUAL(2, *moved->m_map.find(1));
+
+            narena::destroy(copy);
+        }
+    }
+}
+UNITTEST_SUITE_END
@@ -1,11 +1,15 @@
 #include "ccore/c_target.h"
+#include "ccore/c_atomic.h"
 #include "ccore/c_math.h"
 #include "ccore/c_memory.h"
 #include "ccore/c_segment.h"
 #include "ccore/c_arena.h"
+#include "ccore/c_random.h"
 
 #include "cunittest/cunittest.h"
 
+#include "test_thread.h"
+
 using namespace ncore;
 
 static bool s_validate_free_lists(nsegment::allocator_t const & allocator)
@@ -748,6 +752,326 @@ UNITTEST_SUITE_BEGIN(segment)
                 nsegment::teardown(&allocator);
             }
         }
+
+        // Threads allocate nodes of mixed sizes, commit and write the first page and free them again in random order
+        static const s32 cConcurrentThreads = 4;
+        static const s32 cConcurrentSlots   = 8;
+
+        struct concurrent_shared_t
+        {
+            nsegment::allocator_t* m_allocator;
+            s32                    m_ops;
+            bool                   m_commit;
+            bool                   m_global_lock;  // use alloc_node/dealloc_node under a single lock (benchmark baseline)
+            spinlock_t             m_lock;
+            u32 volatile           m_ready;
+            s32                    m_num_threads;
+            u32 volatile           m_failed;
+            u64                    m_duration_ns[8];
+        };
+
+        static void s_concurrent_thread(void* arg, s32 index)
+        {
+            concurrent_shared_t*   shared    = (concurrent_shared_t*)arg;
+            nsegment::allocator_t* allocator = shared->m_allocator;
+            const u32              page_size = (u32)1 << allocator->m_pagesize_shift;
+
+            nsegment::node_t slots[cConcurrentSlots];
+            for (s32 i = 0; i < cConcurrentSlots; ++i)
+                slots[i] = nsegment::cINVALID_NODE;
+
+            xor_random_t rnd((u64)index + 1);
+            natomic::fetch_add(&shared->m_ready, 1u);
+            while (natomic::load(&shared->m_ready) < (u32)shared->m_num_threads)
+                natomic::pause();
+
+            const u64 start = ntest::time_ns();
+            for (s32 op = 0; op < shared->m_ops; ++op)
+            {
+                const u32 r    = rnd.rand32();
+                const s32 slot = (s32)(r % cConcurrentSlots);
+                if (slots[slot] != nsegment::cINVALID_NODE)
+                {
+                    if (shared->m_commit)
+                    {
+                        u32        num_pages = 0;
+                        u32 const* address   = (u32 const*)nsegment::get_address(allocator, slots[slot], num_pages);
+                        if (address == nullptr || address[0] != ((u32)index << 16 | (u32)slot))
+                            natomic::fetch_add(&shared->m_failed, 1u);
+                    }
+                    if (shared->m_global_lock)
+                    {
+                        spinlock_scope_t lock(shared->m_lock);
+                        nsegment::dealloc_node(allocator, slots[slot]);
+                    }
+                    else
+                    {
+                        nsegment::dealloc_node_concurrent(allocator, slots[slot]);
+                    }
+                    slots[slot] = nsegment::cINVALID_NODE;
+                }
+
+                const u64 size = (u64)page_size << ((r >> 8) % 5);
+                if (shared->m_global_lock)
+                {
+                    spinlock_scope_t lock(shared->m_lock);
+                    slots[slot] = nsegment::alloc_node(allocator, size);
+                }
+                else
+                {
+                    slots[slot] = nsegment::alloc_node_concurrent(allocator, size);
+                }
+                if (slots[slot] == nsegment::cINVALID_NODE)
+                {
+                    natomic::fetch_add(&shared->m_failed, 1u);
+                    continue;
+                }
+
+                if (shared->m_commit)
+                {
+                    nsegment::commit(allocator, slots[slot], 1);
+                    u32 num_pages = 0;
+                    u32* address  = (u32*)nsegment::get_address(allocator, slots[slot], num_pages);
+                    address[0]    = (u32)index << 16 | (u32)slot;
+                }
+            }
+
+            for (s32 i = 0; i < cConcurrentSlots; ++i)
+            {
+                if (slots[i] == nsegment::cINVALID_NODE)
+                    continue;
+                if (shared->m_global_lock)
+                {
+                    spinlock_scope_t lock(shared->m_lock);
+                    nsegment::dealloc_node(allocator, slots[i]);
+                }
+                else
+                {
+                    nsegment::dealloc_node_concurrent(allocator, slots[i]);
+                }
+            }
+            shared->m_duration_ns[index] = ntest::time_ns() - start;
+        }
+
+        static u64 s_concurrent_run(concurrent_shared_t* shared, s32 num_threads)
+        {
+            shared->m_num_threads = num_threads;
+            shared->m_ready       = 0;
+            ntest::run_threads(num_threads, s_concurrent_thread, shared);
+            u64 duration = 0;
+            for (s32 t = 0; t < num_threads; ++t)
+                duration = duration < shared->m_duration_ns[t] ? shared->m_duration_ns[t] : duration;
+            return duration;
+        }
+
+        UNITTEST_TEST(concurrent_alloc_dealloc)
+        {
+            const u32 page_size = (u32)v_alloc_get_page_size();
+
+            // every thread holds at most 8 nodes of at most 16 pages, which always fits
+            nsegment::allocator_t allocator;
+            nsegment::initialize(&allocator, (u64)1024 * page_size, (u64)page_size, (u64)256 * page_size);
+            nsegment::enable_concurrent(&allocator, 16);
+
+            concurrent_shared_t shared;
+            shared.m_allocator   = &allocator;
+            shared.m_ops         = 20000;
+            shared.m_commit      = true;
+            shared.m_global_lock = false;
+            shared.m_failed      = 0;
+            nspinlock::init(shared.m_lock);
+            s_concurrent_run(&shared, cConcurrentThreads);
+            CHECK_EQUAL(0, shared.m_failed);
+
+            // after merging the whole address space is available as top level nodes again
+            nsegment::merge_free_nodes(&allocator);
+            CHECK(s_validate_free_lists(allocator));
+            u32 top_nodes = 0;
+            for (u32 i = 0; i < 4; ++i)
+            {
+                const nsegment::node_t node = nsegment::alloc_node_concurrent(&allocator, (u64)256 * page_size);
+                CHECK(node >= 0 && (node & 255) == 0);
+                top_nodes |= node >= 0 ? (1u << (node >> 8)) : 0;
+            }
+            CHECK_EQUAL(15u, top_nodes);
+            CHECK_EQUAL(nsegment::cINVALID_NODE, nsegment::alloc_node_concurrent(&allocator, page_size));
+
+            nsegment::teardown(&allocator);
+        }
+
+        UNITTEST_TEST(fragmentation_stats)
+        {
+            const u32 page_size = (u32)v_alloc_get_page_size();
+
+            nsegment::allocator_t allocator;
+            nsegment::initialize(&allocator, (u64)1024 * page_size, (u64)page_size, (u64)256 * page_size);
+
+            nsegment::stats_t stats;
+            nsegment::get_stats(&allocator, stats);
+            CHECK_EQUAL(4u, stats.m_free_nodes[8]);
+            CHECK_EQUAL((u64)1024 * page_size, stats.m_total_free_bytes);
+            CHECK_EQUAL((u64)256 * page_size, stats.m_largest_free);
+            CHECK_EQUAL(0, stats.m_used_bytes);
+
+            // a single page node splits a top level node into free nodes of class 0 to 7
+            const nsegment::node_t node = nsegment::alloc_node(&allocator, page_size);
+            CHECK(node >= 0);
+            nsegment::get_stats(&allocator, stats);
+            for (u32 c = 0; c < 8; ++c)
+            {
+                CHECK_EQUAL(1u, stats.m_free_nodes[c]);
+                CHECK_EQUAL((u64)page_size << c, stats.m_free_bytes[c]);
+                CHECK_EQUAL(0u, stats.m_mergeable_pairs[c]);
+            }
+            CHECK_EQUAL(3u, stats.m_free_nodes[8]);
+            CHECK_EQUAL((u64)1023 * page_size, stats.m_total_free_bytes);
+            CHECK_EQUAL((u64)page_size, stats.m_used_bytes);
+            CHECK_EQUAL((u64)256 * page_size, stats.m_largest_free);
+
+            nsegment::dealloc_node(&allocator, node);
+            nsegment::get_stats(&allocator, stats);
+            CHECK_EQUAL(4u, stats.m_free_nodes[8]);
+            CHECK_EQUAL(0, stats.m_used_bytes);
+
+            nsegment::teardown(&allocator);
+        }
+
+        UNITTEST_TEST(incremental_coalescing)
+        {
+            const u32 page_size = (u32)v_alloc_get_page_size();
+
+            // a merge batch that is never reached, merging only happens through coalesce
+            nsegment::allocator_t allocator;
+            nsegment::initialize(&allocator, (u64)1024 * page_size, (u64)page_size, (u64)256 * page_size);
+            nsegment::enable_concurrent(&allocator, 0xffffffffu);
+
+            nsegment::node_t nodes[512];
+            for (u32 i = 0; i < 512; ++i)
+            {
+                nodes[i] = nsegment::alloc_node_concurrent(&allocator, page_size);
+                CHECK(nodes[i] >= 0);
+            }
+            for (u32 i = 0; i < 512; ++i)
+                nsegment::dealloc_node_concurrent(&allocator, nodes[i]);
+
+            // the address space is fragmented in single pages while all of it is free
+            nsegment::stats_t stats;
+            nsegment::get_stats(&allocator, stats);
+            CHECK_EQUAL(512u, stats.m_free_nodes[0]);
+            CHECK_EQUAL(256u, stats.m_mergeable_pairs[0]);
+            CHECK_EQUAL(2u, stats.m_free_nodes[8]);
+            CHECK_EQUAL((u64)1024 * page_size, stats.m_total_free_bytes);
+
+            // coalesce with a small budget until the whole address space is merged again
+            u32 calls  = 0;
+            u32 merges = 0;
+            while (stats.m_free_nodes[8] < 4 && calls < 1000)
+            {
+                merges += nsegment::coalesce(&allocator, 16);
+                calls += 1;
+                nsegment::get_stats(&allocator, stats);
+            }
+            CHECK(calls > 8);
+            CHECK_EQUAL(510u, merges);
+            CHECK_EQUAL(4u, stats.m_free_nodes[8]);
+            CHECK_EQUAL((u64)256 * page_size, stats.m_largest_free);
+            for (u32 c = 0; c < 8; ++c)
+            {
+                CHECK_EQUAL(0u, stats.m_free_nodes[c]);
+                CHECK_EQUAL(0u, stats.m_mergeable_pairs[c]);
+            }
+            CHECK(s_validate_free_lists(allocator));
+
+            nsegment::teardown(&allocator);
+        }
+
+#ifdef CCORE_BENCHMARKS
+        // Benchmark, per size-class locking against the single threaded functions under a global lock
+        UNITTEST_TEST(concurrent_benchmark)
+        {
+            const u32 page_size = (u32)v_alloc_get_page_size();
+            const s32 num_ops   = 1 << 18;
+
+            nsegment::allocator_t allocator;
+            nsegment::initialize(&allocator, (u64)16384 * page_size, (u64)page_size, (u64)256 * page_size);
+
+            concurrent_shared_t shared;
+            shared.m_allocator = &allocator;
+            shared.m_ops       = num_ops;
+            shared.m_commit    = false;
+            shared.m_failed    = 0;
+            nspinlock::init(shared.m_lock);
+            for (s32 num_threads = 1; num_threads <= 8; num_threads *= 2)
+            {
+                shared.m_global_lock = true;
+                const u64 global_ns  = s_concurrent_run(&shared, num_threads);
+                nsegment::enable_concurrent(&allocator);
+                shared.m_global_lock     = false;
+                const u64 concurrent_ns  = s_concurrent_run(&shared, num_threads);
+                nsegment::merge_free_nodes(&allocator);
+                allocator.m_merge_batch = 0;  // back to single threaded mode for the baseline
+                printf("segment alloc+dealloc, %d threads: global lock %6.1f ns/op, concurrent %6.1f ns/op\n", num_threads, (double)global_ns / num_ops, (double)concurrent_ns / num_ops);
+            }
+            CHECK_EQUAL(0, shared.m_failed);
+            CHECK(s_validate_free_lists(allocator));
+            nsegment::teardown(&allocator);
+        }
+#endif
+
+        UNITTEST_TEST(numa_node)
+        {
+            const u32 page_size = (u32)v_alloc_get_page_size();
+
+            nsegment::allocator_t allocator;
+            nsegment::initialize(&allocator, (u64)1024 * page_size, (u64)page_size, (u64)256 * page_size, VMEM_PAGES_DEFAULT, v_numa_current_node());
+            CHECK_NOT_NULL(allocator.m_base_address);
+
+            const nsegment::node_t node = nsegment::alloc_node(&allocator, (u64)16 * page_size);
+            CHECK(node >= 0);
+            nsegment::commit(&allocator, node, 16);
+            u32   num_pages = 0;
+            byte* address   = (byte*)nsegment::get_address(&allocator, node, num_pages);
+            CHECK_NOT_NULL(address);
+            g_memset(address, 0xcd, 16 * page_size);
+            CHECK_EQUAL(0xcd, address[16 * page_size - 1]);
+            nsegment::dealloc_node(&allocator, node);
+
+            nsegment::teardown(&allocator);
+        }
+
+        UNITTEST_TEST(large_pages)
+        {
+            nsegment::allocator_t allocator;
+            nsegment::initialize(&allocator, (u64)1u * cGB, 8 * cMB, 64 * cMB, VMEM_PAGES_TRANSPARENT_HUGE);
+            CHECK(allocator.m_base_address != nullptr);
+            CHECK_EQUAL(0, (ptr_t)allocator.m_base_address & (v_alloc_get_large_page_size() - 1));
+
+            // the page unit follows the backing that was obtained
+            if (allocator.m_page_backing != VMEM_PAGES_DEFAULT)
+                CHECK(allocator.m_pagesize_shift == math::ilog2(v_alloc_get_large_page_size()));
+            else
+                CHECK(allocator.m_pagesize_shift == v_alloc_get_page_size_shift());
+
+            const nsegment::node_t node = nsegment::alloc_node(&allocator, 8 * cMB);
+            CHECK(node != nsegment::cINVALID_NODE);
+            u32   num_pages = 0;
+            byte* address   = (byte*)nsegment::get_address(&allocator, node, num_pages);
+            CHECK(address != nullptr);
+            CHECK_EQUAL((u32)(8 * cMB >> allocator.m_pagesize_shift), num_pages);
+            nsegment::commit(&allocator, node, num_pages);
+            address[0]             = 1;
+            address[8 * cMB - 1]   = 2;
+            nsegment::decommit(&allocator, node, 0);
+            nsegment::dealloc_node(&allocator, node);
+            nsegment::teardown(&allocator);
+
+            // segments smaller than a large page cannot use large pages
+            nsegment::initialize(&allocator, (u64)64u * cMB, 1 * cMB, 8 * cMB, VMEM_PAGES_HUGE);
+            CHECK(allocator.m_base_address != nullptr);
+            CHECK(allocator.m_page_backing == VMEM_PAGES_DEFAULT);
+            CHECK(allocator.m_pagesize_shift == v_alloc_get_page_size_shift());
+            nsegment::teardown(&allocator);
+        }
     }
 }
 UNITTEST_SUITE_END
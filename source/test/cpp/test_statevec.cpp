@@ -1,5 +1,7 @@
+#include "ccore/c_arena.h"
 #include "ccore/c_statevec.h"
 #include "ccore/c_memory.h"
+#include "ccore/c_random.h"
 
 #include "cunittest/cunittest.h"
 
@@ -823,5 +825,154 @@ UNITTEST_SUITE_BEGIN(astatevec)
             CHECK_EQUAL(1054, nstatevec20::find_free_last(&free0, free1, free2, &used0, used1, used2, bin3, 1056));
         }
     }
+
+    UNITTEST_FIXTURE(range)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+        // a state-vector keeps its words in 'w', free summary levels first, then the used summary levels, then the bits
+        struct sv12_t
+        {
+            typedef u64 T;
+            static const u32 cShift  = 6;
+            static const u32 cLevels = 2;
+            static void clear_all_free(T** w, u32 maxbits) { nstatevec12::clear_all_free(w[0], w[1], w[2], maxbits); }
+            static void set_used(T** w, u32 maxbits, u32 bit) { nstatevec12::set_used(w[0], w[1], w[2], maxbits, bit); }
+            static s32  find_free(T** w, u32 maxbits) { return nstatevec12::find_free(w[0], w[1], w[2], maxbits); }
+            static s32  find_free_range(T** w, u32 maxbits, u32 n) { return nstatevec12::find_free_range(w[0], w[1], w[2], maxbits, n); }
+            static s32  alloc_range(T** w, u32 maxbits, u32 n) { return nstatevec12::alloc_range(w[0], w[1], w[2], maxbits, n); }
+            static void free_range(T** w, u32 maxbits, u32 start, u32 n) { nstatevec12::free_range(w[0], w[1], w[2], maxbits, start, n); }
+        };
+
+        struct sv18_t
+        {
+            typedef u64 T;
+            static const u32 cShift  = 6;
+            static const u32 cLevels = 3;
+            static void clear_all_free(T** w, u32 maxbits) { nstatevec18::clear_all_free(w[0], w[1], w[2], w[3], w[4], maxbits); }
+            static void set_used(T** w, u32 maxbits, u32 bit) { nstatevec18::set_used(w[0], w[1], w[2], w[3], w[4], maxbits, bit); }
+            static s32  find_free(T** w, u32 maxbits) { return nstatevec18::find_free(w[0], w[1], w[2], w[3], w[4], maxbits); }
+            static s32  find_free_range(T** w, u32 maxbits, u32 n) { return nstatevec18::find_free_range(w[0], w[1], w[2], w[3], w[4], maxbits, n); }
+            static s32  alloc_range(T** w, u32 maxbits, u32 n) { return nstatevec18::alloc_range(w[0], w[1], w[2], w[3], w[4], maxbits, n); }
+            static void free_range(T** w, u32 maxbits, u32 start, u32 n) { nstatevec18::free_range(w[0], w[1], w[2], w[3], w[4], maxbits, start, n); }
+        };
+
+        struct sv20_t
+        {
+            typedef u32 T;
+            static const u32 cShift  = 5;
+            static const u32 cLevels = 4;
+            static void clear_all_free(T** w, u32 maxbits) { nstatevec20::clear_all_free(w[0], w[1], w[2], w[3], w[4], w[5], w[6], maxbits); }
+            static void set_used(T** w, u32 maxbits, u32 bit) { nstatevec20::set_used(w[0], w[1], w[2], w[3], w[4], w[5], w[6], maxbits, bit); }
+            static s32  find_free(T** w, u32 maxbits) { return nstatevec20::find_free(w[0], w[1], w[2], w[3], w[4], w[5], w[6], maxbits); }
+            static s32  find_free_range(T** w, u32 maxbits, u32 n) { return nstatevec20::find_free_range(w[0], w[1], w[2], w[3], w[4], w[5], w[6], maxbits, n); }
+            static s32  alloc_range(T** w, u32 maxbits, u32 n) { return nstatevec20::alloc_range(w[0], w[1], w[2], w[3], w[4], w[5], w[6], maxbits, n); }
+            static void free_range(T** w, u32 maxbits, u32 start, u32 n) { nstatevec20::free_range(w[0], w[1], w[2], w[3], w[4], w[5], w[6], maxbits, start, n); }
+        };
+
+        static s32 s_first_fit(u8 const* used, u32 maxbits, u32 n)
+        {
+            u32 run = 0;
+            for (u32 i = 0; i < maxbits; ++i)
+            {
+                run = used[i] ? 0 : run + 1;
+                if (run == n)
+                    return (s32)(i + 1 - n);
+            }
+            return -1;
+        }
+
+        // random range allocations and frees on a fragmented state-vector, compared with first fit on an array of flags
+        template <typename SV>
+        static bool s_test(u32 maxbits, s32 ops)
+        {
+            arena_t* arena = narena::new_arena(16 * cMB, 64 * cKB);
+
+            // words per level, from the bits up to the single word at the top
+            u32 words[4];
+            words[SV::cLevels - 1] = (maxbits + (1 << SV::cShift) - 1) >> SV::cShift;
+            for (s32 l = (s32)SV::cLevels - 2; l >= 0; --l)
+                words[l] = (words[l + 1] + (1 << SV::cShift) - 1) >> SV::cShift;
+            words[0] = 1;
+
+            typename SV::T* w[7];
+            for (u32 l = 0; l < SV::cLevels - 1; ++l)
+            {
+                w[l]                   = g_allocate_array_and_clear<typename SV::T>(arena, words[l]);
+                w[SV::cLevels - 1 + l] = g_allocate_array_and_clear<typename SV::T>(arena, words[l]);
+            }
+            w[2 * (SV::cLevels - 1)] = g_allocate_array_and_clear<typename SV::T>(arena, words[SV::cLevels - 1]);
+            u8* used                 = g_allocate_array_and_clear<u8>(arena, maxbits);
+
+            SV::clear_all_free(w, maxbits);
+            xor_random_t rnd(0x4321);
+            for (u32 i = 0; i < maxbits / 16; ++i)
+            {
+                u32 const bit = rnd.rand32() % maxbits;
+                SV::set_used(w, maxbits, bit);
+                used[bit] = 1;
+            }
+
+            bool ok = true;
+            u32  held_start[64];
+            u32  held_count[64];
+            u32  held = 0;
+            for (s32 i = 0; i < ops && ok; ++i)
+            {
+                u32 const r = rnd.rand32();
+                if ((r & 3) != 0 && held < 64)
+                {
+                    u32 const sizes[] = {1, 5, 31, 64, 100, 257, 1000};
+                    u32 const n       = 1 + ((r >> 2) % sizes[(r >> 16) % 7]);
+                    s32 const expect  = s_first_fit(used, maxbits, n);
+                    ok                = ok && SV::find_free_range(w, maxbits, n) == expect;
+                    s32 const start   = SV::alloc_range(w, maxbits, n);
+                    ok                = ok && start == expect;
+                    if (start >= 0)
+                    {
+                        g_memset(used + start, 1, n);
+                        held_start[held]   = (u32)start;
+                        held_count[held++] = n;
+                    }
+                }
+                else if (held > 0)
+                {
+                    u32 const h = (r >> 2) % held;
+                    SV::free_range(w, maxbits, held_start[h], held_count[h]);
+                    g_memclr(used + held_start[h], held_count[h]);
+                    held_start[h] = held_start[--held];
+                    held_count[h] = held_count[held];
+                }
+                ok = ok && SV::find_free(w, maxbits) == s_first_fit(used, maxbits, 1);
+            }
+
+            SV::free_range(w, maxbits, 0, maxbits);
+            ok = ok && SV::find_free_range(w, maxbits, maxbits) == 0;
+            ok = ok && SV::alloc_range(w, maxbits, maxbits) == 0 && SV::find_free_range(w, maxbits, 1) == -1 && SV::find_free(w, maxbits) == -1;
+            ok = ok && SV::find_free_range(w, maxbits, 0) == -1 && SV::find_free_range(w, maxbits, maxbits + 1) == -1;
+
+            narena::destroy(arena);
+            return ok;
+        }
+
+        UNITTEST_TEST(statevec12)
+        {
+            CHECK_TRUE(s_test<sv12_t>(4000, 2000));
+            CHECK_TRUE(s_test<sv12_t>(64, 200));
+        }
+
+        UNITTEST_TEST(statevec18)
+        {
+            CHECK_TRUE(s_test<sv18_t>(100000, 1000));
+            CHECK_TRUE(s_test<sv18_t>(1000, 500));
+        }
+
+        UNITTEST_TEST(statevec20)
+        {
+            CHECK_TRUE(s_test<sv20_t>(50000, 1000));
+            CHECK_TRUE(s_test<sv20_t>(5000, 500));
+        }
+    }
 }
 UNITTEST_SUITE_END
@@ -0,0 +1,106 @@
+#ifndef __CCORE_TEST_THREAD_H__
+#define __CCORE_TEST_THREAD_H__
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#    pragma once
+#endif
+
+// Minimal thread and timer helpers for the multi-threaded unittests and benchmarks,
+// ccore itself does not provide any threading.
+// The benchmarks (timing and printed results) are only compiled when CCORE_BENCHMARKS is
+// defined, the default test run only checks correctness.
+
+#if defined(TARGET_PC)
+#    define WIN32_LEAN_AND_MEAN
+#    define NOMINMAX
+#    include <windows.h>
+#else
+#    include <pthread.h>
+#    include <time.h>
+#endif
+#include <stdio.h>
+
+namespace ncore
+{
+    namespace ntest
+    {
+        typedef void (*thread_func_t)(void* arg, s32 thread_index);
+
+        struct thread_args_t
+        {
+            thread_func_t m_func;
+            void*         m_arg;
+            s32           m_index;
+        };
+
+#if defined(TARGET_PC)
+        static DWORD WINAPI s_thread_main(LPVOID param)
+        {
+            thread_args_t* args = (thread_args_t*)param;
+            args->m_func(args->m_arg, args->m_index);
+            return 0;
+        }
+
+        // launch 'count' threads that all run 'func' and wait for all of them to finish
+        inline void run_threads(s32 count, thread_func_t func, void* arg)
+        {
+            HANDLE        handles[64];
+            thread_args_t args[64];
+            ASSERT(count <= 64);
+            for (s32 i = 0; i < count; ++i)
+            {
+                args[i].m_func  = func;
+                args[i].m_arg   = arg;
+                args[i].m_index = i;
+                handles[i]      = ::CreateThread(nullptr, 0, s_thread_main, &args[i], 0, nullptr);
+            }
+            ::WaitForMultipleObjects((DWORD)count, handles, TRUE, INFINITE);
+            for (s32 i = 0; i < count; ++i)
+                ::CloseHandle(handles[i]);
+        }
+
+        // monotonic time in nanoseconds
+        inline u64 time_ns()
+        {
+            LARGE_INTEGER frequency, counter;
+            ::QueryPerformanceFrequency(&frequency);
+            ::QueryPerformanceCounter(&counter);
+            return (u64)((double)counter.QuadPart * (1000000000.0 / (double)frequency.QuadPart));
+        }
+#else
+        static void* s_thread_main(void* param)
+        {
+            thread_args_t* args = (thread_args_t*)param;
+            args->m_func(args->m_arg, args->m_index);
+            return nullptr;
+        }
+
+        // launch 'count' threads that all run 'func' and wait for all of them to finish
+        inline void run_threads(s32 count, thread_func_t func, void* arg)
+        {
+            pthread_t     threads[64];
+            thread_args_t args[64];
+            ASSERT(count <= 64);
+            for (s32 i = 0; i < count; ++i)
+            {
+                args[i].m_func  = func;
+                args[i].m_arg   = arg;
+                args[i].m_index = i;
+                pthread_create(&threads[i], nullptr, s_thread_main, &args[i]);
+            }
+            for (s32 i = 0; i < count; ++i)
+                pthread_join(threads[i], nullptr);
+        }
+
+        // monotonic time in nanoseconds
+        inline u64 time_ns()
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (u64)ts.tv_sec * 1000000000 + (u64)ts.tv_nsec;
+        }
+#endif
+    }  // namespace ntest
+}  // namespace ncore
+
+#endif  // __CCORE_TEST_THREAD_H__